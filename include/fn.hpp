@@ -38,6 +38,17 @@
 #include <iterator> // for std::inserter, MSVC
 #include <cassert>
 #include <memory> // make_shared
+#include <cstdint> // uint64_t for normalized sort-key prefixes
+#include <tuple>
+#include <cmath> // log, exp for sampling
+#include <cstring> // memchr for split
+#include <unordered_map>
+#include <cstddef> // max_align_t
+#include <atomic> // atomic_thread_fence for arena chunks
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 #if defined(DOXYGEN) || (defined(RANGELESS_FN_ENABLE_RUN_TESTS) && RANGELESS_FN_ENABLE_RUN_TESTS)
 #    define RANGELESS_FN_ENABLE_PARALLEL 1
@@ -59,6 +70,100 @@ namespace rangeless
 namespace fn
 {
 
+#if __cplusplus >= 201703L
+    using string_view = std::string_view;
+#else
+    /// @brief A minimal stand-in for `std::string_view` pre-c++17.
+    class string_view
+    {
+    public:
+        using value_type     = char;
+        using iterator       = const char*;
+        using const_iterator = const char*;
+        using size_type      = size_t;
+
+        static constexpr size_t npos = size_t(-1);
+
+        string_view() noexcept
+            : m_data{ nullptr }
+            , m_size{ 0 }
+        {}
+
+        string_view(const char* data, size_t size) noexcept
+            : m_data{ data }
+            , m_size{ size }
+        {}
+
+        string_view(const char* str)
+            : m_data{ str }
+            , m_size{ std::char_traits<char>::length(str) }
+        {}
+
+        string_view(const std::string& str) noexcept
+            : m_data{ str.data() }
+            , m_size{ str.size() }
+        {}
+
+        explicit operator std::string() const
+        {
+            return { m_data, m_size };
+        }
+
+        const char* data()   const noexcept { return m_data; }
+             size_t size()   const noexcept { return m_size; }
+             size_t length() const noexcept { return m_size; }
+               bool empty()  const noexcept { return m_size == 0; }
+
+        const char* begin()  const noexcept { return m_data; }
+        const char* end()    const noexcept { return m_data + m_size; }
+
+        const char& operator[](size_t i) const { return m_data[i]; }
+        const char& front() const { return m_data[0]; }
+        const char& back()  const { return m_data[m_size - 1]; }
+
+        void remove_prefix(size_t n) { m_data += n; m_size -= n; }
+        void remove_suffix(size_t n) { m_size -= n; }
+
+        string_view substr(size_t pos, size_t n = npos) const
+        {
+            if(pos > m_size) {
+                throw std::out_of_range("string_view::substr");
+            }
+            return { m_data + pos, std::min(n, m_size - pos) };
+        }
+
+        size_t find(char c, size_t pos = 0) const noexcept
+        {
+            for(; pos < m_size; ++pos) {
+                if(m_data[pos] == c) {
+                    return pos;
+                }
+            }
+            return npos;
+        }
+
+        int compare(string_view other) const noexcept
+        {
+            const int cmp = std::char_traits<char>::compare(m_data, other.m_data, std::min(m_size, other.m_size));
+            return cmp != 0           ? cmp
+                 : m_size < other.m_size ? -1
+                 : m_size > other.m_size ?  1 : 0;
+        }
+
+    private:
+        const char* m_data;
+        size_t      m_size;
+    };
+
+    inline bool operator==(string_view a, string_view b) noexcept
+    {
+        return a.size() == b.size() && a.compare(b) == 0;
+    }
+
+    inline bool operator!=(string_view a, string_view b) noexcept { return !(a == b);      }
+    inline bool operator< (string_view a, string_view b) noexcept { return a.compare(b) < 0; }
+#endif
+
 namespace impl
 {
     // A trick to make compiler produce a compilation error printing the expanded type.
@@ -75,7 +180,10 @@ namespace impl
 
     /////////////////////////////////////////////////////////////////////////
     /// Very bare-bones version of std::optional-like with rebinding assignment semantics.
-    template<class T>
+    ///
+    /// See the more compact specializations for pointers, reference-wrappers, 
+    /// and trivially-destructible types below.
+    template<class T, typename Enable = void>
     class maybe
     {
        struct sentinel{};
@@ -248,6 +356,269 @@ namespace impl
         }
     };
 
+    template<typename T> 
+    struct is_reference_wrapper : std::false_type
+    {};
+
+    template<typename T> 
+    struct is_reference_wrapper<std::reference_wrapper<T>> : std::true_type
+    {};
+
+    /////////////////////////////////////////////////////////////////////////
+    // Trivially-destructible T: same as above, except without the destructor,
+    // and the branch on m_empty in reset(), so that maybe<T> is trivially-destructible too.
+    template<class T>
+    class maybe<T, typename std::enable_if<   std::is_trivially_destructible<T>::value
+                                          && !std::is_pointer<T>::value
+                                          && !is_reference_wrapper<T>::value>::type>
+    {
+       struct sentinel{};
+       union
+       {
+           sentinel m_sentinel;
+                  T m_value;
+       };
+
+       bool m_empty = true;
+     
+    public:
+        using value_type = T;
+
+        maybe() : m_sentinel{}
+        {}
+
+        maybe(const maybe&) = delete;
+        maybe& operator=(const maybe&) = delete;
+
+        maybe(T val) // NB[5]
+            : m_value(std::move(val))
+            , m_empty{ false }
+        {}
+
+        maybe(maybe&& other) noexcept 
+            : m_sentinel{}
+        {
+            if(!other.m_empty) {
+                reset(std::move(*other));
+                other.m_empty = true;
+            }
+        }
+
+        maybe& operator=(maybe&& other) noexcept
+        {
+            if(this == &other) {
+                ;
+            } else if(!other.m_empty) {
+                reset(std::move(*other));
+                other.m_empty = true;
+            } else {
+                m_empty = true;
+            }
+            return *this;
+        }
+
+        void reset(T&& val)
+        {
+            new (&m_value) T(std::move(val)); // see reset(T&&) above
+            m_empty = false;
+        }
+
+        void reset() noexcept
+        {
+            m_empty = true;
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return !m_empty;
+        }
+     
+        T& operator*() noexcept
+        {
+            assert(!m_empty);
+
+#if __cplusplus >= 201703L
+            return *std::launder(&m_value);
+#else
+            return m_value;
+#endif
+        }
+
+        const T& operator*() const noexcept
+        {
+            assert(!m_empty);
+            
+#if __cplusplus >= 201703L
+            return *std::launder(&m_value);
+#else
+            return m_value;
+#endif
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    // The empty-state for maybe<T*>: the address of the middle of a private 
+    // static buffer, which can't compare equal to any other pointer the 
+    // user-code may have (including one-past-the-end pointers).
+    inline void* maybe_ptr_sentinel() noexcept
+    {
+        alignas(std::max_align_t) static unsigned char buf[2 * alignof(std::max_align_t)];
+        return &buf[alignof(std::max_align_t)];
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // Pointer: represent the empty-state by maybe_ptr_sentinel(), rather than
+    // nullptr, because a seq of pointers may legitimately yield nullptrs.
+    template<class T>
+    class maybe<T*, typename std::enable_if<!std::is_function<T>::value>::type>
+    {
+        T* m_ptr;
+
+        static T* x_sentinel() noexcept
+        {
+            return static_cast<T*>(impl::maybe_ptr_sentinel());
+        }
+
+    public:
+        using value_type = T*;
+
+        maybe() noexcept
+            : m_ptr{ x_sentinel() }
+        {}
+
+        maybe(const maybe&) = delete;
+        maybe& operator=(const maybe&) = delete;
+
+        maybe(T* val) noexcept
+            : m_ptr{ val }
+        {}
+
+        maybe(maybe&& other) noexcept
+            : m_ptr{ other.m_ptr }
+        {
+            other.m_ptr = x_sentinel();
+        }
+
+        maybe& operator=(maybe&& other) noexcept
+        {
+            T* const ptr = other.m_ptr;
+            other.m_ptr = x_sentinel();
+            m_ptr = ptr;
+            return *this;
+        }
+
+        void reset(T*&& val) noexcept
+        {
+            m_ptr = val;
+        }
+
+        void reset() noexcept
+        {
+            m_ptr = x_sentinel();
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_ptr != x_sentinel();
+        }
+
+        T*& operator*() noexcept
+        {
+            assert(*this);
+            return m_ptr;
+        }
+
+        T* const& operator*() const noexcept
+        {
+            assert(*this);
+            return m_ptr;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    // Reference-wrapper (e.g. from fn::refs or tsv::get_next_line):
+    // empty is represented by nullptr, without a separate flag.
+    template<class U>
+    class maybe<std::reference_wrapper<U>, 
+                typename std::enable_if<sizeof(std::reference_wrapper<U>) == sizeof(U*)>::type>
+    {
+        using T = std::reference_wrapper<U>;
+
+        union
+        {
+            U* m_null; // active and nullptr when empty
+             T m_value;
+        };
+
+    public:
+        using value_type = T;
+
+        maybe() noexcept
+            : m_null{ nullptr }
+        {}
+
+        maybe(const maybe&) = delete;
+        maybe& operator=(const maybe&) = delete;
+
+        maybe(T val) noexcept
+            : m_value(val)
+        {}
+
+        maybe(maybe&& other) noexcept
+            : m_null{ nullptr }
+        {
+            if(other) {
+                reset(std::move(*other));
+                other.reset();
+            }
+        }
+
+        maybe& operator=(maybe&& other) noexcept
+        {
+            if(this == &other) {
+                ;
+            } else if(other) {
+                reset(std::move(*other));
+                other.reset();
+            } else {
+                reset();
+            }
+            return *this;
+        }
+
+        void reset(T&& val) noexcept
+        {
+            new (&m_value) T(val);
+        }
+
+        void reset() noexcept
+        {
+            m_null = nullptr;
+        }
+
+        explicit operator bool() const noexcept
+        {
+            // A reference-wrapper is represented by the (non-null) address of
+            // the referent (hence the size-check above), so we can tell
+            // which member is active by inspecting the representation.
+            U* ptr = nullptr;
+            std::memcpy(static_cast<void*>(&ptr), static_cast<const void*>(&m_null), sizeof(ptr));
+            return ptr != nullptr;
+        }
+
+        T& operator*() noexcept
+        {
+            assert(*this);
+            return m_value;
+        }
+
+        const T& operator*() const noexcept
+        {
+            assert(*this);
+            return m_value;
+        }
+    };
+
     /////////////////////////////////////////////////////////////////////////////
     // Will be used to control SFINAE priority of ambiguous overload resolutions.
     // https://stackoverflow.com/questions/34419045
@@ -793,29 +1164,120 @@ namespace impl
         }
     };
 
-}   // namespace impl
+    /////////////////////////////////////////////////////////////////////
+    // std::index_sequence is c++14
+    template<size_t... Is> 
+    struct index_seq
+    {};
 
+    template<size_t N, size_t... Is>
+    struct make_index_seq : make_index_seq<N - 1, N - 1, Is...>
+    {};
 
-/// @brief Common key-functions to use with sort_by/unque_by/group_all_by
-/// @code
-/// ptrs = %= fn::sort_by(fn::by::dereferenced{});
-/// std::move(pairs) % fn::group_all_by(fn::by::second{});
-/// @endcode
-namespace by
-{
-    // sort() / unique() are simply sort_by<identity> and unique_adjacent_by<identity>
-    struct identity 
+    template<size_t... Is>
+    struct make_index_seq<0, Is...>
     {
-        template<typename T>
-        auto operator()(const T& x) const -> const T&
-        {
-            return x;
-        }
+        using type = index_seq<Is...>;
     };
 
-    struct dereferenced
+    // Index of the first of Ts that decays to U (or sizeof...(Ts) if none).
+    template<typename U, typename... Ts>
+    struct index_of_decayed : std::integral_constant<size_t, 0>
+    {};
+
+    template<typename U, typename T, typename... Ts>
+    struct index_of_decayed<U, T, Ts...> 
+        : std::integral_constant<size_t, std::is_same<U, typename std::decay<T>::type>::value 
+                                         ? 0 : 1 + index_of_decayed<U, Ts...>::value>
+    {};
+
+    /////////////////////////////////////////////////////////////////////
+    // Row-proxy of fn::soa_vector: a tuple of references to the row's 
+    // fields in the columns; `T&` for a mutable row, and `const T&` for a const row.
+    //
+    // Converting a row to value_type always copies the fields (the row is 
+    // a prvalue, so we can't tell `value_type v = *it` from `std::move(*it)`);
+    // moving the fields out of the columns is explicit, via move_out().
+    template<typename... Refs>
+    struct soa_row : std::tuple<Refs...>
     {
-        template<typename P> // any dereferenceable type
+        using base_t     = std::tuple<Refs...>;
+        using value_type = std::tuple<typename std::decay<Refs>::type...>;
+        using indices_t  = typename make_index_seq<sizeof...(Refs)>::type;
+
+        soa_row(Refs... refs) : base_t{ std::forward<Refs>(refs)... }
+        {}
+
+        // mutable row -> const row
+        template<typename... Us, 
+                 typename = typename std::enable_if<std::is_constructible<base_t, const std::tuple<Us...>&>::value>::type>
+        soa_row(const soa_row<Us...>& other) : base_t{ static_cast<const std::tuple<Us...>&>(other) }
+        {}
+
+        // assign-through
+        soa_row& operator=(value_type val)
+        {
+            base_t::operator=(std::move(val));
+            return *this;
+        }
+
+        value_type move_out()
+        {
+            return x_move_out(indices_t{});
+        }
+
+    private:
+        template<size_t... Is>
+        value_type x_move_out(index_seq<Is...>)
+        {
+            return value_type{ std::move(std::get<Is>(*this))... };
+        }
+    };
+
+    // Swap the rows' fields (not the proxies), for std::reverse, std::sort, etc.
+    template<typename... Ts>
+    void swap(soa_row<Ts&...> a, soa_row<Ts&...> b)
+    {
+        static_cast<std::tuple<Ts&...>&>(a).swap(b);
+    }
+
+    // Move an element out of a container via its iterator's reference:
+    // std::move for a real reference, and move_out() for a soa_row proxy.
+    template<typename T>
+    auto move_elem(T&& x) -> typename std::remove_reference<T>::type&&
+    {
+        return std::move(x);
+    }
+
+    template<typename... Ts>
+    std::tuple<Ts...> move_elem(soa_row<Ts&...> row)
+    {
+        return row.move_out();
+    }
+
+}   // namespace impl
+
+
+/// @brief Common key-functions to use with sort_by/unque_by/group_all_by
+/// @code
+/// ptrs = %= fn::sort_by(fn::by::dereferenced{});
+/// std::move(pairs) % fn::group_all_by(fn::by::second{});
+/// @endcode
+namespace by
+{
+    // sort() / unique() are simply sort_by<identity> and unique_adjacent_by<identity>
+    struct identity 
+    {
+        template<typename T>
+        auto operator()(const T& x) const -> const T&
+        {
+            return x;
+        }
+    };
+
+    struct dereferenced
+    {
+        template<typename P> // any dereferenceable type
         auto operator()(const P& ptr) const -> decltype(*ptr) // NB: decltype computes a reference
         {
             return *ptr;
@@ -849,6 +1311,14 @@ namespace by
         {
             return std::get<U>(x);
         }
+
+        // soa_vector's row: accesses only the column of type U.
+        template<typename... Refs>
+        auto operator()(const impl::soa_row<Refs...>& row) const -> const U&
+        {
+            static_assert(impl::index_of_decayed<U, Refs...>::value < sizeof...(Refs), "The row has no field of this type.");
+            return std::get<impl::index_of_decayed<U, Refs...>::value>(row);
+        }
     };
 
 
@@ -1107,14 +1577,221 @@ namespace get
         return { begin(src), end(src) };
     }
 
+    /// @brief A block of chars yielded by `fn::from_istream_blocks`.
+    ///
+    /// This is a `std::string`, but of a distinct type, so that the
+    /// char-aware stages can recognize a stream of blocks (see `fn::from_istream_blocks`).
+    struct char_block : std::string
+    {
+        using std::string::basic_string;
+    };
+
+    /// @brief A `fn::string_view` into a chunk of an arena, sharing the ownership of the chunk
+    /// (see `group_adjacent_by(key_fn, fn::in_arena(chunk_size))`).
+    ///
+    /// The chunk stays alive for as long as any views into it do.
+    class arena_string_view
+    {
+    public:
+        using chunk_ptr = std::shared_ptr<const std::vector<char>>;
+
+        arena_string_view() noexcept
+            : m_view{}
+            , m_chunk{}
+        {}
+
+        arena_string_view(string_view view, chunk_ptr chunk) noexcept
+            : m_view{ view }
+            , m_chunk{ std::move(chunk) }
+        {}
+
+        operator string_view() const noexcept
+        {
+            return m_view;
+        }
+
+        explicit operator std::string() const
+        {
+            return std::string(m_view.data(), m_view.size());
+        }
+
+        const char* data()  const noexcept { return m_view.data();  }
+             size_t size()  const noexcept { return m_view.size();  }
+               bool empty() const noexcept { return m_view.empty(); }
+
+        const char* begin() const noexcept { return m_view.data(); }
+        const char* end()   const noexcept { return m_view.data() + m_view.size(); }
+
+        const char& operator[](size_t i) const { return m_view.data()[i]; }
+
+    private:
+        string_view m_view;
+          chunk_ptr m_chunk;
+    };
+
+    inline bool operator==(const arena_string_view& a, const arena_string_view& b) noexcept { return string_view(a) == string_view(b); }
+    inline bool operator==(const arena_string_view& a, string_view b)              noexcept { return string_view(a) == b;              }
+    inline bool operator==(string_view a, const arena_string_view& b)              noexcept { return a == string_view(b);              }
+    inline bool operator!=(const arena_string_view& a, const arena_string_view& b) noexcept { return !(a == b);                        }
+    inline bool operator!=(const arena_string_view& a, string_view b)              noexcept { return !(a == b);                        }
+    inline bool operator!=(string_view a, const arena_string_view& b)              noexcept { return !(a == b);                        }
+    inline bool operator< (const arena_string_view& a, const arena_string_view& b) noexcept { return string_view(a) < string_view(b);  }
+
+namespace impl
+{
+    template<typename Istream>
+    struct istream_blocks
+    {
+        Istream* istr;
+        size_t block_size;
+        char_block garbage;
+
+        using value_type = char_block;
+
+        void recycle(value_type& grbg)
+        {
+            garbage = std::move(grbg);
+        }
+
+        auto operator()() -> maybe<value_type>
+        {
+            value_type ret = std::move(garbage);
+            ret.resize(block_size);
+
+            istr->read(&ret[0], std::streamsize(block_size));
+            ret.resize(size_t(istr->gcount()));
+
+            if(ret.empty()) {
+                return { };
+            }
+            return { std::move(ret) };
+        }
+    };
+} // namespace impl
+
+    /// @brief Read an input stream in blocks of `block_size` chars, rather than char-by-char.
+    ///
+    /// This is a faster replacement for
+    /// `fn::from(std::istreambuf_iterator<char>(istr.rdbuf()), {})`, where every
+    /// char takes a trip through the pipeline.
+    ///
+    /// The char-aware stages process whole blocks in tight loops:
+    /// `fn::transform_chars` maps the chars in place,
+    /// and `fn::group_adjacent_by` (or `fn::group_adjacent_if`) groups the chars
+    /// into `std::string`s, as it would given a seq of chars (groups may span blocks).
+    /// Other stages see a seq of `fn::char_block`.
+    ///
+    /// The blocks are recycled, so the steady state does not allocate.
+    /*!
+    @code
+        std::istringstream istr{ "Hello, World!" };
+
+        auto words = fn::from_istream_blocks(istr, 4)
+          % fn::transform_chars([](char c){ return std::tolower(c); })
+          % fn::group_adjacent_by([](char c){ return bool(std::isalpha(c)); })
+          % fn::to_vector();
+
+        VERIFY(( words == std::vector<std::string>({ "hello", ", ", "world", "!" }) ));
+    @endcode
+    */
+    template<typename Istream>
+    impl::seq<impl::istream_blocks<Istream>> from_istream_blocks(Istream& istr, size_t block_size = 64 * 1024)
+    {
+        return { { &istr, block_size == 0 ? 1 : block_size, {} } };
+    }
+
     /// @}
 
+    template<typename... Ts>
+    class soa_vector; // see below
+
+
 
 
 /////////////////////////////////////////////////////////////////////////
 /// @brief Implementations for corresponding static functions in fn::
 namespace impl
 {   
+    /////////////////////////////////////////////////////////////////////////
+    // The key-type of stages that store the keys past the lifetime of
+    // the elements (sort_by_bounded_disorder, unique_within_by, incremental_aggregate),
+    // guarded against dangling the same way as in unique_all_by::gen.
+    template<typename Key>
+    struct storable_key
+    {
+        static_assert(std::is_default_constructible<Key>::value, "The type returned by key_fn must be default-constructible and have the lifetime independent of arg.");
+        using type = Key;
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    // A container or view tagged as sorted by key_fn (see fn::assume_sorted_by).
+    // 
+    // Stages that can exploit the sortedness provide overloads for it
+    // (take_while_key_lt, drop_while_key_lt, unique_all_by, group_all_by, counts), stages
+    // that preserve the order (take_while, take_last, where, etc.) return it
+    // still tagged via their container-overloads, and stages that change
+    // the order (sort_by, reverse) drop the tag. 
+    template<typename Iterable, typename F>
+    struct sorted_range
+    {
+        Iterable src;
+               F key_fn;
+
+        using value_type = typename Iterable::value_type;
+        using iterator   = typename Iterable::iterator;
+
+        auto begin()       -> decltype(src.begin()) { return src.begin(); }
+        auto end()         -> decltype(src.end())   { return src.end();   }
+        auto begin() const -> decltype(src.begin()) { return src.begin(); }
+        auto end()   const -> decltype(src.end())   { return src.end();   }
+
+        template<typename It>
+        auto erase(It b, It e) -> decltype(src.erase(b, e))
+        {
+            return src.erase(std::move(b), std::move(e));
+        }
+
+        void clear()
+        {
+            src.clear();
+        }
+
+        bool empty() const
+        {
+            return src.empty();
+        }
+
+        // for SequenceContainer-detection in where (see x_EraseFrom)
+        template<typename I = Iterable>
+        auto front() -> decltype(std::declval<I&>().front())
+        {
+            return src.front();
+        }
+
+        template<typename I = Iterable>
+        auto size() const -> decltype(std::declval<const I&>().size())
+        {
+            return src.size();
+        }
+    };
+
+    template<typename F>
+    struct assume_sorted_by
+    {
+        const F key_fn;
+
+        template<typename Iterable>
+        sorted_range<Iterable, F> operator()(Iterable src) const
+        {
+            impl::require_iterator_category_at_least<std::forward_iterator_tag>(src); // [compilation-error-hint]: expecting a container or a view; try fn::to_vector() first.
+
+            assert(std::is_sorted(src.begin(), src.end(), comp<F>{ key_fn })); // Expecting inputs sorted by key_fn.
+
+            return { std::move(src), key_fn };
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
     // Wrap an Iterable as gen-callable, yielding elements by move.
     struct to_seq
     {
@@ -1158,7 +1835,7 @@ namespace impl
                 if(it == inps.end()) {
                     return { };
                 } else {
-                    return { std::move(*it) };
+                    return { impl::move_elem(*it) };
                 }
             }
         }; 
@@ -1189,6 +1866,13 @@ namespace impl
             return vec;
         }
 
+        // drop the sortedness-tag (possibly passing-through the underlying vector)
+        template<typename Iterable, typename F>
+        auto operator()(sorted_range<Iterable, F> src) const -> decltype(std::declval<const to_vector&>()(std::move(src.src)))
+        {
+            return this->operator()(std::move(src.src));
+        }
+
         // overload for a seq - invoke rvalue-specific implicit conversion
         template<typename Gen,
                  typename Vec = std::vector<typename seq<Gen>::value_type>>
@@ -1197,6 +1881,18 @@ namespace impl
             return static_cast<Vec>(std::move(r));
         }
 
+        // structure-of-arrays: move the fields out of the columns into rows
+        template<typename... Ts>
+        std::vector<std::tuple<Ts...>> operator()(soa_vector<Ts...> src) const
+        {
+            std::vector<std::tuple<Ts...>> ret{};
+            ret.reserve(src.size());
+            for(auto&& row : src) {
+                ret.push_back(row.move_out());
+            }
+            return ret;
+        }
+
         // overload for other iterable: move-insert elements into vec
         template<typename Iterable,
                  typename Vec = std::vector<typename Iterable::value_type> >
@@ -1298,2537 +1994,8071 @@ namespace impl
             }
             return ret;
         }
+
+        // Sorted inputs: equal elements are adjacent, so count the run-lengths,
+        // appending each new key at the end of the map in amortized O(1).
+        template<typename Iterable>
+        std::map<typename Iterable::value_type, size_t> operator()(sorted_range<Iterable, by::identity> xs) const
+        {
+            auto ret = std::map<typename Iterable::value_type, size_t>{};
+            for(auto&& x : xs) {
+                if(ret.empty() || ret.key_comp()(std::prev(ret.end())->first, x)) {
+                    ret.emplace_hint(ret.end(), x, 1);
+                } else {
+                    ++std::prev(ret.end())->second;
+                }
+            }
+            return ret;
+        }
     };
 
     /////////////////////////////////////////////////////////////////////
-    template<typename Pred>
-    struct exists_where
+    // 64-bit hashing of keys for the sketches below.
+    //
+    // std::hash is the identity for integers in common implementations,
+    // so we mix the bits (splitmix64 finalizer). Also support the composite
+    // keys that key-functions commonly return: std::tie(...), pairs,
+    // and std::reference_wrapper.
+
+    inline uint64_t mix64(uint64_t h)
     {
-        const Pred pred;
-              bool ret;
+        h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    }
 
-        // e.g. bool ret = vals % !fn::exists_where(pred);
-        exists_where operator!() &&
+    inline uint64_t hash_combine64(uint64_t seed, uint64_t h)
+    {
+        return mix64(seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+    }
+
+    struct hash64
+    {
+        template<typename T>
+        uint64_t operator()(const T& x) const
         {
-            // don't want to make operator! non-const for lvalues,
-            // so instead making it rvalue-specific to prevent
-            // any misuse.
+            return mix64(uint64_t(std::hash<T>{}(x)));
+        }
 
-            ret = !ret;
-            return std::move(*this);
+        template<typename T>
+        uint64_t operator()(const std::reference_wrapper<T>& x) const
+        {
+            return (*this)(x.get());
         }
 
-        template<typename Iterable>
-        bool operator()(const Iterable& iterable) const
+        template<typename A, typename B>
+        uint64_t operator()(const std::pair<A, B>& x) const
         {
-            for(const auto& x : iterable)
-                if(pred(x)) 
-                    return ret;
-            return !ret;
+            return hash_combine64((*this)(x.first), (*this)(x.second));
+        }
+
+        template<typename... Ts>
+        uint64_t operator()(const std::tuple<Ts...>& x) const
+        {
+            return x_combine(x, typename make_index_seq<sizeof...(Ts)>::type{});
+        }
+
+    private:
+        template<typename Tuple, size_t... Is>
+        uint64_t x_combine(const Tuple& x, index_seq<Is...>) const
+        {
+            uint64_t ret = 0;
+            const int unused[] = { 0, (ret = hash_combine64(ret, (*this)(std::get<Is>(x))), 0)... };
+            (void)unused;
+            return ret;
         }
     };
 
-    // NB[3]: In for_each, foldl, foldl_d, foldl_1 we don't really need
-    // the overloads for seq, because seq is Iterable, but by providing
-    // them we work with underlying gens directly, bypassing the iterator
-    // machinery layer of seq, potentially allowing the compiler to do 
-    // better job with optimization.
+    // Count of leading zero bits; 64 if x == 0.
+    inline uint32_t clz64(uint64_t x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return x == 0 ? 64u : uint32_t(__builtin_clzll(x));
+#else
+        uint32_t ret = 0;
+        for(uint64_t mask = 1ULL << 63; mask && !(x & mask); mask >>= 1) {
+            ++ret;
+        }
+        return ret;
+#endif
+    }
 
     /////////////////////////////////////////////////////////////////////
-    template<typename F>
-    struct for_each
+    /// @brief HyperLogLog sketch of the number of distinct keys (see fn::approx_distinct_by).
+    ///
+    /// Uses `2^precision` one-byte registers, and 64-bit hashes, so no large-range
+    /// correction is needed; small cardinalities are estimated with linear counting
+    /// (with empirical switch-over thresholds of HLL++). The relative standard error
+    /// of the estimate is `1.04 / sqrt(2^precision)`.
+    ///
+    /// Sketches with the same precision can be merged, e.g. after counting
+    /// distinct keys in shards or in parallel.
+    class hll_sketch
     {
-        F fn; // may be non-const, hence operator()s are also non-const.
+        uint32_t             m_precision;
+        std::vector<uint8_t> m_registers;
 
-        template<typename Iterable>
-        void operator()(Iterable&& src)
+    public:
+        explicit hll_sketch(size_t precision = 14)
+            : m_precision{ uint32_t(precision) }
+            , m_registers{}
         {
-            for(auto it = src.begin(); it != src.end(); ++it) {
-                fn(*it);
+            if(precision < 4 || precision > 18) {
+                RANGELESS_FN_THROW("Precision must be in [4, 18].");
             }
+            m_registers.resize(size_t(1) << precision, 0);
+        }
 
-            // Used to return by perfect-forwarding, i.e. 
-            // return-type = Iterable&&, and return std::forward<Iterable>(src);
-            //
-            // The intent was to allow downstream stages
-            // after for_each. However,
-            // 1) If Iterable is a single-pass seq, 
-            //    it's not usable after the loop (will cause runtime error
-            //    if we try to iterate over it again).
-            // 2) -Weffc++ says "should return by value" when 
-            //    Iterable is passed by rvalue.
-            // 
-            // So instead, will treat for_each as lfold-into-void.
+        size_t precision() const
+        {
+            return m_precision;
         }
 
+        /// Relative standard error of the estimate.
+        double relative_error() const
+        {
+            return 1.04 / std::sqrt(double(m_registers.size()));
+        }
 
-        // See NB[3]
-        template<typename Gen>
-        void operator()(seq<Gen> src)
+        template<typename Key>
+        void insert(const Key& key)
         {
-            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
-                fn(std::move(*x));
-                impl::recycle(src.get_gen(), *x, impl::resolve_overload{});
-            }
+            insert_hash(hash64{}(key));
         }
-    };
 
-    template<typename F2>
-    struct for_each_adjacent
-    {
-        F2 fn2; // may be non-const, hence operator()s are also non-const.
+        void insert_hash(uint64_t h)
+        {
+            // top p bits select the register; the rest yield the rank
+            const auto i    = size_t(h >> (64 - m_precision));
+            const auto rank = uint8_t(std::min(clz64(h << m_precision), 64 - m_precision) + 1);
 
-        template<typename Iterable>
-        void operator()(Iterable&& src)
+            if(m_registers[i] < rank) {
+                m_registers[i] = rank;
+            }
+        }
+
+        /// Throws `std::logic_error` if the precisions are different.
+        void merge(const hll_sketch& other)
         {
-            impl::require_iterator_category_at_least<std::forward_iterator_tag>(src);
+            if(other.m_precision != m_precision) {
+                RANGELESS_FN_THROW("Can't merge sketches of different precision.");
+            }
 
-            auto it2 = src.begin();
-            if(it2 == src.end()) {
-                return;
+            for(size_t i = 0; i < m_registers.size(); i++) {
+                m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
             }
-            auto it1 = it2;
-            ++it2;
+        }
 
-            for(; it2 != src.end(); it1 = it2, ++it2) {
-                fn2(*it1, *it2);
+        double estimate() const
+        {
+            const double m = double(m_registers.size());
+
+            double sum = 0;
+            size_t num_zeros = 0;
+            for(const auto r : m_registers) {
+                sum += std::ldexp(1.0, -int(r));
+                num_zeros += r == 0;
+            }
+
+            const double alpha = m_precision == 4 ? 0.673
+                               : m_precision == 5 ? 0.697
+                               : m_precision == 6 ? 0.709
+                               :                    0.7213 / (1 + 1.079 / m);
+
+            const double raw = alpha * m * m / sum;
+
+            if(num_zeros == 0) {
+                return raw;
             }
+
+            // linear counting is more accurate below the threshold
+            static const double thresholds[] = { 10, 20, 40, 80, 220, 400, 900, 1800, 3100, 6500, 11500, 20000, 50000, 120000, 350000 };
+            const double lc = m * std::log(m / double(num_zeros));
+            return lc <= thresholds[m_precision - 4] ? lc : raw;
         }
     };
 
-
     /////////////////////////////////////////////////////////////////////
-    template<typename Ret, typename Op>
-    struct foldl
+    /// @brief KLL quantile sketch (see fn::approx_quantiles_by).
+    ///
+    /// A hierarchy of compactors: level `h` holds items of weight `2^h`;
+    /// when a level exceeds its capacity, it's sorted, and every other item
+    /// (starting with a random one of the first two) is promoted to the next level.
+    /// Capacities decrease geometrically (by 2/3) from the top level (`k`) down, so
+    /// the memory is `O(k)` items, and the rank-error is `O(1/k)` (about 1.7% at k=200,
+    /// with high probability).
+    template<typename T>
+    class kll_sketch
     {
-        Ret init;
-        Op fold_op;
+        size_t                      m_k;
+        uint64_t                    m_count;
+        std::vector<std::vector<T>> m_levels;
+        uint64_t                    m_rng_state; // for coin-flips in compactions
 
-        template<typename Iterable>
-        Ret operator()(Iterable&& src) && // rvalue-specific because init will be moved-from
-        {                                 // (we have to, because Ret may be move-only)
+        // cached, as insert() checks them every time
+        std::vector<size_t>         m_capacities; // per level; change only when a level is added
+        size_t                      m_total_capacity;
+        size_t                      m_num_retained;
 
-            static_assert(std::is_same<Ret, decltype(fold_op(std::move(init), *src.begin()))>::value, 
-                         "Type of Init must be the same as the return-type of F");
-    
-            for(auto it = src.begin(); it != src.end(); ++it) {
-                init = fold_op(std::move(init), *it);
-            }
+    public:
+        using value_type = T;
 
-            // NB: can't use std::accumulate because it does not do the std::move(init)
-            // internally until c++20, so it won't compile with move-only types, 
-            // and will make copies for copyable types.
+        kll_sketch(size_t k = 200)
+            : m_k{ k }
+            , m_count{ 0 }
+            , m_levels(1)
+            , m_rng_state{ 0x9e3779b97f4a7c15ULL }
+            , m_capacities{}
+            , m_total_capacity{ 0 }
+            , m_num_retained{ 0 }
+        {
+            if(k < 8) {
+                RANGELESS_FN_THROW("k must be at least 8.");
+            }
+            x_update_capacities();
+        }
 
-            return std::move(init);
+        /// Number of inserted items.
+        uint64_t count() const
+        {
+            return m_count;
         }
 
-        // See NB[3]
-        template<typename Gen>
-        Ret operator()(seq<Gen> src) && 
+        bool empty() const
         {
-            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
-                init = fold_op(std::move(init), std::move(*x));
-                impl::recycle(src.get_gen(), *x, impl::resolve_overload{});
-            }
-            return std::move(init);
+            return m_count == 0;
         }
-    };
-            
-    /////////////////////////////////////////////////////////////////////
-    template<typename Op>
-    struct foldl_d
-    {
-        Op fold_op;
 
-        struct any
+        /// Number of items retained in the sketch.
+        size_t num_retained() const
         {
-            template<typename T>
-            operator T() const;
-        };
+            return m_num_retained;
+        }
 
-        template<typename Iterable>
-        auto operator()(Iterable&& src) const -> decltype(fold_op(any(), *src.begin()))
+        void insert(T x)
         {
-            using ret_t = decltype(fold_op(any(), *src.begin()));
-            auto ret = ret_t{};
+            m_levels.front().push_back(std::move(x));
+            ++m_count;
+            ++m_num_retained;
 
-            for(auto it = src.begin(); it != src.end(); ++it) {
-                ret = fold_op(std::move(ret), *it);
+            // Compact lazily: only when level 0 (the only one that grew) is over
+            // its capacity, and the sketch is over its total capacity.
+            if(m_levels.front().size() > m_capacities.front() && m_num_retained > m_total_capacity) {
+                x_compress();
             }
-
-            return ret;
         }
 
-
-        // See NB[3]
-        template<typename Gen>
-        auto operator()(seq<Gen> src) const -> decltype(fold_op(any(), std::move(*src.get_gen()())))
+        void merge(const kll_sketch& other)
         {
-            using ret_t = decltype(fold_op(any(), std::move(*src.get_gen()())));
-            auto ret = ret_t{};
+            if(m_levels.size() < other.m_levels.size()) {
+                m_levels.resize(other.m_levels.size());
+                x_update_capacities();
+            }
 
-            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
-                ret = fold_op(std::move(ret), std::move(*x));
-                impl::recycle(src.get_gen(), *x, impl::resolve_overload{});
+            for(size_t h = 0; h < other.m_levels.size(); h++) {
+                m_levels[h].insert(m_levels[h].end(), other.m_levels[h].begin(), other.m_levels[h].end());
             }
 
-            return ret;
+            m_count += other.m_count;
+            m_num_retained += other.m_num_retained;
+            x_compress();
         }
-    };
-
-    /////////////////////////////////////////////////////////////////////
-    template<typename F>
-    struct foldl_1
-    {
-        F fold_op;
 
-        template<typename Iterable>
-        auto operator()(Iterable&& src) const -> decltype(fold_op(std::move(*src.begin()), *src.begin()))
+        /// Approximate q-quantile, `q` in `[0, 1]`; throws `std::logic_error` if empty.
+        T quantile(double q) const
         {
-            auto it = src.begin();
-            auto it_end = src.end();
-
-            if(it == it_end) {
-                RANGELESS_FN_THROW("Expected nonempty.");
+            if(empty()) {
+                RANGELESS_FN_THROW("Quantile of an empty sketch.");
             }
 
-            auto init = *it;
+            auto items = x_weighted_items();
+            const double target = std::min(std::max(q, 0.0), 1.0) * double(m_count);
 
-            for(++it; it != it_end; ++it) {
-                init = fold_op(std::move(init), *it);
+            uint64_t cumulative = 0;
+            for(const auto& item : items) {
+                cumulative += item.second;
+                if(double(cumulative) >= target) {
+                    return *item.first;
+                }
             }
+            return *items.back().first;
+        }
 
-            return init;
+        /// Approximate fraction of items less than or equal to `x`.
+        double rank(const T& x) const
+        {
+            uint64_t ret = 0;
+            for(size_t h = 0; h < m_levels.size(); h++) {
+                for(const auto& y : m_levels[h]) {
+                    ret += lt{}(x, y) ? 0 : uint64_t(1) << h;
+                }
+            }
+            return empty() ? 0.0 : double(ret) / double(m_count);
         }
 
-        // See NB[3]
-        template<typename Gen>
-        auto operator()(seq<Gen> src) const -> decltype(fold_op(std::move(*src.get_gen()()), std::move(*src.get_gen()())))
+    private:
+        // Capacity of the compactor at level h is k * (2/3)^depth, at least 2.
+        void x_update_capacities()
         {
-            auto x1 = src.get_gen()();
+            m_capacities.resize(m_levels.size());
+            m_total_capacity = 0;
 
-            if(!x1) {
-                RANGELESS_FN_THROW("Expected nonempty.");
+            double cap = double(m_k);
+            for(size_t h = m_levels.size(); h-- > 0; ) {
+                m_capacities[h] = std::max(size_t(2), size_t(std::ceil(cap)));
+                m_total_capacity += m_capacities[h];
+                cap *= 2.0 / 3.0;
             }
-            
-            auto init = std::move(*x1);
+        }
 
-            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
-                init = fold_op(std::move(init), std::move(*x));
+        void x_compress()
+        {
+            while(m_num_retained > m_total_capacity) {
+                // There must be a level over its capacity; compact the lowest one.
+                for(size_t h = 0; h < m_levels.size(); h++) {
+                    if(m_levels[h].size() > m_capacities[h]) {
+                        x_compact(h);
+                        break;
+                    }
+                }
             }
-
-            return init;
         }
-    };
 
-    /////////////////////////////////////////////////////////////////////////
+        void x_compact(size_t h)
+        {
+            if(h + 1 == m_levels.size()) {
+                m_levels.emplace_back();
+                x_update_capacities();
+            }
 
-    // define operator() overload composing an input-seq
-    // (gen in OutGen presumed to go first)
-    // Basically, we unwrap the input seq, yanking its gen,
-    // compose our gen over it, and wrap it back into seq.
-#define RANGELESS_FN_OVERLOAD_FOR_SEQ(...)                                 \
-    template<typename InGen>                                               \
-    auto operator()(seq<InGen> in) const -> seq<gen<InGen>>                \
-    {                                                                      \
-        return { { std::move(in.get_gen()), __VA_ARGS__ } };               \
-    }                                                                
+            auto& level = m_levels[h];
+            auto& next  = m_levels[h + 1];
 
-    // Default implementation of operator() for cases where 
-    // there's no eager logic for Container-arg, and
-    // we want to treat it the same as seq (overload above)
-    // so we wrap Container as to_seq::gen and do same as above.
-    //
-#define RANGELESS_FN_OVERLOAD_FOR_CONT(...)                                \
-    template<typename Container>                                           \
-    auto operator()(Container cont) const                                  \
-      -> seq<gen<to_seq::gen<Container>>>                                  \
-    {                                                                      \
-        return { { { std::move(cont), { }, false }, __VA_ARGS__ } };       \
-    }                                                                      \
-    //                                ^^^^^^^^^^
-    // NB: it would be better, of course, to specify that `{ }` and `false`
-    // as defaults in declarations of to_seq::gen fields instead of specifying them here,
-    // but GCC-4.9.3 has problems with aggregate initialization in a presence
-    // of field-defaults.
+            std::sort(level.begin(), level.end(), lt{});
 
+            // xorshift64
+            m_rng_state ^= m_rng_state << 13;
+            m_rng_state ^= m_rng_state >> 7;
+            m_rng_state ^= m_rng_state << 17;
+            const size_t offset = m_rng_state & 1;
 
-#define RANGELESS_FN_OVERLOAD_FOR_VIEW(...)                                \
-    template<typename Iterator>                                            \
-    auto operator()(view<Iterator> v) const                                \
-     -> seq<gen<to_seq::gen<view<Iterator>>>>                              \
-    {                                                                      \
-        return { { { std::move(v), { }, false }, __VA_ARGS__ } };          \
-    }    
+            // if odd, the last item stays at this level
+            const size_t num_paired = level.size() - level.size() % 2;
 
-    /////////////////////////////////////////////////////////////////////
-    template<typename F>
-    struct transform
-    {
-        F map_fn;
+            for(size_t i = offset; i < num_paired; i += 2) {
+                next.push_back(std::move(level[i]));
+            }
+            level.erase(level.begin(), level.begin() + std::ptrdiff_t(num_paired));
+            m_num_retained -= num_paired / 2;
+        }
 
-        template<typename InGen>
-        struct gen
+        // (item, weight) pairs, sorted by item
+        std::vector<std::pair<const T*, uint64_t>> x_weighted_items() const
         {
-            InGen gen;
-                F map_fn;
-
-            using value_type = decltype(map_fn(std::move(*gen())));
-
-            static_assert(!std::is_same<value_type, void>::value, "You forgot a return-statement in your transform-function.");
+            std::vector<std::pair<const T*, uint64_t>> ret{};
+            ret.reserve(num_retained());
+            for(size_t h = 0; h < m_levels.size(); h++) {
+                for(const auto& x : m_levels[h]) {
+                    ret.emplace_back(&x, uint64_t(1) << h);
+                }
+            }
 
-            auto operator()() -> maybe<value_type>
+            std::sort(ret.begin(), ret.end(),
+                      [](const std::pair<const T*, uint64_t>& a,
+                         const std::pair<const T*, uint64_t>& b)
             {
-                // NB: passing map_fn as ref, as it may be stateful (e.g. counting)
-                //return gen().transform(std::ref(map_fn));
+                return lt{}(*a.first, *b.first);
+            });
 
-                auto x = gen();
-                if(!x) {
-                    return { };
-                }
+            return ret;
+        }
+    };
 
-                auto ret = map_fn(std::move(*x));
-                impl::recycle(gen, *x, impl::resolve_overload{});
-                return std::move(ret); // I'd expect copy elision here, but
-                                       // GCC4.9.3 tries to use copy-constructor here
+    template<typename F>
+    struct approx_quantiles_by
+    {
+        const F      key_fn;
+        const size_t k;
+
+        template<typename Iterable,
+                 typename Key = typename std::decay<decltype(key_fn(*std::declval<Iterable&>().begin()))>::type>
+        kll_sketch<Key> operator()(const Iterable& xs) const
+        {
+            kll_sketch<Key> ret{ k };
+            for(const auto& x : xs) {
+                ret.insert(key_fn(x));
             }
-        };
+            return ret;
+        }
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( map_fn )
-        RANGELESS_FN_OVERLOAD_FOR_CONT( map_fn )
-        // Given a container, we return a lazy seq rather than
-        // transforming all elements eagerly, because inputs may be
-        // "small", while outputs may be "large" in terms of 
-        // memory and/or computation, so we want to defer it.
+        template<typename Gen,
+                 typename Key = typename std::decay<decltype(key_fn(std::declval<const typename seq<Gen>::value_type&>()))>::type>
+        kll_sketch<Key> operator()(seq<Gen> xs) const
+        {
+            kll_sketch<Key> ret{ k };
+            for(auto&& x : xs) {
+                ret.insert(key_fn(x));
+            }
+            return ret;
+        }
     };
 
-
     /////////////////////////////////////////////////////////////////////
-    struct sliding_window
+    /// @brief Misra-Gries frequent-items summary (see fn::heavy_hitters_by).
+    ///
+    /// Keeps at most `k` counters. When a new key arrives and all counters
+    /// are taken, every counter is decremented instead (amortized O(1), since
+    /// the total decrement can't exceed the number of inserts), and those
+    /// reaching zero are dropped.
+    ///
+    /// A tracked count underestimates the true count by at most `error_bound()`,
+    /// which is at most `count() / (k + 1)`. Hence any key occurring more than
+    /// `count() / (k + 1)` times is guaranteed to be tracked.
+    template<typename Key>
+    class misra_gries_summary
     {
-        const size_t win_size;
+        using counters_t = std::map<Key, uint64_t>;
 
-        template<typename Iterable>
-        struct gen_c
+        size_t     m_capacity;
+        uint64_t   m_count;
+        uint64_t   m_error;
+        counters_t m_counters;
+
+    public:
+        using key_type = Key;
+
+        explicit misra_gries_summary(size_t k)
+            : m_capacity{ k }
+            , m_count{ 0 }
+            , m_error{ 0 }
+            , m_counters{}
         {
-            using iterator = typename Iterable::iterator;
-            using value_type = view<iterator>;
+            if(k == 0) {
+                RANGELESS_FN_THROW("k must be positive.");
+            }
+        }
 
-                Iterable inps;
-                iterator win_beg;
-                iterator win_end;
-                    bool started;
-            const size_t win_size;
+        /// Number of inserted keys.
+        uint64_t count() const
+        {
+            return m_count;
+        }
 
-            auto operator()() -> maybe<value_type>
-            {                
-                if(!started) {
-                    started = true;
+        /// Max underestimation of the count of any key.
+        uint64_t error_bound() const
+        {
+            return m_error;
+        }
 
-                    win_beg = inps.begin();
-                    win_end = inps.begin();
+        /// Lower bound for the number of occurrences of `key`;
+        /// the upper bound is `count(key) + error_bound()`.
+        uint64_t count(const Key& key) const
+        {
+            const auto it = m_counters.find(key);
+            return it == m_counters.end() ? 0 : it->second;
+        }
 
-                    // advance view's it_end by win_size
-                    size_t n = 0;
-                    for(size_t i = 0; i < win_size && win_end != inps.end(); ++i) {
-                        ++win_end;
-                        ++n;
-                    }
+        void insert(Key key)
+        {
+            ++m_count;
 
-                    if(n < win_size) {
-                        return { };
-                    } else {
-                        return value_type{ win_beg, win_end };
-                    }
+            auto it = m_counters.find(key);
+            if(it != m_counters.end()) {
+                ++it->second;
+            } else if(m_counters.size() < m_capacity) {
+                m_counters.emplace(std::move(key), 1);
+            } else {
+                x_decrement_all(1);
+            }
+        }
+
+        /// Mergeable-summaries merge: add up the counters, then subtract
+        /// the (k+1)'th largest count from all, keeping at most k.
+        void merge(const misra_gries_summary& other)
+        {
+            for(const auto& kv : other.m_counters) {
+                m_counters[kv.first] += kv.second;
+            }
+            m_count += other.m_count;
+            m_error += other.m_error;
+
+            if(m_counters.size() > m_capacity) {
+                std::vector<uint64_t> counts{};
+                counts.reserve(m_counters.size());
+                for(const auto& kv : m_counters) {
+                    counts.push_back(kv.second);
                 }
+                std::nth_element(counts.begin(), counts.begin() + std::ptrdiff_t(m_capacity), counts.end(), std::greater<uint64_t>{});
+                x_decrement_all(counts[m_capacity]);
+            }
+        }
 
-                if(win_end == inps.end()) {
-                    return { };
+        /// Tracked keys and their counts, most frequent first.
+        std::vector<std::pair<Key, uint64_t>> top() const
+        {
+            std::vector<std::pair<Key, uint64_t>> ret(m_counters.begin(), m_counters.end());
+            std::stable_sort(ret.begin(), ret.end(),
+                             [](const std::pair<Key, uint64_t>& a,
+                                const std::pair<Key, uint64_t>& b)
+            {
+                return b.second < a.second;
+            });
+            return ret;
+        }
+
+    private:
+        void x_decrement_all(uint64_t d)
+        {
+            for(auto it = m_counters.begin(); it != m_counters.end(); ) {
+                if(it->second <= d) {
+                    it = m_counters.erase(it);
+                } else {
+                    it->second -= d;
+                    ++it;
                 }
+            }
+            m_error += d;
+        }
+    };
 
-                ++win_beg;
-                ++win_end;
+    template<typename F>
+    struct heavy_hitters_by
+    {
+        const F      key_fn;
+        const size_t k;
 
-                return { { win_beg, win_end } };
+        template<typename Iterable,
+                 typename Key = typename std::decay<decltype(key_fn(*std::declval<Iterable&>().begin()))>::type>
+        misra_gries_summary<Key> operator()(const Iterable& xs) const
+        {
+            misra_gries_summary<Key> ret{ k };
+            for(const auto& x : xs) {
+                ret.insert(key_fn(x));
             }
-        };
+            return ret;
+        }
 
-        template<typename Iterable>
-        auto operator()(Iterable inps) const -> seq<gen_c<Iterable>>
+        template<typename Gen,
+                 typename Key = typename std::decay<decltype(key_fn(std::declval<const typename seq<Gen>::value_type&>()))>::type>
+        misra_gries_summary<Key> operator()(seq<Gen> xs) const
         {
-            impl::require_iterator_category_at_least<std::forward_iterator_tag>(inps);
-            return { { std::move(inps), {}, {}, false, win_size } };
-                          // iterators: ^^  ^^, ^started
+            misra_gries_summary<Key> ret{ k };
+            for(auto&& x : xs) {
+                ret.insert(key_fn(x));
+            }
+            return ret;
         }
+    };
 
-        /////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////
+    /// @brief Count-min sketch (see fn::approx_counts_by).
+    ///
+    /// `depth` rows of `width` counters; a key increments one counter per row
+    /// (selected by double-hashing), and its count is estimated as the minimum
+    /// of its counters. The estimate never underestimates, and with probability
+    /// `1 - exp(-depth)` overestimates by at most `error_bound() = e / width * total()`.
+    ///
+    /// With conservative update, only the counters that are at the minimum are
+    /// incremented, which reduces the overestimation considerably (but the
+    /// sketch then only supports increments).
+    class count_min_sketch
+    {
+        size_t                m_width;
+        size_t                m_depth;
+        bool                  m_conservative;
+        uint64_t              m_total;
+        std::vector<uint64_t> m_counters; // depth x width
 
-        // for seq: buffer win_size elements in a queue
-        template<typename InGen>
-        struct gen
+    public:
+        count_min_sketch(size_t width, size_t depth, bool conservative_update = false)
+            : m_width{ width }
+            , m_depth{ depth }
+            , m_conservative{ conservative_update }
+            , m_total{ 0 }
+            , m_counters{}
+        {
+            if(width == 0 || depth == 0) {
+                RANGELESS_FN_THROW("width and depth must be positive.");
+            }
+            m_counters.resize(width * depth, 0);
+        }
+
+        size_t width() const { return m_width; }
+        size_t depth() const { return m_depth; }
+
+        /// Sum of all inserted counts.
+        uint64_t total() const
         {
-                   InGen gen;
+            return m_total;
+        }
 
-            using inp_t      = typename InGen::value_type;
-            using queue_t    = std::deque<inp_t>;
-            using value_type = view<typename queue_t::iterator>;
+        /// Max overestimation of `count(key)`, with probability `1 - exp(-depth)`.
+        double error_bound() const
+        {
+            return 2.718281828459045 / double(m_width) * double(m_total);
+        }
 
-                 queue_t queue;
-              value_type curr;
-            const size_t win_size;
+        template<typename Key>
+        void insert(const Key& key, uint64_t n = 1)
+        {
+            const uint64_t h = hash64{}(key);
+            m_total += n;
 
-            auto operator()() -> maybe<value_type>
-            {                
-                if(!queue.empty()) {
-                    queue.pop_front();
+            if(!m_conservative) {
+                for(size_t i = 0; i < m_depth; i++) {
+                    m_counters[x_index(h, i)] += n;
                 }
+                return;
+            }
 
-                while(queue.size() < win_size) {
-                    auto x = gen();
-                    if(!x) {
-                        return { };
-                    }
-                    queue.push_back(std::move(*x));
-                }
+            const uint64_t target = x_estimate(h) + n;
+            for(size_t i = 0; i < m_depth; i++) {
+                auto& counter = m_counters[x_index(h, i)];
+                counter = std::max(counter, target);
+            }
+        }
 
-                return { { queue.begin(), queue.end() } };
+        /// Estimated count of `key`: never less than the true count.
+        template<typename Key>
+        uint64_t count(const Key& key) const
+        {
+            return x_estimate(hash64{}(key));
+        }
+
+        /// Throws `std::logic_error` if the dimensions are different.
+        void merge(const count_min_sketch& other)
+        {
+            if(other.m_width != m_width || other.m_depth != m_depth) {
+                RANGELESS_FN_THROW("Can't merge sketches of different dimensions.");
             }
-        };
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( {}, {{}, {}}, win_size )
-    };
+            for(size_t i = 0; i < m_counters.size(); i++) {
+                m_counters[i] += other.m_counters[i];
+            }
+            m_total += other.m_total;
+        }
 
+    private:
+        // Kirsch-Mitzenmacher: i'th hash is h1 + i*h2
+        size_t x_index(uint64_t h, size_t row) const
+        {
+            const uint64_t h2 = mix64(h) | 1;
+            return row * m_width + size_t((h + row * h2) % m_width);
+        }
 
-    /////////////////////////////////////////////////////////////////////
+        uint64_t x_estimate(uint64_t h) const
+        {
+            uint64_t ret = ~uint64_t(0);
+            for(size_t i = 0; i < m_depth; i++) {
+                ret = std::min(ret, m_counters[x_index(h, i)]);
+            }
+            return ret;
+        }
+    };
 
-#if 0
-    Note: leaving the original implementation for reference.
     template<typename F>
-    struct adapt
+    struct approx_counts_by
     {
-        F fn;
+        const F      key_fn;
+        const size_t width;
+        const size_t depth;
+        const bool   conservative_update;
 
-        template<typename Gen>
-        struct gen
+        template<typename Iterable>
+        count_min_sketch operator()(const Iterable& xs) const
         {
-            Gen gen; // upstream nullary generator
-            F fn;    // unary user-function taking the generator (NOT the result)
-
-            auto operator()() -> decltype(fn(gen))
-            {
-                // fn may be taking gen by value [](auto gen){...},
-                // so the state of the original (possibly mutable) gen 
-                // will not be updated. We force passing by-reference here
-                // with reference-wrapper, such that the above construct
-                // in the user code invokes the original gen.
-                return fn(std::ref(gen));
+            count_min_sketch ret{ width, depth, conservative_update };
+            for(const auto& x : xs) {
+                ret.insert(key_fn(x));
             }
-        };
+            return ret;
+        }
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( fn )
-        RANGELESS_FN_OVERLOAD_FOR_CONT( fn )
+        template<typename Gen>
+        count_min_sketch operator()(seq<Gen> xs) const
+        {
+            count_min_sketch ret{ width, depth, conservative_update };
+            for(auto&& x : xs) {
+                ret.insert(key_fn(x));
+            }
+            return ret;
+        }
     };
-#else
 
     /////////////////////////////////////////////////////////////////////
-    // The implementation below was added to enable the user-code (fn)
-    // interrogate the passed gen whether it can yield another value
-    // (so the user-code can wrap-up without throwing), so it prefetches
-    // the next value from in_gen, and the gen-wrapper conversion to 
-    // bool is false iff the prefetched maybe<...> is empty.
+    // Aggregators for incremental_aggregate_by (see fn::agg).
     //
-    // The alternative is to have gen return a maybe<...>,
-    // but we want to isolate the user-code from 
-    // implementation details.
+    // An aggregator defines the per-key accumulator `state<Value>`,
+    // with `result()` method, and insert(state, x) and erase(state, x).
+
     template<typename F>
-    struct adapt
+    struct agg_sum
     {
-        F fn;
+        F val_fn;
 
-        template<typename InGen>
-        struct gen
+        template<typename Value>
+        struct state
         {
-                   InGen in_gen; // upstream nullary generator
-                       F fn;     // unary user-function taking the generator (NOT the result)
+            using result_type = typename std::decay<decltype(std::declval<const F&>()(std::declval<const Value&>()))>::type;
 
-            using inp_t = typename InGen::value_type;
+            result_type sum;
 
-            maybe<inp_t> inp;
-                    bool started;
+            const result_type& result() const
+            {
+                return sum;
+            }
+        };
 
-            // the gen-wrapper that will be passed to fn
-            struct gen_wr
+        template<typename State, typename Value>
+        void insert(State& s, const Value& x) const
+        {
+            s.sum += val_fn(x);
+        }
+
+        template<typename State, typename Value>
+        void erase(State& s, const Value& x) const
+        {
+            s.sum -= val_fn(x);
+        }
+    };
+
+    struct agg_count
+    {
+        template<typename Value>
+        struct state
+        {
+            size_t count;
+
+            size_t result() const
             {
-                gen* parent;
+                return count;
+            }
+        };
 
-                auto operator()() -> inp_t
-                {
-                    assert(parent);
+        template<typename State, typename Value>
+        void insert(State& s, const Value&) const
+        {
+            ++s.count;
+        }
 
-                    if(!parent->inp) {
-                        // user-code called gen() too many times
-                        throw end_seq::exception{};
-                    }
+        template<typename State, typename Value>
+        void erase(State& s, const Value&) const
+        {
+            --s.count;
+        }
+    };
 
-                    auto ret = std::move(*parent->inp);
-                    parent->next();
-                    return ret;
-                }
+    // Min or max is not invertible, so we keep a heap of values, and a heap
+    // of erased values; when the tops are equal, pop both (lazy deletion).
+    // With Comp = std::greater this is a min-heap yielding the min.
+    template<typename F, template<typename> class Comp>
+    struct agg_extremum
+    {
+        F val_fn;
 
-                explicit operator bool() const
-                {
-                    assert(parent);
+        template<typename Value>
+        struct state
+        {
+            using result_type = typename std::decay<decltype(std::declval<const F&>()(std::declval<const Value&>()))>::type;
 
-                    return bool(parent->inp);
-                }
-            };
+            std::vector<result_type> heap;
+            std::vector<result_type> erased;
 
-            void next()
+            const result_type& result() const
             {
-                inp = in_gen();
+                return heap.front();
             }
+        };
 
-            using value_type = decltype(fn(gen_wr{ nullptr }));
+        template<typename State, typename Value>
+        void insert(State& s, const Value& x) const
+        {
+            s.heap.push_back(val_fn(x));
+            std::push_heap(s.heap.begin(), s.heap.end(), Comp<typename State::result_type>{});
+        }
 
-            auto operator()() -> maybe<value_type>
-            {
-                if(!started) {
-                    started = true;
-                    next();
-                }
+        template<typename State, typename Value>
+        void erase(State& s, const Value& x) const
+        {
+            const auto comp = Comp<typename State::result_type>{};
 
-                // user-function fn may throw end-of-inputs,
-                // either explicitly or by invoking gen after
-                // its conversion to bool equals false. We
-                // catch it here and return empty-maybe exactly
-                // as we do in catch_end-wrapper.
-                try { 
-                    return { fn(gen_wr{ this }) };
+            s.erased.push_back(val_fn(x));
+            std::push_heap(s.erased.begin(), s.erased.end(), comp);
 
-                } catch( const end_seq::exception& ) {
-                    return { };
-                }
+            while(!s.erased.empty() && !s.heap.empty() && s.erased.front() == s.heap.front()) {
+                std::pop_heap(s.heap.begin(), s.heap.end(), comp);
+                s.heap.pop_back();
+                std::pop_heap(s.erased.begin(), s.erased.end(), comp);
+                s.erased.pop_back();
             }
-        };
-
-        RANGELESS_FN_OVERLOAD_FOR_SEQ(  fn, {}, false )
-        RANGELESS_FN_OVERLOAD_FOR_CONT( fn, {}, false )
+        }
     };
 
-#endif // adapt
-   
     /////////////////////////////////////////////////////////////////////
-    template<typename Pred>
-    struct take_while
+    /// @brief Per-key aggregates maintained under batches of inserted and erased elements.
+    /// (see fn::incremental_aggregate_by).
+    template<typename Value, typename F, typename Agg>
+    class incremental_aggregate
     {
-        Pred pred;
+    public:
+        using value_type  = Value;
+        using key_type    = typename storable_key<typename std::decay<decltype(std::declval<const F&>()(std::declval<const Value&>()))>::type>::type;
+        using state_type  = typename Agg::template state<Value>;
+        using result_type = typename std::decay<decltype(std::declval<const state_type&>().result())>::type;
+        using results_t   = std::map<key_type, result_type>;
 
-        template<typename InGen>
-        struct gen
+    private:
+        struct entry_t
         {
-            InGen gen;
-             Pred pred;
-             bool found_unsatisfying;
+                size_t count; // number of elements with the key
+            state_type state;
+        };
 
-            using value_type = typename InGen::value_type;
+                              F m_key_fn;
+                            Agg m_agg;
+        std::map<key_type, entry_t> m_entries;
+                      results_t m_results;
 
-            auto operator()() -> maybe<value_type>
-            {
-                if(found_unsatisfying) {
-                    return { };
-                }
+    public:
+        incremental_aggregate(F key_fn, Agg agg)
+            : m_key_fn{ std::move(key_fn) }
+            , m_agg{ std::move(agg) }
+            , m_entries{}
+            , m_results{}
+        {}
 
-                auto x = gen();
-                if(!pred(*x)) {
-                    found_unsatisfying = true;
-                    return { };
-                }
-                return std::move(x);
-            }
-        };
-
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( pred, false )
-
-        template<typename Container>
-        Container operator()(Container cont) const
+        /// Add elements; the cost is proportional to the size of the batch.
+        template<typename Iterable>
+        void insert(Iterable&& batch)
         {
-            auto it = std::find_if_not(cont.begin(), cont.end(), pred);
-            cont.erase(it, cont.end()); 
-            return cont;
+            for(const auto& x : batch) {
+                auto& entry = m_entries.emplace(m_key_fn(x), entry_t{ 0, state_type{} }).first->second;
+                ++entry.count;
+                m_agg.insert(entry.state, x);
+                m_results[m_key_fn(x)] = entry.state.result();
+            }
         }
-    };
-
-    /////////////////////////////////////////////////////////////////////
-    struct take_last
-    {
-        const size_t cap;
 
-        template<typename Gen>
-        auto operator()(seq<Gen> r) const -> std::vector<typename seq<Gen>::value_type>
+        /// Remove elements, that are equal to previously inserted elements
+        /// (for min/max aggregates the values shall compare equal).
+        /// Throws `std::logic_error` if there's no inserted element with the key
+        /// (the preceding elements of the batch remain erased).
+        template<typename Iterable>
+        void erase(Iterable&& batch)
         {
-            // consume all elements, keep last `cap` in the queue
-            std::vector<typename seq<Gen>::value_type> queue;
-
-            queue.reserve(cap);
-
-            size_t i = 0; // count of insertions
+            for(const auto& x : batch) {
+                const auto it = m_entries.find(m_key_fn(x));
+                if(it == m_entries.end()) {
+                    RANGELESS_FN_THROW("Erasing an element with the key of no inserted elements.");
+                }
 
-            for(auto x = r.get_gen()(); x; x = r.get_gen()()) {
-                if(i < cap) {
-                    // NB: can't call queue.resize() because that imposes
-                    // default-constructible on value_type, so instead
-                    // push_back in the beginning.
-                    queue.push_back(std::move(*x));
+                if(--it->second.count == 0) {
+                    m_results.erase(it->first);
+                    m_entries.erase(it);
                 } else {
-                    queue[i % cap] = std::move(*x);
+                    m_agg.erase(it->second.state, x);
+                    m_results[it->first] = it->second.state.result();
                 }
-                ++i;
-            }
-
-            if(cap < i) {
-                // put the contents in proper order.
-                auto it = queue.begin();
-                std::advance(it, i % cap); // oldest inserted element
-                std::rotate(queue.begin(), it, queue.end());
             }
+        }
 
-            return queue;
+        /// Current results: a view of map: key -> result.
+        view<typename results_t::const_iterator> results() const
+        {
+            return { m_results.begin(), m_results.end() };
         }
+    };
 
-        template<typename Iterable>
-        Iterable operator()(Iterable&& inps) const
+    template<typename F, typename Agg>
+    struct incremental_aggregate_by
+    {
+          F key_fn;
+        Agg agg;
+
+        template<typename Iterable,
+                 typename Value = typename std::remove_reference<Iterable>::type::value_type>
+        incremental_aggregate<Value, F, Agg> operator()(Iterable&& src) const
         {
-            // Iterable may be a container or view
-            static_assert(std::is_rvalue_reference<Iterable&&>::value, "");
+            incremental_aggregate<Value, F, Agg> ret{ key_fn, agg };
+            ret.insert(std::forward<Iterable>(src));
+            return ret;
+        }
+    };
 
-            // in case cont is a view:
-            impl::require_iterator_category_at_least<std::forward_iterator_tag>(inps);
-            const auto size = size_t(std::distance(inps.begin(), inps.end()));
+    template<typename F>
+    struct approx_distinct_by
+    {
+        const F      key_fn;
+        const size_t precision;
 
-            if(cap < size) {
-                auto it = inps.begin();
-                std::advance(it, size - cap);
-                inps.erase(inps.begin(), it);
+        template<typename Iterable>
+        hll_sketch operator()(const Iterable& xs) const
+        {
+            hll_sketch ret{ precision };
+            for(const auto& x : xs) {
+                ret.insert(key_fn(x));
             }
-            return std::move(inps);
+            return ret;
         }
 
-        template<typename Container>
-        Container operator()(const Container& cont) const
+        template<typename Gen>
+        hll_sketch operator()(seq<Gen> xs) const
         {
-            Container ret{};
-
-            if(cap < cont.size()) {
-                auto it = cont.begin();
-                std::advance(it, cont.size() - cap);
-                ret.insert(ret.end(), it, cont.end());
+            hll_sketch ret{ precision };
+            for(auto&& x : xs) {
+                ret.insert(key_fn(x));
             }
             return ret;
         }
     };
 
-    /////////////////////////////////////////////////////////////////////////
-    struct drop_last
+    /////////////////////////////////////////////////////////////////////
+    template<typename Pred>
+    struct exists_where
     {
-        const size_t n;
+        const Pred pred;
+              bool ret;
 
-        template<typename InGen>
-        struct gen
+        // e.g. bool ret = vals % !fn::exists_where(pred);
+        exists_where operator!() &&
         {
-            InGen gen;
-           size_t cap;
+            // don't want to make operator! non-const for lvalues,
+            // so instead making it rvalue-specific to prevent
+            // any misuse.
 
-            using value_type = typename InGen::value_type;
-            using vec_t = std::vector<value_type>;
+            ret = !ret;
+            return std::move(*this);
+        }
 
-            vec_t queue;
-           size_t i;
-            
-            auto operator()() -> maybe<value_type>
-            {
-                if(queue.capacity() < cap) {
-                    queue.reserve(cap);
-                }
+        template<typename Iterable>
+        bool operator()(const Iterable& iterable) const
+        {
+            for(const auto& x : iterable)
+                if(pred(x)) 
+                    return ret;
+            return !ret;
+        }
+    };
 
-                while(i < cap) {
-                    auto x = gen();
-                    if(!x) {
-                        return { };
-                    }
-                    queue.push_back(std::move(*x));
-                    ++i;
-                }
-                
-                auto& dest = queue[i++ % cap];
-                auto ret = std::move(dest);
-                auto x = gen();
-                if(!x) {
-                    return { };
-                } else {
-                    dest = std::move(*x);
-                    return { std::move(ret) };
-                }
-            }
-        };
+    // NB[3]: In for_each, foldl, foldl_d, foldl_1 we don't really need
+    // the overloads for seq, because seq is Iterable, but by providing
+    // them we work with underlying gens directly, bypassing the iterator
+    // machinery layer of seq, potentially allowing the compiler to do 
+    // better job with optimization.
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( n, {}, 0 )
+    /////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct for_each
+    {
+        F fn; // may be non-const, hence operator()s are also non-const.
 
         template<typename Iterable>
-        Iterable operator()(Iterable&& inps) const
+        void operator()(Iterable&& src)
         {
-            // Iterable may be a container or view
-            static_assert(std::is_rvalue_reference<Iterable&&>::value, "");
-
-            // in case cont is a view:
-            impl::require_iterator_category_at_least<std::forward_iterator_tag>(inps);
-            const auto size = size_t(std::distance(inps.begin(), inps.end()));
-
-            if(n < size) {
-                auto it = inps.begin();
-                std::advance(it, size - n);
-                inps.erase(it, inps.end());
-            } else {
-                inps.clear();
+            for(auto it = src.begin(); it != src.end(); ++it) {
+                fn(*it);
             }
 
-            return std::move(inps);
+            // Used to return by perfect-forwarding, i.e. 
+            // return-type = Iterable&&, and return std::forward<Iterable>(src);
+            //
+            // The intent was to allow downstream stages
+            // after for_each. However,
+            // 1) If Iterable is a single-pass seq, 
+            //    it's not usable after the loop (will cause runtime error
+            //    if we try to iterate over it again).
+            // 2) -Weffc++ says "should return by value" when 
+            //    Iterable is passed by rvalue.
+            // 
+            // So instead, will treat for_each as lfold-into-void.
         }
 
 
-        template<typename Container>
-        Container operator()(const Container& cont) const
+        // See NB[3]
+        template<typename Gen>
+        void operator()(seq<Gen> src)
         {
-            Container ret{};
-
-            if(n < cont.size()) {
-                auto it = cont.begin();
-                std::advance(it, cont.size() - n);
-                ret.insert(ret.end(), cont.begin(), it);
+            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
+                fn(std::move(*x));
+                impl::recycle(src.get_gen(), *x, impl::resolve_overload{});
             }
-
-            return ret;
         }
     };
 
-    /////////////////////////////////////////////////////////////////////
-    template<typename Pred>
-    struct drop_while
+    template<typename F2>
+    struct for_each_adjacent
     {
-        Pred pred;
+        F2 fn2; // may be non-const, hence operator()s are also non-const.
 
-        template<typename InGen>
-        struct gen
+        template<typename Iterable>
+        void operator()(Iterable&& src)
         {
-            InGen gen;
-             Pred pred;
-             bool found_unsatisfying;
-
-            using value_type = typename InGen::value_type;
-
-            auto operator()() -> maybe<value_type>
-            {
-                auto x = gen();
-                while(!found_unsatisfying && x && pred(*x)) {
-                    x = gen();
-                }
+            impl::require_iterator_category_at_least<std::forward_iterator_tag>(src);
 
-                found_unsatisfying = true;
-                return x;
+            auto it2 = src.begin();
+            if(it2 == src.end()) {
+                return;
             }
-        };
-
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( pred, false )
+            auto it1 = it2;
+            ++it2;
 
-        template<typename Iterable>
-        Iterable operator()(Iterable inps) const
-        {
-            auto it = std::find_if_not(inps.begin(), inps.end(), pred);
-            inps.erase(inps.begin(), it);
-            return inps;
+            for(; it2 != src.end(); it1 = it2, ++it2) {
+                fn2(*it1, *it2);
+            }
         }
     };
 
+
     /////////////////////////////////////////////////////////////////////
-    // used by take_first, drop_first
-    struct call_count_lt
+    template<typename Ret, typename Op>
+    struct foldl
     {
-        const size_t cap;
-        mutable size_t num_calls;
+        Ret init;
+        Op fold_op;
 
-        template<typename T>
-        bool operator()(const T&) const
-        {
-            return num_calls++ < cap;
-        }
-    };
+        template<typename Iterable>
+        Ret operator()(Iterable&& src) && // rvalue-specific because init will be moved-from
+        {                                 // (we have to, because Ret may be move-only)
+
+            static_assert(std::is_same<Ret, decltype(fold_op(std::move(init), *src.begin()))>::value, 
+                         "Type of Init must be the same as the return-type of F");
+    
+            for(auto it = src.begin(); it != src.end(); ++it) {
+                init = fold_op(std::move(init), *it);
+            }
+
+            // NB: can't use std::accumulate because it does not do the std::move(init)
+            // internally until c++20, so it won't compile with move-only types, 
+            // and will make copies for copyable types.
+
+            return std::move(init);
+        }
 
+        // See NB[3]
+        template<typename Gen>
+        Ret operator()(seq<Gen> src) && 
+        {
+            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
+                init = fold_op(std::move(init), std::move(*x));
+                impl::recycle(src.get_gen(), *x, impl::resolve_overload{});
+            }
+            return std::move(init);
+        }
+    };
+            
     /////////////////////////////////////////////////////////////////////
-    template<typename Pred>
-    struct where
+    template<typename Op>
+    struct foldl_d
     {
-        Pred pred; // NB: may be mutable lambda, e.g.
-                   // where([i = 0]() mutable { return i++ < 10; }).
-                   //
-                   // In container-specific overloads will need to
-                   // make a copy and use that to be const-compliant.
+        Op fold_op;
 
-        /////////////////////////////////////////////////////////////////////////
-        template<typename InGen>
-        struct gen
+        struct any
         {
-            InGen gen;
-             Pred pred;
-
-            using value_type = typename InGen::value_type;
-
-            static_assert(std::is_same<decltype(pred(*gen())), bool>::value, "The return value of predicate must be convertible to bool.");
-            // is_convertible<..., bool> would suffice, but if it's not bool there's
-            // a good chance that the user code is inadvertently doing something
-            // the programmer did not intend, so we'll be a little more stringent
-            // to guard against this.
+            template<typename T>
+            operator T() const;
+        };
 
-            auto operator()() -> maybe<value_type>
-            {
-                auto x = gen();
-                while(x && !pred(*x)) {
-                    x = gen();
-                }
+        template<typename Iterable>
+        auto operator()(Iterable&& src) const -> decltype(fold_op(any(), *src.begin()))
+        {
+            using ret_t = decltype(fold_op(any(), *src.begin()));
+            auto ret = ret_t{};
 
-                return x;
+            for(auto it = src.begin(); it != src.end(); ++it) {
+                ret = fold_op(std::move(ret), *it);
             }
-        };
-
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( pred )
 
-        RANGELESS_FN_OVERLOAD_FOR_VIEW( pred ) // could be an InputRange; treating as seq
+            return ret;
+        }
 
-        /////////////////////////////////////////////////////////////////////////
 
-        // If cont is passed as const-reference, 
-        // make another container, copying only the
-        // elements satisfying the predicate.
-        template<typename Container>
-        Container operator()(const Container& cont) const
+        // See NB[3]
+        template<typename Gen>
+        auto operator()(seq<Gen> src) const -> decltype(fold_op(any(), std::move(*src.get_gen()())))
         {
-            Container ret{};
-            auto pred_copy = pred; // in case copy_if needs non-const access 
-            std::copy_if(cont.begin(),
-                         cont.end(), 
-                         std::inserter(ret, ret.end()), 
-                         pred_copy);
+            using ret_t = decltype(fold_op(any(), std::move(*src.get_gen()())));
+            auto ret = ret_t{};
+
+            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
+                ret = fold_op(std::move(ret), std::move(*x));
+                impl::recycle(src.get_gen(), *x, impl::resolve_overload{});
+            }
+
             return ret;
         }
+    };
 
-        // Why the above overload won't bind to non-const-reference args,
-        // necessitating this overload?
-        template<typename Container>
-        Container operator()(Container& cont) const
+    /////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct foldl_1
+    {
+        F fold_op;
+
+        template<typename Iterable>
+        auto operator()(Iterable&& src) const -> decltype(fold_op(std::move(*src.begin()), *src.begin()))
         {
-            const Container& const_cont = cont;
-            return this->operator()(const_cont);
+            auto it = src.begin();
+            auto it_end = src.end();
+
+            if(it == it_end) {
+                RANGELESS_FN_THROW("Expected nonempty.");
+            }
+
+            auto init = *it;
+
+            for(++it; it != it_end; ++it) {
+                init = fold_op(std::move(init), *it);
+            }
+
+            return init;
         }
 
-        // If cont is passed as rvalue-reference,
-        // erase elements not satisfying predicate.
-        // (this also supports the case of container
-        // with move-only value-type).
-        template<typename Container>
-        Container operator()(Container&& cont) const //-> typename std::enable_if<std::is_rvalue_reference<Container&&>::value, Container>::type
+        // See NB[3]
+        template<typename Gen>
+        auto operator()(seq<Gen> src) const -> decltype(fold_op(std::move(*src.get_gen()()), std::move(*src.get_gen()())))
         {
-            static_assert(std::is_rvalue_reference<Container&&>::value, "");
+            auto x1 = src.get_gen()();
 
-            x_EraseFrom(cont, impl::resolve_overload{}); // SFINAE-dispatch to erase-remove or iterate-erase overload.
-            return std::move(cont); // must move, because Container may contain move-only elements
-                                    // (e.g. won't compile otherwise with Container=std::vector<std::unique_ptr<int>>)
+            if(!x1) {
+                RANGELESS_FN_THROW("Expected nonempty.");
+            }
+            
+            auto init = std::move(*x1);
+
+            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
+                init = fold_op(std::move(init), std::move(*x));
+            }
+
+            return init;
         }
+    };
 
-    private:
-        template<typename Container>
-        void x_EraseRemove(Container& cont) const
+    /////////////////////////////////////////////////////////////////////
+    // Pieces for join: chars, c-strings, or anything having data() and size(),
+    // e.g. std::string or string_view.
+    struct str_piece
+    {
+        static size_t size(char)
         {
-            auto pred_copy = pred;
-            cont.erase(
-                std::remove_if(
-                    cont.begin(), cont.end(),
-                    [&pred_copy](const typename Container::value_type& x)
-                    {
-                        return !pred_copy(x);
-                    }),
-                cont.end());
+            return 1;
+        }
 
-           // Using std::not1(pred) instead of the lambda above won't compile:
-           // error: no type named 'argument_type'...
-           // Can't use std::not_fn because that's c++17.
+        static size_t size(const char* s)
+        {
+            return std::char_traits<char>::length(s);
         }
 
+        template<typename Str>
+        static auto size(const Str& s) -> decltype(size_t(s.size()))
+        {
+            return size_t(s.size());
+        }
 
-        // High-priority overload for containers where can call remove_if.
-        template<typename Container>
-        auto x_EraseFrom(Container& cont, pr_high) const -> decltype(void(cont.front()))
-        {                                                         // ^^^^^^^^^^ discussion below
-            // This overload must be made unpalatable to SFINAE unless 
-            // std::remove_if is viable for Container, e.g. feature-checking
-            // as follows:
-            //
-            // A) Can call std::remove:
-            //     -> decltype(void( std::remove(cont.begin(), cont.end(), *cont.begin()) ))
-            //
-            // B) Or simplifying, iterator's reference_type is non-const (assignable),
-            //     -> decltype(void( *cont.begin() = std::move(*cont.begin()) ))
-            //  or -> decltype(std::swap(*cont.begin(), *cont.begin()))
-            //
-            // For a std::map, even though map's value_type is not move-assignable, 
-            // (due to key being const, the lines below should not and would not compile, 
-            // and yet SFINAE still considers this overload viable (??)
-            //
-            //     std::remove(cont.begin(), cont.end(), *cont.begin());
-            //     *cont.begin() = std::move(*cont.begin());
-            //
-            // I'm not sure why SFINAE fails to reject it in the decltype,
-            // resulting in ambiguous resolution of x_EraseFrom.
-            //
-            // Anyway, that's why we're instead feature-testing for SequenceContainer 
-            // based the presence of cont.front()
-            // https://en.cppreference.com/w/cpp/named_req/SequenceContainer
-            //
-            // Update: This is no longer an issue with newer compilers, so this must have been
-            // a compiler bug. However, Leaving the cont.front() check in place for now
-            // to support older compilers.
+        static void append(std::string& out, char c)
+        {
+            out.push_back(c);
+        }
 
-            x_EraseRemove(cont); 
+        static void append(std::string& out, const char* s)
+        {
+            out.append(s);
         }
 
-        // Low-priority overload where remove_if is not viable, but
-        // the container has equal_range method (e.g. set and associative
-        // containers) so it is reasonable to expect that iterate-erase
-        // idiom is applicable.
-        template<typename Container>
-        auto x_EraseFrom(Container& cont, pr_low) const
-          -> decltype(void(
-                cont.equal_range(
-                    std::declval<typename Container::key_type const&>())))
+        template<typename Str>
+        static auto append(std::string& out, const Str& s) -> decltype((void)out.append(s.data(), size_t(s.size())))
         {
-            auto pred_copy = pred;
-            for(auto it = cont.begin(), it_end =cont.end(); 
-                     it != it_end; 
-                     it = pred_copy(*it) ? std::next(it)
-                                         : cont.erase(it))
-            {
-                ;
-            }
+            out.append(s.data(), size_t(s.size()));
         }
 
-        template<typename NotAContainer>
-        static void x_EraseFrom(NotAContainer&, pr_lowest)
+        // Make room for n more chars, growing capacity geometrically
+        // (std::string::reserve is not required to do that).
+        static void reserve_more(std::string& out, size_t n)
         {
-            static_assert(sizeof(NotAContainer) == 0, "The argument to fn::impl::where is expected to be either a seq<...> or a sequence container or an associative container having equal_range method.");
-            TheTypeInQuestionIs<NotAContainer>{};
+            if(out.capacity() - out.size() < n) {
+                out.reserve(std::max(out.size() + n, 2 * out.capacity()));
+            }
         }
     };
 
-    /////////////////////////////////////////////////////////////////////
-    template<typename SortedRange, typename F>
-    struct in_sorted_by
+    struct join
     {
-         const SortedRange& r;
-                 const bool is_subtract; // subtract or intersect r
-        const impl::comp<F> comp;
+        const std::string sep;
 
-        bool operator()(const typename SortedRange::value_type& x) const
+        // Compute the total size first, and allocate once.
+        template<typename Iterable>
+        std::string operator()(const Iterable& src) const
         {
-            return is_subtract ^ std::binary_search(r.begin(), r.end(), x, comp);
+            size_t total = 0;
+            size_t n = 0;
+            for(const auto& x : src) {
+                total += str_piece::size(x);
+                ++n;
+            }
+
+            std::string ret{};
+            ret.reserve(total + (n > 0 ? (n - 1) * sep.size() : 0));
+
+            bool first = true;
+            for(const auto& x : src) {
+                if(!first) {
+                    ret += sep;
+                }
+                first = false;
+                str_piece::append(ret, x);
+            }
+            return ret;
         }
-    };
 
-    /////////////////////////////////////////////////////////////////////
-    template<typename F>
-    struct where_max_by
-    {
-        const F   key_fn;
-        const int use_max; // 1 for max, -1 for use-min
+        template<typename Gen>
+        std::string operator()(seq<Gen> src) const
+        {
+            std::string ret{};
+            bool first = true;
 
-        /////////////////////////////////////////////////////////////////
-        // Note: rather than returning a seq, as with where() or transform(),
-        // we're returning a vector with accumulated results (we had to accumulate
-        // the results somewhere, and there's no point in wrapping back in seq.
-        template<typename InGen,
-                 typename Ret = typename std::vector<typename seq<InGen>::value_type> >
-        auto operator()(seq<InGen> in) const -> Ret
-        {
-            Ret ret{};
-
-            auto& gen = in.get_gen();
-
-            for(auto x = gen(); x; x = gen()) {
-
-                const auto which = ret.empty() ? 0 
-                                 : impl::compare(key_fn(ret.front()), 
-                                                 key_fn(*x)) * use_max;
-                if(which < 0) {
-                    ret.clear();
-                    ret.push_back(std::move(*x));
-
-                } else if(which > 0) {
-                    ;
-                } else {
-                    ret.push_back(std::move(*x));
+            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
+                str_piece::reserve_more(ret, sep.size() + str_piece::size(*x));
+                if(!first) {
+                    ret += sep;
                 }
+                first = false;
+                str_piece::append(ret, *x);
+                impl::recycle(src.get_gen(), *x, impl::resolve_overload{});
             }
+            return ret;
+        }
+    };
 
-            if(ret.capacity() >= ret.size() * 2) {
-                ret.shrink_to_fit();
+    template<typename F>
+    struct join_with
+    {
+        const std::string sep;
+                        F append_fn;
+
+        template<typename Iterable>
+        std::string operator()(const Iterable& src) const
+        {
+            std::string ret{};
+            bool first = true;
+            for(const auto& x : src) {
+                x_append(ret, x, first);
             }
+            return ret;
+        }
 
+        template<typename Gen>
+        std::string operator()(seq<Gen> src) const
+        {
+            std::string ret{};
+            bool first = true;
+            for(auto x = src.get_gen()(); x; x = src.get_gen()()) {
+                x_append(ret, *x, first);
+                impl::recycle(src.get_gen(), *x, impl::resolve_overload{});
+            }
             return ret;
         }
 
-        /////////////////////////////////////////////////////////////////
-        template<typename Container,
-                 typename Ret = std::vector<typename Container::value_type> >
-        Ret operator()(Container cont) const
+    private:
+        template<typename T>
+        void x_append(std::string& out, const T& x, bool& first) const
         {
-            // TODO: Take Container as forwarding reference instead of by value
-            // such that if it is passed by lvalue-reference we don't need to
-            // copy all elements; will only copy the maximal ones.
-            // (copy or move value from the iterator depending on whether 
-            // cont is lvalue or rvalue-reference?)
+            if(!first) {
+                str_piece::reserve_more(out, sep.size());
+                out += sep;
+            }
+            first = false;
 
-            // NB[2]: if we're taking lvalue of key_fn(element),
-            // be mindful that key may contain references to keyed object.
-            // (hopefully const, but we can't even assume that).
-            // (e.g. make_tuple(....) unwraps reference-wrappers and returns
-            // a tuple that may contain references.
-            //
-            // Therefore:
-            // 1) we can't reassign keys, e.g. best_key = max(best_key, current_key),
-            //    as this will assign the internal reference (if non-const)
-            //    or will not compile (if reference is const).
-            //
-            // 2) The value of key may become invalidated if referenced
-            //    element is assigned or moved from (explicitly, or under the hood, 
-            //    e.g. while reallocating when a std::vector is resized in push_back,
-            //    or when the element is moved to a different position by erase-remove
-            //    algorithm.
-           
-            // NB: we could reuse the same logic for both input and Container use-cases,
-            // but having multi-pass capability with Container allows us to do less
-            // memory churn (we only need to move elements-of-interest into ret).
+            // std::string::append grows the capacity geometrically
+            // in the common implementations, so no need to presize.
+            append_fn(out, x);
+        }
+    };
 
-            Ret ret{};
+    /////////////////////////////////////////////////////////////////////////
 
-            if(cont.empty())
-                return ret;
-            
-            auto first_best_it = cont.begin();
-            auto last_best_it  = cont.begin();
-            size_t n = 1; // count of max-elements
+    // define operator() overload composing an input-seq
+    // (gen in OutGen presumed to go first)
+    // Basically, we unwrap the input seq, yanking its gen,
+    // compose our gen over it, and wrap it back into seq.
+#define RANGELESS_FN_OVERLOAD_FOR_SEQ(...)                                 \
+    template<typename InGen>                                               \
+    auto operator()(seq<InGen> in) const -> seq<gen<InGen>>                \
+    {                                                                      \
+        return { { std::move(in.get_gen()), __VA_ARGS__ } };               \
+    }                                                                
 
-            {
-                auto it = cont.begin();
-                for(++it; it != cont.end(); ++it) {
-                    const int which = impl::compare(key_fn(*it), 
-                                                    key_fn(*first_best_it)) * use_max;
-                    if(which < 0) {
-                        ; // not-best
-                    } else if(which > 0) {
-                        // new-best
-                        first_best_it = last_best_it = it;
-                        n = 1;
-                    } else {
-                        last_best_it = it;
-                        n++;
-                    }
-                }
-            }
+    // Default implementation of operator() for cases where 
+    // there's no eager logic for Container-arg, and
+    // we want to treat it the same as seq (overload above)
+    // so we wrap Container as to_seq::gen and do same as above.
+    //
+#define RANGELESS_FN_OVERLOAD_FOR_CONT(...)                                \
+    template<typename Container>                                           \
+    auto operator()(Container cont) const                                  \
+      -> seq<gen<to_seq::gen<Container>>>                                  \
+    {                                                                      \
+        return { { { std::move(cont), { }, false }, __VA_ARGS__ } };       \
+    }                                                                      \
+    //                                ^^^^^^^^^^
+    // NB: it would be better, of course, to specify that `{ }` and `false`
+    // as defaults in declarations of to_seq::gen fields instead of specifying them here,
+    // but GCC-4.9.3 has problems with aggregate initialization in a presence
+    // of field-defaults.
 
-            ret.reserve(n);
-            ret.push_back(std::move(*first_best_it));
-            ++first_best_it;
-            ++last_best_it; // convert to end
 
-            for(auto it = first_best_it; it != last_best_it; ++it) 
-                if(impl::compare(key_fn(*it), 
-                                 key_fn(ret.back())) * use_max >= 0)
+#define RANGELESS_FN_OVERLOAD_FOR_VIEW(...)                                \
+    template<typename Iterator>                                            \
+    auto operator()(view<Iterator> v) const                                \
+     -> seq<gen<to_seq::gen<view<Iterator>>>>                              \
+    {                                                                      \
+        return { { { std::move(v), { }, false }, __VA_ARGS__ } };          \
+    }    
+
+    /////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct transform
+    {
+        F map_fn;
+
+        template<typename InGen>
+        struct gen
+        {
+            InGen gen;
+                F map_fn;
+
+            using value_type = decltype(map_fn(std::move(*gen())));
+
+            static_assert(!std::is_same<value_type, void>::value, "You forgot a return-statement in your transform-function.");
+
+            auto operator()() -> maybe<value_type>
             {
-                ret.push_back(std::move(*it));
-            }
+                // NB: passing map_fn as ref, as it may be stateful (e.g. counting)
+                //return gen().transform(std::ref(map_fn));
 
-            return ret;
-            
-#if 0 // An example of what NOT to do:
-            auto best_key = key_fn(*cont.begin());
-            for(const auto& e : cont) {
-                auto key = key_fn(e);
-                if(impl::compare(best_key, key)*use_max > 0) {
-                    best_key = std::move(key);  // BUG: modifies referenced object via
-                                                // internal non-const references in key.
-                                                // (or will not compile if references are const)
+                auto x = gen();
+                if(!x) {
+                    return { };
+                }
+
+                auto ret = map_fn(std::move(*x));
+                impl::recycle(gen, *x, impl::resolve_overload{});
+                return std::move(ret); // I'd expect copy elision here, but
+                                       // GCC4.9.3 tries to use copy-constructor here
             }
+        };
 
-            return fn::where(
-                    [&, this](const typename Ret::value_type& x)
-                    {
-                        return impl::compare(key_fn(x), best_key)*use_max >= 0;
-                    })(std::forward<Container>(cont));
-            // BUG: best_key may contain a reference, which is invalidated mid-processing
-            // when best-element is moved inside erase-remove loop in fn::where.
-#endif
-        }
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( map_fn )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( map_fn )
+        // Given a container, we return a lazy seq rather than
+        // transforming all elements eagerly, because inputs may be
+        // "small", while outputs may be "large" in terms of 
+        // memory and/or computation, so we want to defer it.
     };
 
-
     /////////////////////////////////////////////////////////////////////
-    struct reverse
+    // Applies char -> char map_fn to the chars of a seq of chars, or, 
+    // given a seq of char_blocks (see fn::from_istream_blocks), 
+    // to the chars of each block in place.
+    //
+    // The result of map_fn is narrowed to char, 
+    // e.g. [](char c){ return std::tolower(c); } returns an int.
+    template<typename F>
+    struct transform_chars
     {
-        template<typename Gen>
-        auto operator()(seq<Gen> r) const -> std::vector<typename seq<Gen>::value_type>
-        {
-            auto vec = to_vector{}(std::move(r));
-            std::reverse(vec.begin(), vec.end());
-            return vec;
-        }
+        F map_fn;
 
-#if 0
-        template<typename Iterable>
-        struct reversed
+        template<typename InGen, 
+                 bool = std::is_same<typename InGen::value_type, char_block>::value>
+        struct gen
         {
-            Iterable src;
-            using value_type     = typename Iterable::value_type;
-            using iterator       = typename Iterable::reverse_iterator;
-            using const_iterator = typename Iterable::const_reverse_iterator;
+            InGen gen;
+                F map_fn;
 
-            iterator begin()
-            {
-                return src.rbegin();
-            }
+            using value_type = char;
 
-            iterator end()
-            {
-                return src.rend();
-            }
+            static_assert(std::is_integral<typename std::decay<decltype(map_fn(char()))>::type>::value,
+                          "Expected a char -> char function.");
 
-            const_iterator begin() const
+            auto operator()() -> maybe<value_type>
             {
-                return src.rbegin();
+                auto x = gen();
+                if(!x) {
+                    return { };
+                }
+                return { static_cast<char>(map_fn(static_cast<char>(*x))) };
             }
+        };
 
-            const_iterator end() const
-            {
-                return src.rend();
-            }
+        template<typename InGen>
+        struct gen<InGen, true>
+        {
+            InGen gen;
+                F map_fn;
 
-            const_iterator cbegin() const
+            using value_type = char_block;
+
+            static_assert(std::is_integral<typename std::decay<decltype(map_fn(char()))>::type>::value,
+                          "Expected a char -> char function.");
+
+            void recycle(value_type& grbg)
             {
-                return src.crbegin();
+                impl::recycle(gen, grbg, impl::resolve_overload{});
             }
 
-            const_iterator cend() const
+            auto operator()() -> maybe<value_type>
             {
-                return src.crend();
+                auto x = gen();
+                if(x) {
+                    for(char& c : *x) {
+                        c = static_cast<char>(map_fn(c));
+                    }
+                }
+                return x;
             }
         };
 
-        template<typename Iterable>
-        reversed<Iterable> operator()(Iterable src) const
-        {
-            return reversed<Iterable>{ std::move(src) };
-        }
-
-#else   // The above approach is more clever, and works for all containers that support bidirectional iteration.
-        // In practice, however, the input is a vector and the user programmer expects the reversed vector as output.
-        // So in the spirit of pragmatism, will expect a reversible sequence container as input, and reverse eagerly.
-        // (Since it costs at least O(n) to create a container, reversing in O(n) does not add
-        // to asymptotic complexity).
-
-        template<typename ReversibleContainer>
-        auto operator()(ReversibleContainer cont) const -> ReversibleContainer
-        {
-            std::reverse(cont.begin(), cont.end()); // compilation hint: expecting ReversibleContainer - consider fn::to_vector() first.
-            return cont;
-        }
-#endif
-
-        template<typename Iterator>
-        view<std::reverse_iterator<Iterator>> operator()(view<Iterator> v) const
-        {
-            impl::require_iterator_category_at_least<std::bidirectional_iterator_tag>(v);
-
-            using rev_it_t = std::reverse_iterator<Iterator>;
-            return { rev_it_t{ v.end()   }, 
-                     rev_it_t{ v.begin() } };
-        }
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( map_fn )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( map_fn )
     };
 
-    // NB: sort and reverse have identical signatures for overloads
-
     /////////////////////////////////////////////////////////////////////
-    // I made a decision to deviate from STL naming convention,
-    // where std::sort is unstable, and made fn::sort/sort_by a stable-sort.
-    // 
-    // I think STL should have followed the principle of least astonishment and made
-    // std::sort a stable-sort, and have an additonal std::unstable_sort version.
-    // (STL is known for its poor names that tend to surprise novice programmers).
-    // That is, by default sort should do "the most right" thing,
-    // and have an differently named (e.g. "unstable_sort") optimizing
-    // version that can make additional assumptions about the inputs.
-    //
-    // In real-life sort_by/group_all_by/unique_all_by use-cases we don't 
-    // simply sort ints or strings where unstable-sort would do; rather,
-    // we sort some objects by some subset of properties, where the sort-key only
-    // partially differentiates between the objects, and a two objects
-    // that are equivalent according to the sort key don't necessarily
-    // compare equal, and so we shouldn't be swapping their relative order.
-    struct stable_sort_tag {};
-    struct unstable_sort_tag {};
-    template<typename F, typename SortTag = stable_sort_tag>
-    struct sort_by
+    // default addr_fn for prefetch: the pointee of a pointer or of a reference_wrapper
+    struct addr_of
     {
-        const F key_fn;
-
-        template<typename Gen>
-        auto operator()(seq<Gen> r) const -> std::vector<typename seq<Gen>::value_type>
-        {
-            return this->operator()(to_vector{}(std::move(r)));
-        }
-
-        template<typename Iterable>
-        Iterable operator()(Iterable src) const
-        {
-            impl::require_iterator_category_at_least<std::random_access_iterator_tag>(src);
-
-            // this will fire if Iterable is std::map, where value_type is std::pair<const Key, Value>,
-            // which is not move-assignable because of constness.
-            static_assert(std::is_move_assignable<typename Iterable::value_type>::value, "value_type must be move-assignable.");
-
-            s_sort( src, 
-                    [this](const typename Iterable::value_type& x, 
-                           const typename Iterable::value_type& y)
-                    {
-                        return lt{}(key_fn(x), key_fn(y));
-                    }
-                    , SortTag{});
-
-            return src;
-        }
-
-    private:
-        template<typename Iterable, typename Comp>
-        static void s_sort(Iterable& src, Comp comp, stable_sort_tag)
+        template<typename T>
+        const T* operator()(const T* p) const
         {
-            std::stable_sort(src.begin(), src.end(), std::move(comp)); // [compilation-error-hint]: expecting sortable container; try fn::to_vector() first.
+            return p;
         }
 
-        template<typename Iterable, typename Comp>
-        static void s_sort(Iterable& src, Comp comp, unstable_sort_tag)
+        template<typename T>
+        const T* operator()(const std::reference_wrapper<T>& r) const
         {
-            std::sort(src.begin(), src.end(), std::move(comp)); // [compilation-error-hint]: expecting sortable container; try fn::to_vector() first.
+            return std::addressof(r.get());
         }
     };
 
-    /////////////////////////////////////////////////////////////////////////
-
-    // NB: initially thought of having stable_sort_by and unstable_sort_by versions,
-    // and for unstable_sort_by/Container use std::sort, and for unstable_sort_by/seq<..>
-    // seq use lazy heap sort. The unstable-ness, however, is different between the two. 
-    // So instead decided to go with lazy_sort_by for both Container and seq<>
-
-    // Initially dump all elements and heapify in O(n);
-    // lazily yield elements with pop_heap in O(log(n))
-    //
-    // TODO: can we make this stable? E.g. falling-back on pointer comparison (probably not)
-    // or keeping a vector of std::pair<decltype(gen()), size_t> where ::second is the 
-    // original ordinal.
     template<typename F>
-    struct lazy_sort_by
+    struct prefetch
     {
-        const F key_fn;
+        const size_t distance;
+                   F addr_fn;
 
         template<typename InGen>
         struct gen
         {
-              InGen gen;
-            const F key_fn;
+            InGen gen;
+           size_t distance;
+                F addr_fn;
 
             using value_type = typename InGen::value_type;
-            using vec_t = std::vector<value_type>;
 
-            static_assert(std::is_move_assignable<value_type>::value, "value_type must be move-assignable.");
-
-            vec_t heap;
-             bool heapified;
+            // ring-buffer of the lookahead elements, that were prefetched
+            std::vector<value_type> ring;
+                             size_t head;        // the oldest element in the ring
+                             size_t num_drained; // after the inputs ended
+                               bool ended;
 
             auto operator()() -> maybe<value_type>
             {
-                auto op_gt = [this](const value_type& x, 
-                                    const value_type& y)
-                {
-                    return lt{}(key_fn(y), key_fn(x));
-                };
-
-                if(!heapified) {
-                    assert(heap.empty());
-                    heapified = true;
+                while(!ended && ring.size() < distance) { // filling-up initially
+                    if(ring.empty()) {
+                        ring.reserve(distance);
+                    }
 
-                    // TODO: if gen is to_gen wrapper, move elements
-                    // directly from the underlying Iterable.
-                    for(auto x = gen(); x; x = gen()) {
-                        heap.push_back(std::move(*x));
+                    auto x = gen();
+                    if(!x) {
+                        ended = true;
+                        break;
                     }
+                    x_prefetch(*x);
+                    ring.push_back(std::move(*x));
+                }
+
+                if(!ended) {
+                    auto x = gen();
+                    if(x) {
+                        if(ring.empty()) { // distance == 0
+                            return x;
+                        }
 
-                    std::make_heap(heap.begin(), heap.end(), op_gt);
+                        // yield the oldest element, and put the new one in its place
+                        x_prefetch(*x);
+                        using std::swap;
+                        swap(*x, ring[head]);
+                        head = head + 1 < ring.size() ? head + 1 : 0;
+                        return x;
+                    }
+                    ended = true;
                 }
 
-                if(heap.empty()) {
+                if(num_drained == ring.size()) {
                     return { };
                 }
 
-                std::pop_heap(heap.begin(), heap.end(), op_gt);
-                auto ret = std::move(heap.back());
-                heap.pop_back();
+                auto ret = std::move(ring[head]);
+                head = head + 1 < ring.size() ? head + 1 : 0;
+                ++num_drained;
                 return { std::move(ret) };
             }
+
+            void x_prefetch(const value_type& x)
+            {
+#if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(static_cast<const void*>(addr_fn(x)));
+#else
+                (void)x;
+#endif
+            }
         };
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ(  key_fn, {}, false )
-        RANGELESS_FN_OVERLOAD_FOR_CONT( key_fn, {}, false )
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(  distance, addr_fn, {}, 0, 0, false )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( distance, addr_fn, {}, 0, 0, false )
     };
 
     /////////////////////////////////////////////////////////////////////
-    template<typename F>
-    struct take_top_n_by
+    // Contiguous chars of a std::string, string_view, std::vector<char>, etc.
+    template<typename Chars>
+    auto chars_as_string_view(const Chars& s, pr_high) -> decltype(string_view(s.data(), size_t(s.size())))
     {
-        const F      key_fn;
-        const size_t capacity;
+        return string_view(s.data(), size_t(s.size()));
+    }
 
-        template<typename Iterable>
-        auto operator()(Iterable src) const -> std::vector<typename Iterable::value_type>
-        {
-            // TODO: if Iterable is a vector, do partial-sort, decreasing, take_first(n), and reverse.
-            //
-            // Take by forwarding-reference here instead of by-value?
-            // (Same question as in where_max_by)
+    // ... or of a view of contiguous chars (e.g. fn::cfrom(str)).
+    template<typename Iterator>
+    struct is_contiguous_chars_iterator : std::integral_constant<bool,
+           std::is_same<Iterator, const char*>::value
+        || std::is_same<Iterator, char*>::value
+        || std::is_same<Iterator, std::string::const_iterator>::value
+        || std::is_same<Iterator, std::string::iterator>::value
+        || std::is_same<Iterator, std::vector<char>::const_iterator>::value
+        || std::is_same<Iterator, std::vector<char>::iterator>::value>
+    {};
 
-            using value_type = typename Iterable::value_type;
+    template<typename Iterator>
+    string_view chars_as_string_view(const view<Iterator>& v, pr_low)
+    {
+        static_assert(is_contiguous_chars_iterator<Iterator>::value,
+                      "Expected a view of contiguous chars, e.g. of a std::string or std::vector<char>.");
 
-            // this will fire if Iterable is std::map, where value_type is std::pair<const Key, Value>,
-            // which is not move-assignable because of constness.
-            static_assert(std::is_move_assignable<value_type>::value, "value_type must be move-assignable.");
+        return v.begin() == v.end() ? string_view{} 
+                                    : string_view(&*v.begin(), size_t(v.end() - v.begin()));
+    }
 
-            auto op_gt = [this](const value_type& x, 
-                                const value_type& y)
-            {
-                return lt{}(key_fn(y), key_fn(x));
-            };
+    template<typename Chars>
+    struct is_chars_view : std::false_type
+    {};
 
-            // NB: can't use priority_queue, because it provides 
-            // const-only exposition of elements, so we can't use
-            // it with move-only types.
+    template<>
+    struct is_chars_view<string_view> : std::true_type
+    {};
 
-            std::vector<value_type> heap{};  // min-heap, (min at front)
-            heap.reserve(capacity);
+    template<typename Iterator>
+    struct is_chars_view<view<Iterator>> : std::true_type
+    {};
 
-            if(capacity > 0)
-                for(auto&& x : src)
-                    if(heap.size() < capacity || lt{}(key_fn(heap.front()), key_fn(x)))
-            {
-                if(heap.size() >= capacity) {
-                    std::pop_heap(heap.begin(), heap.end(), op_gt);
-                    heap.pop_back();
-                }
+    // Delimiters for split: find the position of the next delimiter in s[pos, n), or n.
 
-                heap.push_back(std::move(x));
-                std::push_heap(heap.begin(), heap.end(), op_gt);
-            }
+    struct char_delim
+    {
+        char delim;
 
-            std::sort_heap(heap.begin(), heap.end(), op_gt);
-            std::reverse(heap.begin(), heap.end());
-            
-            return heap;
+        size_t find(const char* s, size_t pos, size_t n) const
+        {
+            // memchr is vectorized in the common libc implementations.
+            const void* const p = pos < n ? std::memchr(s + pos, delim, n - pos) : nullptr;
+            return p ? size_t(static_cast<const char*>(p) - s) : n;
         }
     };
 
-    /////////////////////////////////////////////////////////////////////
-    template<typename F, typename BinaryPred = impl::eq>
-    struct group_adjacent_by
+    template<typename Pred>
+    struct pred_delim
     {
-        // We parametrize to both key_fn and pred2 to reuse
-        // this for both
-        // group_adjacent_by: key_fn:user-provided,      pred2=impl::eq
-        // group_adjacent_if: key_fn=impl::by::identity, pred2:user-provided.
-        
-                 const F key_fn;
-        const BinaryPred pred2;
+        Pred is_delim;
 
-        /////////////////////////////////////////////////////////////////////
-        // A simple version that accumulates equivalent-group in a vector, 
-        // and yield vector_t. This makes it easy to deal-with (no seq-of
-        // seqs), but it needs to allocate a return std::vector per-group.
-        // (Edit: unless the use-case supports recycling (see below))
-        //
-        template<typename InGen>
-        struct gen
+        size_t find(const char* s, size_t pos, size_t n) const
         {
-                          InGen gen;
-                        const F key_fn;
-               const BinaryPred pred2;
-
-            using inp_t      = typename InGen::value_type;
-
-            using value_type = typename std::conditional<
-                                    std::is_same<inp_t, char>::value, 
-                                        std::string, 
-                                        std::vector<inp_t> >::type;
+            while(pos < n && !is_delim(s[pos])) {
+                ++pos;
+            }
+            return pos;
+        }
+    };
 
-            static_assert(std::is_move_assignable<value_type>::value, "value_type must be move-assignable.");
+    /////////////////////////////////////////////////////////////////////
+    template<typename Delim>
+    struct split
+    {
+        Delim delim;
+         bool drop_empty_tokens;
+         bool trim;
 
+        split&& drop_empty() &&
+        {
+            drop_empty_tokens = true;
+            return std::move(*this);
+        }
 
-            value_type next;
-            value_type garbage;
+        split&& trim_blanks() &&
+        {
+            trim = true;
+            return std::move(*this);
+        }
 
-            // instead of allocating a new vector, the caller, prior to calling
-            // the operator(), may choose to disown existing vector so we can
-            // reuse its internal storage
+        struct gen
+        {
+         string_view src;
+               Delim delim;
+                bool drop_empty_tokens;
+                bool trim;
+              size_t pos;  // start of the next token
+                bool done;
 
-            void recycle(value_type& grbg)
-            {
-                garbage = std::move(grbg);
-            }
+            using value_type = string_view;
 
             auto operator()() -> maybe<value_type>
             {
-                // NB: number of calls to key_fn shall be max(0, 2*(n-1))
-                // (as required by fn::chunker)
+                const string_view& s = src;
 
-                auto curr = std::move(next);
-                next = std::move(garbage);
-                next.clear(); // clearing does not deallocate internal storage
+                while(!done) {
+                    size_t b = pos;
+                    size_t e = delim.find(s.data(), pos, s.size());
 
-                for(auto x = gen(); x; x = gen()) {
-                    if(curr.empty() || pred2(key_fn(curr.back()), key_fn(*x))) {
-                        curr.push_back(std::move(*x));
-                    } else {
-                        next.push_back(std::move(*x));
-                        break;
+                    done = e == s.size();
+                    pos = e + 1;
+
+                    while(trim && b < e && s[b] == ' ') {
+                        ++b;
+                    }
+                    while(trim && b < e && s[e-1] == ' ') {
+                        --e;
                     }
-                }
 
-                if(curr.empty()) {
-                    return { };
+                    if(b < e || !drop_empty_tokens) {
+                        return { string_view(s.data() + b, e - b) };
+                    }
                 }
-                
-                return std::move(curr);
+                return { };
             }
         };
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( key_fn, pred2, {}, {} )
+        // The tokens are views into src, so we don't take ownership of it;
+        // a temporary container is rejected, as the tokens would dangle.
+        template<typename Chars>
+        auto operator()(Chars&& src) const -> seq<gen>
+        {
+            static_assert(std::is_lvalue_reference<Chars>::value 
+                       || is_chars_view<typename std::decay<Chars>::type>::value,
+                          "fn::split: the tokens would dangle - split an lvalue, or a fn::string_view of it.");
 
-        // view may be an InputRange, so treat as seq.
-        RANGELESS_FN_OVERLOAD_FOR_VIEW( key_fn, pred2, {}, {} )
+            return { { impl::chars_as_string_view(src, impl::resolve_overload{}), 
+                       delim, drop_empty_tokens, trim, 0, false } };
+        }
+    };
 
-        /////////////////////////////////////////////////////////////////////
-        template<typename Container>
-        auto operator()(Container cont) const -> std::vector<Container>
+
+    /////////////////////////////////////////////////////////////////////
+    struct sliding_window
+    {
+        const size_t win_size;
+
+        template<typename Iterable>
+        struct gen_c
         {
-            // NB: number of calls to key_fn shall be max(0, 2*(n-1))
-            // (see chunker)
+            using iterator = typename Iterable::iterator;
+            using value_type = view<iterator>;
 
-            std::vector<Container> ret;
+                Iterable inps;
+                iterator win_beg;
+                iterator win_end;
+                    bool started;
+            const size_t win_size;
 
-            auto it = cont.begin();
-            const auto it_end = cont.end();
+            auto operator()() -> maybe<value_type>
+            {                
+                if(!started) {
+                    started = true;
 
-            if(it == it_end) {
-                return ret;
-            }
+                    win_beg = inps.begin();
+                    win_end = inps.begin();
 
-            ret.push_back(Container{});
-            ret.back().insert(ret.back().end(), std::move(*it)); // [compilation-error-hint]: Expecting Container's value-type to be end-insertable container.
-            ++it;
+                    // advance view's it_end by win_size
+                    size_t n = 0;
+                    for(size_t i = 0; i < win_size && win_end != inps.end(); ++i) {
+                        ++win_end;
+                        ++n;
+                    }
 
-            for(; it != it_end; ++it) {
-                if(!pred2(key_fn(*ret.back().rbegin()), // NB: last! NB[4]: not crbegin() here, see discussion below
-                          key_fn(*it)))
-                {
-                    ret.push_back(Container{});
+                    if(n < win_size) {
+                        return { };
+                    } else {
+                        return value_type{ win_beg, win_end };
+                    }
                 }
-                auto& dest = ret.back();
-                dest.insert(dest.end(), std::move(*it));
-            }
 
-            // If key_fn is e.g. [](auto&& x){ return std::tie(arg); } 
-            // then the return type will be std::tuple<X&> or std::tuple<const X&> depending
-            // on constness of x, so the args passed to pred2 must be of the same constness,
-            // or it will fail to match to pred2::operator(const T&, const T&)
+                if(win_end == inps.end()) {
+                    return { };
+                }
 
-            return ret;
-        }
-    };
+                ++win_beg;
+                ++win_end;
 
+                return { { win_beg, win_end } };
+            }
+        };
 
-    /////////////////////////////////////////////////////////////////////
-    template<typename F, typename BinaryPred = impl::eq>
-    struct group_adjacent_as_subseqs_by
-    {
-                 const F key_fn;
-        const BinaryPred pred2;
+        template<typename Iterable>
+        auto operator()(Iterable inps) const -> seq<gen_c<Iterable>>
+        {
+            impl::require_iterator_category_at_least<std::forward_iterator_tag>(inps);
+            return { { std::move(inps), {}, {}, false, win_size } };
+                          // iterators: ^^  ^^, ^started
+        }
+
+        /////////////////////////////////////////////////////////////////////
 
+        // for seq: buffer win_size elements in a queue
         template<typename InGen>
         struct gen
         {
-            // subgen for subseq - yield elements of the same group
-            struct subgen
-            {
-                using value_type = typename InGen::value_type;
-                gen* parent;
-
-                maybe<value_type> operator()()
-                {
-                    assert(parent);
-                    return parent->next();
-                }
-            };
-
-            /////////////////////////////////////////////////////////////////
-
-            using element_type = typename InGen::value_type;
-            using value_type = seq<subgen>;
+                   InGen gen;
 
-                          InGen in_gen;
-                        const F key_fn;
-               const BinaryPred pred2;   // returns true iff two elemens belong to same group
-            maybe<element_type> current; // current element of the current group
-                           bool reached_subend; 
+            using inp_t      = typename InGen::value_type;
+            using queue_t    = std::deque<inp_t>;
+            using value_type = view<typename queue_t::iterator>;
 
-            /////////////////////////////////////////////////////////////////
+                 queue_t queue;
+              value_type curr;
+            const size_t win_size;
 
-            maybe<element_type> next() // called from subgen::operator()()
-            {
-                if(!current || reached_subend) {
-                    reached_subend = true;
-                    return {};
+            auto operator()() -> maybe<value_type>
+            {                
+                if(!queue.empty()) {
+                    queue.pop_front();
                 }
 
-                auto nxt = in_gen(); // not "next" to avoid shadow-warning
-                reached_subend = !nxt || !pred2(key_fn(*current), key_fn(*nxt));
-                std::swap(current, nxt);
-                return std::move(nxt);
-            }
-            
-            maybe<value_type> operator()() // return seq for next group
-            {
-                if(!current) { // starting initial group
-                    current = in_gen();
-                } else {
-
-                    // NB: the user-code may have accessed the group only
-                    // partially (or not at all), in which case we must skip
-                    // over the rest elements in the group until we reach 
-                    // the next one.
-                    while(!reached_subend) {
-                        next();
+                while(queue.size() < win_size) {
+                    auto x = gen();
+                    if(!x) {
+                        return { };
                     }
+                    queue.push_back(std::move(*x));
                 }
 
-                if(!current) { // reached final end
-                    return {};
-                }
-
-                reached_subend = false;
-                return { subgen{ this } };
+                return { { queue.begin(), queue.end() } };
             }
         };
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ(  key_fn, pred2, {}, false )
-        RANGELESS_FN_OVERLOAD_FOR_VIEW( key_fn, pred2, {}, false )
-        RANGELESS_FN_OVERLOAD_FOR_CONT( key_fn, pred2, {}, false )
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( {}, {{}, {}}, win_size )
     };
 
 
     /////////////////////////////////////////////////////////////////////
-    // used for in_groups_of(n)
-    struct chunker
+
+#if 0
+    Note: leaving the original implementation for reference.
+    template<typename F>
+    struct adapt
     {
-        const size_t chunk_size;
-        mutable size_t n_calls;
+        F fn;
 
-        template<typename T>
-        size_t operator()(const T&) const
+        template<typename Gen>
+        struct gen
         {
-            // chunker is called with group_adjacent_by.
-            // If we had one call to key_fn per element, 
-            // we could chunk in groups of 10 like
-            // elems % fn::group_adjacent_by([n = 0UL](const auto){ return n++/10; });
-            //
-            // in group_adjacent_by we call the key_fn 2*(n-1) times.
-            return ++n_calls/2/chunk_size;
-        }
+            Gen gen; // upstream nullary generator
+            F fn;    // unary user-function taking the generator (NOT the result)
+
+            auto operator()() -> decltype(fn(gen))
+            {
+                // fn may be taking gen by value [](auto gen){...},
+                // so the state of the original (possibly mutable) gen 
+                // will not be updated. We force passing by-reference here
+                // with reference-wrapper, such that the above construct
+                // in the user code invokes the original gen.
+                return fn(std::ref(gen));
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( fn )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( fn )
     };
+#else
 
     /////////////////////////////////////////////////////////////////////
+    // The implementation below was added to enable the user-code (fn)
+    // interrogate the passed gen whether it can yield another value
+    // (so the user-code can wrap-up without throwing), so it prefetches
+    // the next value from in_gen, and the gen-wrapper conversion to 
+    // bool is false iff the prefetched maybe<...> is empty.
+    //
+    // The alternative is to have gen return a maybe<...>,
+    // but we want to isolate the user-code from 
+    // implementation details.
     template<typename F>
-    struct group_all_by
+    struct adapt
     {
-    private:
-        using group_adjacent_by_t = group_adjacent_by<F>;
+        F fn;
 
-    public:
-        const F key_fn;
+        template<typename InGen>
+        struct gen
+        {
+                   InGen in_gen; // upstream nullary generator
+                       F fn;     // unary user-function taking the generator (NOT the result)
 
-        // group_all_by: convert input to vector, sort by key_fn, 
-        // and delegate to group_adjacent_by::gen
-        //
-        // (could instead delegate to the eager overload below,
-        // since we need to do the sort anyway, but the difference
-        // is that group_adjacent_by will recycle std::vector storage
-        // while yielding groups one by one, rather than having to
-        // allocate a separate std::vector per-group.
+            using inp_t = typename InGen::value_type;
 
-        template<typename Gen>  // Container or seq<...>
-        auto operator()(seq<Gen> inps) const -> 
-            seq<
-                typename group_adjacent_by_t::template gen<
-                    to_seq::gen<
-                        std::vector<typename seq<Gen>::value_type>>>>
-        {
-            return 
-                group_adjacent_by_t{ key_fn, {} }(
-                    impl::to_seq{}(
-                        sort_by<F>{ key_fn }(
-                            impl::to_vector{}(
-                                std::move(inps)))));
-        }
-
-        /////////////////////////////////////////////////////////////////
-        template<typename Container>
-        auto operator()(Container cont) const
-            //-> std::vector<std::vector<typename Container::value_type>>
-            //The above is almost correct, except if Container is a map,
-            //conversion to vector removes the key-constness, so we
-            //need to do it via decltype
-            -> decltype(
-                    group_adjacent_by_t{ key_fn, {} }(
-                        impl::to_vector{}(
-                            std::move(cont))))
-        {
-#if 0 
-            // An example of what not to do
-            using key_t = remove_cvref_t<decltype(key_fn(*cont.begin()))>;
-            std::map<key_t, Container, lt_t> m;
-            for(auto&& x : cont) {
-                auto& dest = m[key_fn(x)];
-                dest.insert(dest.end(), std::move(x)); 
-                // BUG: the key in the map just became invalidated
-                // after move(x), if it contained references to it.
-            }
-            cont.clear(); 
-
-            std::vector<Container> ret;
-            ret.reserve(m.size());
-            for(auto& kv : m) {
-                ret.push_back(std::move(kv.second));
-            }
-            return ret;
-
-            // Can't also implement is as collect elems into
-            // std::set<Container, decltype(opless_by_keyfn_on_element)>,
-            // because if value_type is move-only, we won't be able
-            // to move-out the elements from the set since 
-            // set provides only const access to the elements.
-#else
-            return group_adjacent_by_t{ key_fn, {} }(
-                impl::sort_by<F>{ key_fn }(
-                    impl::to_vector{}(
-                        std::move(cont))));
-#endif
-        }
-    };
+            maybe<inp_t> inp;
+                    bool started;
 
+            // the gen-wrapper that will be passed to fn
+            struct gen_wr
+            {
+                gen* parent;
 
+                auto operator()() -> inp_t
+                {
+                    assert(parent);
 
-    /////////////////////////////////////////////////////////////////////
-    // Flatten a range-of-ranges.
-    // Inverse of group_all_by or group_adjacent_by(original elements are in key-order)
-    //
-    // This is the bind operator for the List monad.
-    //
-    // What do we name this? 
-    //
-    //    Haskell: concat
-    //     Elixir: concat
-    //        Elm: concat
-    //     O'Caml: concat, flatten
-    //      Scala: flatten
-    //    clojure: flatten
-    //     python: chain
-    //          D: chain
-    //         F#: collect
-    // javascript: flat
-    //   range-v3: join
-    //       LINQ: SelectMany
-    //
-    struct concat
-    {
-        template<typename InGen>
-        struct gen
-        {
-            InGen gen;
+                    if(!parent->inp) {
+                        // user-code called gen() too many times
+                        throw end_seq::exception{};
+                    }
 
-            using gen_value_t = typename InGen::value_type;
-            using group_t     = maybe<gen_value_t>;
-                               // via maybe, because might not be default-constructible;
-                               // or could be a seq<...>, holding a closure under the hood,
-                               // rendering the seq not move-assigneable.
+                    auto ret = std::move(*parent->inp);
+                    parent->next();
+                    return ret;
+                }
 
-            using iterator    = typename gen_value_t::iterator;
-            using value_type  = typename gen_value_t::value_type;
+                explicit operator bool() const
+                {
+                    assert(parent);
 
-             group_t current_group;
-            iterator it;
+                    return bool(parent->inp);
+                }
+            };
 
-#if 0       // We don't really need this
+            void next()
+            {
+                inp = in_gen();
+            }
 
-            // -Weffc++ recommends explicit assignment operator because
-            // we have pointer members (presumably current_group), so we
-            // explicitly make this move-only.
-            gen& operator=(gen&&) = default;
-                       gen(gen&&) = default;
-            
-            gen& operator=(const gen&) = delete;
-                       gen(const gen&) = delete;
-#endif
+            using value_type = decltype(fn(gen_wr{ nullptr }));
 
             auto operator()() -> maybe<value_type>
             {
-                if(current_group) {
-                    // NB: we do not return { std::move(*it++) },
-                    // and instead the defer the increment until
-                    // the next call, because the user code consuming ret may have
-                    // side-effects that affect how and whether the
-                    // iterator is advanced, so we don't want to advance
-                    // it prematurely. 
-                    //
-                    // For example, ret's type could be
-                    // some proxy-object that will fetch an object from a stream,
-                    // and the lazy-sequnece's operator++ checks whether
-                    // the stream is empty to check whether it reached end.
-                    ++it;
+                if(!started) {
+                    started = true;
+                    next();
                 }
 
-                while(!current_group || it == (*current_group).end()) {
-                    current_group = gen();
-                    
-                    if(!current_group) {
-                        return { };
-                    }
+                // user-function fn may throw end-of-inputs,
+                // either explicitly or by invoking gen after
+                // its conversion to bool equals false. We
+                // catch it here and return empty-maybe exactly
+                // as we do in catch_end-wrapper.
+                try { 
+                    return { fn(gen_wr{ this }) };
 
-                    it = (*current_group).begin();
+                } catch( const end_seq::exception& ) {
+                    return { };
                 }
-
-                return { std::move(*it) };
             }
         };
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( {}, typename gen<InGen>::iterator() )
-                                    //^^ simply {} does not compile with GCC-4.9.3
-
-        /////////////////////////////////////////////////////////////////
-        
-        template<typename Iterable,
-                 typename Ret = typename Iterable::value_type>
-        Ret operator()(Iterable src) const
-        {
-            // TODO: return a vector instead? What if cont is a set or a map?
-
-            Ret ret{};
-            ret.clear(); // [compilation-error-hint]: Expecting Iterable::value_type to be a container.
-
-            for(auto&& v : src) {
-                ret.insert(ret.end(),
-                           std::make_move_iterator(v.begin()),
-                           std::make_move_iterator(v.end()));
-            }
-
-            return ret;
-        }
-
-        // The case of vector-of-seq can't be handled by the above overload,
-        // because seq can't be end-inserted into.
-        // So we'll wrap container-of-seq into seq, and treat as seq-of-seq.
-        template<typename Gen>
-        auto operator()(std::vector<seq<Gen>> vec_of_seqs) const
-          -> seq<gen< to_seq::gen< std::vector<seq<Gen>> > >>
-        {                       //^^^^^^^^^^^^^^^^^^^^^       input vec
-                     //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^     wrapped as seq
-          //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^  composed with this
-          // TODO: needs a test.
-
-            return { { { std::move(vec_of_seqs) } } };
-        }
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(  fn, {}, false )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( fn, {}, false )
     };
 
-
+#endif // adapt
+   
     /////////////////////////////////////////////////////////////////////
-    template<typename F>
-    struct unique_adjacent_by
+    template<typename Pred>
+    struct take_while
     {
-        const F key_fn;
+        Pred pred;
 
         template<typename InGen>
         struct gen
         {
-              InGen gen;
-            const F key_fn;
+            InGen gen;
+             Pred pred;
+             bool found_unsatisfying;
 
             using value_type = typename InGen::value_type;
 
-            using state_t = maybe<value_type>;
-            // wrapped into maybe, because might not be default-constructible
-
-            state_t next;
-
             auto operator()() -> maybe<value_type>
             {
-                auto curr = std::move(next);
-                next.reset();
-
-                for(auto x = gen(); x; x = gen()) {
-                    if(!curr) {
-                        curr = std::move(x);
-                    } else if( impl::eq{}(key_fn(*curr), key_fn(*x))) {
-                        continue; // skip equivalent elements
-                    } else {
-                        next = std::move(x);
-                        break;
-                    }
+                if(found_unsatisfying) {
+                    return { };
                 }
 
-                return curr;
+                auto x = gen();
+                if(!pred(*x)) {
+                    found_unsatisfying = true;
+                    return { };
+                }
+                return std::move(x);
             }
         };
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( key_fn, {} )
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( pred, false )
 
-        template<typename Iterable>
-        Iterable operator()(Iterable inps) const
+        template<typename Container>
+        Container operator()(Container cont) const
         {
-            impl::require_iterator_category_at_least<std::forward_iterator_tag>(inps);
-
-            inps.erase(
-                std::unique(
-                    inps.begin(), inps.end(),
-                    [this](const typename Iterable::value_type& x, 
-                           const typename Iterable::value_type& y)
-                    {
-                        return impl::eq{}(key_fn(x), key_fn(y));
-                    }),
-                inps.end());
-
-            return inps;
+            auto it = std::find_if_not(cont.begin(), cont.end(), pred);
+            cont.erase(it, cont.end()); 
+            return cont;
         }
     };
 
-
-
     /////////////////////////////////////////////////////////////////////
-    template<typename F>
-    struct unique_all_by
+    struct take_last
     {
-        const F key_fn;
+        const size_t cap;
 
-        template<typename InGen>
-        struct gen
+        template<typename Gen>
+        auto operator()(seq<Gen> r) const -> std::vector<typename seq<Gen>::value_type>
         {
-              InGen gen;
-            const F key_fn; // lifetime of returned key shall be independent of arg.
+            // consume all elements, keep last `cap` in the queue
+            std::vector<typename seq<Gen>::value_type> queue;
 
-            using value_type = typename InGen::value_type;
+            queue.reserve(cap);
 
-            using key_t = typename std::decay<decltype(key_fn(*gen()))>::type; 
-            // key_fn normally yields a const-reference, but we'll be storing 
-            // keys in a map, so need to decay the type (remove_cvref would do).
+            size_t i = 0; // count of insertions
 
-            static_assert(std::is_default_constructible<key_t>::value, "The type returned by key_fn in unique_all_by must be default-constructible and have the lifetime independent of arg.");
-            // In case key_fn returns a reference-wrapper or a tie-tuple containing
-            // a reference, these will become invalidated as keys in the map
-            // when the referenced object goes out of scope, so we guard against
-            // these by requiring default-constructible on key_t.
+            for(auto x = r.get_gen()(); x; x = r.get_gen()()) {
+                if(i < cap) {
+                    // NB: can't call queue.resize() because that imposes
+                    // default-constructible on value_type, so instead
+                    // push_back in the beginning.
+                    queue.push_back(std::move(*x));
+                } else {
+                    queue[i % cap] = std::move(*x);
+                }
+                ++i;
+            }
 
-            using seen_t = std::map<key_t, bool>; 
-            // might as well have used std::set, but to #include fewer things will
-            // repurpose std::map that's already included for other things.
+            if(cap < i) {
+                // put the contents in proper order.
+                auto it = queue.begin();
+                std::advance(it, i % cap); // oldest inserted element
+                std::rotate(queue.begin(), it, queue.end());
+            }
 
-            seen_t seen;
+            return queue;
+        }
+
+        template<typename Iterable>
+        Iterable operator()(Iterable&& inps) const
+        {
+            // Iterable may be a container or view
+            static_assert(std::is_rvalue_reference<Iterable&&>::value, "");
+
+            // in case cont is a view:
+            impl::require_iterator_category_at_least<std::forward_iterator_tag>(inps);
+            const auto size = size_t(std::distance(inps.begin(), inps.end()));
+
+            if(cap < size) {
+                auto it = inps.begin();
+                std::advance(it, size - cap);
+                inps.erase(inps.begin(), it);
+            }
+            return std::move(inps);
+        }
+
+        template<typename Container>
+        Container operator()(const Container& cont) const
+        {
+            Container ret{};
+
+            if(cap < cont.size()) {
+                auto it = cont.begin();
+                std::advance(it, cont.size() - cap);
+                ret.insert(ret.end(), it, cont.end());
+            }
+            return ret;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    struct drop_last
+    {
+        const size_t n;
+
+        template<typename InGen>
+        struct gen
+        {
+            InGen gen;
+           size_t cap;
+
+            using value_type = typename InGen::value_type;
+            using vec_t = std::vector<value_type>;
 
+            vec_t queue;
+           size_t i;
+            
             auto operator()() -> maybe<value_type>
             {
-                auto x = gen();
-
-                if(!x) {
-                    return { };
+                if(queue.capacity() < cap) {
+                    queue.reserve(cap);
                 }
-                auto k = key_fn(*x);
 
-                while(!seen.emplace(std::move(k), true).second) {
-                    x = gen();
+                while(i < cap) {
+                    auto x = gen();
                     if(!x) {
-                        break;
+                        return { };
                     }
-                    k = key_fn(*x);
+                    queue.push_back(std::move(*x));
+                    ++i;
+                }
+                
+                auto& dest = queue[i++ % cap];
+                auto ret = std::move(dest);
+                auto x = gen();
+                if(!x) {
+                    return { };
+                } else {
+                    dest = std::move(*x);
+                    return { std::move(ret) };
                 }
-                return x;
             }
         };
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ( key_fn, {} )
-
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( n, {}, 0 )
 
         template<typename Iterable>
-        auto operator()(Iterable src) const
-          -> decltype( // see the corresponding overload in group_all_by
-                  unique_adjacent_by<F>{ key_fn }(
-                      to_vector{}(
-                          std::move(src))))
+        Iterable operator()(Iterable&& inps) const
         {
-            return unique_adjacent_by<F>{ key_fn }(
-                sort_by<F>{ key_fn }(
-                    to_vector{}(
-                        std::move(src))));
-        }
-    };
+            // Iterable may be a container or view
+            static_assert(std::is_rvalue_reference<Iterable&&>::value, "");
 
+            // in case cont is a view:
+            impl::require_iterator_category_at_least<std::forward_iterator_tag>(inps);
+            const auto size = size_t(std::distance(inps.begin(), inps.end()));
 
-    /////////////////////////////////////////////////////////////////////
-    // Concat a pair of (possibly heterogeous) `Iterables`.
-    template<typename Iterable2>
-    struct append
-    {
-        Iterable2 src2;
+            if(n < size) {
+                auto it = inps.begin();
+                std::advance(it, size - n);
+                inps.erase(it, inps.end());
+            } else {
+                inps.clear();
+            }
 
-        template<typename Iterable1>
-        struct gen
+            return std::move(inps);
+        }
+
+
+        template<typename Container>
+        Container operator()(const Container& cont) const
         {
-                               Iterable1 inps1;
-                               Iterable2 inps2;
-            typename Iterable1::iterator it1;
-            typename Iterable2::iterator it2;
-                                     int which; // 0: not-started; 
-                                                // 1: in range1
-                                                // 2: in range2
-            using value_type = 
-                typename std::common_type<
-                    typename Iterable1::value_type,
-                    typename Iterable2::value_type
-                                         >::type;
+            Container ret{};
 
-            auto operator()() -> maybe<value_type>
-            {
-                return which == 1 && it1 != inps1.end() ? std::move(*it1++)
-                     : which == 2 && it2 != inps2.end() ? std::move(*it2++)
-                     : which == 0 ? (which = 1, it1 = inps1.begin(), (*this)())
-                     : which == 1 ? (which = 2, it2 = inps2.begin(), (*this)())
-                     :              maybe<value_type>{ };
+            if(n < cont.size()) {
+                auto it = cont.begin();
+                std::advance(it, cont.size() - n);
+                ret.insert(ret.end(), cont.begin(), it);
             }
-        };
 
-        template<typename Iterable1>
-        auto operator()(Iterable1 src1) && -> seq<gen<Iterable1>> // rvalue-specific because src2 is moved-from
-        {
-            return { { std::move(src1), std::move(src2), {}, {}, 0 } };
+            return ret;
         }
     };
 
     /////////////////////////////////////////////////////////////////////
-    template<typename Iterable2, typename BinaryFn>
-    struct zip_with
+    template<typename Pred>
+    struct drop_while
     {
-        Iterable2 src2;
-        BinaryFn  fn;
+        Pred pred;
 
-        template<typename Iterable1>
+        template<typename InGen>
         struct gen
         {
-                                BinaryFn fn;
-                               Iterable1 src1;
-                               Iterable2 src2;
-            typename Iterable1::iterator it1;
-            typename Iterable2::iterator it2;
-                                    bool started;
+            InGen gen;
+             Pred pred;
+             bool found_unsatisfying;
 
-            using value_type = decltype(fn(std::move(*it1),
-                                           std::move(*it2)));
+            using value_type = typename InGen::value_type;
 
             auto operator()() -> maybe<value_type>
             {
-                if(!started) {
-                    it1 = src1.begin();
-                    it2 = src2.begin();
-                    started = true;
-                }
-
-                if(it1 == src1.end() || it2 == src2.end()) {
-                    return { };
+                auto x = gen();
+                while(!found_unsatisfying && x && pred(*x)) {
+                    x = gen();
                 }
 
-                auto ret = fn(std::move(*it1), std::move(*it2));
-                ++it1;
-                ++it2;
-                return { std::move(ret) };
+                found_unsatisfying = true;
+                return x;
             }
         };
 
-        template<typename Iterable1>
-        auto operator()(Iterable1 src1) && -> seq<gen<Iterable1>> // rvalue-specific because src2 is moved-from
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( pred, false )
+
+        template<typename Iterable>
+        Iterable operator()(Iterable inps) const
         {
-            return { { std::move(fn), std::move(src1), std::move(src2), {}, {}, false } };
+            auto it = std::find_if_not(inps.begin(), inps.end(), pred);
+            inps.erase(inps.begin(), it);
+            return inps;
         }
     };
 
-    /////////////////////////////////////////////////////////////////////////
-    template<typename BinaryFn>
-    struct zip_adjacent
-    {    
-        BinaryFn fn;
+    /////////////////////////////////////////////////////////////////////
+    // take_while_key_lt, drop_while_key_lt: the prefix with key_fn(x) < bound
+    // is found by binary search, as the range is sorted by the same key_fn.
+    template<typename Key>
+    struct take_while_key_lt
+    {
+        Key bound;
 
-        template<typename Iterable>
-        struct gen
-        {    
-                              BinaryFn fn;
-                              Iterable src; 
-           typename Iterable::iterator it;
-                                  bool started;
+        template<typename Iterable, typename F>
+        sorted_range<Iterable, F> operator()(sorted_range<Iterable, F> src) const
+        {
+            src.erase(x_lower_bound(src), src.end());
+            return src;
+        }
 
-            using value_type = decltype(fn(*it, *it));
+        template<typename Iterable, typename F>
+        auto x_lower_bound(sorted_range<Iterable, F>& src) const -> decltype(src.begin())
+        {
+            const F& key_fn = src.key_fn;
+            return std::lower_bound(src.begin(), src.end(), bound, 
+                [&key_fn](const typename Iterable::value_type& x, const Key& b)
+                {
+                    return lt{}(key_fn(x), b);
+                });
+        }
+    };
 
-            auto operator()() -> maybe<value_type>
-            {    
-                if(!started) {
-                    it = src.begin();
-                    started = true;
-                }    
+    template<typename Key>
+    struct drop_while_key_lt
+    {
+        Key bound;
 
-                auto prev_it = it == src.end() ? it : it++;
+        template<typename Iterable, typename F>
+        sorted_range<Iterable, F> operator()(sorted_range<Iterable, F> src) const
+        {
+            src.erase(src.begin(), take_while_key_lt<Key>{ bound }.x_lower_bound(src));
+            return src;
+        }
+    };
 
-                if(it != src.end()) {
-                    return { fn(*prev_it, *it) };
-                } else {
-                    return { }; 
-                }    
-            }    
-        };   
+    /////////////////////////////////////////////////////////////////////
+    // used by take_first, drop_first
+    struct call_count_lt
+    {
+        const size_t cap;
+        mutable size_t num_calls;
 
-        template<typename Iterable>
-        auto operator()(Iterable src) && -> seq<gen<Iterable>>
-        {    
-            impl::require_iterator_category_at_least<std::forward_iterator_tag>(src);
-            return { { std::move(fn), std::move(src), {}, false } }; 
-        }    
+        template<typename T>
+        bool operator()(const T&) const
+        {
+            return num_calls++ < cap;
+        }
     };
 
-    /////////////////////////////////////////////////////////////////////////
-    template<typename Iterable2, typename BinaryFn>
-    struct cartesian_product_with
+    /////////////////////////////////////////////////////////////////////
+    template<typename Pred>
+    struct where
     {
-        Iterable2 src2;
-        BinaryFn fn;
+        Pred pred; // NB: may be mutable lambda, e.g.
+                   // where([i = 0]() mutable { return i++ < 10; }).
+                   //
+                   // In container-specific overloads will need to
+                   // make a copy and use that to be const-compliant.
 
-        template<typename Iterable1>
+        /////////////////////////////////////////////////////////////////////////
+        template<typename InGen>
         struct gen
         {
-                                BinaryFn fn;
-                               Iterable1 src1;
-                               Iterable2 src2;
-            typename Iterable1::iterator it1;
-            typename Iterable2::iterator it2;
-                                    bool started;
+            InGen gen;
+             Pred pred;
 
-            // Checking against input-range semantics.
-            // Checking against moving iterators (yielding rvalue-references)
-            // because if fn takes a param by value and the iterator yields 
-            // it will be moved-from.
-            static_assert(!std::is_rvalue_reference<decltype(*--it1)>::value, "For cartesian-product expecting upstream iterable to be a bidirectional range yielding lvalue-references or values");
-            static_assert(!std::is_rvalue_reference<decltype(*--it2)>::value, "For cartesian-product expecting parameter-iterable to be a bidirectional range yielding lvalue-references or values");
+            using value_type = typename InGen::value_type;
 
-            using value_type = decltype(fn(*it1, *it2));
+            static_assert(std::is_same<decltype(pred(*gen())), bool>::value, "The return value of predicate must be convertible to bool.");
+            // is_convertible<..., bool> would suffice, but if it's not bool there's
+            // a good chance that the user code is inadvertently doing something
+            // the programmer did not intend, so we'll be a little more stringent
+            // to guard against this.
 
             auto operator()() -> maybe<value_type>
             {
-                if(!started) {
-                    it1 = src1.begin();
-                    it2 = src2.begin();
-                    started = true;
-                    if(it1 == src1.end() || it2 == src2.end()) {
-                        return { };
-                    }
-                }
-
-                while(it2 == src2.end()) {
-                    it2 = src2.begin();
-
-                    ++it1;
-                    if(it1 == src1.end()) {
-                        return { };
-                    }
+                auto x = gen();
+                while(x && !pred(*x)) {
+                    x = gen();
                 }
 
-                auto ret = fn(*it1, *it2);
-                ++it2;
-                return { std::move(ret) };
+                return x;
             }
         };
 
-        template<typename Iterable1>
-        auto operator()(Iterable1 src1) && -> seq<gen<Iterable1>> // rvalue-specific because range2 is moved-from
-        {
-            return { { std::move(fn), std::move(src1), std::move(src2), {}, {}, false } };
-        }
-    };
-
-    /////////////////////////////////////////////////////////////////////////
-
-    struct memoizer_detail
-    {
-        template<class Ret, class Arg>
-        struct lambda_traits_detail
-        {    
-            using ret = Ret; 
-            using arg = Arg;
-        };   
-
-        template<class L>
-        struct lambda_traits
-             : lambda_traits<decltype(&L::operator())>
-        {};
-
-        // NB: not providing non-const version (must be pure)
-        template<class Ret, class Class, class Arg>
-        struct lambda_traits<Ret(Class::*)(Arg) const>
-             : lambda_traits_detail<Ret, Arg>
-        {};
-    };
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( pred )
 
-    template<typename F>
-    struct memoizer
-    {
-        using traits = impl::memoizer_detail::lambda_traits<F>;
-        using    Arg = typename std::remove_reference<typename traits::arg>::type;
-        using    Ret = typename traits::ret;
-        using  Cache = std::map<Arg, Ret>;
+        RANGELESS_FN_OVERLOAD_FOR_VIEW( pred ) // could be an InputRange; treating as seq
 
-        // Even after std::remove_reference the type could be e.g. a 
-        // tuple containing references which may become dangling, 
-        // so to guard against those we're requiring move-assignable.
-        //
-        // Same goes for the output-type, e.g. if return type is a reference-wrapper
-        // we will disallow that to guard against dangling references.
-        //
-        // (also see unique_all_by)
-        static_assert(std::is_default_constructible<Arg>::value, "The argument-type must be default-constructible.");
-        static_assert(std::is_default_constructible<Ret>::value, "The return-type type must be default-constructible.");
+        // A view tagged as sorted: same as above, dropping the tag.
+        template<typename Iterator, typename F>
+        auto operator()(sorted_range<view<Iterator>, F> src) const 
+            -> decltype(std::declval<const where&>()(std::move(src.src)))
+        {
+            return this->operator()(std::move(src.src));
+        }
 
-                    F fn;
-        mutable Cache m; // mutable, because operator() must be const
-                         // e.g. we may be memoizing some key_fn, and 
-                         // those are expected to be const
+        /////////////////////////////////////////////////////////////////////////
 
-        const Ret& operator()(const Arg& arg) const
+        // If cont is passed as const-reference, 
+        // make another container, copying only the
+        // elements satisfying the predicate.
+        template<typename Container>
+        Container operator()(const Container& cont) const
         {
-            static_assert(std::is_same<decltype(arg < arg), bool>::value, "The argument-type must have operator< to be viable as std::map key-type.");
-
-            auto it = m.find(arg);
-            return it != m.end() ? it->second
-                                 : m.emplace(arg, fn(arg)).first->second;
+            Container ret{};
+            auto pred_copy = pred; // in case copy_if needs non-const access 
+            std::copy_if(cont.begin(),
+                         cont.end(), 
+                         std::inserter(ret, ret.end()), 
+                         pred_copy);
+            return ret;
         }
-    };
 
-    /////////////////////////////////////////////////////////////////////////
-    template<typename F>
-    struct scope_guard
-    {
-           F fn;
-        bool dismissed;
+        // Why the above overload won't bind to non-const-reference args,
+        // necessitating this overload?
+        template<typename Container>
+        Container operator()(Container& cont) const
+        {
+            const Container& const_cont = cont;
+            return this->operator()(const_cont);
+        }
 
-        void dismiss()
+        // Structure-of-arrays: the predicate is invoked with row-proxies,
+        // so only the columns it accesses are read.
+        template<typename... Ts>
+        soa_vector<Ts...> operator()(const soa_vector<Ts...>& src) const
         {
-            dismissed = true;
+            soa_vector<Ts...> ret{};
+            auto pred_copy = pred;
+            for(const auto row : src) {
+                if(pred_copy(row)) {
+                    ret.push_back(row);
+                }
+            }
+            return ret;
         }
 
-        ~scope_guard() noexcept(noexcept(fn()))
+        template<typename... Ts>
+        soa_vector<Ts...> operator()(soa_vector<Ts...>&& src) const
         {
-            if(!dismissed)
-                fn(); // NB: it's up to m_fn to decide whether to catch exceptions.
+            auto pred_copy = pred;
+            src.erase_if([&pred_copy](const typename soa_vector<Ts...>::const_reference& row)
+            {
+                return !pred_copy(row);
+            });
+            return std::move(src);
         }
-    };
 
+        // If cont is passed as rvalue-reference,
+        // erase elements not satisfying predicate.
+        // (this also supports the case of container
+        // with move-only value-type).
+        template<typename Container>
+        Container operator()(Container&& cont) const //-> typename std::enable_if<std::is_rvalue_reference<Container&&>::value, Container>::type
+        {
+            static_assert(std::is_rvalue_reference<Container&&>::value, "");
 
-}   // namespace impl
+            x_EraseFrom(cont, impl::resolve_overload{}); // SFINAE-dispatch to erase-remove or iterate-erase overload.
+            return std::move(cont); // must move, because Container may contain move-only elements
+                                    // (e.g. won't compile otherwise with Container=std::vector<std::unique_ptr<int>>)
+        }
 
-    /////////////////////////////////////////////////////////////////////////
+    private:
+        template<typename Container>
+        void x_EraseRemove(Container& cont) const
+        {
+            auto pred_copy = pred;
+            cont.erase(
+                std::remove_if(
+                    cont.begin(), cont.end(),
+                    [&pred_copy](const typename Container::value_type& x)
+                    {
+                        return !pred_copy(x);
+                    }),
+                cont.end());
 
-    template<typename T>
-    using any_seq_t = impl::seq<impl::any_gen<T>>;
+           // Using std::not1(pred) instead of the lambda above won't compile:
+           // error: no type named 'argument_type'...
+           // Can't use std::not_fn because that's c++17.
+        }
 
-    /// @brief Type-erase a `seq`.
-    ///
-    /// Wrap the underlying nullary invokable as std::function.
-    template<typename Gen, typename T = typename Gen::value_type>
-    inline any_seq_t<T> make_typerased(impl::seq<Gen> seq)
-    {
-#if 0
-        return { std::move(seq) };
-#else
-        // seqs's gen(erator) may contain move-only state, 
-        // not satisfying CopyConstructible, so we can't use it
-        // for std::function payload for any_gen.
-        // So we need to first wrap gen as a shared_ptr and create
-        // a copyable gen-wrapper.
-        // (there's only going to be a single instance that 
-        // is used to construct any_seq_t with, so the state
-        // is not actually shared).
 
-        auto gen_ptr = std::make_shared<Gen>( std::move(seq.get_gen()) );
-        return {{ 
-            [gen_ptr]() -> impl::maybe<T>
-            {
-                return (*gen_ptr)();
-            }
-        }};
-#endif
-    }
-
-    /// @defgroup to_vec to_vector/to_seq
-    /// @{
+        // High-priority overload for containers where can call remove_if.
+        template<typename Container>
+        auto x_EraseFrom(Container& cont, pr_high) const -> decltype(void(cont.front()))
+        {                                                         // ^^^^^^^^^^ discussion below
+            // This overload must be made unpalatable to SFINAE unless 
+            // std::remove_if is viable for Container, e.g. feature-checking
+            // as follows:
+            //
+            // A) Can call std::remove:
+            //     -> decltype(void( std::remove(cont.begin(), cont.end(), *cont.begin()) ))
+            //
+            // B) Or simplifying, iterator's reference_type is non-const (assignable),
+            //     -> decltype(void( *cont.begin() = std::move(*cont.begin()) ))
+            //  or -> decltype(std::swap(*cont.begin(), *cont.begin()))
+            //
+            // For a std::map, even though map's value_type is not move-assignable, 
+            // (due to key being const, the lines below should not and would not compile, 
+            // and yet SFINAE still considers this overload viable (??)
+            //
+            //     std::remove(cont.begin(), cont.end(), *cont.begin());
+            //     *cont.begin() = std::move(*cont.begin());
+            //
+            // I'm not sure why SFINAE fails to reject it in the decltype,
+            // resulting in ambiguous resolution of x_EraseFrom.
+            //
+            // Anyway, that's why we're instead feature-testing for SequenceContainer 
+            // based the presence of cont.front()
+            // https://en.cppreference.com/w/cpp/named_req/SequenceContainer
+            //
+            // Update: This is no longer an issue with newer compilers, so this must have been
+            // a compiler bug. However, Leaving the cont.front() check in place for now
+            // to support older compilers.
 
-    /// @brief Move elements of an `Iterable` to std::vector.
-    inline impl::to_vector to_vector()
-    {
-        return {};
-    }
+            x_EraseRemove(cont); 
+        }
 
-    /// @brief Wrap an `Iterable`, taken by value, as `seq` yielding elements by-move.
-    ///
-    /// This is a dual of `to_vector`. It can be used to adapt your own `InputRange` as
-    /// `seq`, but it can also be used to wrap a container to force lazy evaluation
-    /// e.g. `std::move(container) % fn::to_seq() % fn::group_adjacent_by(key_fn) % fn::take_first()`
-    inline impl::to_seq to_seq()
-    {
-        return {};
-    }
+        // Low-priority overload where remove_if is not viable, but
+        // the container has equal_range method (e.g. set and associative
+        // containers) so it is reasonable to expect that iterate-erase
+        // idiom is applicable.
+        template<typename Container>
+        auto x_EraseFrom(Container& cont, pr_low) const
+          -> decltype(void(
+                cont.equal_range(
+                    std::declval<typename Container::key_type const&>())))
+        {
+            auto pred_copy = pred;
+            for(auto it = cont.begin(), it_end =cont.end(); 
+                     it != it_end; 
+                     it = pred_copy(*it) ? std::next(it)
+                                         : cont.erase(it))
+            {
+                ;
+            }
+        }
 
-    /// e.g. `auto set_of_ints = fn::seq(...) % ... % fn::to(std::set<int>{})`;
-    template<typename Container>
-    impl::to<Container> to(Container dest)
-    {
-        return { std::move(dest) };
-    }
+        template<typename NotAContainer>
+        static void x_EraseFrom(NotAContainer&, pr_lowest)
+        {
+            static_assert(sizeof(NotAContainer) == 0, "The argument to fn::impl::where is expected to be either a seq<...> or a sequence container or an associative container having equal_range method.");
+            TheTypeInQuestionIs<NotAContainer>{};
+        }
+    };
 
-    /// @brief return map: value_type -> size_t
-    inline impl::counts counts()
+    /////////////////////////////////////////////////////////////////////
+    // Predicate of fn::where_in_sorted_by and fn::where_not_in_sorted_by.
+    //
+    // NB: operator() is non-const, because the lookups advance a cursor (pos). 
+    // The const where-stage never invokes it; the predicate is copied into
+    // where::gen (or into pred_copy in the container-overloads), such that 
+    // each traversal has its own cursor, starting from r.begin().
+    //
+    // The cursor is an offset rather than an iterator, as r may be modified 
+    // between making the stage and applying it (invalidating the iterators).
+    template<typename SortedRange, typename F>
+    struct in_sorted_by
     {
-        return {};
-    }
+        using iterator = decltype(std::declval<const SortedRange&>().begin());
 
+         const SortedRange& r;
+                 const bool is_subtract; // subtract or intersect r
+        const impl::comp<F> comp;
+                     size_t pos; // offset of the lower-bound found by the previous lookup
 
-    /// @}
-    /// @defgroup transform Transform and Adapt
-    ///
-    /// @{
-
-    /// @brief Create a custom processing-stage function-object.
-    ///
-    /// This is somewhat similar to `fn::transform`, except the correspondence between
-    /// inputs and outputs is not necessarily 1:1, and instead of taking a single element to transform
-    /// we take a nullary generator callable `gen` and use it to fetch however many input elements
-    /// we need to generate the next output element.
-    /// 
-    /// NB: If `bool(gen)==false`, the next invocation of gen() shall throw `fn::end_seq::exception` signaling end-of-inputs.
-    /*!
-    @code
-        auto my_transform = [](auto fn)
+        bool operator()(const typename SortedRange::value_type& x)
         {
-            return fn::adapt([fn = std::move(fn)](auto gen)
-            {
-                return fn(gen());
-            });
-        };
+            return is_subtract ^ x_contains(x, typename std::iterator_traits<iterator>::iterator_category{});
+        }
 
-        auto my_where = [](auto pred)
+    private:
+        bool x_contains(const typename SortedRange::value_type& x, std::forward_iterator_tag)
         {
-            return fn::adapt([pred = std::move(pred)](auto gen)
-            {
-                auto x = gen();
-                while(!pred(x)) {
-                    x = gen();
-                }
-                return x;
-            });
-        };
+            return std::binary_search(r.begin(), r.end(), x, comp);
+        }
 
-        auto my_take_while = [](auto pred)
+        // If the inputs are sorted by the same key too (e.g. tagged with fn::assume_sorted_by),
+        // successive lookups are monotonic, so we search forward from the lower-bound of
+        // the previous lookup with galloping (exponential) search, such that the overall
+        // cost is that of a merge: O(n*log(m/n)) rather than O(n*log(m)). 
+        // Otherwise we start from the beginning, which amounts to binary search.
+        bool x_contains(const typename SortedRange::value_type& x, std::random_access_iterator_tag)
         {
-            return fn::adapt([pred = std::move(pred)](auto gen)
-            {
-                auto x = gen();
-                return pred(x) ? std::move(x) : fn::end_seq();
-            });
-        };
+            const auto b = r.begin();
+            const auto e = r.end();
 
-        auto my_intersperse = [](auto delim)
-        {
-#if 1
-            return [delim = std::move(delim)](auto inputs)
-            {
-                return fn::seq([  delim, 
-                                 inputs = std::move(inputs), 
-                                     it = inputs.end(), 
-                                started = false, 
-                                   flag = false]() mutable
-                {
-                    if(!started) {
-                        started = true;
-                        it = inputs.begin();
-                    }
-                    return it == inputs.end() ? fn::end_seq()
-                         :     (flag = !flag) ? std::move(*it++)
-                         :                      delim;
-                });
-            };
-            
-#elif 0 // or
+            // invariant: elements in [b, lo) are less than x
+            auto lo = pos <= size_t(e - b) ? b + std::ptrdiff_t(pos) : b;
+            if(lo != b && !comp(*(lo - 1), x)) {
+                lo = b;
+            }
 
-            return [delim = std::move(delim)](auto inputs)
-            {
-                return std::move(inputs)
-              % fn::transform([delim](auto inp)
-                {
-                    return std::array<decltype(inp), 2>{{ std::move(inp), delim }};
-                })
-              % fn::concat()
-              % fn::drop_last(); // drop trailing delim
-            };
+            auto hi = lo;
+            for(auto step = e - e + 1; hi != e && comp(*hi, x); step *= 2) {
+                lo = hi + 1;
+                hi = e - lo > step ? lo + step : e;
+            }
 
-#else // or
+            const auto it = std::lower_bound(lo, hi, x, comp);
+            pos = size_t(it - b);
+            return it != e && !comp(x, *it);
+        }
+    };
 
-            return fn::adapt([delim, flag = false](auto gen) mutable
-            {
-                return           !gen ? fn::end_seq() 
-                     : (flag = !flag) ? gen() 
-                     :                  delim;
-            });
-#endif
-        };
+    /////////////////////////////////////////////////////////////////////
+    // A subset of elements of a random-access view, selected by index
+    // (see fn::where_indices). Iterating yields references to the 
+    // selected elements of the original range.
+    template<typename View>
+    struct selection
+    {
+                       View src;
+        std::vector<size_t> indices; // ascending
 
+        using value_type = typename View::value_type;
 
-        auto my_inclusive_scan = []
+        class iterator
         {
-            return fn::adapt([sum = 0](auto gen) mutable
-            {
-                return sum += gen();
-            });
-        };
+            using base_it_t = typename View::iterator;
+            using index_it_t = std::vector<size_t>::const_iterator;
+            using diff_t = typename std::iterator_traits<base_it_t>::difference_type;
 
-        auto res = 
-            fn::seq([i = 0]() mutable
-            {
-                return i++;
-            })                  // 0,1,2,3,...
+            base_it_t  m_base;
+            index_it_t m_it;
 
-          % my_where([](int x)
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = typename std::iterator_traits<base_it_t>::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = typename std::iterator_traits<base_it_t>::pointer;
+            using reference         = typename std::iterator_traits<base_it_t>::reference;
+
+            iterator()
+                : m_base{}
+                , m_it{}
+            {}
+
+            iterator(base_it_t base, index_it_t it) 
+                : m_base( std::move(base) )
+                , m_it( std::move(it) )
+            {}
+
+            reference operator*() const
             {
-                return x >= 3; 
-            })                  // 3,4,5,...
+                return m_base[diff_t(*m_it)];
+            }
 
-          % my_take_while([](int x)
+            iterator& operator++()
             {
-                return x <= 5;
-            })                  // 3,4,5
+                ++m_it;
+                return *this;
+            }
 
-          % my_intersperse(-1)  // 3,-1,4,-1,5
+            iterator operator++(int)
+            {
+                auto ret = *this;
+                ++m_it;
+                return ret;
+            }
 
-          % my_transform([](int x)
+            bool operator==(const iterator& other) const
             {
-                return x + 1;
-            })                  // 4,0,5,0,6
+                return m_it == other.m_it;
+            }
 
-          % my_inclusive_scan() // 4,4,9,9,15
+            bool operator!=(const iterator& other) const
+            {
+                return !(*this == other);
+            }
+        };
 
-          % fn::to_vector();
+        using const_iterator = iterator;
 
-        VERIFY((res == vec_t{{4, 4, 9, 9, 15}}));
-    @endcode
+        iterator begin() const
+        {
+            return { src.begin(), indices.begin() };
+        }
 
-    A more realistic example: suppose you have a pipeline
-    transforming inputs to outputs in parallel, and you want to
-    compress the output, but the outputs are small and compressing
-    them individually would be ineffective, and you want to 
-    serialize the incoming results into a buffer of some minimum
-    size, e.g. 100kb, before passing it to the compressing stage.
-    @code
-        auto make_result     = [](std::string s){ return s; };
-        auto compress_block  = [](std::string s){ return s; };
-        auto write_to_ostr   = [](std::string s){ std::cout << s; };
+        iterator end() const
+        {
+            return { src.begin(), indices.end() };
+        }
 
-        namespace fn = rangeless::fn;
-        using fn::operators::operator%;
+        size_t size() const
+        {
+            return indices.size();
+        }
 
-        fn::seq([&]() -> std::string
+        bool empty() const
         {
-            std::string line;
-            return std::getline(std::cin, line) ? std::move(line) 
-                                                : fn::end_seq();
-        })
+            return indices.empty();
+        }
+    };
 
-      % fn::transform_in_parallel(make_result)
+    template<typename Pred>
+    struct where_indices
+    {
+        Pred pred; // NB: may be mutable lambda (see where)
+
+        // First filter: one pass over all elements, collecting indices of satisfying ones.
+        template<typename Iterator>
+        selection<view<Iterator>> operator()(view<Iterator> v) const
+        {
+            impl::require_iterator_category_at_least<std::random_access_iterator_tag>(v);
+
+            auto pred_copy = pred;
+            std::vector<size_t> indices{};
+            size_t i = 0;
+            for(auto it = v.begin(), it_end = v.end(); it != it_end; ++it, ++i) {
+                if(pred_copy(*it)) {
+                    indices.push_back(i);
+                }
+            }
+            return { std::move(v), std::move(indices) };
+        }
+
+        // The container is referenced rather than owned, so it must be an lvalue
+        // that outlives the selection.
+        template<typename Container>
+        auto operator()(Container& cont) const -> selection<decltype(fn::from(cont))>
+        {
+            return this->operator()(fn::from(cont));
+        }
+
+        // Refinement: one pass over the selected elements only.
+        template<typename View>
+        selection<View> operator()(selection<View> sel) const
+        {
+            using diff_t = typename std::iterator_traits<typename View::iterator>::difference_type;
+
+            auto pred_copy = pred;
+            const auto b = sel.src.begin();
+
+            sel.indices.erase(
+                std::remove_if(
+                    sel.indices.begin(), sel.indices.end(),
+                    [&](size_t i)
+                    {
+                        return !pred_copy(b[diff_t(i)]);
+                    }),
+                sel.indices.end());
+
+            return sel;
+        }
+    };
+
+    // Materialize the selected elements, by move if the underlying
+    // range is non-const (same as fn::from), or by copy otherwise.
+    struct gather
+    {
+        // Taking an rvalue, as the selected elements are moved from the
+        // underlying range (unless it is const): std::move(sel) % fn::gather().
+        template<typename View>
+        std::vector<typename View::value_type> operator()(selection<View>&& sel) const
+        {
+            std::vector<typename View::value_type> ret{};
+            ret.reserve(sel.size());
+            for(auto&& x : sel) {
+                ret.push_back(std::move(x));
+            }
+            return ret;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct where_max_by
+    {
+        const F   key_fn;
+        const int use_max; // 1 for max, -1 for use-min
+
+        /////////////////////////////////////////////////////////////////
+        // Note: rather than returning a seq, as with where() or transform(),
+        // we're returning a vector with accumulated results (we had to accumulate
+        // the results somewhere, and there's no point in wrapping back in seq.
+        template<typename InGen,
+                 typename Ret = typename std::vector<typename seq<InGen>::value_type> >
+        auto operator()(seq<InGen> in) const -> Ret
+        {
+            Ret ret{};
+
+            auto& gen = in.get_gen();
+
+            for(auto x = gen(); x; x = gen()) {
+
+                const auto which = ret.empty() ? 0 
+                                 : impl::compare(key_fn(ret.front()), 
+                                                 key_fn(*x)) * use_max;
+                if(which < 0) {
+                    ret.clear();
+                    ret.push_back(std::move(*x));
+
+                } else if(which > 0) {
+                    ;
+                } else {
+                    ret.push_back(std::move(*x));
+                }
+            }
+
+            if(ret.capacity() >= ret.size() * 2) {
+                ret.shrink_to_fit();
+            }
+
+            return ret;
+        }
+
+        /////////////////////////////////////////////////////////////////
+        template<typename Container,
+                 typename Ret = std::vector<typename Container::value_type> >
+        Ret operator()(Container cont) const
+        {
+            // TODO: Take Container as forwarding reference instead of by value
+            // such that if it is passed by lvalue-reference we don't need to
+            // copy all elements; will only copy the maximal ones.
+            // (copy or move value from the iterator depending on whether 
+            // cont is lvalue or rvalue-reference?)
+
+            // NB[2]: if we're taking lvalue of key_fn(element),
+            // be mindful that key may contain references to keyed object.
+            // (hopefully const, but we can't even assume that).
+            // (e.g. make_tuple(....) unwraps reference-wrappers and returns
+            // a tuple that may contain references.
+            //
+            // Therefore:
+            // 1) we can't reassign keys, e.g. best_key = max(best_key, current_key),
+            //    as this will assign the internal reference (if non-const)
+            //    or will not compile (if reference is const).
+            //
+            // 2) The value of key may become invalidated if referenced
+            //    element is assigned or moved from (explicitly, or under the hood, 
+            //    e.g. while reallocating when a std::vector is resized in push_back,
+            //    or when the element is moved to a different position by erase-remove
+            //    algorithm.
+           
+            // NB: we could reuse the same logic for both input and Container use-cases,
+            // but having multi-pass capability with Container allows us to do less
+            // memory churn (we only need to move elements-of-interest into ret).
+
+            Ret ret{};
+
+            if(cont.empty())
+                return ret;
+            
+            auto first_best_it = cont.begin();
+            auto last_best_it  = cont.begin();
+            size_t n = 1; // count of max-elements
+
+            {
+                auto it = cont.begin();
+                for(++it; it != cont.end(); ++it) {
+                    const int which = impl::compare(key_fn(*it), 
+                                                    key_fn(*first_best_it)) * use_max;
+                    if(which < 0) {
+                        ; // not-best
+                    } else if(which > 0) {
+                        // new-best
+                        first_best_it = last_best_it = it;
+                        n = 1;
+                    } else {
+                        last_best_it = it;
+                        n++;
+                    }
+                }
+            }
+
+            ret.reserve(n);
+            ret.push_back(std::move(*first_best_it));
+            ++first_best_it;
+            ++last_best_it; // convert to end
+
+            for(auto it = first_best_it; it != last_best_it; ++it) 
+                if(impl::compare(key_fn(*it), 
+                                 key_fn(ret.back())) * use_max >= 0)
+            {
+                ret.push_back(std::move(*it));
+            }
+
+            return ret;
+            
+#if 0 // An example of what NOT to do:
+            auto best_key = key_fn(*cont.begin());
+            for(const auto& e : cont) {
+                auto key = key_fn(e);
+                if(impl::compare(best_key, key)*use_max > 0) {
+                    best_key = std::move(key);  // BUG: modifies referenced object via
+                                                // internal non-const references in key.
+                                                // (or will not compile if references are const)
+            }
+
+            return fn::where(
+                    [&, this](const typename Ret::value_type& x)
+                    {
+                        return impl::compare(key_fn(x), best_key)*use_max >= 0;
+                    })(std::forward<Container>(cont));
+            // BUG: best_key may contain a reference, which is invalidated mid-processing
+            // when best-element is moved inside erase-remove loop in fn::where.
+#endif
+        }
+    };
+
+
+    /////////////////////////////////////////////////////////////////////
+    struct reverse
+    {
+        template<typename Gen>
+        auto operator()(seq<Gen> r) const -> std::vector<typename seq<Gen>::value_type>
+        {
+            auto vec = to_vector{}(std::move(r));
+            std::reverse(vec.begin(), vec.end());
+            return vec;
+        }
+
+#if 0
+        template<typename Iterable>
+        struct reversed
+        {
+            Iterable src;
+            using value_type     = typename Iterable::value_type;
+            using iterator       = typename Iterable::reverse_iterator;
+            using const_iterator = typename Iterable::const_reverse_iterator;
+
+            iterator begin()
+            {
+                return src.rbegin();
+            }
+
+            iterator end()
+            {
+                return src.rend();
+            }
+
+            const_iterator begin() const
+            {
+                return src.rbegin();
+            }
+
+            const_iterator end() const
+            {
+                return src.rend();
+            }
+
+            const_iterator cbegin() const
+            {
+                return src.crbegin();
+            }
+
+            const_iterator cend() const
+            {
+                return src.crend();
+            }
+        };
+
+        template<typename Iterable>
+        reversed<Iterable> operator()(Iterable src) const
+        {
+            return reversed<Iterable>{ std::move(src) };
+        }
+
+#else   // The above approach is more clever, and works for all containers that support bidirectional iteration.
+        // In practice, however, the input is a vector and the user programmer expects the reversed vector as output.
+        // So in the spirit of pragmatism, will expect a reversible sequence container as input, and reverse eagerly.
+        // (Since it costs at least O(n) to create a container, reversing in O(n) does not add
+        // to asymptotic complexity).
+
+        template<typename ReversibleContainer>
+        auto operator()(ReversibleContainer cont) const -> ReversibleContainer
+        {
+            std::reverse(cont.begin(), cont.end()); // compilation hint: expecting ReversibleContainer - consider fn::to_vector() first.
+            return cont;
+        }
+#endif
+
+        // no longer sorted: drop the tag.
+        template<typename Iterable, typename F>
+        auto operator()(sorted_range<Iterable, F> src) const -> decltype(std::declval<const reverse&>()(std::move(src.src)))
+        {
+            return this->operator()(std::move(src.src));
+        }
+
+        template<typename Iterator>
+        view<std::reverse_iterator<Iterator>> operator()(view<Iterator> v) const
+        {
+            impl::require_iterator_category_at_least<std::bidirectional_iterator_tag>(v);
+
+            using rev_it_t = std::reverse_iterator<Iterator>;
+            return { rev_it_t{ v.end()   }, 
+                     rev_it_t{ v.begin() } };
+        }
+    };
+
+    // NB: sort and reverse have identical signatures for overloads
+
+    /////////////////////////////////////////////////////////////////////
+    // I made a decision to deviate from STL naming convention,
+    // where std::sort is unstable, and made fn::sort/sort_by a stable-sort.
+    // 
+    // I think STL should have followed the principle of least astonishment and made
+    // std::sort a stable-sort, and have an additonal std::unstable_sort version.
+    // (STL is known for its poor names that tend to surprise novice programmers).
+    // That is, by default sort should do "the most right" thing,
+    // and have an differently named (e.g. "unstable_sort") optimizing
+    // version that can make additional assumptions about the inputs.
+    //
+    // In real-life sort_by/group_all_by/unique_all_by use-cases we don't 
+    // simply sort ints or strings where unstable-sort would do; rather,
+    // we sort some objects by some subset of properties, where the sort-key only
+    // partially differentiates between the objects, and a two objects
+    // that are equivalent according to the sort key don't necessarily
+    // compare equal, and so we shouldn't be swapping their relative order.
+    struct stable_sort_tag {};
+    struct unstable_sort_tag {};
+
+    // Rearrange elements in [first, first + perm.size()) such that
+    // the element at position perm[i] ends up at position i,
+    // following the cycles of the permutation, so that each element
+    // is moved exactly once (plus one temporary per cycle).
+    // NB: perm is reset to identity in the process.
+    template<typename Iterator>
+    void apply_permutation(Iterator first, std::vector<size_t>& perm)
+    {
+        using value_type = typename std::iterator_traits<Iterator>::value_type;
+        using diff_t = typename std::iterator_traits<Iterator>::difference_type;
+
+        for(size_t i = 0; i < perm.size(); i++) {
+            if(perm[i] == i) {
+                continue;
+            }
+
+            value_type tmp = std::move(first[diff_t(i)]);
+            size_t j = i;
+            while(perm[j] != i) {
+                const size_t k = perm[j];
+                first[diff_t(j)] = std::move(first[diff_t(k)]);
+                perm[j] = j;
+                j = k;
+            }
+            first[diff_t(j)] = std::move(tmp);
+            perm[j] = j;
+        }
+    }
+
+    // Normalized-key prefix of a sort-key that starts with a std::string:
+    // the first 8 bytes, zero-padded and big-endian-packed into uint64_t,
+    // such that if the prefixes of two keys compare unequal as integers,
+    // the keys compare the same way; only if they're equal do we need
+    // to compare the keys in full.
+    //
+    // (Only exactly std::string - not things convertible to it,
+    // e.g. const char*, that lt{} would compare as pointers).
+    template<typename S>
+    auto string_key_prefix(const S& s) -> typename std::enable_if<std::is_same<S, std::string>::value, uint64_t>::type
+    {
+        uint64_t ret = 0;
+        for(size_t i = 0; i < 8; i++) {
+            ret = (ret << 8) | (i < s.size() ? uint64_t(static_cast<unsigned char>(s[i])) : 0u);
+        }
+        return ret;
+    }
+
+    template<typename T>
+    auto string_key_prefix(const std::reference_wrapper<T>& r) -> decltype(string_key_prefix(r.get()))
+    {
+        return string_key_prefix(r.get());
+    }
+
+    template<typename T, typename... Ts>
+    auto string_key_prefix(const std::tuple<T, Ts...>& t) -> decltype(string_key_prefix(std::get<0>(t)))
+    {
+        return string_key_prefix(std::get<0>(t));
+    }
+
+    template<typename A, typename B>
+    auto string_key_prefix(const std::pair<A, B>& p) -> decltype(string_key_prefix(p.first))
+    {
+        return string_key_prefix(p.first);
+    }
+
+    // Natural merge sort: find the maximal non-descending and strictly-descending runs,
+    // reversing the latter in-place (which preserves stability, as they contain no ties),
+    // and merge adjacent runs pairwise with std::inplace_merge in O(n*log(r)) for r runs;
+    // O(n) for already-sorted or reverse-sorted inputs.
+    //
+    // Returns false if the inputs turn out not to be presorted (the average run-length
+    // is short), in which case the range is left permuted but not sorted, 
+    // and the caller shall fall back to a regular sort. Since we bail out as soon 
+    // as the run-count exceeds the threshold, the detection costs only
+    // a small fraction of n comparisons on non-presorted inputs.
+    template<typename Iterator, typename Comp>
+    bool natural_merge_sort(Iterator b, Iterator e, Comp comp)
+    {
+        const auto max_runs = size_t(std::distance(b, e)) / 32 + 1;
+
+        std::vector<Iterator> bounds{ b }; // run i is [bounds[i], bounds[i+1])
+        for(auto it = b; it != e; bounds.push_back(it)) {
+            if(bounds.size() > max_runs) {
+                return false;
+            }
+
+            auto next = it + 1;
+
+            if(next == e) {
+                ;
+            } else if(comp(*next, *it)) {
+                ++next;
+                while(next != e && comp(*next, *(next - 1))) {
+                    ++next;
+                }
+                std::reverse(it, next);
+            } else {
+                ++next;
+                while(next != e && !comp(*next, *(next - 1))) {
+                    ++next;
+                }
+            }
+            it = next;
+        }
+
+        while(bounds.size() > 2) {
+            std::vector<Iterator> merged{ bounds.front() };
+            for(size_t i = 2; i < bounds.size(); i += 2) {
+                std::inplace_merge(bounds[i - 2], bounds[i - 1], bounds[i], comp);
+                merged.push_back(bounds[i]);
+            }
+
+            if(merged.back() != bounds.back()) { // odd run-count: last one carries over
+                merged.push_back(bounds.back());
+            }
+            bounds.swap(merged);
+        }
+        return true;
+    }
+
+    // Compute the permutation of indices that stable-sorts [b, b + n) by key_fn.
+    //
+    // If the sort-key starts with a std::string, e.g. an accession, or std::tie(acc, pos),
+    // instead of memcmp-ing strings through pointer-indirection in every comparison,
+    // sort a vector of (normalized-prefix, index) pairs, such that most comparisons
+    // are integer-compares, and compare keys in full only on prefix-ties. 
+    // Ties on keys are broken on index, so the result is stable.
+    template<typename Iterator, typename F>
+    auto sorting_permutation(Iterator b, size_t n, const F& key_fn, pr_high)
+        -> decltype(string_key_prefix(key_fn(*b)), std::vector<size_t>())
+    {
+        using diff_t = typename std::iterator_traits<Iterator>::difference_type;
+
+        struct entry_t
+        {
+            uint64_t prefix;
+              size_t index;
+        };
+
+        std::vector<entry_t> entries;
+        entries.reserve(n);
+        for(size_t i = 0; i < n; i++) {
+            entries.push_back({ string_key_prefix(key_fn(b[diff_t(i)])), i });
+        }
+
+        std::sort(entries.begin(), entries.end(), [&](const entry_t& x, const entry_t& y)
+        {
+            return x.prefix != y.prefix                                         ? x.prefix < y.prefix
+                 : lt{}(key_fn(b[diff_t(x.index)]), key_fn(b[diff_t(y.index)])) ? true
+                 : lt{}(key_fn(b[diff_t(y.index)]), key_fn(b[diff_t(x.index)])) ? false
+                 :                                                                x.index < y.index;
+        });
+
+        std::vector<size_t> perm;
+        perm.reserve(n);
+        for(const auto& e : entries) {
+            perm.push_back(e.index);
+        }
+        return perm;
+    }
+
+    template<typename Iterator, typename F>
+    std::vector<size_t> sorting_permutation(Iterator b, size_t n, const F& key_fn, pr_low)
+    {
+        using diff_t = typename std::iterator_traits<Iterator>::difference_type;
+
+        std::vector<size_t> perm;
+        perm.reserve(n);
+        for(size_t i = 0; i < n; i++) {
+            perm.push_back(i);
+        }
+
+        std::stable_sort(perm.begin(), perm.end(), [&](size_t x, size_t y)
+        {
+            return lt{}(key_fn(b[diff_t(x)]), key_fn(b[diff_t(y)]));
+        });
+        return perm;
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+
+    template<typename F, typename SortTag = stable_sort_tag>
+    struct sort_by
+    {
+        const F key_fn;
+
+        template<typename Gen>
+        auto operator()(seq<Gen> r) const -> std::vector<typename seq<Gen>::value_type>
+        {
+            return this->operator()(to_vector{}(std::move(r)));
+        }
+
+        // re-sorting by possibly another key: drop the sortedness-tag.
+        template<typename Iterable, typename G>
+        Iterable operator()(sorted_range<Iterable, G> src) const
+        {
+            return this->operator()(std::move(src.src));
+        }
+
+        // Structure-of-arrays: sort the row-indices once, with key_fn 
+        // reading only the columns it accesses, and permute every column.
+        template<typename... Ts>
+        soa_vector<Ts...> operator()(soa_vector<Ts...> src) const
+        {
+            src.permute(sorting_permutation(src.cbegin(), src.size(), key_fn, resolve_overload{}));
+            return src;
+        }
+
+        template<typename Iterable>
+        Iterable operator()(Iterable src) const
+        {
+            impl::require_iterator_category_at_least<std::random_access_iterator_tag>(src);
+
+            // this will fire if Iterable is std::map, where value_type is std::pair<const Key, Value>,
+            // which is not move-assignable because of constness.
+            static_assert(std::is_move_assignable<typename Iterable::value_type>::value, "value_type must be move-assignable.");
+
+            // Much of real-life data is presorted, e.g. concatenated sorted
+            // shards, or appended batches: try exploiting the runs first.
+            const bool sorted = natural_merge_sort(src.begin(), src.end(),
+                [this](const typename Iterable::value_type& x, 
+                       const typename Iterable::value_type& y)
+                {
+                    return lt{}(key_fn(x), key_fn(y));
+                });
+
+            if(!sorted) {
+                x_sort(src, resolve_overload{});
+            }
+
+            return src;
+        }
+
+    private:
+
+        // Sort-key starts with a std::string: sort indirectly via normalized prefixes.
+        template<typename Iterable>
+        auto x_sort(Iterable& src, pr_high) const
+            -> decltype(void(string_key_prefix(key_fn(*src.begin()))))
+        {
+            const auto b = src.begin();
+            const auto n = size_t(std::distance(b, src.end()));
+
+            if(n < 16) {
+                x_sort(src, pr_low{});
+                return;
+            }
+
+            auto perm = sorting_permutation(b, n, key_fn, pr_high{});
+            apply_permutation(b, perm);
+        }
+
+        template<typename Iterable>
+        void x_sort(Iterable& src, pr_low) const
+        {
+            s_sort( src, 
+                    [this](const typename Iterable::value_type& x, 
+                           const typename Iterable::value_type& y)
+                    {
+                        return lt{}(key_fn(x), key_fn(y));
+                    }
+                    , SortTag{});
+        }
+
+        template<typename Iterable, typename Comp>
+        static void s_sort(Iterable& src, Comp comp, stable_sort_tag)
+        {
+            std::stable_sort(src.begin(), src.end(), std::move(comp)); // [compilation-error-hint]: expecting sortable container; try fn::to_vector() first.
+        }
+
+        template<typename Iterable, typename Comp>
+        static void s_sort(Iterable& src, Comp comp, unstable_sort_tag)
+        {
+            std::sort(src.begin(), src.end(), std::move(comp)); // [compilation-error-hint]: expecting sortable container; try fn::to_vector() first.
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct sort_by_indirect
+    {
+        const F key_fn;
+
+        template<typename Gen>
+        auto operator()(seq<Gen> r) const -> std::vector<typename seq<Gen>::value_type>
+        {
+            return this->operator()(to_vector{}(std::move(r)));
+        }
+
+        template<typename Iterable, typename G>
+        Iterable operator()(sorted_range<Iterable, G> src) const
+        {
+            return this->operator()(std::move(src.src));
+        }
+
+        template<typename Iterable>
+        Iterable operator()(Iterable src) const
+        {
+            impl::require_iterator_category_at_least<std::random_access_iterator_tag>(src); // [compilation-error-hint]: expecting random-access container; try fn::to_vector() or fn::refs() first.
+
+            using value_type = typename Iterable::value_type;
+            static_assert(std::is_move_constructible<value_type>::value, "value_type must be move-constructible.");
+            static_assert(std::is_move_assignable<value_type>::value, "value_type must be move-assignable.");
+
+            const auto b = src.begin();
+            auto perm = sorting_permutation(b, size_t(std::distance(b, src.end())), key_fn, resolve_overload{});
+            apply_permutation(b, perm);
+
+            return src;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+
+    // NB: initially thought of having stable_sort_by and unstable_sort_by versions,
+    // and for unstable_sort_by/Container use std::sort, and for unstable_sort_by/seq<..>
+    // seq use lazy heap sort. The unstable-ness, however, is different between the two. 
+    // So instead decided to go with lazy_sort_by for both Container and seq<>
+
+    // Incremental quicksort (Paredes & Navarro): initially dump all elements in O(n);
+    // then on each call partition only the leftmost unsorted segment until the
+    // next element is in its final position. Consuming the first k elements
+    // costs O(n + k*log(k)) expected, and consuming all of them amounts
+    // to a regular quicksort.
+    //
+    // The boundaries of the not-yet-sorted segments are kept in a stack;
+    // small segments are finished off with std::sort, and a run of elements
+    // equal to the pivot is marked as sorted, so inputs with many duplicate
+    // keys don't degrade to quadratic.
+    //
+    // The stable flavor keeps the original ordinal with each element and
+    // uses it as the tie-breaker, so all keys become distinct.
+    template<typename F, typename SortTag = unstable_sort_tag>
+    struct lazy_sort_by
+    {
+        const F key_fn;
+
+        template<typename InGen>
+        struct gen
+        {
+              InGen gen;
+            const F key_fn;
+
+            using value_type = typename InGen::value_type;
+
+            static_assert(std::is_move_assignable<value_type>::value, "value_type must be move-assignable.");
+
+            using elem_t = typename std::conditional<
+                                std::is_same<SortTag, stable_sort_tag>::value,
+                                std::pair<value_type, size_t>, // ::second is the original ordinal
+                                value_type >::type;
+
+            struct segment_t
+            {
+                size_t end;
+                  bool sorted; // elements in this segment are in their final positions
+                size_t depth;  // partitioning-levels left before falling back to heapsort
+            };
+
+            std::vector<elem_t> vec;
+            std::vector<segment_t> segments; // ::back() is the leftmost
+                         size_t pos;         // next element to yield
+                         size_t sorted_end;  // [pos, sorted_end) is in final order
+                           bool started;
+
+            auto operator()() -> maybe<value_type>
+            {
+                if(!started) {
+                    started = true;
+                    assert(vec.empty());
+
+                    // TODO: if gen is to_gen wrapper, move elements
+                    // directly from the underlying Iterable.
+                    for(auto x = gen(); x; x = gen()) {
+                        s_push_back(vec, std::move(*x), SortTag{});
+                    }
+
+                    pos = 0;
+                    sorted_end = 0;
+
+                    if(!vec.empty()) {
+                        // introsort-style depth limit: 2*log2(n)
+                        size_t depth = 0;
+                        for(size_t n = vec.size(); n > 1; n /= 2) {
+                            depth += 2;
+                        }
+                        segments.push_back({ vec.size(), false, depth });
+                    }
+                }
+
+                while(pos == sorted_end) {
+                    if(segments.empty()) {
+                        assert(pos == vec.size());
+                        vec.clear();
+                        pos = 0;
+                        sorted_end = 0;
+                        return { };
+                    }
+                    const auto seg = segments.back();
+                    segments.pop_back();
+
+                    if(!seg.sorted) {
+                        x_partition(seg.end, seg.depth);
+                    } else {
+                        sorted_end = seg.end;
+                    }
+                }
+
+                return { std::move(s_value(vec[pos++], SortTag{})) };
+            }
+
+        private:
+            static const size_t s_small_segment = 16;
+
+            void x_partition(const size_t end, const size_t depth)
+            {
+                auto op_lt = [this](const elem_t& x, const elem_t& y)
+                {
+                    return this->x_lt(x, y, SortTag{});
+                };
+
+                const auto b = vec.begin() + static_cast<std::ptrdiff_t>(pos);
+                const auto e = vec.begin() + static_cast<std::ptrdiff_t>(end);
+
+                if(end - pos <= s_small_segment) {
+                    std::sort(b, e, op_lt);
+                    sorted_end = end;
+                    return;
+                }
+
+                // Too many unbalanced partitions (e.g. adversarial inputs for
+                // the median-of-3): heapsort the segment for O(n*log(n)) worst-case.
+                if(depth == 0) {
+                    std::make_heap(b, e, op_lt);
+                    std::sort_heap(b, e, op_lt);
+                    sorted_end = end;
+                    return;
+                }
+
+                // median-of-3 pivot, moved to the last position of the segment
+                auto m = b + (e - b) / 2;
+                auto l = e - 1;
+                if(op_lt(*m, *b)) { std::iter_swap(m, b); }
+                if(op_lt(*l, *b)) { std::iter_swap(l, b); }
+                if(op_lt(*m, *l)) { std::iter_swap(m, l); }
+                
+                const auto& pivot = *l;
+
+                auto p = std::partition(b, l, [&](const elem_t& x)
+                {
+                    return op_lt(x, pivot);
+                });
+
+                if(p != b) {
+                    std::iter_swap(p, l);
+                    const auto p_pos = static_cast<size_t>(p - vec.begin());
+
+                    if(p_pos + 1 < end) {
+                        segments.push_back({ end, false, depth - 1 });
+                    }
+                    segments.push_back({ p_pos + 1, true, 0 });
+                    segments.push_back({ p_pos, false, depth - 1 });
+                    return;
+                }
+
+                // The pivot is the smallest; separate out the elements equal to
+                // it: they are in their final positions at the front of the segment.
+                auto q = std::partition(b, l, [&](const elem_t& x)
+                {
+                    return !op_lt(pivot, x);
+                });
+
+                std::iter_swap(q, l);
+                const auto q_pos = static_cast<size_t>(q - vec.begin()) + 1;
+
+                if(q_pos < end) {
+                    segments.push_back({ end, false, depth - 1 });
+                }
+                sorted_end = q_pos;
+            }
+
+            bool x_lt(const elem_t& x, const elem_t& y, unstable_sort_tag) const
+            {
+                return lt{}(key_fn(x), key_fn(y));
+            }
+
+            bool x_lt(const elem_t& x, const elem_t& y, stable_sort_tag) const
+            {
+                return lt{}(key_fn(x.first), key_fn(y.first)) ? true
+                     : lt{}(key_fn(y.first), key_fn(x.first)) ? false
+                     : x.second < y.second;
+            }
+
+            static void s_push_back(std::vector<elem_t>& v, value_type x, unstable_sort_tag)
+            {
+                v.push_back(std::move(x));
+            }
+
+            static void s_push_back(std::vector<elem_t>& v, value_type x, stable_sort_tag)
+            {
+                const auto ordinal = v.size();
+                v.emplace_back(std::move(x), ordinal);
+            }
+
+            static value_type& s_value(elem_t& x, unstable_sort_tag)
+            {
+                return x;
+            }
+
+            static value_type& s_value(elem_t& x, stable_sort_tag)
+            {
+                return x.first;
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(  key_fn, {}, {}, 0, 0, false )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( key_fn, {}, {}, 0, 0, false )
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    struct throw_on_late
+    {
+        template<typename T>
+        void operator()(T&&) const
+        {
+            RANGELESS_FN_THROW("Input is out of order by more than the specified bound.");
+        }
+    };
+
+    // Lazily sort a stream where each element is at most k positions out of place:
+    // keep a min-heap of k+1 elements; when full, yield the min. An element arriving 
+    // with key less than that of an already-yielded element violates the bound,
+    // and is diverted to on_late (throws by default).
+    //
+    // Ties are broken on the arrival-ordinal, so the sort is stable.
+    template<typename F, typename OnLate>
+    struct sort_by_bounded_disorder
+    {
+        const F key_fn;
+        const size_t k;
+        const OnLate on_late;
+
+        template<typename InGen>
+        struct gen
+        {
+              InGen gen;
+            const F key_fn; // lifetime of returned key shall be independent of arg.
+            const size_t k;
+             OnLate on_late;
+
+            using value_type = typename InGen::value_type;
+            using key_t = typename storable_key<typename std::decay<decltype(key_fn(std::declval<const value_type&>()))>::type>::type;
+            // (we hold on to the key of the last yielded element)
+
+            using elem_t = std::pair<value_type, size_t>; // ::second is the arrival-ordinal
+
+            std::vector<elem_t> heap; // min-heap (min at front)
+            maybe<key_t> last_key;
+            size_t ordinal;
+            bool exhausted;
+
+            auto operator()() -> maybe<value_type>
+            {
+                auto op_gt = [this](const elem_t& x, const elem_t& y)
+                {
+                    return lt{}(key_fn(y.first), key_fn(x.first)) ? true
+                         : lt{}(key_fn(x.first), key_fn(y.first)) ? false
+                         : y.second < x.second;
+                };
+
+                while(!exhausted && heap.size() <= k) {
+                    auto x = gen();
+
+                    if(!x) {
+                        exhausted = true;
+                    } else if(last_key && lt{}(key_fn(*x), *last_key)) {
+                        on_late(std::move(*x));
+                    } else {
+                        heap.emplace_back(std::move(*x), ordinal++);
+                        std::push_heap(heap.begin(), heap.end(), op_gt);
+                    }
+                }
+
+                if(heap.empty()) {
+                    return { };
+                }
+
+                std::pop_heap(heap.begin(), heap.end(), op_gt);
+                auto ret = std::move(heap.back().first);
+                heap.pop_back();
+
+                last_key.reset(key_t(key_fn(ret)));
+                return { std::move(ret) };
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(  key_fn, k, on_late, {}, {}, 0, false )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( key_fn, k, on_late, {}, {}, 0, false )
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct take_top_n_by
+    {
+        const F      key_fn;
+        const size_t capacity;
+
+        template<typename Iterable>
+        auto operator()(Iterable src) const -> std::vector<typename Iterable::value_type>
+        {
+            // TODO: if Iterable is a vector, do partial-sort, decreasing, take_first(n), and reverse.
+            //
+            // Take by forwarding-reference here instead of by-value?
+            // (Same question as in where_max_by)
+
+            using value_type = typename Iterable::value_type;
+
+            // this will fire if Iterable is std::map, where value_type is std::pair<const Key, Value>,
+            // which is not move-assignable because of constness.
+            static_assert(std::is_move_assignable<value_type>::value, "value_type must be move-assignable.");
+
+            auto op_gt = [this](const value_type& x, 
+                                const value_type& y)
+            {
+                return lt{}(key_fn(y), key_fn(x));
+            };
+
+            // NB: can't use priority_queue, because it provides 
+            // const-only exposition of elements, so we can't use
+            // it with move-only types.
+
+            std::vector<value_type> heap{};  // min-heap, (min at front)
+            heap.reserve(capacity);
+
+            if(capacity > 0)
+                for(auto&& x : src)
+                    if(heap.size() < capacity || lt{}(key_fn(heap.front()), key_fn(x)))
+            {
+                if(heap.size() >= capacity) {
+                    std::pop_heap(heap.begin(), heap.end(), op_gt);
+                    heap.pop_back();
+                }
+
+                heap.push_back(std::move(x));
+                std::push_heap(heap.begin(), heap.end(), op_gt);
+            }
+
+            std::sort_heap(heap.begin(), heap.end(), op_gt);
+            std::reverse(heap.begin(), heap.end());
+            
+            return heap;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    // Uniform in (0, 1) from a UniformRandomBitGenerator.
+    // (Not using std::uniform_real_distribution, which may yield 0,
+    // whereas we need to take the log of it).
+    template<typename URBG>
+    double uniform01(URBG& rng)
+    {
+        const double range = double(URBG::max() - URBG::min()) + 1.0;
+        const double ret = (double(rng() - URBG::min()) + 0.5) / range;
+        return ret < 1.0 ? ret : std::nextafter(1.0, 0.0);
+    }
+
+    // Number of failures before the first success in Bernoulli trials
+    // with success-probability p, where log_q = log(1 - p).
+    template<typename URBG>
+    double geometric_skip(URBG& rng, double log_q)
+    {
+        return std::floor(std::log(uniform01(rng)) / log_q);
+    }
+
+    /////////////////////////////////////////////////////////////////////
+    // Reservoir sampling, Algorithm L (Li, 1994): rather than calling the rng for every
+    // element, after the reservoir is filled compute how many elements to skip until
+    // the next one that enters the reservoir, so that the rng is called O(k*(1 + log(n/k))) times.
+    // For random-access inputs the skipped elements are not touched.
+    template<typename URBG>
+    struct sample_n
+    {
+        const size_t capacity;
+               URBG& rng;
+
+        template<typename Iterable>
+        auto operator()(Iterable src) const -> std::vector<typename Iterable::value_type>
+        {
+            using value_type = typename Iterable::value_type;
+            static_assert(std::is_move_assignable<value_type>::value, "value_type must be move-assignable.");
+
+            std::vector<value_type> reservoir{};
+            reservoir.reserve(capacity);
+
+            auto it = src.begin();
+            const auto it_end = src.end();
+
+            for(; it != it_end && reservoir.size() < capacity; ++it) {
+                reservoir.push_back(std::move(*it));
+            }
+
+            if(it == it_end || capacity == 0) {
+                return reservoir;
+            }
+
+            const double inv_k = 1.0 / double(capacity);
+            double w = std::exp(std::log(uniform01(rng)) * inv_k);
+
+            while(x_advance(it, it_end, geometric_skip(rng, std::log1p(-w)),
+                            typename std::iterator_traits<decltype(it)>::iterator_category{}))
+            {
+                const auto i = std::min(size_t(uniform01(rng) * double(capacity)), capacity - 1);
+                reservoir[i] = std::move(*it);
+                ++it;
+                w *= std::exp(std::log(uniform01(rng)) * inv_k);
+            }
+
+            return reservoir;
+        }
+
+    private:
+        // Advance by n elements; return false if reached the end.
+        template<typename Iterator>
+        static bool x_advance(Iterator& it, const Iterator& it_end, double n, std::random_access_iterator_tag)
+        {
+            const auto remaining = it_end - it;
+            if(!(n < double(remaining))) {
+                return false;
+            }
+            it += decltype(remaining)(n);
+            return true;
+        }
+
+        template<typename Iterator>
+        static bool x_advance(Iterator& it, const Iterator& it_end, double n, std::input_iterator_tag)
+        {
+            for(; n >= 1.0 && it != it_end; n -= 1.0) {
+                ++it;
+            }
+            return it != it_end;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    // Bernoulli sampling with geometric skip-ahead: rather than flipping
+    // a coin for every element, compute the distance to the next selected one,
+    // so the rng is called once per yielded element.
+    template<typename URBG>
+    struct sample_fraction
+    {
+        const double p;
+               URBG& rng;
+
+        template<typename InGen>
+        struct gen
+        {
+                 InGen gen;
+            const double p;
+                   URBG& rng;
+
+            using value_type = typename InGen::value_type;
+
+            auto operator()() -> maybe<value_type>
+            {
+                if(p <= 0.0) {
+                    return { };
+                }
+
+                double skip = p < 1.0 ? geometric_skip(rng, std::log1p(-p)) : 0.0;
+                auto x = gen();
+                for(; x && skip >= 1.0; skip -= 1.0) {
+                    x = gen();
+                }
+                return x;
+            }
+        };
+
+        // Random-access container or view: skip-ahead is an index-jump.
+        template<typename Iterable>
+        struct ra_gen
+        {
+            using value_type = typename Iterable::value_type;
+
+              Iterable inps;
+            const double p;
+                   URBG& rng;
+                  size_t pos;
+
+            auto operator()() -> maybe<value_type>
+            {
+                const auto n = size_t(std::distance(inps.begin(), inps.end()));
+                const double skip = p <= 0.0 ? double(n)
+                                  : p <  1.0 ? geometric_skip(rng, std::log1p(-p))
+                                  :            0.0;
+
+                if(!(skip < double(n - pos))) {
+                    pos = n;
+                    return { };
+                }
+
+                pos += size_t(skip);
+                return { std::move(inps.begin()[std::ptrdiff_t(pos++)]) };
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( p, rng )
+
+        template<typename Iterable>
+        auto operator()(Iterable src) const
+            -> typename std::enable_if<
+                    std::is_base_of<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<typename Iterable::iterator>::iterator_category>::value,
+                    seq<ra_gen<Iterable>>>::type
+        {
+            return { { std::move(src), p, rng, 0 } };
+        }
+
+        template<typename Iterable>
+        auto operator()(Iterable src) const
+            -> typename std::enable_if<
+                   !std::is_base_of<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<typename Iterable::iterator>::iterator_category>::value,
+                    seq<gen<to_seq::gen<Iterable>>>>::type
+        {
+            return { { { std::move(src), { }, false }, p, rng } };
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    template<typename F, typename BinaryPred = impl::eq>
+    struct group_adjacent_by
+    {
+        // We parametrize to both key_fn and pred2 to reuse
+        // this for both
+        // group_adjacent_by: key_fn:user-provided,      pred2=impl::eq
+        // group_adjacent_if: key_fn=impl::by::identity, pred2:user-provided.
+        
+                 const F key_fn;
+        const BinaryPred pred2;
+
+        /////////////////////////////////////////////////////////////////////
+        // A simple version that accumulates equivalent-group in a vector, 
+        // and yield vector_t. This makes it easy to deal-with (no seq-of
+        // seqs), but it needs to allocate a return std::vector per-group.
+        // (Edit: unless the use-case supports recycling (see below))
+        //
+        template<typename InGen,
+                 bool = std::is_same<typename InGen::value_type, char_block>::value>
+        struct gen
+        {
+                          InGen gen;
+                        const F key_fn;
+               const BinaryPred pred2;
+
+            using inp_t      = typename InGen::value_type;
+
+            using value_type = typename std::conditional<
+                                    std::is_same<inp_t, char>::value, 
+                                        std::string, 
+                                        std::vector<inp_t> >::type;
+
+            static_assert(std::is_move_assignable<value_type>::value, "value_type must be move-assignable.");
+
+
+            value_type next;
+            value_type garbage;
+
+            // instead of allocating a new vector, the caller, prior to calling
+            // the operator(), may choose to disown existing vector so we can
+            // reuse its internal storage
+
+            void recycle(value_type& grbg)
+            {
+                garbage = std::move(grbg);
+            }
+
+            auto operator()() -> maybe<value_type>
+            {
+                // NB: number of calls to key_fn shall be max(0, 2*(n-1))
+                // (as required by fn::chunker)
+
+                auto curr = std::move(next);
+                next = std::move(garbage);
+                next.clear(); // clearing does not deallocate internal storage
+
+                for(auto x = gen(); x; x = gen()) {
+                    if(curr.empty() || pred2(key_fn(curr.back()), key_fn(*x))) {
+                        curr.push_back(std::move(*x));
+                    } else {
+                        next.push_back(std::move(*x));
+                        break;
+                    }
+                }
+
+                if(curr.empty()) {
+                    return { };
+                }
+                
+                return std::move(curr);
+            }
+        };
+
+        /////////////////////////////////////////////////////////////////////
+        // A seq of char_blocks (see fn::from_istream_blocks): group the chars, 
+        // same as for a seq of chars, scanning each block in a tight loop.
+        // A group spanning several blocks is accumulated across them.
+        template<typename InGen>
+        struct gen<InGen, true>
+        {
+                          InGen gen;
+                        const F key_fn;
+               const BinaryPred pred2;
+
+            struct cursor_t
+            {
+                char_block block;
+                    size_t pos;
+            };
+
+            using value_type = std::string;
+
+              cursor_t curr;    // current block and the position of the next char in it
+            value_type garbage;
+
+            void recycle(value_type& grbg)
+            {
+                garbage = std::move(grbg);
+            }
+
+            auto operator()() -> maybe<value_type>
+            {
+                value_type ret = std::move(garbage);
+                ret.clear();
+
+                while(true) {
+                    if(curr.pos == curr.block.size()) {
+                        // done with this block: give it back upstream for reuse
+                        impl::recycle(gen, curr.block, impl::resolve_overload{});
+                        curr.block.clear();
+                        curr.pos = 0;
+
+                        auto x = gen();
+                        if(!x) {
+                            break;
+                        }
+                        curr.block = std::move(*x);
+                        continue;
+                    }
+
+                    const char* const beg = curr.block.data();
+                    const size_t n = curr.block.size();
+                    size_t i = curr.pos;
+
+                    if(ret.empty()) {
+                        ++i;
+                    }
+
+                    char prev = i == curr.pos ? ret.back() : beg[curr.pos];
+                    for(; i < n && pred2(key_fn(prev), key_fn(beg[i])); ++i) {
+                        prev = beg[i];
+                    }
+
+                    ret.append(beg + curr.pos, i - curr.pos);
+                    curr.pos = i;
+
+                    if(i < n) {
+                        break; // the group ends within this block
+                    }
+                }
+
+                if(ret.empty()) {
+                    return { };
+                }
+                return { std::move(ret) };
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( key_fn, pred2, {}, {} )
+
+        // view may be an InputRange, so treat as seq.
+        RANGELESS_FN_OVERLOAD_FOR_VIEW( key_fn, pred2, {}, {} )
+
+        /////////////////////////////////////////////////////////////////////
+        template<typename Container>
+        auto operator()(Container cont) const -> std::vector<Container>
+        {
+            // NB: number of calls to key_fn shall be max(0, 2*(n-1))
+            // (see chunker)
+
+            std::vector<Container> ret;
+
+            auto it = cont.begin();
+            const auto it_end = cont.end();
+
+            if(it == it_end) {
+                return ret;
+            }
+
+            ret.push_back(Container{});
+            ret.back().insert(ret.back().end(), std::move(*it)); // [compilation-error-hint]: Expecting Container's value-type to be end-insertable container.
+            ++it;
+
+            for(; it != it_end; ++it) {
+                if(!pred2(key_fn(*ret.back().rbegin()), // NB: last! NB[4]: not crbegin() here, see discussion below
+                          key_fn(*it)))
+                {
+                    ret.push_back(Container{});
+                }
+                auto& dest = ret.back();
+                dest.insert(dest.end(), std::move(*it));
+            }
+
+            // If key_fn is e.g. [](auto&& x){ return std::tie(arg); } 
+            // then the return type will be std::tuple<X&> or std::tuple<const X&> depending
+            // on constness of x, so the args passed to pred2 must be of the same constness,
+            // or it will fail to match to pred2::operator(const T&, const T&)
+
+            return ret;
+        }
+    };
+
+
+    /////////////////////////////////////////////////////////////////////
+    template<typename F, typename BinaryPred = impl::eq>
+    struct group_adjacent_as_subseqs_by
+    {
+                 const F key_fn;
+        const BinaryPred pred2;
+
+        template<typename InGen>
+        struct gen
+        {
+            // subgen for subseq - yield elements of the same group
+            struct subgen
+            {
+                using value_type = typename InGen::value_type;
+                gen* parent;
+
+                maybe<value_type> operator()()
+                {
+                    assert(parent);
+                    return parent->next();
+                }
+            };
+
+            /////////////////////////////////////////////////////////////////
+
+            using element_type = typename InGen::value_type;
+            using value_type = seq<subgen>;
+
+                          InGen in_gen;
+                        const F key_fn;
+               const BinaryPred pred2;   // returns true iff two elemens belong to same group
+            maybe<element_type> current; // current element of the current group
+                           bool reached_subend; 
+
+            /////////////////////////////////////////////////////////////////
+
+            maybe<element_type> next() // called from subgen::operator()()
+            {
+                if(!current || reached_subend) {
+                    reached_subend = true;
+                    return {};
+                }
+
+                auto nxt = in_gen(); // not "next" to avoid shadow-warning
+                reached_subend = !nxt || !pred2(key_fn(*current), key_fn(*nxt));
+                std::swap(current, nxt);
+                return std::move(nxt);
+            }
+            
+            maybe<value_type> operator()() // return seq for next group
+            {
+                if(!current) { // starting initial group
+                    current = in_gen();
+                } else {
+
+                    // NB: the user-code may have accessed the group only
+                    // partially (or not at all), in which case we must skip
+                    // over the rest elements in the group until we reach 
+                    // the next one.
+                    while(!reached_subend) {
+                        next();
+                    }
+                }
+
+                if(!current) { // reached final end
+                    return {};
+                }
+
+                reached_subend = false;
+                return { subgen{ this } };
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(  key_fn, pred2, {}, false )
+        RANGELESS_FN_OVERLOAD_FOR_VIEW( key_fn, pred2, {}, false )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( key_fn, pred2, {}, false )
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    // see fn::in_arena
+    struct in_arena
+    {
+        size_t chunk_size;
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    // Group a seq of chars or of char_blocks, appending the groups to 
+    // a chunked arena and yielding them as arena_string_views, 
+    // which share the ownership of their chunk.
+    //
+    // When the current chunk is full, it is reused in place if no views
+    // into it are alive; otherwise we switch to the spare chunk (the previous 
+    // one), if its views are gone too, or to a new chunk. A chunk that is
+    // still referenced by the consumer is freed by the last view into it.
+    template<typename F, typename BinaryPred = impl::eq>
+    struct group_adjacent_in_arena_by
+    {
+                 const F key_fn;
+        const BinaryPred pred2;
+            const size_t chunk_size;
+
+        template<typename InGen>
+        struct gen
+        {
+            using inp_t = typename InGen::value_type;
+
+            static_assert(std::is_same<inp_t, char>::value || std::is_same<inp_t, char_block>::value,
+                          "Expected a seq of chars or of fn::char_blocks.");
+
+            using chunk_ptr = std::shared_ptr<std::vector<char>>;
+
+            struct state_t
+            {
+                chunk_ptr chunk; // the groups are appended here
+                chunk_ptr spare; // the previous chunk, to reuse once the views into it are gone
+               char_block span;  // current input block (or char)
+                   size_t pos;   // position of the next char in span
+            };
+
+                          InGen gen;
+                        const F key_fn;
+               const BinaryPred pred2;
+                   const size_t chunk_size;
+                        state_t st;
+
+            using value_type = arena_string_view;
+
+            auto operator()() -> maybe<value_type>
+            {
+                size_t beg = x_size(); // start of the group in the chunk
+
+                while(true) {
+                    if(st.pos == st.span.size()) {
+                        if(!x_next_span(static_cast<inp_t*>(nullptr))) {
+                            break;
+                        }
+                        continue;
+                    }
+
+                    const char* const data = st.span.data();
+                    const size_t n = st.span.size();
+                    size_t i = st.pos;
+
+                    if(x_size() == beg) {
+                        ++i; // the first char of the group
+                    }
+
+                    char prev = i == st.pos ? st.chunk->back() : data[st.pos];
+                    for(; i < n && pred2(key_fn(prev), key_fn(data[i])); ++i) {
+                        prev = data[i];
+                    }
+
+                    x_append(beg, data + st.pos, i - st.pos);
+                    st.pos = i;
+
+                    if(i < n) {
+                        break; // the group ends within this span
+                    }
+                }
+
+                if(x_size() == beg) {
+                    return { };
+                }
+                return { arena_string_view{ string_view(st.chunk->data() + beg, x_size() - beg), st.chunk } };
+            }
+
+            size_t x_size() const
+            {
+                return st.chunk ? st.chunk->size() : 0;
+            }
+
+            static bool x_is_unused(const chunk_ptr& chunk)
+            {
+                if(chunk.use_count() != 1) {
+                    return false;
+                }
+
+                // synchronize with the release of the last view, possibly in another thread
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return true;
+            }
+
+            bool x_next_span(char*)
+            {
+                auto x = gen();
+                if(!x) {
+                    return false;
+                }
+                st.span.assign(1, *x);
+                st.pos = 0;
+                return true;
+            }
+
+            bool x_next_span(char_block*)
+            {
+                // done with this block: give it back upstream for reuse
+                impl::recycle(gen, st.span, impl::resolve_overload{});
+                st.span.clear();
+                st.pos = 0;
+
+                auto x = gen();
+                if(!x) {
+                    return false;
+                }
+                st.span = std::move(*x);
+                return true;
+            }
+
+            // Append n chars to the group starting at chunk[beg].
+            // A chunk is never reallocated or overwritten while 
+            // there are views into it; when it is full, the partial 
+            // group is moved to the start of a reusable or a new chunk.
+            void x_append(size_t& beg, const char* s, size_t n)
+            {
+                auto& chunk = st.chunk;
+
+                if(!chunk || chunk->size() + n > chunk->capacity()) {
+                    const size_t len = x_size() - beg;
+                    const size_t cap = std::max(chunk_size, 2 * (len + n));
+
+                    if(chunk && x_is_unused(chunk)) {
+                        chunk->erase(chunk->begin(), chunk->begin() + std::ptrdiff_t(beg));
+                        chunk->reserve(cap);
+                    } else {
+                        if(!st.spare || !x_is_unused(st.spare)) {
+                            st.spare = std::make_shared<std::vector<char>>();
+                        }
+
+                        st.spare->clear();
+                        st.spare->reserve(cap);
+                        if(chunk) {
+                            st.spare->insert(st.spare->end(), chunk->begin() + std::ptrdiff_t(beg), chunk->end());
+                        }
+                        std::swap(chunk, st.spare);
+                    }
+                    beg = 0;
+                }
+
+                chunk->insert(chunk->end(), s, s + n);
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(  key_fn, pred2, chunk_size, {} )
+        RANGELESS_FN_OVERLOAD_FOR_VIEW( key_fn, pred2, chunk_size, {} )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( key_fn, pred2, chunk_size, {} )
+    };
+
+
+    /////////////////////////////////////////////////////////////////////
+    // used for in_groups_of(n)
+    struct chunker
+    {
+        const size_t chunk_size;
+        mutable size_t n_calls;
+
+        template<typename T>
+        size_t operator()(const T&) const
+        {
+            // chunker is called with group_adjacent_by.
+            // If we had one call to key_fn per element, 
+            // we could chunk in groups of 10 like
+            // elems % fn::group_adjacent_by([n = 0UL](const auto){ return n++/10; });
+            //
+            // in group_adjacent_by we call the key_fn 2*(n-1) times.
+            return ++n_calls/2/chunk_size;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct group_all_by
+    {
+    private:
+        using group_adjacent_by_t = group_adjacent_by<F>;
+
+    public:
+        const F key_fn;
+
+        // group_all_by: convert input to vector, sort by key_fn, 
+        // and delegate to group_adjacent_by::gen
+        //
+        // (could instead delegate to the eager overload below,
+        // since we need to do the sort anyway, but the difference
+        // is that group_adjacent_by will recycle std::vector storage
+        // while yielding groups one by one, rather than having to
+        // allocate a separate std::vector per-group.
+
+        template<typename Gen>  // Container or seq<...>
+        auto operator()(seq<Gen> inps) const -> 
+            seq<
+                typename group_adjacent_by_t::template gen<
+                    to_seq::gen<
+                        std::vector<typename seq<Gen>::value_type>>>>
+        {
+            return 
+                group_adjacent_by_t{ key_fn, {} }(
+                    impl::to_seq{}(
+                        sort_by<F>{ key_fn }(
+                            impl::to_vector{}(
+                                std::move(inps)))));
+        }
+
+        /////////////////////////////////////////////////////////////////
+        template<typename Container>
+        auto operator()(Container cont) const
+            //-> std::vector<std::vector<typename Container::value_type>>
+            //The above is almost correct, except if Container is a map,
+            //conversion to vector removes the key-constness, so we
+            //need to do it via decltype
+            -> decltype(
+                    group_adjacent_by_t{ key_fn, {} }(
+                        impl::to_vector{}(
+                            std::move(cont))))
+        {
+#if 0 
+            // An example of what not to do
+            using key_t = remove_cvref_t<decltype(key_fn(*cont.begin()))>;
+            std::map<key_t, Container, lt_t> m;
+            for(auto&& x : cont) {
+                auto& dest = m[key_fn(x)];
+                dest.insert(dest.end(), std::move(x)); 
+                // BUG: the key in the map just became invalidated
+                // after move(x), if it contained references to it.
+            }
+            cont.clear(); 
+
+            std::vector<Container> ret;
+            ret.reserve(m.size());
+            for(auto& kv : m) {
+                ret.push_back(std::move(kv.second));
+            }
+            return ret;
+
+            // Can't also implement is as collect elems into
+            // std::set<Container, decltype(opless_by_keyfn_on_element)>,
+            // because if value_type is move-only, we won't be able
+            // to move-out the elements from the set since 
+            // set provides only const access to the elements.
+#else
+            return group_adjacent_by_t{ key_fn, {} }(
+                impl::sort_by<F>{ key_fn }(
+                    impl::to_vector{}(
+                        std::move(cont))));
+#endif
+        }
+
+        // Inputs already sorted by key_fn (see fn::assume_sorted_by): skip the sort.
+        template<typename Iterable>
+        auto operator()(sorted_range<Iterable, F> src) const
+            -> decltype(
+                    group_adjacent_by_t{ key_fn, {} }(
+                        impl::to_vector{}(
+                            std::move(src.src))))
+        {
+            return group_adjacent_by_t{ key_fn, {} }(
+                impl::to_vector{}(
+                    std::move(src.src)));
+        }
+    };
+
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Flatten a range-of-ranges.
+    // Inverse of group_all_by or group_adjacent_by(original elements are in key-order)
+    //
+    // This is the bind operator for the List monad.
+    //
+    // What do we name this? 
+    //
+    //    Haskell: concat
+    //     Elixir: concat
+    //        Elm: concat
+    //     O'Caml: concat, flatten
+    //      Scala: flatten
+    //    clojure: flatten
+    //     python: chain
+    //          D: chain
+    //         F#: collect
+    // javascript: flat
+    //   range-v3: join
+    //       LINQ: SelectMany
+    //
+    struct concat
+    {
+        template<typename InGen>
+        struct gen
+        {
+            InGen gen;
+
+            using gen_value_t = typename InGen::value_type;
+            using group_t     = maybe<gen_value_t>;
+                               // via maybe, because might not be default-constructible;
+                               // or could be a seq<...>, holding a closure under the hood,
+                               // rendering the seq not move-assigneable.
+
+            using iterator    = typename gen_value_t::iterator;
+            using value_type  = typename gen_value_t::value_type;
+
+             group_t current_group;
+            iterator it;
+
+#if 0       // We don't really need this
+
+            // -Weffc++ recommends explicit assignment operator because
+            // we have pointer members (presumably current_group), so we
+            // explicitly make this move-only.
+            gen& operator=(gen&&) = default;
+                       gen(gen&&) = default;
+            
+            gen& operator=(const gen&) = delete;
+                       gen(const gen&) = delete;
+#endif
+
+            auto operator()() -> maybe<value_type>
+            {
+                if(current_group) {
+                    // NB: we do not return { std::move(*it++) },
+                    // and instead the defer the increment until
+                    // the next call, because the user code consuming ret may have
+                    // side-effects that affect how and whether the
+                    // iterator is advanced, so we don't want to advance
+                    // it prematurely. 
+                    //
+                    // For example, ret's type could be
+                    // some proxy-object that will fetch an object from a stream,
+                    // and the lazy-sequnece's operator++ checks whether
+                    // the stream is empty to check whether it reached end.
+                    ++it;
+                }
+
+                while(!current_group || it == (*current_group).end()) {
+                    current_group = gen();
+                    
+                    if(!current_group) {
+                        return { };
+                    }
+
+                    it = (*current_group).begin();
+                }
+
+                return { std::move(*it) };
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( {}, typename gen<InGen>::iterator() )
+                                    //^^ simply {} does not compile with GCC-4.9.3
+
+        /////////////////////////////////////////////////////////////////
+        
+        template<typename Iterable,
+                 typename Ret = typename Iterable::value_type>
+        Ret operator()(Iterable src) const
+        {
+            // TODO: return a vector instead? What if cont is a set or a map?
+
+            Ret ret{};
+            ret.clear(); // [compilation-error-hint]: Expecting Iterable::value_type to be a container.
+
+            for(auto&& v : src) {
+                ret.insert(ret.end(),
+                           std::make_move_iterator(v.begin()),
+                           std::make_move_iterator(v.end()));
+            }
+
+            return ret;
+        }
+
+        // The case of vector-of-seq can't be handled by the above overload,
+        // because seq can't be end-inserted into.
+        // So we'll wrap container-of-seq into seq, and treat as seq-of-seq.
+        template<typename Gen>
+        auto operator()(std::vector<seq<Gen>> vec_of_seqs) const
+          -> seq<gen< to_seq::gen< std::vector<seq<Gen>> > >>
+        {                       //^^^^^^^^^^^^^^^^^^^^^       input vec
+                     //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^     wrapped as seq
+          //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^  composed with this
+          // TODO: needs a test.
+
+            return { { { std::move(vec_of_seqs) } } };
+        }
+    };
+
+
+    /////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct unique_adjacent_by
+    {
+        const F key_fn;
+
+        template<typename InGen>
+        struct gen
+        {
+              InGen gen;
+            const F key_fn;
+
+            using value_type = typename InGen::value_type;
+
+            using state_t = maybe<value_type>;
+            // wrapped into maybe, because might not be default-constructible
+
+            state_t next;
+
+            auto operator()() -> maybe<value_type>
+            {
+                auto curr = std::move(next);
+                next.reset();
+
+                for(auto x = gen(); x; x = gen()) {
+                    if(!curr) {
+                        curr = std::move(x);
+                    } else if( impl::eq{}(key_fn(*curr), key_fn(*x))) {
+                        continue; // skip equivalent elements
+                    } else {
+                        next = std::move(x);
+                        break;
+                    }
+                }
+
+                return curr;
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( key_fn, {} )
+
+        template<typename Iterable>
+        Iterable operator()(Iterable inps) const
+        {
+            impl::require_iterator_category_at_least<std::forward_iterator_tag>(inps);
+
+            inps.erase(
+                std::unique(
+                    inps.begin(), inps.end(),
+                    [this](const typename Iterable::value_type& x, 
+                           const typename Iterable::value_type& y)
+                    {
+                        return impl::eq{}(key_fn(x), key_fn(y));
+                    }),
+                inps.end());
+
+            return inps;
+        }
+    };
+
+
+
+    /////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct unique_all_by
+    {
+        const F key_fn;
+
+        template<typename InGen>
+        struct gen
+        {
+              InGen gen;
+            const F key_fn; // lifetime of returned key shall be independent of arg.
+
+            using value_type = typename InGen::value_type;
+
+            using key_t = typename std::decay<decltype(key_fn(*gen()))>::type; 
+            // key_fn normally yields a const-reference, but we'll be storing 
+            // keys in a map, so need to decay the type (remove_cvref would do).
+
+            static_assert(std::is_default_constructible<key_t>::value, "The type returned by key_fn in unique_all_by must be default-constructible and have the lifetime independent of arg.");
+            // In case key_fn returns a reference-wrapper or a tie-tuple containing
+            // a reference, these will become invalidated as keys in the map
+            // when the referenced object goes out of scope, so we guard against
+            // these by requiring default-constructible on key_t.
+
+            using seen_t = std::map<key_t, bool>; 
+            // might as well have used std::set, but to #include fewer things will
+            // repurpose std::map that's already included for other things.
+
+            seen_t seen;
+
+            auto operator()() -> maybe<value_type>
+            {
+                auto x = gen();
+
+                if(!x) {
+                    return { };
+                }
+                auto k = key_fn(*x);
+
+                while(!seen.emplace(std::move(k), true).second) {
+                    x = gen();
+                    if(!x) {
+                        break;
+                    }
+                    k = key_fn(*x);
+                }
+                return x;
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ( key_fn, {} )
+
+
+        template<typename Iterable>
+        auto operator()(Iterable src) const
+          -> decltype( // see the corresponding overload in group_all_by
+                  unique_adjacent_by<F>{ key_fn }(
+                      to_vector{}(
+                          std::move(src))))
+        {
+            return unique_adjacent_by<F>{ key_fn }(
+                sort_by<F>{ key_fn }(
+                    to_vector{}(
+                        std::move(src))));
+        }
+
+        // Inputs already sorted by key_fn (see fn::assume_sorted_by): skip the sort.
+        template<typename Iterable>
+        auto operator()(sorted_range<Iterable, F> src) const
+          -> decltype(
+                  unique_adjacent_by<F>{ key_fn }(
+                      to_vector{}(
+                          std::move(src.src))))
+        {
+            return unique_adjacent_by<F>{ key_fn }(
+                to_vector{}(
+                    std::move(src.src)));
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    // Window-policies for unique_within_by:
+    // stamp() is the position of an element (its ordinal, or time);
+    // an occurrence of a key expires when now - stamp exceeds the window;
+    // capacity() bounds the number of remembered keys.
+
+    // Keys occurring among the last n inputs.
+    struct window_last_n
+    {
+        uint64_t n;
+
+        template<typename T>
+        uint64_t stamp(const T&, uint64_t ordinal) const
+        {
+            return ordinal;
+        }
+
+        bool expired(uint64_t stamp, uint64_t now) const
+        {
+            return now - stamp > n;
+        }
+
+        size_t capacity() const
+        {
+            return size_t(-1);
+        }
+    };
+
+    // Up to `cap` most-recently-seen keys.
+    struct window_lru
+    {
+        size_t cap;
+
+        template<typename T>
+        uint64_t stamp(const T&, uint64_t ordinal) const
+        {
+            return ordinal;
+        }
+
+        bool expired(uint64_t, uint64_t) const
+        {
+            return false;
+        }
+
+        size_t capacity() const
+        {
+            return cap;
+        }
+    };
+
+    // Keys seen within `span` of time (the times shall be non-decreasing).
+    template<typename Span, typename TimeFn>
+    struct window_span
+    {
+           Span span;
+         TimeFn time_fn;
+
+        template<typename T>
+        auto stamp(const T& x, uint64_t) const -> typename std::decay<decltype(time_fn(x))>::type
+        {
+            return time_fn(x);
+        }
+
+        template<typename Time>
+        bool expired(const Time& stamp, const Time& now) const
+        {
+            return !(now - stamp < span);
+        }
+
+        size_t capacity() const
+        {
+            return size_t(-1);
+        }
+    };
+
+    // std::hash-compatible wrapper of hash64
+    struct hasher
+    {
+        template<typename T>
+        size_t operator()(const T& x) const
+        {
+            return size_t(hash64{}(x));
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    template<typename F, typename Window>
+    struct unique_within_by
+    {
+        const F      key_fn;
+        const Window window;
+
+        // Remember the ordinal of the last occurrence of each key in a hash-map,
+        // and the occurrences in arrival order in a FIFO. Expired or evicted
+        // keys are dropped from the front of the FIFO; a FIFO-entry is stale
+        // if the key occurred again since (the ordinals don't match), in which
+        // case the entry is simply dropped. Amortized O(1) per element.
+        template<typename InGen>
+        struct gen
+        {
+                  InGen gen;
+                const F key_fn; // lifetime of returned key shall be independent of arg.
+           const Window window;
+
+            using value_type = typename InGen::value_type;
+            using key_t      = typename storable_key<typename std::decay<decltype(key_fn(*gen()))>::type>::type;
+            using stamp_t    = typename std::decay<decltype(window.stamp(*gen(), 0))>::type;
+
+            using seen_t = std::unordered_map<key_t, uint64_t, hasher>;
+
+            struct occurrence_t
+            {
+                const key_t* key; // points to the key in seen
+                   uint64_t  ordinal;
+                    stamp_t  stamp;
+            };
+
+                          seen_t seen;
+            std::deque<occurrence_t> fifo;
+                        uint64_t ordinal;
+
+            auto operator()() -> maybe<value_type>
+            {
+                for(auto x = gen(); x; x = gen(), ++ordinal) {
+                    const auto now = window.stamp(*x, ordinal);
+
+                    while(!fifo.empty() && window.expired(fifo.front().stamp, now)) {
+                        x_pop_front();
+                    }
+
+                    auto ins = seen.emplace(key_fn(*x), ordinal);
+                    const bool is_dup = !ins.second;
+                    ins.first->second = ordinal;
+                    fifo.push_back({ &ins.first->first, ordinal, now });
+
+                    while(seen.size() > window.capacity()) {
+                        x_pop_front();
+                    }
+
+                    if(fifo.size() > 2 * seen.size() + 16) {
+                        x_drop_stale();
+                    }
+
+                    if(!is_dup) {
+                        ++ordinal;
+                        return x;
+                    }
+                }
+                return { };
+            }
+
+        private:
+            bool x_is_latest(const occurrence_t& occ) const
+            {
+                return seen.find(*occ.key)->second == occ.ordinal;
+            }
+
+            void x_pop_front()
+            {
+                if(x_is_latest(fifo.front())) {
+                    seen.erase(*fifo.front().key);
+                }
+                fifo.pop_front();
+            }
+
+            void x_drop_stale()
+            {
+                fifo.erase(
+                    std::remove_if(
+                        fifo.begin(), fifo.end(),
+                        [this](const occurrence_t& occ)
+                        {
+                            return !x_is_latest(occ);
+                        }),
+                    fifo.end());
+            }
+        };
+
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(  key_fn, window, {}, {}, 0 )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( key_fn, window, {}, {}, 0 )
+    };
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Concat a pair of (possibly heterogeous) `Iterables`.
+    template<typename Iterable2>
+    struct append
+    {
+        Iterable2 src2;
+
+        template<typename Iterable1>
+        struct gen
+        {
+                               Iterable1 inps1;
+                               Iterable2 inps2;
+            typename Iterable1::iterator it1;
+            typename Iterable2::iterator it2;
+                                     int which; // 0: not-started; 
+                                                // 1: in range1
+                                                // 2: in range2
+            using value_type = 
+                typename std::common_type<
+                    typename Iterable1::value_type,
+                    typename Iterable2::value_type
+                                         >::type;
+
+            auto operator()() -> maybe<value_type>
+            {
+                return which == 1 && it1 != inps1.end() ? std::move(*it1++)
+                     : which == 2 && it2 != inps2.end() ? std::move(*it2++)
+                     : which == 0 ? (which = 1, it1 = inps1.begin(), (*this)())
+                     : which == 1 ? (which = 2, it2 = inps2.begin(), (*this)())
+                     :              maybe<value_type>{ };
+            }
+        };
+
+        template<typename Iterable1>
+        auto operator()(Iterable1 src1) && -> seq<gen<Iterable1>> // rvalue-specific because src2 is moved-from
+        {
+            return { { std::move(src1), std::move(src2), {}, {}, 0 } };
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    template<typename Iterable2, typename BinaryFn>
+    struct zip_with
+    {
+        Iterable2 src2;
+        BinaryFn  fn;
+
+        template<typename Iterable1>
+        struct gen
+        {
+                                BinaryFn fn;
+                               Iterable1 src1;
+                               Iterable2 src2;
+            typename Iterable1::iterator it1;
+            typename Iterable2::iterator it2;
+                                    bool started;
+
+            using value_type = decltype(fn(std::move(*it1),
+                                           std::move(*it2)));
+
+            auto operator()() -> maybe<value_type>
+            {
+                if(!started) {
+                    it1 = src1.begin();
+                    it2 = src2.begin();
+                    started = true;
+                }
+
+                if(it1 == src1.end() || it2 == src2.end()) {
+                    return { };
+                }
+
+                auto ret = fn(std::move(*it1), std::move(*it2));
+                ++it1;
+                ++it2;
+                return { std::move(ret) };
+            }
+        };
+
+        template<typename Iterable1>
+        auto operator()(Iterable1 src1) && -> seq<gen<Iterable1>> // rvalue-specific because src2 is moved-from
+        {
+            return { { std::move(fn), std::move(src1), std::move(src2), {}, {}, false } };
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    template<typename BinaryFn>
+    struct zip_adjacent
+    {    
+        BinaryFn fn;
+
+        template<typename Iterable>
+        struct gen
+        {    
+                              BinaryFn fn;
+                              Iterable src; 
+           typename Iterable::iterator it;
+                                  bool started;
+
+            using value_type = decltype(fn(*it, *it));
+
+            auto operator()() -> maybe<value_type>
+            {    
+                if(!started) {
+                    it = src.begin();
+                    started = true;
+                }    
+
+                auto prev_it = it == src.end() ? it : it++;
+
+                if(it != src.end()) {
+                    return { fn(*prev_it, *it) };
+                } else {
+                    return { }; 
+                }    
+            }    
+        };   
+
+        template<typename Iterable>
+        auto operator()(Iterable src) && -> seq<gen<Iterable>>
+        {    
+            impl::require_iterator_category_at_least<std::forward_iterator_tag>(src);
+            return { { std::move(fn), std::move(src), {}, false } }; 
+        }    
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    template<typename Iterable2, typename BinaryFn>
+    struct cartesian_product_with
+    {
+        Iterable2 src2;
+        BinaryFn fn;
+
+        template<typename Iterable1>
+        struct gen
+        {
+                                BinaryFn fn;
+                               Iterable1 src1;
+                               Iterable2 src2;
+            typename Iterable1::iterator it1;
+            typename Iterable2::iterator it2;
+                                    bool started;
+
+            // Checking against input-range semantics.
+            // Checking against moving iterators (yielding rvalue-references)
+            // because if fn takes a param by value and the iterator yields 
+            // it will be moved-from.
+            static_assert(!std::is_rvalue_reference<decltype(*--it1)>::value, "For cartesian-product expecting upstream iterable to be a bidirectional range yielding lvalue-references or values");
+            static_assert(!std::is_rvalue_reference<decltype(*--it2)>::value, "For cartesian-product expecting parameter-iterable to be a bidirectional range yielding lvalue-references or values");
+
+            using value_type = decltype(fn(*it1, *it2));
+
+            auto operator()() -> maybe<value_type>
+            {
+                if(!started) {
+                    it1 = src1.begin();
+                    it2 = src2.begin();
+                    started = true;
+                    if(it1 == src1.end() || it2 == src2.end()) {
+                        return { };
+                    }
+                }
+
+                while(it2 == src2.end()) {
+                    it2 = src2.begin();
+
+                    ++it1;
+                    if(it1 == src1.end()) {
+                        return { };
+                    }
+                }
+
+                auto ret = fn(*it1, *it2);
+                ++it2;
+                return { std::move(ret) };
+            }
+        };
+
+        template<typename Iterable1>
+        auto operator()(Iterable1 src1) && -> seq<gen<Iterable1>> // rvalue-specific because range2 is moved-from
+        {
+            return { { std::move(fn), std::move(src1), std::move(src2), {}, {}, false } };
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+
+    struct memoizer_detail
+    {
+        template<class Ret, class Arg>
+        struct lambda_traits_detail
+        {    
+            using ret = Ret; 
+            using arg = Arg;
+        };   
+
+        template<class L>
+        struct lambda_traits
+             : lambda_traits<decltype(&L::operator())>
+        {};
+
+        // NB: not providing non-const version (must be pure)
+        template<class Ret, class Class, class Arg>
+        struct lambda_traits<Ret(Class::*)(Arg) const>
+             : lambda_traits_detail<Ret, Arg>
+        {};
+    };
+
+    template<typename F>
+    struct memoizer
+    {
+        using traits = impl::memoizer_detail::lambda_traits<F>;
+        using    Arg = typename std::remove_reference<typename traits::arg>::type;
+        using    Ret = typename traits::ret;
+        using  Cache = std::map<Arg, Ret>;
+
+        // Even after std::remove_reference the type could be e.g. a 
+        // tuple containing references which may become dangling, 
+        // so to guard against those we're requiring move-assignable.
+        //
+        // Same goes for the output-type, e.g. if return type is a reference-wrapper
+        // we will disallow that to guard against dangling references.
+        //
+        // (also see unique_all_by)
+        static_assert(std::is_default_constructible<Arg>::value, "The argument-type must be default-constructible.");
+        static_assert(std::is_default_constructible<Ret>::value, "The return-type type must be default-constructible.");
+
+                    F fn;
+        mutable Cache m; // mutable, because operator() must be const
+                         // e.g. we may be memoizing some key_fn, and 
+                         // those are expected to be const
+
+        const Ret& operator()(const Arg& arg) const
+        {
+            static_assert(std::is_same<decltype(arg < arg), bool>::value, "The argument-type must have operator< to be viable as std::map key-type.");
+
+            auto it = m.find(arg);
+            return it != m.end() ? it->second
+                                 : m.emplace(arg, fn(arg)).first->second;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    template<typename F>
+    struct scope_guard
+    {
+           F fn;
+        bool dismissed;
+
+        void dismiss()
+        {
+            dismissed = true;
+        }
+
+        ~scope_guard() noexcept(noexcept(fn()))
+        {
+            if(!dismissed)
+                fn(); // NB: it's up to m_fn to decide whether to catch exceptions.
+        }
+    };
+
+
+}   // namespace impl
+
+    /////////////////////////////////////////////////////////////////////////
+    /// @brief Structure-of-arrays container of `std::tuple<Ts...>` rows, stored as `std::vector<Ts>` columns.
+    ///
+    /// Dereferencing an iterator yields a row-proxy: a `std::tuple` of references into the columns,
+    /// that converts to `value_type` by copy, and supports assignment and `swap` through the references.
+    /// The fields can be moved out of the columns explicitly via `row.move_out()`.
+    /// Key-functions and predicates that take the row as `const_reference` (or `const auto&`)
+    /// and access only some of the fields, e.g. `fn::by::get<int>{}`, read only the corresponding columns.
+    ///
+    /// `fn::sort_by` sorts a permutation of row-indices once and applies it to every column;
+    /// `fn::where` evaluates the predicate on row-proxies and compacts every column.
+    /// Other stages treat it as a random-access container of `value_type`.
+    /*!
+    @code
+        using alns_t = fn::soa_vector<std::string, int, double>; // accession, pos, score
+        alns_t alns{};
+        alns.push_back(alns_t::value_type{ "NC_2", 20, 0.5 });
+        alns.push_back(alns_t::value_type{ "NC_1", 30, 0.9 });
+        alns.push_back(alns_t::value_type{ "NC_1", 10, 0.1 });
+
+        alns = std::move(alns)
+          % fn::where([](const alns_t::const_reference& row){ return std::get<2>(row) > 0.2; }) // reads only the scores
+          % fn::sort_by(fn::by::get<std::string>{});                                             // reads only the accessions
+
+        VERIFY(( alns.column<1>() == std::vector<int>{{ 30, 20 }} ));
+    @endcode
+    */
+    template<typename... Ts>
+    class soa_vector
+    {
+    public:
+        using value_type      = std::tuple<Ts...>;
+        using reference       = impl::soa_row<Ts&...>;
+        using const_reference = impl::soa_row<const Ts&...>;
+        using size_type       = size_t;
+
+    private:
+        using columns_t = std::tuple<std::vector<Ts>...>;
+        using indices_t = typename impl::make_index_seq<sizeof...(Ts)>::type;
+
+        columns_t m_columns;
+
+        template<typename Owner, typename Ref>
+        class x_iterator
+        {
+            Owner* m_owner;
+            size_t m_pos;
+
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type        = soa_vector::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using reference         = Ref;
+
+            x_iterator(Owner* owner = nullptr, size_t pos = 0) 
+                : m_owner{ owner }
+                , m_pos{ pos }
+            {}
+
+            reference operator*() const
+            {
+                return (*m_owner)[m_pos];
+            }
+
+            reference operator[](difference_type n) const
+            {
+                return (*m_owner)[size_t(difference_type(m_pos) + n)];
+            }
+
+            x_iterator& operator++()                  { ++m_pos; return *this; }
+            x_iterator& operator--()                  { --m_pos; return *this; }
+            x_iterator  operator++(int)               { auto ret = *this; ++m_pos; return ret; }
+            x_iterator  operator--(int)               { auto ret = *this; --m_pos; return ret; }
+            x_iterator& operator+=(difference_type n) { m_pos = size_t(difference_type(m_pos) + n); return *this; }
+            x_iterator& operator-=(difference_type n) { m_pos = size_t(difference_type(m_pos) - n); return *this; }
+
+            x_iterator operator+(difference_type n) const 
+            { 
+                return { m_owner, size_t(difference_type(m_pos) + n) };
+            }
+
+            x_iterator operator-(difference_type n) const 
+            { 
+                return { m_owner, size_t(difference_type(m_pos) - n) };
+            }
+
+            difference_type operator-(const x_iterator& other) const
+            {
+                return difference_type(m_pos) - difference_type(other.m_pos);
+            }
+
+            bool operator==(const x_iterator& other) const { return m_pos == other.m_pos; }
+            bool operator!=(const x_iterator& other) const { return m_pos != other.m_pos; }
+            bool operator< (const x_iterator& other) const { return m_pos <  other.m_pos; }
+            bool operator> (const x_iterator& other) const { return m_pos >  other.m_pos; }
+            bool operator<=(const x_iterator& other) const { return m_pos <= other.m_pos; }
+            bool operator>=(const x_iterator& other) const { return m_pos >= other.m_pos; }
+        };
+
+    public:
+        using iterator       = x_iterator<soa_vector, reference>;
+        using const_iterator = x_iterator<const soa_vector, const_reference>;
+
+        soa_vector() : m_columns{}
+        {}
+
+        soa_vector(std::initializer_list<value_type> rows) : m_columns{}
+        {
+            reserve(rows.size());
+            for(const auto& row : rows) {
+                push_back(row);
+            }
+        }
+
+        size_t size() const
+        {
+            return std::get<0>(m_columns).size();
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        void reserve(size_t n)
+        {
+            x_for_each_column(x_reserve{ n }, indices_t{});
+        }
+
+        void clear()
+        {
+            x_for_each_column(x_clear{}, indices_t{});
+        }
+
+        void push_back(value_type row)
+        {
+            x_push_back(row, indices_t{});
+        }
+
+        reference operator[](size_t i)
+        {
+            return x_at(i, indices_t{});
+        }
+
+        const_reference operator[](size_t i) const
+        {
+            return x_at(i, indices_t{});
+        }
+
+        iterator        begin()       { return { this, 0 }; }
+        iterator          end()       { return { this, size() }; }
+        const_iterator  begin() const { return { this, 0 }; }
+        const_iterator    end() const { return { this, size() }; }
+        const_iterator cbegin() const { return { this, 0 }; }
+        const_iterator   cend() const { return { this, size() }; }
+
+        /// Erase rows in `[b, e)`.
+        iterator erase(const iterator& b, const iterator& e)
+        {
+            const auto pos = b - begin();
+            x_for_each_column(x_erase{ pos, e - b }, indices_t{});
+            return begin() + pos;
+        }
+
+        /// Erase rows for which `pred(const_reference)` is true.
+        template<typename Pred>
+        void erase_if(Pred pred)
+        {
+            std::vector<bool> erased(size(), false);
+            for(size_t i = 0, n = size(); i < n; i++) {
+                erased[i] = pred(static_cast<const soa_vector&>(*this)[i]);
+            }
+
+            x_for_each_column(x_compact{ erased }, indices_t{});
+        }
+
+        /// Rearrange rows such that the row at position `perm[i]` ends up at position `i`.
+        void permute(const std::vector<size_t>& perm)
+        {
+            assert(perm.size() == size());
+            x_for_each_column(x_permute{ perm }, indices_t{});
+        }
+
+        /// Access the I'th column.
+        template<size_t I>
+        const typename std::tuple_element<I, columns_t>::type& column() const
+        {
+            return std::get<I>(m_columns);
+        }
+
+        template<size_t I>
+        typename std::tuple_element<I, columns_t>::type& column()
+        {
+            return std::get<I>(m_columns);
+        }
+
+    private:
+        struct x_reserve
+        {
+            size_t n;
+
+            template<typename Column>
+            void operator()(Column& col) const
+            {
+                col.reserve(n);
+            }
+        };
+
+        struct x_clear
+        {
+            template<typename Column>
+            void operator()(Column& col) const
+            {
+                col.clear();
+            }
+        };
+
+        struct x_erase
+        {
+            std::ptrdiff_t pos;
+            std::ptrdiff_t len;
+
+            template<typename Column>
+            void operator()(Column& col) const
+            {
+                col.erase(col.begin() + pos, col.begin() + pos + len);
+            }
+        };
+
+        struct x_compact
+        {
+            const std::vector<bool>& erased;
+
+            template<typename Column>
+            void operator()(Column& col) const
+            {
+                size_t dest = 0;
+                for(size_t i = 0; i < erased.size(); i++) {
+                    if(erased[i]) {
+                        continue;
+                    } else if(dest != i) { // no self-move-assignment
+                        col[dest] = std::move(col[i]);
+                    }
+                    dest++;
+                }
+                col.erase(col.begin() + std::ptrdiff_t(dest), col.end());
+            }
+        };
+
+        struct x_permute
+        {
+            const std::vector<size_t>& perm;
+
+            template<typename Column>
+            void operator()(Column& col) const
+            {
+                auto perm_copy = perm; // apply_permutation resets it to identity
+                impl::apply_permutation(col.begin(), perm_copy);
+            }
+        };
+
+        template<typename F, size_t... Is>
+        void x_for_each_column(const F& fn, impl::index_seq<Is...>)
+        {
+            const int unused[] = { 0, (fn(std::get<Is>(m_columns)), 0)... };
+            (void)unused;
+        }
+
+        template<size_t... Is>
+        reference x_at(size_t i, impl::index_seq<Is...>)
+        {
+            return { std::get<Is>(m_columns)[i]... };
+        }
+
+        template<size_t... Is>
+        const_reference x_at(size_t i, impl::index_seq<Is...>) const
+        {
+            return { std::get<Is>(m_columns)[i]... };
+        }
+
+        template<size_t... Is>
+        void x_push_back(value_type& row, impl::index_seq<Is...>)
+        {
+            const int unused[] = { 0, (std::get<Is>(m_columns).push_back(std::move(std::get<Is>(row))), 0)... };
+            (void)unused;
+        }
+    };
+
+
+    /////////////////////////////////////////////////////////////////////////
+
+    template<typename T>
+    using any_seq_t = impl::seq<impl::any_gen<T>>;
+
+    /// @brief Type-erase a `seq`.
+    ///
+    /// Wrap the underlying nullary invokable as std::function.
+    template<typename Gen, typename T = typename Gen::value_type>
+    inline any_seq_t<T> make_typerased(impl::seq<Gen> seq)
+    {
+#if 0
+        return { std::move(seq) };
+#else
+        // seqs's gen(erator) may contain move-only state, 
+        // not satisfying CopyConstructible, so we can't use it
+        // for std::function payload for any_gen.
+        // So we need to first wrap gen as a shared_ptr and create
+        // a copyable gen-wrapper.
+        // (there's only going to be a single instance that 
+        // is used to construct any_seq_t with, so the state
+        // is not actually shared).
+
+        auto gen_ptr = std::make_shared<Gen>( std::move(seq.get_gen()) );
+        return {{ 
+            [gen_ptr]() -> impl::maybe<T>
+            {
+                return (*gen_ptr)();
+            }
+        }};
+#endif
+    }
+
+    /// @defgroup to_vec to_vector/to_seq
+    /// @{
+
+    /// @brief Move elements of an `Iterable` to std::vector.
+    inline impl::to_vector to_vector()
+    {
+        return {};
+    }
+
+    /// @brief Wrap an `Iterable`, taken by value, as `seq` yielding elements by-move.
+    ///
+    /// This is a dual of `to_vector`. It can be used to adapt your own `InputRange` as
+    /// `seq`, but it can also be used to wrap a container to force lazy evaluation
+    /// e.g. `std::move(container) % fn::to_seq() % fn::group_adjacent_by(key_fn) % fn::take_first()`
+    inline impl::to_seq to_seq()
+    {
+        return {};
+    }
+
+    /// e.g. `auto set_of_ints = fn::seq(...) % ... % fn::to(std::set<int>{})`;
+    template<typename Container>
+    impl::to<Container> to(Container dest)
+    {
+        return { std::move(dest) };
+    }
+
+    /// @brief return map: value_type -> size_t
+    inline impl::counts counts()
+    {
+        return {};
+    }
+
+
+    /// @}
+    /// @defgroup transform Transform and Adapt
+    ///
+    /// @{
+
+    /// @brief Create a custom processing-stage function-object.
+    ///
+    /// This is somewhat similar to `fn::transform`, except the correspondence between
+    /// inputs and outputs is not necessarily 1:1, and instead of taking a single element to transform
+    /// we take a nullary generator callable `gen` and use it to fetch however many input elements
+    /// we need to generate the next output element.
+    /// 
+    /// NB: If `bool(gen)==false`, the next invocation of gen() shall throw `fn::end_seq::exception` signaling end-of-inputs.
+    /*!
+    @code
+        auto my_transform = [](auto fn)
+        {
+            return fn::adapt([fn = std::move(fn)](auto gen)
+            {
+                return fn(gen());
+            });
+        };
+
+        auto my_where = [](auto pred)
+        {
+            return fn::adapt([pred = std::move(pred)](auto gen)
+            {
+                auto x = gen();
+                while(!pred(x)) {
+                    x = gen();
+                }
+                return x;
+            });
+        };
+
+        auto my_take_while = [](auto pred)
+        {
+            return fn::adapt([pred = std::move(pred)](auto gen)
+            {
+                auto x = gen();
+                return pred(x) ? std::move(x) : fn::end_seq();
+            });
+        };
+
+        auto my_intersperse = [](auto delim)
+        {
+#if 1
+            return [delim = std::move(delim)](auto inputs)
+            {
+                return fn::seq([  delim, 
+                                 inputs = std::move(inputs), 
+                                     it = inputs.end(), 
+                                started = false, 
+                                   flag = false]() mutable
+                {
+                    if(!started) {
+                        started = true;
+                        it = inputs.begin();
+                    }
+                    return it == inputs.end() ? fn::end_seq()
+                         :     (flag = !flag) ? std::move(*it++)
+                         :                      delim;
+                });
+            };
+            
+#elif 0 // or
+
+            return [delim = std::move(delim)](auto inputs)
+            {
+                return std::move(inputs)
+              % fn::transform([delim](auto inp)
+                {
+                    return std::array<decltype(inp), 2>{{ std::move(inp), delim }};
+                })
+              % fn::concat()
+              % fn::drop_last(); // drop trailing delim
+            };
+
+#else // or
+
+            return fn::adapt([delim, flag = false](auto gen) mutable
+            {
+                return           !gen ? fn::end_seq() 
+                     : (flag = !flag) ? gen() 
+                     :                  delim;
+            });
+#endif
+        };
+
+
+        auto my_inclusive_scan = []
+        {
+            return fn::adapt([sum = 0](auto gen) mutable
+            {
+                return sum += gen();
+            });
+        };
+
+        auto res = 
+            fn::seq([i = 0]() mutable
+            {
+                return i++;
+            })                  // 0,1,2,3,...
+
+          % my_where([](int x)
+            {
+                return x >= 3; 
+            })                  // 3,4,5,...
+
+          % my_take_while([](int x)
+            {
+                return x <= 5;
+            })                  // 3,4,5
+
+          % my_intersperse(-1)  // 3,-1,4,-1,5
+
+          % my_transform([](int x)
+            {
+                return x + 1;
+            })                  // 4,0,5,0,6
+
+          % my_inclusive_scan() // 4,4,9,9,15
+
+          % fn::to_vector();
+
+        VERIFY((res == vec_t{{4, 4, 9, 9, 15}}));
+    @endcode
+
+    A more realistic example: suppose you have a pipeline
+    transforming inputs to outputs in parallel, and you want to
+    compress the output, but the outputs are small and compressing
+    them individually would be ineffective, and you want to 
+    serialize the incoming results into a buffer of some minimum
+    size, e.g. 100kb, before passing it to the compressing stage.
+    @code
+        auto make_result     = [](std::string s){ return s; };
+        auto compress_block  = [](std::string s){ return s; };
+        auto write_to_ostr   = [](std::string s){ std::cout << s; };
+
+        namespace fn = rangeless::fn;
+        using fn::operators::operator%;
+
+        fn::seq([&]() -> std::string
+        {
+            std::string line;
+            return std::getline(std::cin, line) ? std::move(line) 
+                                                : fn::end_seq();
+        })
+
+      % fn::transform_in_parallel(make_result)
 
       % fn::adapt([](auto get_next)
         { 
             std::ostringstream buf{};
 
-            while(get_next && buf.tellp() < 100000) {
-                buf << get_next();
-            }
+            while(get_next && buf.tellp() < 100000) {
+                buf << get_next();
+            }
+
+            return buf.tellp() ? buf.str() : fn::end_seq();
+        })
+
+      % fn::transform_in_parallel(compress_block)
+
+      % fn::for_each(write_to_ostr);
+
+    @endcode
+    */
+    template<typename F> 
+    impl::adapt<F> adapt(F fn)
+    {
+        return { std::move(fn) };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Create a `seq` yielding results of applying the transform functions to input-elements.
+    ///
+    /// Returns a unary function-object, which will capture the arg by value and 
+    /// return an adapted `seq<...>` which will yield results of invoking 
+    /// `map_fn` on the elements (passed by value) of arg.
+    /// See `fn::where` for an example.
+    template<typename F> 
+    impl::transform<F> transform(F map_fn)
+    {
+        // Rationale:
+        // <br>
+        // 1) A possible implementation for a container-input could assume that 
+        // `transform` function is inexpensive to recompute on-demand (this is
+        // this approach in `range-v3` which may call `transform` multiple times
+        // per element depending on the access pattern from the downstream views).
+        // 
+        // 2) An implementation could require the result-type to be cacheable
+        // and assume it is 'light' in terms of memory requirements and memoize the results.
+        //
+        // Our approach of applying `transform` lazily allows us to
+        // make neither assumption and apply `transform` at most once per element and without caching. 
+        // The user-code may always follow that by fn::to_vector() when necessary.
+
+        return { std::move(map_fn) };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Like `fn::transform` with a `char -> char` function, but given a seq 
+    /// of `fn::char_block`s (see `fn::from_istream_blocks`), maps the chars of each block in place.
+    ///
+    /// The result of `map_fn` is narrowed to `char`, so e.g. `std::tolower` can be used as is.
+    /// (`fn::transform` invokes its function with the blocks as is).
+    /*!
+    @code
+        std::istringstream istr{ "Hello, World!" };
+
+        auto text = fn::from_istream_blocks(istr, 4)
+          % fn::transform_chars([](char c){ return std::toupper(c); })
+          % fn::to_vector();
+
+        VERIFY(( text % fn::join() == "HELLO, WORLD!" ));
+    @endcode
+    */
+    template<typename F> 
+    impl::transform_chars<F> transform_chars(F map_fn)
+    {
+        return { std::move(map_fn) };
+    }
+
+#if 0
+    // see comments around struct composed
+    template<typename F, typename... Fs>
+    auto transform(F fn, Fs... fns) -> impl::transform<decltype(impl::compose(std::move(fn), std::move(fns)...))>
+    {
+        return { impl::compose(std::move(fn), std::move(fns)...) };
+    }
+#endif
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Lazily split a string on a delimiter char, yielding `fn::string_view`s of the tokens.
+    ///
+    /// The input is a `std::string` or `std::vector<char>` lvalue, a `fn::string_view`,
+    /// or a view of contiguous chars, e.g. `fn::cfrom(str)`. The tokens are views into
+    /// the input, which is not copied, so it must outlive the tokens (a temporary
+    /// `std::string` is rejected at compile-time). Nothing is allocated.
+    ///
+    /// Like `tsv::split_on_delim`, N delimiters make N+1 tokens, unless
+    /// `.drop_empty()` is specified. With `.trim_blanks()` the leading and trailing
+    /// spaces of the tokens are truncated (before checking for emptiness).
+    /*!
+    @code
+        const std::string path = "/usr//local/ bin /";
+
+        auto toks = fn::string_view(path)
+          % fn::split('/').trim_blanks().drop_empty()
+          % fn::transform([](fn::string_view s){ return std::string(s); })
+          % fn::to_vector();
+
+        VERIFY(( toks == std::vector<std::string>({ "usr", "local", "bin" }) ));
+    @endcode
+    */
+    inline impl::split<impl::char_delim> split(char delim)
+    {
+        return { { delim }, false, false };
+    }
+
+    /// @brief Lazily split a string on chars for which `is_delim(char)` is true.
+    template<typename Pred>
+    impl::split<impl::pred_delim<Pred>> split(Pred is_delim)
+    {
+        return { { std::move(is_delim) }, false, false };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Prefetch the memory at `addr_fn(elem)` for upcoming elements, `distance` elements ahead.
+    ///
+    /// Yields the inputs as is. This is for pipelines chasing pointers, where
+    /// the downstream stages access scattered objects, and so each access is a cache-miss:
+    /// this stage pulls the inputs ahead of consumption, and issues a prefetch
+    /// (`__builtin_prefetch`, where available) for each, so that by the
+    /// time the element is consumed its memory is likely in cache.
+    ///
+    /// `addr_fn(const value_type&)` returns a pointer; the default
+    /// one handles pointers and reference-wrappers (e.g. from `fn::refs`).
+    ///
+    /// This pays off when the consumer does some real work per element: 
+    /// if it merely reads a field, the out-of-order core already overlaps the
+    /// cache-misses of many iterations on its own, and the stage is pure overhead.
+    /// Measure (see test/prefetch_bench.cpp).
+    ///
+    /// Buffering space requirements: `O(distance)`.
+    /*!
+    @code
+        auto total_score = fn::refs(scattered_records)
+          % fn::sort_by([](const record_t& r){ return r.pos; }) // no longer in memory-order
+          % fn::prefetch(8)
+          % fn::foldl(0.0, [](double out, const record_t& r){ return out + score(r); }); // some real work per record
+    @endcode
+    */
+    template<typename F>
+    impl::prefetch<F> prefetch(size_t distance, F addr_fn)
+    {
+        return { distance, std::move(addr_fn) };
+    }
+
+    inline impl::prefetch<impl::addr_of> prefetch(size_t distance)
+    {
+        return { distance, {} };
+    }
+
+
+
+
+    /// @}
+    /// @defgroup folding Folds and Loops
+    /// @{
+
+    /////////////////////////////////////////////////////////////////////////////
+    /*! @brief Range-based version of c++20 (copy-free) `std::accumulate`
+     *
+     * @see foldl_d
+     * @see foldl_1
+    @code
+        using namespace fn::operators;
+        const std::string x = vec_t{ 1, 2, 3 }
+          % fn::foldl(std::string{"^"},         // init
+                   [](std::string out, int in)  // fold-op
+            {
+                return std::move(out) + "|" + std::to_string(in);
+            });
+
+        VERIFY(x == "^|1|2|3");
+    @endcode
+
+    NB: The body of the fold-loop is `init = binary_op(std::move(init), *it);`
+    If `it` is a `move`-ing iterator, like that of an `seq`, 
+    you'd take `in` by value or rvalue-reference in your binary operator,
+    whereas if it's a regular iterator yielding lvalue-references, you'd 
+    take it by const or non-const reference.
+    */
+    template<typename Result, typename Op>
+    impl::foldl<Result, Op> foldl(Result init, Op binary_op)
+    {
+        // NB: idiomatically the init value goes after the binary op,
+        // but most of the time binary-op is a multiline lambda, and having
+        // the init arg visually far-removed from the call-site 
+        // make things less readable, i.e. foldl([](...){ many lines }, init).
+        // So placing the binary-op last.
+        // (Tried it both ways, and found this order preferable).
+
+        return { std::move(init), std::move(binary_op) };
+    }
+
+    /// Fold-Left-with-Default: this version uses default-initialized value for init.
+    /*!
+     * @see foldl
+     * @see foldl_1
+    @code
+        const std::string x = vec_t{ 1, 2, 3 }
+        % fn::foldl_d(
+            [](std::string out, int in)
+            {
+                return std::move(out) + "|" + std::to_string(in);
+            });
+
+        VERIFY(x == "|1|2|3");
+    @endcode
+    */
+    template<typename Op>
+    impl::foldl_d<Op> foldl_d(Op binary_op)
+    {
+        return { std::move(binary_op) };
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    /// Init-free version of foldl (first element is used as init); requires at least one element.
+    /*!
+     * @see foldl
+     * @see foldl_d
+     * 
+    @code
+        const auto min_int = 
+            std::vector<std::string>{{ "11", "-333", "22" }}
+        % fn::transform([](const string& s) { return std::stoi(s); })
+        % fn::foldl_1([](int out, int in)   { return std::min(out, in); });
+
+        VERIFY(min_int == -333);
+    @endcode
+     */
+    template<typename Op>
+    impl::foldl_1<Op> foldl_1(Op binary_op) 
+    {
+        return { std::move(binary_op) };
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    /// @brief Concatenate strings, string-views, c-strings, or chars, with `sep` between them.
+    ///
+    /// Unlike folding with `std::move(out) + sep + in`, the result is built in one buffer:
+    /// given a container, the total length is computed first and the buffer is allocated once;
+    /// given a seq, the buffer grows geometrically.
+    /*!
+    @code
+        VERIFY(( std::vector<std::string>({ "a", "bb", "ccc" }) % fn::join(", ") == "a, bb, ccc" ));
+    @endcode
+    */
+    inline impl::join join(string_view sep = "")
+    {
+        return { std::string(sep.data(), sep.size()) };
+    }
+
+    inline impl::join join(char sep)
+    {
+        return { std::string(1, sep) };
+    }
+
+    /// @brief Formatting version of `join`: `append_fn(std::string& out, const T& elem)` appends a formatted element.
+    /*!
+    @code
+        const std::string s = vec_t{{ 1, 2, 3 }}
+          % fn::join(",", [](std::string& out, int x)
+            {
+                out += std::to_string(x * x);
+            });
+
+        VERIFY(s == "1,4,9");
+    @endcode
+    */
+    template<typename F>
+    impl::join_with<F> join(string_view sep, F append_fn)
+    {
+        return { std::string(sep.data(), sep.size()), std::move(append_fn) };
+    }
+
+    template<typename F>
+    impl::join_with<F> join(char sep, F append_fn)
+    {
+        return { std::string(1, sep), std::move(append_fn) };
+    }
+
+
+    /// Return a `seq` yielding a view of a fixed-sized sliding window over elements.
+    ///
+    /// If the input is a `seq`, last `win_size` elements are internally cached in a deque.
+    /*!
+    @code
+        const auto result = 
+            make_inputs({ 1,2,3,4 })
+          % fn::sliding_window(2)
+          % fn::foldl(0L, [](long out, auto v)
+            { 
+                VERIFY(std::distance(v.begin(), v.end()) == 2);
+                auto it = v.begin();
+                return (out * 1000) + (*it * 10) + *std::next(it);
+            });
+        VERIFY(result == 12023034);
+    @endcode
+    */
+    inline impl::sliding_window sliding_window(size_t win_size)
+    {
+        return { win_size };
+    }
+
+    /// Invoke fn on each element.
+    ///
+    /// NB: this is similar to a left-fold with binary-op `(nullptr_t, x) -> nullptr_t`
+    /// where `x` is consumed by-side-effect, and the binary-op is simplified to unary `(x)->void`. 
+    template<typename F>
+    impl::for_each<F> for_each(F fn)
+    {
+        return { std::move(fn) };
+    }
+
+
+    /// Invoke binary fn on each pair of adjacent elements.
+    ///
+    /// NB: the inputs must satisfy `ForwardRange` or stronger.
+    template<typename F2>
+    impl::for_each_adjacent<F2> for_each_adjacent(F2 fn2)
+    {
+        return { std::move(fn2) };
+    }
+
+    /// @}
+    /// @defgroup sketches Approximate Aggregates
+    /// Bounded-memory approximate summaries of a range, for streams where
+    /// the exact answer (e.g. a `std::map` of all keys) would not fit in memory.
+    /// The summaries are mergeable, e.g. per-shard or per-thread summaries can be combined.
+    /// @{
+
+    /// @brief Estimate the number of distinct keys with a HyperLogLog sketch.
+    ///
+    /// Returns `impl::hll_sketch` with methods `estimate()`, `merge(other)`, `insert(key)`, and `relative_error()`.
+    /// The memory is `2^precision` bytes, and the relative standard error is `1.04 / sqrt(2^precision)`,
+    /// e.g. 0.81% for the default precision of 14 (16KiB); with 99.7% probability the error is within
+    /// three times that. For small cardinalities the estimate is nearly exact.
+    ///
+    /// A key-function may return a value, a `std::reference_wrapper`, a `std::pair`,
+    /// or a `std::tuple` (e.g. `std::tie`) of those, where the values are `std::hash`-able.
+    /*!
+    @code
+        auto sketch = fn::from(accs_shard1) % fn::approx_distinct_by(fn::by::identity{});
+        sketch.merge(fn::from(accs_shard2) % fn::approx_distinct_by(fn::by::identity{}));
+        const size_t num_distinct_accs = size_t(sketch.estimate());
+    @endcode
+    */
+    template<typename F>
+    impl::approx_distinct_by<F> approx_distinct_by(F key_fn, size_t precision = 14)
+    {
+        return { std::move(key_fn), precision };
+    }
+
+    /// @brief Approximate quantiles of keys with a KLL sketch.
+    ///
+    /// Returns `impl::kll_sketch<Key>` with methods `quantile(q)`, `rank(key)`, `count()`,
+    /// `insert(key)`, and `merge(other)`, where `Key` is the decayed return-type of `key_fn`.
+    /// The memory is `O(k)` keys, and with high probability the rank-error of an answer
+    /// is within about `3.3 / k` (e.g. within 1.7% for the default `k=200`):
+    /// `quantile(0.5)` returns a key whose true rank is within `[0.483, 0.517]`.
+    ///
+    /// Unlike `fn::to_vector() % fn::sort_by(key_fn)`, this does not need to buffer the inputs.
+    /*!
+    @code
+        const auto scores = alns % fn::approx_quantiles_by([](const aln_t& aln){ return aln.score; });
+        const double median = scores.quantile(0.5);
+        const double p99    = scores.quantile(0.99);
+    @endcode
+    */
+    template<typename F>
+    impl::approx_quantiles_by<F> approx_quantiles_by(F key_fn, size_t k = 200)
+    {
+        return { std::move(key_fn), k };
+    }
+
+    /// @brief Find the most frequent keys with a Misra-Gries summary of `k` counters.
+    ///
+    /// Returns `impl::misra_gries_summary<Key>` with methods `top()` (tracked keys with
+    /// their counts, most frequent first), `count(key)`, `error_bound()`, `insert(key)`, and `merge(other)`.
+    ///
+    /// Unlike `fn::counts()`, the memory is `O(k)` regardless of the number of distinct keys.
+    /// The tracked counts are underestimated by at most `error_bound() <= N / (k + 1)`,
+    /// so every key occurring more than `N / (k + 1)` times is reported. The key-function
+    /// shall return by value (the summary stores the keys).
+    /*!
+    @code
+        const auto summary = alns % fn::heavy_hitters_by([](const aln_t& aln){ return aln.acc; }, 1000);
+
+        for(const auto& acc_count : summary.top()) {
+            std::cout << acc_count.first << "\t" << acc_count.second << "\n";
+        }
+    @endcode
+    */
+    template<typename F>
+    impl::heavy_hitters_by<F> heavy_hitters_by(F key_fn, size_t k)
+    {
+        return { std::move(key_fn), k };
+    }
+
+    /// @brief Approximate counts of keys with a count-min sketch of `depth` rows of `width` counters.
+    ///
+    /// Returns `impl::count_min_sketch` with methods `count(key)`, `total()`, `error_bound()`,
+    /// `insert(key[, n])`, and `merge(other)`. This is a fixed-memory alternative to `fn::counts()`.
+    ///
+    /// `count(key)` never underestimates, and with probability `1 - exp(-depth)` overestimates
+    /// by at most `e / width * N`; e.g. `width = 2^20, depth = 5` (40MiB) yields counts within
+    /// `2.6e-6 * N` with probability 99.3%. Conservative update makes the overestimation much smaller
+    /// in practice. Sketches of the same dimensions can be merged.
+    /*!
+    @code
+        auto sketch = fn::from(kmers) % fn::approx_counts_by(fn::by::identity{}, 1 << 20, 5, true);
+
+        auto frequent = std::move(kmers)
+          % fn::where([&](const std::string& kmer){ return sketch.count(kmer) >= 100; });
+    @endcode
+    */
+    template<typename F>
+    impl::approx_counts_by<F> approx_counts_by(F key_fn, size_t width, size_t depth, bool conservative_update = false)
+    {
+        return { std::move(key_fn), width, depth, conservative_update };
+    }
+
+    /// @}
+    /// @defgroup incremental Incremental Aggregation
+    /// @{
+
+    /// @brief Aggregators for `fn::incremental_aggregate_by`.
+    ///
+    /// A user-defined aggregator is a type with a member-template `state<Value>`,
+    /// a value-initializable accumulator with `result()` method, and methods
+    /// `insert(state&, const Value&)` and `erase(state&, const Value&)`.
+    namespace agg
+    {
+        /// @brief Sum of `val_fn(x)`; invertible.
+        template<typename F>
+        impl::agg_sum<F> sum(F val_fn)
+        {
+            return { std::move(val_fn) };
+        }
+
+        /// @brief Count of elements; invertible.
+        inline impl::agg_count count()
+        {
+            return {};
+        }
+
+        /// @brief Min of `val_fn(x)`; backed by a heap with lazy deletion.
+        template<typename F>
+        impl::agg_extremum<F, std::greater> min(F val_fn)
+        {
+            return { std::move(val_fn) };
+        }
+
+        /// @brief Max of `val_fn(x)`; backed by a heap with lazy deletion.
+        template<typename F>
+        impl::agg_extremum<F, std::less> max(F val_fn)
+        {
+            return { std::move(val_fn) };
+        }
+    }
+
+    /// @brief Group-by-key and aggregate, maintaining the results as elements are inserted and erased.
+    ///
+    /// Applied to a range, returns `impl::incremental_aggregate` initialized with its elements,
+    /// with methods `insert(batch)`, `erase(batch)`, taking any range of elements, and `results()`,
+    /// returning the view of `std::map<Key, Result>`. The cost of updating the results
+    /// is proportional to the size of the batch rather than of the table.
+    ///
+    /// This is an alternative to re-doing `fn::group_all_by(key_fn) % fn::transform(...)`
+    /// when a few rows of a large table change.
+    /*!
+    @code
+        using row_t = std::pair<std::string, int>;
+
+        auto totals = std::vector<row_t>{{ {"a", 1}, {"a", 5}, {"b", 3} }}
+          % fn::incremental_aggregate_by(fn::by::first{}, fn::agg::sum(fn::by::second{}));
+
+        totals.insert(std::vector<row_t>{{ {"a", 2}, {"c", 7} }});
+        totals.erase(std::vector<row_t>{{ {"b", 3} }});
+
+        auto res = totals.results() % fn::to_vector(); // {{"a", 8}, {"c", 7}}
+    @endcode
+    */
+    template<typename F, typename Agg>
+    impl::incremental_aggregate_by<F, Agg> incremental_aggregate_by(F key_fn, Agg aggregator)
+    {
+        return { std::move(key_fn), std::move(aggregator) };
+    }
+
+    /// @}
+    /// @defgroup filtering Filtering
+    /// @{
+ 
+    /// @brief Yield elements until pred evaluates to false.
+    template<typename P> 
+    impl::take_while<P> take_while(P pred)
+    {
+        return { std::move(pred) };
+    }
+
+    /// @brief Yield first `n` elements.
+    inline impl::take_while<impl::call_count_lt> take_first(size_t n = 1)
+    {
+        return {{ n, 0UL }};
+    }
+
+    /// @brief Yield last `n` elements.
+    ///
+    /// Buffering space requirements for `seq`: `O(n)`.
+    inline impl::take_last take_last(size_t n = 1)
+    {
+        return { n };
+    }
+
+    /// @brief Drop elements until pred evaluates to false.
+    template<typename P> 
+    impl::drop_while<P> drop_while(P pred)
+    {
+        return { std::move(pred) };
+    }
+
+    /// @brief Drop first `n` elements.
+    inline impl::drop_while<impl::call_count_lt> drop_first(size_t n = 1)
+    {
+        return {{ n, 0UL }};
+    }
+
+    /// @brief Drop last `n` elements.
+    ///
+    /// Buffering space requirements for `seq`: `O(n)`.
+    inline impl::drop_last drop_last(size_t n = 1)
+    {
+        return { n };
+    }
+
+    /// @brief Keep the elements with `key_fn(x) < bound` in a range tagged as sorted by `key_fn` (see `fn::assume_sorted_by`).
+    ///
+    /// The boundary is found by binary search: `O(log(n))` calls to `key_fn`.
+    /// Unlike `take_while` with an arbitrary predicate, this needs no
+    /// assumption about the predicate being monotonic in the sort-key.
+    /*!
+    @code
+        auto res = rows // std::vector<std::pair<std::string, int>>, sorted by name
+          % fn::assume_sorted_by(fn::by::first{})
+          % fn::drop_while_key_lt(std::string("b"))
+          % fn::take_while_key_lt(std::string("d")) // rows with names in ["b", "d")
+          % fn::to_vector();
+    @endcode
+    */
+    template<typename Key>
+    impl::take_while_key_lt<Key> take_while_key_lt(Key bound)
+    {
+        return { std::move(bound) };
+    }
+
+    /// @brief Drop the elements with `key_fn(x) < bound` in a range tagged as sorted by `key_fn` (see `take_while_key_lt`).
+    template<typename Key>
+    impl::drop_while_key_lt<Key> drop_while_key_lt(Key bound)
+    {
+        return { std::move(bound) };
+    }
+
+    /// @brief Return a uniform random sample of `k` elements (or all of them, if fewer), in unspecified order.
+    ///
+    /// Reservoir sampling (Algorithm L): the random number generator
+    /// is invoked `O(k*(1 + log(N/k)))` times rather than once per element.
+    /// For random-access inputs, e.g. `fn::from(vec)` or `fn::cfrom(vec)`,
+    /// the elements that are skipped over are not accessed.
+    ///
+    /// `rng` is a UniformRandomBitGenerator, e.g. `std::mt19937_64`; it is captured by reference.
+    ///
+    /// Buffering space requirements: `O(k)`.
+    /*!
+    @code
+        std::mt19937_64 rng{ 42 };
+        auto qc_rows = fn::cfrom(rows) % fn::sample_n(1000000, rng);
+    @endcode
+    */
+    template<typename URBG>
+    impl::sample_n<URBG> sample_n(size_t k, URBG& rng)
+    {
+        return { k, rng };
+    }
+
+    /// @brief Yield each element independently with probability `p`, preserving the order.
+    ///
+    /// Instead of drawing a random number per element, draws the geometrically-distributed
+    /// distance to the next selected element, so the random number generator is invoked
+    /// once per yielded element. For random-access inputs the skip is an index-jump.
+    ///
+    /// `rng` is a UniformRandomBitGenerator; it is captured by reference.
+    template<typename URBG>
+    impl::sample_fraction<URBG> sample_fraction(double p, URBG& rng)
+    {
+        return { p, rng };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Filter elements.
+    ///
+    /// Returns a unary function-object.
+    /*!
+    @code
+        // 1) If arg is a container passed by lvalue-reference,
+        // return a copy of the container with elements 
+        // satisfying the predicate:
+        auto nonempty_strs = strs % fn::where([](auto&& s) { return !s.empty(); });
+
+        // 2.1) If arg is a sequence container passed by rvalue,
+        // remove the unsatisfying elements using erase-remove idiom and return the container.
+        //
+        // 2.2) If arg is a container having equal_range method (sets, associative containers, etc),
+        // remove the unsatisfying elements using iterate-erase idiom and return the container.
+        strs = std::move(strs) % fn::where([](auto&& s) { return !s.empty(); });
+
+        // 3) If arg is a seq<G>, return adapted seq<...> that shall 
+        // yield elements satisfying the predicate:
+        auto res = fn::seq([i = 0]
+        {
+            return i < 5 ? i++ : fn::end_seq();
+
+        }) % fn::where(     [](int x) { return x > 2; }) // 3, 4
+           % fn::transform( [](int x) { return x + 1; }) // 4, 5
+           % fn::foldl_d(   [](int out, int in) { return out*10 + in; });
+        VERIFY(res == 45);
+    @endcode
+     */
+    template<typename P> 
+    impl::where<P> where(P pred)
+    {
+        return { std::move(pred) };
+    }
+
+    /// @see `where_in_sorted`
+    template<typename SortedForwardRange, typename F> 
+    impl::where<impl::in_sorted_by<SortedForwardRange, F> > where_in_sorted_by(const SortedForwardRange& r, F key_fn)
+    {
+        return { { r, false, { std::move(key_fn) }, 0 } };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Intersect with a sorted range.
+    ///
+    /// `elems %= fn::where_in_sorted(whitelist);`
+    template<typename SortedForwardRange> 
+    impl::where<impl::in_sorted_by<SortedForwardRange, by::identity> > where_in_sorted(const SortedForwardRange& r)
+    {
+        return { { r, false, { { } }, 0 } };
+    }
+
+    /// @see `where_not_in_sorted`
+    template<typename SortedForwardRange, typename F> 
+    impl::where<impl::in_sorted_by<SortedForwardRange, F> > where_not_in_sorted_by(const SortedForwardRange& r, F key_fn)
+    {
+        return { { r, true, { std::move(key_fn) }, 0 } };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Subtract a sorted range.
+    ///
+    /// `elems %= fn::where_not_in_sorted(blacklist);`
+    template<typename SortedForwardRange> 
+    impl::where<impl::in_sorted_by<SortedForwardRange, by::identity> > where_not_in_sorted(const SortedForwardRange& r)
+    {
+        return { { r, true, { { } }, 0 } };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Select elements satisfying the predicate by index, without moving them.
+    ///
+    /// Given an lvalue random-access container or view, yields a selection: a view of
+    /// the original range and a compact vector of indices of the satisfying elements.
+    /// Applying `where_indices` to a selection refines it, evaluating the predicate on
+    /// selected elements only. Use `fn::gather()` to materialize the selected elements,
+    /// or iterate over the selection directly.
+    ///
+    /// For wide records filtered several times in a row, each filter costs 
+    /// one pass over indices, and no records are moved until the final projection.
+    ///
+    /// The container is referenced, and must outlive the selection.
+    /*!
+    @code
+        const auto alns = std::vector<std::pair<std::string, int>>{{ {"a", 1}, {"bb", 20}, {"c", 30}, {"dd", 4} }};
+
+        auto res = alns
+          % fn::where_indices([](const std::pair<std::string, int>& a){ return a.second > 2;       })
+          % fn::where_indices([](const std::pair<std::string, int>& a){ return a.first.size() > 1; })
+          % fn::gather(); // copies, since alns is const
+
+        VERIFY(( res == std::vector<std::pair<std::string, int>>{{ {"bb", 20}, {"dd", 4} }} ));
+    @endcode
+    */
+    template<typename P> 
+    impl::where_indices<P> where_indices(P pred)
+    {
+        return { std::move(pred) };
+    }
+
+    /// @brief Materialize the elements of a selection (see `where_indices`)
+    ///
+    /// Same as `fn::from`, elements are moved from the underlying range,
+    /// unless it is const. Hence the selection must be an rvalue, e.g. `std::move(sel) % fn::gather()`.
+    inline impl::gather gather()
+    {
+        return {};
+    }
+
+
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Filter elements to those having maximum value of fn.
+    ///
+    /*!
+    @code
+        // 1) If Arg is a container (taken by value), find the max-element
+        // and return a vector of max-elements (moved-from the original container).
+        strs = std::move(strs) % fn::where_max_by([](auto&& s) { return s.size(); });
+
+        // 2) If Arg is a seq, iterates the seq and returns
+        // std::vector<seq<...>::value_type> containing maximal elements.
+        auto res = fn::seq([i = 0]
+        {
+            return i < 5 ? i++ : fn::end_seq();
+        }) % fn::where_max_by([](int x) { return x % 2; });
+        VERIFY((res == vec_t{{1, 3}}));
+    @endcode
+
+    Buffering space requirements for `seq`: `O(k)`, where `k` = maximum number of max-elements in a prefix of seq over all prefixes of seq.
+    e.g.
+    <br>`[1,0,1,1,0,1,1,9]: k = 5`
+    <br>`[1,3,1,1,3,1,1,9]: k = 2`
+    */
+    template<typename F> 
+    impl::where_max_by<F> where_max_by(F key_fn)
+    {
+        return { std::move(key_fn), 1 };
+    }
+
+    inline impl::where_max_by<by::identity> where_max()
+    {
+        return { by::identity{}, 1 };
+    }
+
+    /// Filter elements to those having maximum value of fn.
+    /// @see where_max_by
+    template<typename F> 
+    impl::where_max_by<F> where_min_by(F key_fn)
+    {
+        return { std::move(key_fn), -1 };
+    }
+
+    inline impl::where_max_by<by::identity> where_min()
+    {
+        return { by::identity{}, -1 };
+    }
+
+    /// @code
+    /// const bool any  = vals %  fn::exists_where(pred);
+    /// const bool none = vals % !fn::exists_where(pred);
+    /// const bool all =  vals % !fn::exists_where(not_pred);
+    /// @endcode
+    template<typename Pred>
+    impl::exists_where<Pred> exists_where(Pred p)
+    {
+        return { std::move(p), true };
+    }
+
+
+    /// @}
+    /// @defgroup grouping Grouping
+    /// @{
+
+    /// @brief Similar to `group_adjacent_by`, but presorts the elements.
+    ///
+    /// @see group_adjacent_by
+    /*! 
+    @code
+        using alns_t = std::vector<CRef<CSeq_align>>;
+        
+        std::move(alignments)
+
+          % fn::group_all_by([&](CConstRef<CSeq_align> aln) 
+            {    
+                return GetLocusId( aln->GetSeq_id(0) );
+            })   
+
+          % fn::for_each([&](alns_t alns)
+            {    
+                // Process alignments for a locus...
+            });  
+
+       Note: template<typename Container> impl::group_all_by<F>::operator()(Container inputs)
+       takes Container by-value and moves elements into the output.
+    @endcode
+
+    Buffering space requirements for `seq`: `O(N)`.
+    */
+    template<typename F> 
+    impl::group_all_by<F> group_all_by(F key_fn)
+    {
+        return { std::move(key_fn) };
+    }
+
+    inline impl::group_all_by<by::identity> group_all()
+    {
+        return { by::identity{} };
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+
+    /// @brief Group adjacent elements.
+    /// @see group_all_by
+    /// @see concat
+    ///
+    /// If arg is a container, works similar to `group_all_by`, except 
+    /// returns a `std::vector<Container>` where each container
+    /// contains adjacently-equal elements having same value of key.
+    ///
+    /// If arg is a `seq<...>`, composes a `seq<...>`
+    /// that shall yield `vector<value_type>`s having same value of key.
+    /// (NB: if the value_type is a char, the group-type is std::string).
+    ///
+    /// Buffering space requirements for `seq`: `O(max-groupsize)`.
+    template<typename F>
+    impl::group_adjacent_by<F> group_adjacent_by(F key_fn)
+    {
+        return { std::move(key_fn), {} };
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    /// @brief Group adjacent elements.
+    ///
+    /// This is similar to regular `group_adjacent_by`, except the result type
+    /// is a seq yielding subseqs of equivalent elements, rather than vectors.
+    /// @code
+    ///     fn::seq(...) 
+    ///   % fn::group_adjacent_by(key_fn, fn::to_seq()) 
+    ///   % fn::for_each([&](auto group_seq) // type of group_seq is a seq<...> instead of vector<...>
+    ///     {
+    ///         for(auto elem : group_seq) {
+    ///             // ...
+    ///         }
+    ///     });
+    /// @endcode
+    ///
+    /// This is useful for cases where a subseq can be arbitrarily large, and you want
+    /// to process grouped elements on-the-fly without accumulating them in a vector.
+    ///
+    /// This comes at the cost of more constrained functionality, since all groups and
+    /// all elements in each group can only be accessed once and in order.
+    template<typename F>
+    impl::group_adjacent_as_subseqs_by<F> group_adjacent_by(F key_fn, impl::to_seq)
+    {
+        return { std::move(key_fn), {} };
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    /// @brief Tag for `group_adjacent_by(key_fn, fn::in_arena(chunk_size))`.
+    inline impl::in_arena in_arena(size_t chunk_size = 1024 * 1024)
+    {
+        return { chunk_size };
+    }
+
+    /// @brief Group adjacent chars, yielding the groups as `fn::arena_string_view`s into an arena.
+    ///
+    /// The input is a seq of chars, or of `fn::char_block`s (see `fn::from_istream_blocks`).
+    /// Instead of yielding a `std::string` per group, the groups are appended to
+    /// chunks of `chunk_size` chars, so tokenizing a text does not allocate per-token.
+    ///
+    /// A view shares the ownership of its chunk, so the views can be kept (e.g. with
+    /// `fn::to_vector` or `fn::counts`). A chunk is reused once the consumer has
+    /// dropped all views into it, so a streaming consumer cycles through at most two chunks;
+    /// conversely, one long-lived view keeps its whole chunk alive - convert the views to
+    /// `std::string` if only a few of them are kept.
+    /*!
+    @code
+        std::istringstream istr{ "Hello, World!" };
+
+        auto lengths = fn::from_istream_blocks(istr)
+          % fn::group_adjacent_by([](char c){ return bool(std::isalpha(c)); }, fn::in_arena())
+          % fn::transform([](fn::string_view s){ return s.size(); })
+          % fn::to_vector();
+
+        VERIFY(( lengths == std::vector<size_t>({ 5, 2, 5, 1 }) ));
+    @endcode
+    */
+    template<typename F>
+    impl::group_adjacent_in_arena_by<F> group_adjacent_by(F key_fn, impl::in_arena arena)
+    {
+        return { std::move(key_fn), {}, std::max(arena.chunk_size, size_t(1)) };
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+
+    inline impl::group_adjacent_by<by::identity> group_adjacent()
+    {
+        return { by::identity{}, {} };
+    }
+
+    inline impl::group_adjacent_as_subseqs_by<by::identity> group_adjacent(impl::to_seq)
+    {
+        return { by::identity{}, {} };
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+
+    /// @brief Group adjacent elements if binary predicate holds.
+    template<typename BinaryPred>
+    impl::group_adjacent_by<fn::by::identity, BinaryPred> group_adjacent_if(BinaryPred pred2)
+    {
+        return { {}, std::move(pred2) };
+    }
+
+    /// @brief Group adjacent elements if binary predicate holds.
+    template<typename BinaryPred>
+    impl::group_adjacent_as_subseqs_by<fn::by::identity, BinaryPred> group_adjacent_if(BinaryPred pred2, impl::to_seq)
+    {
+        return { {}, std::move(pred2) };
+    }
+
+    /// @brief Group adjacent chars if binary predicate holds, yielding the groups as `fn::arena_string_view`s into an arena.
+    template<typename BinaryPred>
+    impl::group_adjacent_in_arena_by<fn::by::identity, BinaryPred> group_adjacent_if(BinaryPred pred2, impl::in_arena arena)
+    {
+        return { {}, std::move(pred2), std::max(arena.chunk_size, size_t(1)) };
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+
+
+    /// @brief Group adjacent elements into chunks of specified size.
+    /*!
+    @code
+        std::move(elems) 
+      % fn::in_groups_of(5)
+      % fn::for_each(auto&& group)
+        {
+            ASSERT(group.size() <= 5);
+        });
+    @endcode
+
+    Buffering space requirements for `seq`: `O(n)`.
+    */
+    inline impl::group_adjacent_by<impl::chunker> in_groups_of(size_t n)
+    {
+        if(n < 1) {
+            RANGELESS_FN_THROW("Batch size must be at least 1.");
+        }
+        return { impl::chunker{ n, 0 }, {} };
+    }
+
+
+    /// @}
+    /// @defgroup ordering Ordering
+    /// @{
+
+    /// @brief Reverse the elements in the input container.
+    ///
+    /// Buffering space requirements for `seq`: `O(N)`.
+    inline impl::reverse reverse()
+    {
+        return {};
+    }
+
+    /// @brief stable-sort and return the input.
+    /*! 
+    @code
+        auto res = 
+            std::list<std::string>{{ "333", "1", "22", "333", "22" }}
+          % fn::to_vector()
+          % fn::sort_by([](const std::string& s) 
+            {
+                return fn::by::decreasing(s.size());
+            })
+          % fn::unique_adjacent();
+
+        VERIFY(( res == std::vector<std::string>{{ "333", "22", "1" }} ));
+    @endcode
+
+    Buffering space requirements for `seq`: `O(N)`.
+    */
+    template<typename F>
+    impl::sort_by<F, impl::stable_sort_tag> sort_by(F key_fn)
+    {
+        return { std::move(key_fn) };
+    }
+
+    /// @brief `sort_by with key_fn = by::identity`
+    inline impl::sort_by<by::identity, impl::stable_sort_tag> sort()
+    {
+        return { by::identity{} };
+    }
+
+
+    template<typename F>
+    impl::sort_by<F, impl::unstable_sort_tag> unstable_sort_by(F key_fn)
+    {
+        return { std::move(key_fn) };
+    }
+
+    inline impl::sort_by<by::identity, impl::unstable_sort_tag> unstable_sort()
+    {
+        return { by::identity{} };
+    }
+
+
+    /// @brief Tag a container or a view as sorted by `key_fn`, allowing downstream stages to exploit it.
+    ///
+    /// - `take_while_key_lt`, `drop_while_key_lt` binary-search for the boundary of the key-range
+    /// (`take_while`, `drop_while` with an arbitrary predicate stay linear).
+    /// - `unique_all_by`, `group_all_by` skip their internal sort (the type of `key_fn` must be the same,
+    /// e.g. pass the same lambda object to both).
+    /// - `counts` counts run-lengths (if tagged with `assume_sorted()`).
+    /// - `where_in_sorted` lookups proceed as a merge rather than a binary-search per element
+    /// (this works for sorted inputs regardless of the tag).
+    ///
+    /// Stages that preserve the order (`take_last`, `drop_last`, `where`, etc.) keep the tag;
+    /// `sort_by`, `reverse` and `to_vector` drop it; lazy stages yield an untagged `seq`.
+    ///
+    /// Debug builds verify the ordering (`assert`).
+    /*!
+    @code
+        auto res = std::vector<int>{{ 1, 2, 2, 3, 5, 8, 8, 9 }}
+          % fn::assume_sorted()
+          % fn::drop_while_key_lt(2)                   // O(log(n))
+          % fn::take_while_key_lt(9)                   // O(log(n))
+          % fn::unique_all()                           // no sorting
+          % fn::to_vector();
+
+        VERIFY(( res == std::vector<int>{{ 2, 3, 5, 8 }} ));
+    @endcode
+    */
+    template<typename F>
+    impl::assume_sorted_by<F> assume_sorted_by(F key_fn)
+    {
+        return { std::move(key_fn) };
+    }
+
+    /// @brief `assume_sorted_by with key_fn = by::identity`
+    inline impl::assume_sorted_by<by::identity> assume_sorted()
+    {
+        return { by::identity{} };
+    }
+
+    /// @brief Stable-sort indirectly: sort a permutation of indices by key, and then
+    /// apply it in-place by following its cycles, such that each element is moved exactly once.
+    ///
+    /// This is more efficient than `sort_by` for large or expensive-to-move elements
+    /// (e.g. records of hundreds of bytes), where the element-moves
+    /// done by `std::stable_sort`'s merges would dominate. Supports move-only types.
+    ///
+    /// For non-random-access containers, e.g. `std::list`, sort the references
+    /// instead: `fn::refs(lst) % fn::sort_by_indirect(key_fn)`.
+    /*!
+    @code
+        auto res = std::vector<std::pair<std::string, int>>{{ {"b", 0}, {"a", 1}, {"b", 2}, {"a", 3} }}
+          % fn::sort_by_indirect(fn::by::first{});
+
+        VERIFY(( res == std::vector<std::pair<std::string, int>>{{ {"a", 1}, {"a", 3}, {"b", 0}, {"b", 2} }} ));
+    @endcode
+
+    Buffering space requirements for `seq`: `O(N)`; additional `O(N)` indices.
+    */
+    template<typename F>
+    impl::sort_by_indirect<F> sort_by_indirect(F key_fn)
+    {
+        return { std::move(key_fn) };
+    }
+
+    /// @brief Unstable lazy sort.
+    ///
+    /// Initially move all inputs into a `std::vector` in `O(n)`,
+    /// and then lazily yield elements using incremental quicksort,
+    /// partitioning only the prefix that is needed to produce the next element,
+    /// such that consuming the first `k` elements costs `O(n + k*log(k))`.
+    /// This is more efficient if the downstream stage is expected to consume
+    /// a small fraction of sorted inputs.
+    ///
+    /// Buffering space requirements for `seq`: `O(N)`.
+    template<typename F>
+    impl::lazy_sort_by<F, impl::unstable_sort_tag> lazy_sort_by(F key_fn)
+    {
+        return { std::move(key_fn) };
+    }
+
+    /// @brief `lazy_sort_by with key_fn = by::identity`
+    inline impl::lazy_sort_by<by::identity, impl::unstable_sort_tag> lazy_sort()
+    {
+        return { by::identity{} };
+    }
+
+    /// @brief Stable lazy sort.
+    ///
+    /// Same as `lazy_sort_by`, but elements with equivalent keys
+    /// are yielded in their original order (ties are broken on the input ordinal).
+    /*!
+    @code
+        auto res = std::vector<std::pair<int, int>>{{ {2, 0}, {1, 1}, {2, 2}, {1, 3} }}
+          % fn::lazy_stable_sort_by(fn::by::first{})
+          % fn::take_first(3)
+          % fn::to_vector();
+
+        VERIFY(( res == std::vector<std::pair<int, int>>{{ {1, 1}, {1, 3}, {2, 0} }} ));
+    @endcode
+
+    Buffering space requirements for `seq`: `O(N)`.
+    */
+    template<typename F>
+    impl::lazy_sort_by<F, impl::stable_sort_tag> lazy_stable_sort_by(F key_fn)
+    {
+        return { std::move(key_fn) };
+    }
+
+    /// @brief `lazy_stable_sort_by with key_fn = by::identity`
+    inline impl::lazy_sort_by<by::identity, impl::stable_sort_tag> lazy_stable_sort()
+    {
+        return { by::identity{} };
+    }
+
+    /// @brief Lazily stable-sort a stream that is sorted except for bounded lateness,
+    /// where each element is at most `k` positions out of place.
+    ///
+    /// The implementation maintains a min-heap of `k+1` elements, and yields the min
+    /// whenever the heap is full, so it can be used on unbounded streams, e.g. of
+    /// events ordered by timestamp. Elements in violation of the bound (i.e.
+    /// ones with key less than that of an already-yielded element) cause an exception.
+    /*!
+    @code
+        auto res = std::vector<int>{{ 2, 1, 3, 5, 4, 6 }}
+          % fn::sort_by_bounded_disorder(fn::by::identity{}, 1)
+          % fn::to_vector();
+
+        VERIFY(( res == std::vector<int>{{ 1, 2, 3, 4, 5, 6 }} ));
+    @endcode
+
+    Buffering space requirements: `O(k)`; time complexity: `O(N*log(k))`.
+    */
+    template<typename F>
+    impl::sort_by_bounded_disorder<F, impl::throw_on_late> sort_by_bounded_disorder(F key_fn, size_t k)
+    {
+        return { std::move(key_fn), k, {} };
+    }
+
+    /// @brief Same as above, but instead of throwing, divert the elements
+    /// in violation of the bound to `on_late` (e.g. a side-channel), 
+    /// called with each such element as rvalue.
+    template<typename F, typename OnLate>
+    impl::sort_by_bounded_disorder<F, OnLate> sort_by_bounded_disorder(F key_fn, size_t k, OnLate on_late)
+    {
+        return { std::move(key_fn), k, std::move(on_late) };
+    }
+
+    /// @brief Return top-n elements, sorted by key_fn.
+    ///
+    /// This is conceptually similar to `fn::sort_by(key_fn) % fn::take_last(n)`,
+    /// but is more efficient: the implementation mantains a priority-queue of
+    /// top-n max-elements encountered so-far.
+    ///
+    /// Buffering space requirements: `O(n)`; time complexity: `O(N*log(n))`
+    template<typename F>
+    impl::take_top_n_by<F> take_top_n_by(size_t n, F key_fn)
+    {
+        return { std::move(key_fn), n };
+    }
+
+    /// @brief Return top-n elements, sorted by identity.
+    inline impl::take_top_n_by<by::identity> take_top_n(size_t n)
+    {
+        return { by::identity{}, n };
+    }
+
+
+
+    /// @}
+    /// @defgroup uniq Uniquefying
+    /// @{
+
+    /// @brief Keep first element from every adjacently-equal run of elements.
+    /// 
+    /// If arg is a container, apply erase-unique idiom and return
+    /// the container.
+    ///
+    /// If arg is a `seq<In>`, compose `seq<Out>` that
+    /// will yield first element from every adjacently-equal run of elements.
+    template<typename F>
+    impl::unique_adjacent_by<F> unique_adjacent_by(F key_fn)
+    {
+        return { std::move(key_fn) };
+    }
+
+    inline impl::unique_adjacent_by<by::identity> unique_adjacent()
+    {
+        return { by::identity{} };
+    }
+
+    /// @brief Uniquefy elements globally, as-if `unique_adjacent_by` pre-sorted by same key.
+    ///
+    /// If arg is a container, move contents to vector, and then sort-by and unique-adjacent-by.
+    ///
+    /// If arg is a `seq<In>`, compose `seq<Out>` that will
+    /// keep values of key_fn in a set, and skip already-seen elements. 
+    ///
+    /// NB: the lifetime of value returned by key_fn must be independent of arg.
+    template<typename F>
+    impl::unique_all_by<F> unique_all_by(F key_fn)
+    {
+        return { std::move(key_fn) };
+    }
+
+    inline impl::unique_all_by<by::identity> unique_all()
+    {
+        return { by::identity{} };
+    }    
+
+    /// @brief Drop elements whose key occurred among the preceding `n` elements.
+    ///
+    /// Unlike `unique_all_by`, which remembers every key, the memory is bounded by the window,
+    /// so this is suitable for unbounded streams, e.g. from `mt::synchronized_queue`.
+    /// Backed by a hash-map (see `approx_distinct_by` for the supported key-types) and a FIFO;
+    /// amortized O(1) per element. The inputs are processed lazily.
+    ///
+    /// NB: the lifetime of value returned by key_fn must be independent of arg.
+    /*!
+    @code
+        VERIFY(( vec_t{{ 1, 2, 1, 3, 1, 2, 2 }} % fn::unique_within_by(fn::by::identity{}, 2) % fn::to_vector()
+              == vec_t{{ 1, 2, 3, 2 }} ));
+    @endcode
+    */
+    template<typename F>
+    impl::unique_within_by<F, impl::window_last_n> unique_within_by(F key_fn, size_t n)
+    {
+        return { std::move(key_fn), { n } };
+    }
+
+    /// @brief Drop elements whose key occurred less than `span` ago, as measured by `time_fn(elem)`.
+    ///
+    /// The times shall be non-decreasing; `Span` is the type of the difference of two times,
+    /// e.g. `std::chrono::seconds` for time-points, or an integer for integer timestamps.
+    template<typename F, typename Span, typename TimeFn>
+    impl::unique_within_by<F, impl::window_span<Span, TimeFn>> unique_within_by(F key_fn, Span span, TimeFn time_fn)
+    {
+        return { std::move(key_fn), { std::move(span), std::move(time_fn) } };
+    }
+
+    /// @brief Drop elements whose key is among the `capacity` most-recently-seen keys.
+    template<typename F>
+    impl::unique_within_by<F, impl::window_lru> unique_within_lru_by(F key_fn, size_t capacity)
+    {
+        return { std::move(key_fn), { capacity } };
+    }
+    
+
+    /// @}
+    /// @defgroup concat Combining
+    /// @{
+
+    /// @brief Flatten the result of `group_all_by` or `group_adjacent_by`. 
+    ///
+    /// Given a `ContainerA<ContainerB<...>>`, move all elements and return `ContainerB<...>`.
+    ///
+    /// Given a seq-of-iterables `seq<In>`, compose `seq<Out>` that will lazily yield elements 
+    /// of each iterable in seq.
+    inline impl::concat concat()
+    {
+        return {};
+    }
+
+    /// @brief Yield elements of next after elements of arg.
+    /*!
+    @code
+        auto res = vec_t{{1,2}}
+                 % fn::append( vec_t{{3}} )
+                 % fn::to_vector();
+
+        VERIFY((res == vec_t{{1,2,3}}));
+    @endcode
+    */
+    template<typename Iterable>
+    impl::append<Iterable> append(Iterable next)
+    {
+        return { std::move(next) };
+    }
+
+    /// @brief Yield pairs of elements, (up to end of the shorter range)
+    /*!
+    @code
+        auto res = vec_t{{1,2}}
+                 % fn::zip_with( vec_t{{3,4,5}}, [](int x, int y)
+                   {
+                        return x*10 + y;
+                   })
+                 % fn::to_vector();
+
+        VERIFY((res == vec_t{{13, 24}}));
+    @endcode
+    */
+    template<typename Iterable, typename BinaryFn>
+    impl::zip_with<Iterable, BinaryFn> zip_with(Iterable second, BinaryFn fn)
+    {
+        // We could have provided zip2 instead, returning a pair of elements,
+        // but more often than not that pair will need to be transformed,
+        // so instead we provide generalized zip_with that also takes the
+        // binary transform-function, obviating the need in separate transform-stage.
+        // If necessary, the transform-function can simply yield std::make_pair.
+
+        return { std::move(second), std::move(fn) };
+    }
+
+    /// @brief Yield invocations of `fn` over pairs of adjacent inputs.
+    template<typename BinaryFn>
+    impl::zip_adjacent<BinaryFn> zip_adjacent(BinaryFn fn)
+    {
+        return { std::move(fn) };
+    }
+
+    // @brief Outer zip_with.
+    template<typename Iterable, typename BinaryFn>
+    impl::cartesian_product_with<Iterable, BinaryFn> cartesian_product_with(Iterable second, BinaryFn fn)
+    {
+        return { std::move(second), std::move(fn) };
+    }
+
+    /// @}
+    /// @defgroup el_access Element Access
+    /// @{
+
+    /////////////////////////////////////////////////////////////////////////////
+    /*! @brief Access unique element matching the predicate.
+     *
+     * Throw unless found exactly one element matching the predicate.
+     * Returns const or non-const reference depending on the constness of the container.
+     * @see set_unique
+    @code
+        const CConstRef<CUser_object>& model_evidence_uo = 
+            fn::get_unique(seq_feat.GetExts(), [](CConstRef<CUser_object> uo)
+            {
+                return uo->GetType().GetStr() == "ModelEvidence";
+            });
+    @endcode
+    */
+    template<typename Container, typename P>
+    auto get_unique(Container& container, P&& pred) -> decltype(*container.begin())
+    {
+        auto best_it = container.end();
+        size_t n = 0;
+
+        for(auto it   = container.begin(), 
+                 it_end = container.end();
+
+                 it != it_end; ++it)
+        {
+            if(pred(*it)) {
+                best_it = it;
+                ++n;
+            }
+        }
+
+        if(n != 1) {
+            RANGELESS_FN_THROW("Expected unique element satisfying search criteria, found " 
+                          + std::to_string(n) + ".");
+        }
+
+        return *best_it;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    /// @brief Similar to get_unique, but end-insert an element if missing.
+    ///
+    /*!
+    @code
+        CRef<CSeqdesc>& gb_desc =
+            fn::set_unique(seq_entry.SetDescr().Set(), [](CConstRef<CSeqdesc> d)
+            {    
+                return d->IsGenbank();
+            },   
+            [] // add if missing (must satisfy pred)
+            {    
+                auto g = Ref(new CSeqdesc);
+                g->SetGenbank();
+                return g;
+            });  
+    @endcode
+    */
+    template<typename Container, typename P, typename Construct>
+    auto set_unique(Container& container, P&& pred, Construct&& con) -> decltype(*container.begin())
+    {
+        auto best_it = container.end();
+        size_t n = 0;
+
+        for(auto it   = container.begin(), 
+                 it_end = container.end();
+
+                 it != it_end; ++it)
+        {
+            if(pred(*it)) {
+                best_it = it;
+                ++n;
+            }
+        }
+
+        if(n == 0) {
+            best_it = container.insert(container.end(), con());
+            ++n;
+            if(!pred(*best_it)) {
+                RANGELESS_FN_THROW("New element does not satisfy predicate.");
+            }
+        }
+
+        if(n != 1) {
+            RANGELESS_FN_THROW("Expected unique element satisfying search criteria, found " 
+                          + std::to_string(n) + ".");
+        }
+
+        return *best_it;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /// e.g. `const CConstRef<CSeq_align> aln = first_or_default( get_alns_annot(...)->Get() );`
+    template<typename Container>
+    auto first_or_default(const Container& c) -> typename Container::value_type
+    {
+        return c.begin() == c.end() ? typename Container::value_type{} : *c.begin();
+    }
+
+    template<typename Container, typename Pred>
+    auto first_or_default(const Container& c, Pred&& pred) -> typename Container::value_type
+    {
+        auto it = std::find_if(c.begin(), c.end(), std::forward<Pred>(pred));
+        return it == c.end() ? typename Container::value_type{} : *it;
+    }
+
+    template<typename Container>
+    auto last_or_default(const Container& c) -> typename Container::value_type
+    {
+        return c.rbegin() == c.rend() ? typename Container::value_type{} : *c.rbegin();
+    }
+
+    template<typename Container, typename Pred>
+    auto last_or_default(const Container& c, Pred&& pred) -> typename Container::value_type
+    {
+        auto it = std::find_if(c.rbegin(), c.rend(), std::forward<Pred>(pred));
+        return it == c.rend() ? typename Container::value_type{} : *it;
+    }
+
+    /// @}
+    /// @defgroup other Util
+    /// @{
+
+    /// @brief Memoizing wrapper for non-recursive non-mutable unary lambdas (not synchronized).
+    /*!
+    @code
+        size_t exec_count = 0;
+        auto fn = make_memoized([&](int x){ exec_count++; return x*2; });
+        
+        VERIFY(fn(1) == 2);
+        VERIFY(fn(2) == 4);
+        VERIFY(fn(1) == 2);
+        VERIFY(exec_count == 2);
+    @endcode
+    */
+    template<typename F>
+    impl::memoizer<F> make_memoized(F fn)
+    {
+        return { std::move(fn), {} };
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    /// @brief Basic scope guard - execute some code in guard`s destructor.
+    /*!
+    @code
+        {{
+            // ...
+
+            auto on_exit = fn::make_scope_guard([&]
+            {
+                std::cerr << "Executing clean-up or roll-back...\n";
+            });
+
+            on_exit.dismiss(); // Cancel if no longer applicable.
+        }}
+    @endcode
+    */
+    template<typename F>
+    impl::scope_guard<F> make_scope_guard(F fn)
+    {
+        return { std::move(fn), false };
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    /// Similar to `std::tie`; except capture lvalues as lvalue-references, and rvalues as values.
+    /*!
+    @code
+        const int x = 0;
+        const char* foo = "foo";
+        auto tpl = fn::tie_lvals(x, 42, std::ref(x), foo, "abc");
+        static_assert(std::is_same<decltype(tpl), std::tuple<const int&, int, std::reference_wrapper<const int>, const char*&, const char (&)[4]>>::value, "");
+    @code
+    */
+    template<typename... Ts>
+    auto tie_lvals(Ts&&... xs) -> std::tuple<Ts...>
+    {
+        return std::tuple<Ts...>(std::forward<Ts>(xs)...);
+    }
+
+    /// @}
+
+
+namespace operators
+{
+    // Why operator % ?
+    // Because many other libraries overload >> or | for various purposes,
+    // so in case of compilation errors involving those 
+    // you get an honorable mention of every possible overload in TU.
+    //
+    // Also, in range-v3 it is used for composition of views
+    // rather than a function application, so we want to avoid possible confusion.
+
+    /// @brief `return std::forward<F>(fn)(std::forward<Arg>(arg))`
+    ///
+    /// This is similar to Haskell's operator `(&) :: a -> (a -> b) -> b |infix 1|` or F#'s operator `|>`
+    
+#if 0 && (defined(__GNUC__) || defined(__clang__))
+    __attribute__ ((warn_unused_result))
+    // A user may forget to iterate over the sequence, e.g.
+    //         std::move(inputs) % fn::transform(...); // creates and immediately destroys a lazy-seq.
+    // whereas the user code probably intended:
+    //         std::move(inputs) % fn::transform(...) % fn::for_each(...);
+    // 
+    // To deal with this we could make operator% nodiscard / warn_unused_result,
+    // but disabling for now because I can't figure out how to suppress the 
+    // warning from the final % for_each(...).
+#endif 
+    template<typename Arg, typename F>
+    auto operator % (Arg&& arg, F&& fn) -> decltype( std::forward<F>(fn)(std::forward<Arg>(arg)) )
+    {
+        // NB: forwarding fn too because it may have rvalue-specific overloads
+        return std::forward<F>(fn)(std::forward<Arg>(arg));
+    }
+
+    // Note: in operator %= and <<= below we're not returning the original reference
+    // because the operators are right-to-left associative, so it makes no sense to do it.
+
+    /// @brief `arg = fn::to(Arg{})(std::forward<F>(fn)(std::move(arg)));`
+    ///
+    /// `strs %= fn::where([](const std::string& s){ return !s.empty(); }); // drop empty strings`
+    template<typename Arg, typename F>
+    auto operator %= (Arg& arg, F&& fn) -> decltype(void(std::forward<F>(fn)(std::move(arg))))
+    {
+        // NB: forwarding fn too because it may have rvalue-specific overloads.
+        // Note: result-type may be not the same as arg, so we 
+        // have to move the elements rather than simply assign.
+        arg = fn::to(Arg{})(std::forward<F>(fn)(std::move(arg)));
+    }
+
+    /// @brief End-insert elements of cont2 into cont1 by-move.
+    /*!
+    @code
+        out <<= GetItems();
+
+        // equivalent of:
+        {{
+            auto items = GetItems();
+            for(auto&& item : items) {
+                out.insert(out.end(), std::move(item));
+            }
+        }}
+    @endcode
+    */
+    template<class Container1, class Container2>
+    auto operator<<=(Container1& cont1, 
+                    Container2&& cont2) -> decltype(void(cont1.insert(cont1.end(), std::move(*cont2.begin()))))
+    {
+        static_assert(std::is_rvalue_reference<Container2&&>::value, "");
+        cont1.insert(cont1.end(),
+                     std::make_move_iterator(cont2.begin()),
+                     std::make_move_iterator(cont2.end()));
+    }
+
+    // Could also take Container2 by value, but taking by rvalue-reference instead
+    // will preserve the internal storage of the container (instead of it being 
+    // freed here when going out of scope if we took it by value). In some cases
+    // this may be desirable. So instead having separate overloads for 
+    // Container2&& and const Container2& that will copy elements.
+
+    template<class Container1, class Container2>
+    auto operator<<=(Container1& cont1, 
+               const Container2& cont2) -> decltype(void(cont1.insert(cont1.end(), *cont2.begin())))
+    {
+        cont1.insert(cont1.end(),
+                     cont2.begin(),
+                     cont2.end());
+    }
+
+    // I would have expected that seq-based input would work with the above overload as well,
+    // but that is not so - after wrapping into std::make_move_iterator we're getting 
+    // compilation errors about missing operators +,+=,-,-= for the iterator.
+    // Hence the special overload for seq (it already yields rvalue-references)
+    template<class Container1, class Gen>
+    void operator<<=(Container1& cont1, impl::seq<Gen> seq)
+    {
+        cont1.insert(cont1.end(), seq.begin(), seq.end());
+    }
+
+    template<class Container>
+    void operator<<=(Container& cont, typename Container::value_type el)
+    {
+         cont.insert(cont.end(), std::move(el));
+    }
+
+} // namespace operators
+
+} // namespace fn
+
+} // namespace rangeless
+        
+#if RANGELESS_ENABLE_TSV
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <cctype> // for MSVC v19.16
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h> // for jsonl
+#endif
+
+namespace rangeless
+{
+namespace tsv
+{
+    using row_t = std::vector<std::string>;
+
+    struct params
+    {
+        std::string header = "";    
+        // If specified, throw unless it is encountered verbatim in data before first data-row.
+        // Used for checking that the file content corresponds to the program's expectations.
+        // Skipped, even if skip_comments = false.
+        //
+        //  e.g. "#Col1 name\tCol2 name"  - Column names are in a comment before the data rows.
+        //   or  "Col1 name\tCol2 name"   - Column names are in the first data-row.
+        //   or  "# File descriptor 42"   - some arbitrary comment. 
+
+        std::string filename  = "";    // Report filename in exception messages.
+                                        
+        bool skip_comments    = true;  // Skip lines starting with '#'.
+        bool truncate_blanks  = true;  // Truncate leading and trailing spaces.
+        bool skip_empty       = true;  // Skip lines that are empty (checked after truncate_blanks is applied).
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+
+    class get_next_line
+    {
+    public: 
+        get_next_line(std::istream& istr, params p = params{})
+            :   m_istr{ istr }
+            , m_params{ std::move(p) }
+        {}
+
+        auto operator()() -> std::reference_wrapper<const std::string>
+        {
+            if(!m_istr) {
+                throw std::runtime_error("Stream " + m_params.filename + " is not in good state before reading.");
+            }
+
+            m_line.clear();
+            while(std::getline(m_istr, m_line))
+                if(x_prepare())
+            {
+                return { m_line };
+            }
+
+            if(    m_istr.bad() 
+               || (m_istr.fail() && !m_istr.eof()) 
+               || !m_line.empty())
+            {
+                throw std::runtime_error("Stream " + m_params.filename + " terminated abnormally.");
+            } else {
+                rangeless::fn::end_seq(); // finished normally.
+            }
+
+            return { m_line };
+        }
+
+    private:
+        std::istream& m_istr;
+         const params m_params;
+                 bool m_found_header = false;
+          std::string m_line         = "";
+
+        // preprocess the line and return true iff returnable
+        bool x_prepare()
+        {
+            if(!m_line.empty() && m_line.back() == '\r') {
+                m_line.pop_back();
+            }
+
+            const bool is_comment = !m_line.empty() && m_line[0] == '#';
+
+            if(    !m_params.header.empty()
+                && !m_found_header
+                && m_line == m_params.header)
+            {
+                m_found_header = true;
+                m_line.clear();
+                return false;
+            }
+
+            if(m_params.truncate_blanks) {
+                while(!m_line.empty() && m_line.back() == ' ') {
+                    m_line.pop_back();
+                }
+
+                size_t i = 0;
+                while(i < m_line.size() && m_line[i] == ' ') {
+                    ++i;
+                }
+                m_line.erase(0, i);
+            }
+
+            if( (m_params.skip_empty    &&  m_line.empty())
+             || (m_params.skip_comments && !m_line.empty() && m_line[0] == '#'))
+            {
+                m_line.clear();
+                return false;
+            }
+
+            if(    !m_line.empty() && !is_comment // data-line
+                && !m_params.header.empty() && !m_found_header) // did not find expected header-line
+            {
+                throw std::runtime_error(
+                        "Did not find expected header: '" 
+                       + m_params.header + "'" 
+                       + (m_params.filename.empty() ? "" : ( " in file: " + m_params.filename)));
+            }
+
+            return true;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+
+    class split_on_delim
+    {
+    private:
+        const char m_delim;
+        const bool m_truncate_blanks;
+        tsv::row_t m_row;
+
+    public:
+        split_on_delim(char delim = '\t', bool truncate_blanks = true)
+          : m_delim{ delim }
+          , m_truncate_blanks{ truncate_blanks }
+          , m_row{}
+        {}
+
+        // If we're an rvalue, support usage like `const auto row = tsv::split_on_delim{ ',' }("a,bb,ccc");` 
+        // or, if we want to reuse existing row's storage: `row = tsv::spit_on_delim{ ',' }("a,bb,ccc", std::move(row));`
+        auto operator()(const std::string& line, row_t ret = {}) const && -> tsv::row_t
+        {
+            ret.resize(size_t(1 + std::count(line.begin(), line.end(), m_delim)));
+
+            size_t i = 0;
+            auto capture_next = [&](size_t b, size_t e)
+            {
+                if(e == std::string::npos) {
+                    e = line.size();
+                }
+
+                while(m_truncate_blanks && b < e && line[b] == ' ') {
+                    ++b;
+                }
+                while(m_truncate_blanks && b < e && line[e-1] == ' ') {
+                    --e;
+                }
+
+                ret[i++].assign(line, b, e - b);
+            };
+
+            size_t start_pos = 0, end_pos = 0;
+
+            do {
+                end_pos = line.find(m_delim, start_pos);
+                capture_next(start_pos, end_pos);
+                start_pos = end_pos + 1;
+            } while(end_pos != std::string::npos);
+
+            return ret; // copy elision guaranteed here in c++11?
+        }
+
+        // The operator below is for repeated invocations when we're an lvalue.
+        //
+        // To prevent unnecesary heap allocatinos, instead of returning row_t,
+        // we return a const reference-wrapper, and reuse the allocated storage
+        // in m_row.
+        auto operator()(const std::string& line) & -> std::reference_wrapper<const tsv::row_t>
+        {
+            m_row = std::move(*this)(line, std::move(m_row));
+            return { m_row };
+        }
+    };
+
+    /// @brief Read tab-separated-values from stream.
+    /*!
+    @code
+    std::string result = "";
+    std::istringstream istr{"foo\n#comment\n\n\n  bar  \tbaz\n"};
+
+    for(const std::vector<std::string>& row : tsv::from(istr)) {
+        for(const auto& f : row) {
+            result += f;
+            result += "|";
+        }
+        result += ";";
+    });
+
+    VERIFY(result == "foo|;bar|baz|;");
+    @endcode
+    */
+    inline auto from(std::istream& istr, char delim = '\t', params params = {}) 
+        -> fn::impl::seq<
+                fn::impl::transform< tsv::split_on_delim >::gen<
+                    fn::impl::catch_end< tsv::get_next_line > > >
+    {
+        const auto truncate_blanks = params.truncate_blanks; // params will be moved from.
+        return fn::transform( split_on_delim{ delim, truncate_blanks } )( 
+                     fn::seq(  get_next_line{ istr,  std::move(params) }) );
+    }
+
+    /// @brief Utility to parse numbers.
+    ///
+    /// This is a dispatcher for `std::strto*` functions with additional functionality:
+    /// throws `std::domain_error` if can't parse, or out of bounds, or input has trailing non-whitespaces, or the destination type is unsigned and the input is a negative number.
+    /*!
+     * @code
+     * double   a = tsv::to_num("");         // throws - expected a number
+     * double   b = tsv::to_num(" 123xyz");  // throws - trailing garbage not allowed
+     * int8_t   c = tsv::to_num(" 12345 ");  // throws - out of range
+     * float    d = tsv::to_num("12e-456");  // throws - underflow
+     * uint16_t e = tsv::to_num("-1");       // throws - negative number while destination is unsigned
+     * @endcode
+     */
+    class to_num
+    {
+    public:
+        to_num(const to_num&) = delete; // prevent nonsense like auto x = tsv::num("123") from compiling
+        to_num& operator=(const to_num&) = delete;
+
+        explicit to_num(const char* str) 
+          : m_beg{ str }
+          , m_end{ m_beg + std::strlen(str) } 
+        {}
+
+        template<typename Str> // string, string_view, CTempString etc.
+        explicit to_num(const Str& str) 
+          : m_beg{ str.begin() == str.end() ? nullptr : &*str.begin() }
+          , m_end{ str.begin() == str.end() ? nullptr : &*str.begin() + str.size() }
+        {}
+
+        /// Conversion to an enum or enum-class
+        template<typename Enum, typename std::enable_if<std::is_enum<Enum>::value>::type* = nullptr>
+        operator Enum() const && // rvalue-specific such that no possibility of m_beg/m_end becoming dangling
+        {
+            auto value = typename std::underlying_type<Enum>::type{};
+            value = std::move(*this);
+            return Enum(value);
+        }
+
+        /// Conversion to an arithmetic type
+        template<typename Number, typename std::enable_if<std::is_arithmetic<Number>::value>::type* = nullptr>
+        operator Number() const &&
+        {
+            auto ret = Number{};
+            char* endptr = nullptr;
+            
+            errno = 0;
+            x_parse(ret, &endptr);
+
+            throw_if(errno,                      ret, "under-or-overflow"); 
+            throw_if(!endptr || endptr == m_beg, ret, "could not interpret");
+            throw_if(endptr > m_end,             ret, "parsed past the end");
+
+            for(; endptr < m_end; ++endptr) { // verify that there's no garbage past the end
+                throw_if(!std::isspace(*endptr), ret, "trailing non-whitespace characters");
+            }
+            return ret;
+        }
+
+        /// Convert to `uint8_t` first; throw unless 0 or 1; return as bool.
+        operator bool() const &&
+        {
+            uint8_t ret = std::move(*this);
+            throw_if(ret != 0 && ret != 1, ret, "out of bounds");
+            return ret;
+        }
+
+    private:
+        const char* m_beg;
+        const char* m_end;
+
+        template<typename T>
+        void throw_if(bool cond, const T&, const char* message) const
+        {
+            if(cond) {
+                throw std::domain_error(
+                    "Can't parse '" 
+                  + std::string(m_beg, size_t(m_end-m_beg))
+                  + "' as numeric type '" + typeid(T).name() 
+                  + "' - " + message + ".");
+            }
+        }
+
+        void x_parse(long double& d, char** endptr) const
+        {
+            d = std::strtold(m_beg, endptr);
+        }
+
+        void x_parse(double& d, char** endptr) const
+        {
+            d = std::strtod(m_beg, endptr);
+        }
+        
+        void x_parse(float& d, char** endptr) const
+        {
+            d = std::strtof(m_beg, endptr);
+        }
+
+        // NB: originally had two functions below as one function and 
+        // chose dynamically how to parse based on std::is_signed<Integral>::value,
+        // but had to switch to static-dispatch to avoid the signed-vs-unsigned 
+        // comparison warnings
+
+        template<typename Integral, typename std::enable_if<std::is_signed<Integral>::value>::type* = nullptr >
+        void x_parse(Integral& x, char** endptr) const
+        {
+            static_assert(std::is_integral<Integral>::value, "");
+            auto num = std::strtoll(m_beg, endptr, 10);
+            x = static_cast<Integral>(num);
+            throw_if(x != num, x, "overflow");
+        }
+
+        template<typename Integral, typename std::enable_if<std::is_unsigned<Integral>::value>::type* = nullptr >
+        void x_parse(Integral& x, char** endptr) const
+        {
+            static_assert(std::is_integral<Integral>::value, "");
+            auto ptr = m_beg;
+            while(ptr < m_end && std::isspace(*ptr)) {
+                ++ptr;
+            }
+            throw_if(ptr < m_end && *ptr == '-', x, "negative number in unsigned conversion");
+
+            auto num = std::strtoull(ptr, endptr, 10);
+            x = static_cast<Integral>(num);
+            throw_if(x != num, x, "overflow");
+        }
+    }; // to_num
+
+
+} // namespace tsv
+
+/// @brief Reading JSON Lines (one JSON object per line).
+namespace jsonl
+{
+    using fn::string_view;
+
+    /// @brief Structural index of a line: positions of `{}[]:,` outside of
+    /// strings, and of the quotes delimiting the strings.
+    ///
+    /// With SSE2, the candidate characters are located 16 bytes at a time,
+    /// and only those are inspected one by one, to track the strings and escapes.
+    inline void index_structurals(string_view line, std::vector<uint32_t>& tape)
+    {
+        if(line.size() >= (uint64_t(1) << 32)) {
+            throw std::runtime_error("JSON line is too long.");
+        }
+
+        tape.clear();
+
+        const char* const p = line.data();
+        const size_t n      = line.size();
+        bool   in_string    = false;
+        size_t escaped_pos  = size_t(-1);
+        int    depth        = 0;
+
+        auto on_char = [&](size_t i)
+        {
+            const char c = p[i];
+
+            if(in_string) {
+                if(i == escaped_pos) {
+                    ;
+                } else if(c == '\\') {
+                    escaped_pos = i + 1;
+                } else if(c == '"') {
+                    in_string = false;
+                    tape.push_back(uint32_t(i));
+                }
+                return;
+            }
+
+            if(c == '"') {
+                in_string = true;
+            } else if(c == '{' || c == '[') {
+                ++depth;
+            } else if(c == '}' || c == ']') {
+                --depth;
+            } else if(c == '\\') {
+                return;
+            }
+
+            if(depth < 0 || (depth == 0 && c != '}' && c != ']')) {
+                throw std::runtime_error("Malformed JSON: " + std::string(p, n));
+            }
+            tape.push_back(uint32_t(i));
+        };
+
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        const __m128i quote   = _mm_set1_epi8('"');
+        const __m128i bslash  = _mm_set1_epi8('\\');
+        const __m128i colon   = _mm_set1_epi8(':');
+        const __m128i comma   = _mm_set1_epi8(',');
+        const __m128i opening = _mm_set1_epi8('[');
+        const __m128i closing = _mm_set1_epi8(']');
+        const __m128i fold    = _mm_set1_epi8(char(0xDF)); // '[' vs '{' and ']' vs '}' differ only in bit 5
+
+        for(; i + 16 <= n; i += 16) {
+            const __m128i block  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            const __m128i folded = _mm_and_si128(block, fold);
+
+            __m128i m = _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, bslash));
+            m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(block, colon), _mm_cmpeq_epi8(block, comma)));
+            m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(folded, opening), _mm_cmpeq_epi8(folded, closing)));
+
+            for(auto mask = unsigned(_mm_movemask_epi8(m)); mask != 0; mask &= mask - 1) {
+                on_char(i + size_t(__builtin_ctz(mask)));
+            }
+        }
+#endif
+        for(; i < n; i++) {
+            switch(p[i]) {
+                case '"': case '\\': case ':': case ',':
+                case '{': case '}':    case '[': case ']':
+                    on_char(i);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if(in_string || depth != 0 || tape.empty() || p[tape.front()] != '{') {
+            throw std::runtime_error("Malformed JSON: " + std::string(p, n));
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    /// @brief A lazy reference to a JSON value within a `jsonl::record`.
+    ///
+    /// Nothing is parsed or copied until requested: `raw()` is the
+    /// slice of the line; `num<T>()` parses it with `tsv::to_num`.
+    class value
+    {
+    public:
+        enum class type { missing, null, boolean, number, string, object, array };
+
+        value() = default;
+
+        value(string_view line, const std::vector<uint32_t>* tape, size_t pos, type t, string_view raw)
+            : m_line{ line }
+            , m_tape{ tape }
+            , m_pos{ pos }
+            , m_type{ t }
+            , m_raw{ raw }
+        {}
+
+        type get_type() const { return m_type; }
+        bool exists()   const { return m_type != type::missing; }
+        bool is_null()  const { return m_type == type::null; }
+
+        /// The JSON text of the value; for strings - without
+        /// the quotes, and with escape-sequences not decoded.
+        string_view raw() const
+        {
+            x_require_exists();
+            return m_raw;
+        }
+
+        /// Parse as a number with `tsv::to_num` (a number-valued string is also accepted).
+        template<typename Number>
+        Number num() const
+        {
+            x_require_exists();
+            Number ret = tsv::to_num(m_raw);
+            return ret;
+        }
+
+        bool boolean() const
+        {
+            if(m_type != type::boolean) {
+                throw std::domain_error("Expected JSON boolean, got '" + std::string(m_raw.data(), m_raw.size()) + "'.");
+            }
+            return m_raw.size() == 4; // true
+        }
+
+        /// The string with escape-sequences decoded.
+        std::string str() const
+        {
+            if(m_type != type::string) {
+                throw std::domain_error("Expected JSON string, got '" + std::string(m_raw.data(), m_raw.size()) + "'.");
+            }
+
+            std::string ret{};
+            ret.reserve(m_raw.size());
+
+            for(size_t i = 0; i < m_raw.size(); i++) {
+                if(m_raw[i] != '\\' || i + 1 == m_raw.size()) {
+                    ret.push_back(m_raw[i]);
+                    continue;
+                }
+
+                const char c = m_raw[++i];
+                switch(c) {
+                    case 'b': ret.push_back('\b'); break;
+                    case 'f': ret.push_back('\f'); break;
+                    case 'n': ret.push_back('\n'); break;
+                    case 'r': ret.push_back('\r'); break;
+                    case 't': ret.push_back('\t'); break;
+                    case 'u': i = x_decode_utf16(i, ret); break;
+                    default:  ret.push_back(c); // '"', '\\', '/'
+                }
+            }
+            return ret;
+        }
+
+        /// Member of an object; missing if not an object or no such key.
+        /// (The key is compared with the raw JSON text of the member's name).
+        value operator[](string_view key) const
+        {
+            if(m_type != type::object) {
+                return {};
+            }
+
+            size_t t = m_pos;
+            if(x_char_at(t + 1) == '}') {
+                return {}; // empty object
+            }
+
+            // t is at '{' or ','; followed by quote, quote, colon, value.
+            while(true) {
+                if(x_char_at(t + 1) != '"' || x_char_at(t + 3) != ':') {
+                    throw std::runtime_error("Malformed JSON: " + std::string(m_line.data(), m_line.size()));
+                }
+
+                const size_t b = (*m_tape)[t + 1] + 1;
+                const size_t e = (*m_tape)[t + 2];
+
+                if(string_view{ m_line.data() + b, e - b } == key) {
+                    return x_value_after(t + 3);
+                }
+
+                t = x_skip_value_after(t + 3);
+                if(x_char_at(t) != ',') {
+                    return {};
+                }
+            }
+        }
+
+        value operator[](const char* key) const
+        {
+            return (*this)[string_view{ key }];
+        }
+
+        /// Element of an array; missing if not an array or out of bounds.
+        value operator[](size_t i) const
+        {
+            if(m_type != type::array || x_is_empty_array()) {
+                return {};
+            }
+
+            size_t t = m_pos;
+            for(; i > 0 && x_char_at(t) != ']'; --i) {
+                t = x_skip_value_after(t);
+            }
+            return x_char_at(t) == ']' ? value{} : x_value_after(t);
+        }
+
+        /// Look up by a dot-separated path, e.g. `"hits.0.acc"`; path-components
+        /// that are numbers index into arrays.
+        value get(string_view path) const
+        {
+            value ret = *this;
+
+            while(ret.exists()) {
+                const size_t pos  = path.find('.');
+                const auto   name = path.substr(0, pos);
+
+                ret = ret.m_type == type::array && !name.empty() && name[0] >= '0' && name[0] <= '9'
+                    ? ret[size_t(tsv::to_num(name))]
+                    : ret[name];
+
+                if(pos == string_view::npos) {
+                    break;
+                }
+                path = path.substr(pos + 1);
+            }
+            return ret;
+        }
+
+    private:
+        string_view                  m_line = {};
+        const std::vector<uint32_t>* m_tape = nullptr;
+        size_t                       m_pos  = 0; // tape-position of the opening bracket
+        type                         m_type = type::missing;
+        string_view                  m_raw  = {};
+
+        void x_require_exists() const
+        {
+            if(m_type == type::missing) {
+                throw std::domain_error("Missing JSON field.");
+            }
+        }
+
+        static bool x_is_blank(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        char x_char_at(size_t t) const
+        {
+            return t < m_tape->size() ? m_line[(*m_tape)[t]] : '\0';
+        }
+
+        bool x_is_empty_array() const
+        {
+            size_t i = (*m_tape)[m_pos] + 1;
+            while(x_is_blank(m_line[i])) {
+                ++i;
+            }
+            return m_line[i] == ']';
+        }
+
+        // the value following the ':', '[', or ',' at tape-position t
+        value x_value_after(size_t t) const
+        {
+            size_t b = (*m_tape)[t] + 1;
+            while(x_is_blank(m_line[b])) {
+                ++b;
+            }
+
+            const char c = m_line[b];
+
+            if(c == '{' || c == '[') {
+                const size_t end_t = x_skip_value_after(t) - 1;
+                const size_t e = (*m_tape)[end_t] + 1;
+                return { m_line, m_tape, t + 1, c == '{' ? type::object : type::array, { m_line.data() + b, e - b } };
+            }
+
+            if(c == '"') {
+                const size_t e = (*m_tape)[t + 2];
+                return { m_line, m_tape, t + 1, type::string, { m_line.data() + b + 1, e - b - 1 } };
+            }
+
+            size_t e = (*m_tape)[t + 1]; // next structural
+            while(e > b && x_is_blank(m_line[e - 1])) {
+                --e;
+            }
+
+            const string_view raw{ m_line.data() + b, e - b };
+
+            const type ty = raw == "null"                  ? type::null
+                          : raw == "true" || raw == "false" ? type::boolean
+                          :                                   type::number;
+            return { m_line, m_tape, t + 1, ty, raw };
+        }
+
+        // tape-position of the ',' or closing bracket after the value following t
+        size_t x_skip_value_after(size_t t) const
+        {
+            // A scalar is followed by ',' or a closing bracket, so
+            // if the next structural is an opening one, it is ours.
+            const char c = x_char_at(t + 1);
+
+            if(c == '"') {
+                return t + 3;
+            } else if(c != '{' && c != '[') {
+                return t + 1; // scalar
+            }
+
+            size_t depth = 0;
+            for(++t; t < m_tape->size(); ++t) {
+                const char ch = x_char_at(t);
+                if(ch == '{' || ch == '[') {
+                    ++depth;
+                } else if((ch == '}' || ch == ']') && --depth == 0) {
+                    return t + 1;
+                }
+            }
+            throw std::runtime_error("Malformed JSON: " + std::string(m_line.data(), m_line.size()));
+        }
+
+        // \uXXXX (with surrogate-pairs) -> UTF-8; i is at 'u'; returns the position of last hex-digit.
+        size_t x_decode_utf16(size_t i, std::string& out) const
+        {
+            auto hex4 = [this](size_t pos) -> uint32_t
+            {
+                if(pos + 4 > m_raw.size()) {
+                    throw std::domain_error("Malformed \\u-escape in JSON string.");
+                }
+                uint32_t ret = 0;
+                for(size_t k = pos; k < pos + 4; k++) {
+                    const char c = m_raw[k];
+                    const uint32_t d = c >= '0' && c <= '9' ? uint32_t(c - '0')
+                                     : c >= 'a' && c <= 'f' ? uint32_t(c - 'a' + 10)
+                                     : c >= 'A' && c <= 'F' ? uint32_t(c - 'A' + 10)
+                                     : throw std::domain_error("Malformed \\u-escape in JSON string.");
+                    ret = ret * 16 + d;
+                }
+                return ret;
+            };
+
+            uint32_t cp = hex4(i + 1);
+            i += 4;
+
+            if(cp >= 0xD800 && cp < 0xDC00 && i + 2 < m_raw.size() && m_raw[i + 1] == '\\' && m_raw[i + 2] == 'u') {
+                const uint32_t lo = hex4(i + 3);
+                if(lo >= 0xDC00 && lo < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    i += 6;
+                }
+            }
+
+            if(cp < 0x80) {
+                out.push_back(char(cp));
+            } else if(cp < 0x800) {
+                out.push_back(char(0xC0 | (cp >> 6)));
+                out.push_back(char(0x80 | (cp & 0x3F)));
+            } else if(cp < 0x10000) {
+                out.push_back(char(0xE0 | (cp >> 12)));
+                out.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(char(0x80 | (cp & 0x3F)));
+            } else {
+                out.push_back(char(0xF0 | (cp >> 18)));
+                out.push_back(char(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(char(0x80 | (cp & 0x3F)));
+            }
+            return i;
+        }
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    /// @brief A parsed line: the line and its structural index.
+    class record
+    {
+    public:
+        record() : m_line{}, m_tape{}
+        {}
+
+        explicit record(string_view line) : m_line{}, m_tape{}
+        {
+            assign(line);
+        }
+
+        /// Re-index, reusing the storage.
+        void assign(string_view line)
+        {
+            m_line = line;
+            index_structurals(m_line, m_tape);
+        }
+
+        string_view line() const
+        {
+            return m_line;
+        }
+
+        value root() const
+        {
+            return { m_line, &m_tape, 0, value::type::object, m_line };
+        }
+
+        value operator[](string_view key) const { return root()[key]; }
+        value operator[](const char* key) const { return root()[key]; }
+
+        /// (see `value::get`)
+        value get(string_view path) const
+        {
+            return root().get(path);
+        }
+
+    private:
+        string_view           m_line;
+        std::vector<uint32_t> m_tape;
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+
+    class parse_line
+    {
+    private:
+        jsonl::record m_rec;
+
+    public:
+        parse_line() : m_rec{}
+        {}
+
+        // The record refers to the line, and is reused between invocations
+        // (see `tsv::split_on_delim`).
+        auto operator()(const std::string& line) & -> std::reference_wrapper<const jsonl::record>
+        {
+            m_rec.assign(line);
+            return { m_rec };
+        }
+    };
+
+    // tsv::get_next_line owning the stream
+    class get_next_line_from_file
+    {
+    public:
+        get_next_line_from_file(const std::string& filename, tsv::params params)
+            : m_file{ std::make_shared<std::ifstream>(filename) }
+            , m_next_line{}
+        {
+            if(!*m_file) {
+                throw std::runtime_error("Could not open " + filename);
+            }
+            m_next_line = std::make_shared<tsv::get_next_line>(*m_file, std::move(params));
+        }
+
+        auto operator()() -> std::reference_wrapper<const std::string>
+        {
+            return (*m_next_line)();
+        }
+
+    private:
+        std::shared_ptr<std::ifstream>       m_file;
+        std::shared_ptr<tsv::get_next_line>  m_next_line;
+    };
+
+    /// @brief Read JSON Lines from stream.
+    ///
+    /// Yields `const jsonl::record&`, valid until the next record is pulled.
+    /// The line is indexed once, and the fields are accessed lazily, without copying:
+    /// the unused fields are never materialized. Empty lines are skipped.
+    /*!
+    @code
+    std::istringstream istr{ R"({"acc": "NM_000001", "len": 123, "exons": [{"start": 1}, {"start": 50}]})" };
+
+    for(const jsonl::record& rec : jsonl::from(istr)) {
+        std::string acc   = rec["acc"].str();
+        size_t      len   = rec["len"].num<size_t>();
+        int         start = rec.get("exons.1.start").num<int>();
+    }
+    @endcode
+    */
+    inline auto from(std::istream& istr, tsv::params params = {})
+        -> fn::impl::seq<
+                fn::impl::transform< jsonl::parse_line >::gen<
+                    fn::impl::catch_end< tsv::get_next_line > > >
+    {
+        params.skip_comments = false;
+        return fn::transform( parse_line{} )(
+                     fn::seq(  tsv::get_next_line{ istr, std::move(params) }) );
+    }
+
+    /// @brief Read JSON Lines from a file.
+    inline auto from(const std::string& filename)
+        -> fn::impl::seq<
+                fn::impl::transform< jsonl::parse_line >::gen<
+                    fn::impl::catch_end< jsonl::get_next_line_from_file > > >
+    {
+        tsv::params params{};
+        params.filename = filename;
+        params.skip_comments = false;
+
+        return fn::transform( parse_line{} )(
+                     fn::seq(  get_next_line_from_file{ filename, std::move(params) }) );
+    }
+
+} // namespace jsonl
+
+} // namespace rangeless
+
+#endif // ENABLE_TSV
+
+
+
+#if RANGELESS_FN_ENABLE_RUN_TESTS
+#include <list>
+#include <string>
+#include <tuple>
+#include <set>
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <cctype>
+#include <memory>
+
+#ifndef VERIFY
+#define VERIFY(expr) if(!(expr)) RANGELESS_FN_THROW("Assertion failed: ( "#expr" ).");
+#endif
+
+namespace rangeless
+{
+namespace fn
+{
+namespace impl
+{
+
+// move-only non-default-constructible type wrapping an int.
+// Will use it as our value_type in tests to verify that 
+// we're supporting this.
+struct X
+{
+    int value;
 
-            return buf.tellp() ? buf.str() : fn::end_seq();
-        })
+    X(int i) : value{ i }
+    {}
 
-      % fn::transform_in_parallel(compress_block)
+#if defined(__GNUC__) && (__GNUC___ >= 5)
+    X() = delete;
 
-      % fn::for_each(write_to_ostr);
+    // We want to test that everything compiles even if the
+    // type is not default-constructibse, however, with GCC 4.9.3
+    // that results in
+    // /opt/ncbi/gcc/4.9.3/include/c++/4.9.3/bits/stl_algobase.h:573:4: error: static assertion failed: type is not assignable
+    // when calling std::erase or std::rotate on a vector<X>.
+    //
+    // So making leaving X default-constructible.
+#endif
+               X(X&&) = default;
+    X& operator=(X&&) = default;
 
-    @endcode
-    */
-    template<typename F> 
-    impl::adapt<F> adapt(F fn)
+               X(const X&) = delete;
+    X& operator=(const X&) = delete;
+
+    operator int&()
     {
-        return { std::move(fn) };
+        return value;
     }
 
-    ///////////////////////////////////////////////////////////////////////////
-    /// @brief Create a `seq` yielding results of applying the transform functions to input-elements.
-    ///
-    /// Returns a unary function-object, which will capture the arg by value and 
-    /// return an adapted `seq<...>` which will yield results of invoking 
-    /// `map_fn` on the elements (passed by value) of arg.
-    /// See `fn::where` for an example.
-    template<typename F> 
-    impl::transform<F> transform(F map_fn)
+    operator const int& () const
     {
-        // Rationale:
-        // <br>
-        // 1) A possible implementation for a container-input could assume that 
-        // `transform` function is inexpensive to recompute on-demand (this is
-        // this approach in `range-v3` which may call `transform` multiple times
-        // per element depending on the access pattern from the downstream views).
-        // 
-        // 2) An implementation could require the result-type to be cacheable
-        // and assume it is 'light' in terms of memory requirements and memoize the results.
-        //
-        // Our approach of applying `transform` lazily allows us to
-        // make neither assumption and apply `transform` at most once per element and without caching. 
-        // The user-code may always follow that by fn::to_vector() when necessary.
-
-        return { std::move(map_fn) };
+        return value;
     }
+};
+using Xs = std::vector<X>;
+
+// This is templated to unary-callable, because
+// we want to reuse the same battery of tests when
+// the input is a container and when the input-type
+// is a lazy seq.
+template<typename UnaryCallable>
+auto make_tests(UnaryCallable make_inputs) -> std::map<std::string, std::function<void()>>
+{
+    std::map<std::string, std::function<void()>> tests{};
+    using fn::operators::operator%;
+
+    //make_inputs({1, 2, 3}); // returns Xs or seq yielding X's
+
+    auto fold = fn::foldl_d([](int64_t out, int64_t in)
+    {
+        return out*10 + in;
+    });
+
 
 #if 0
-    // see comments around struct composed
-    template<typename F, typename... Fs>
-    auto transform(F fn, Fs... fns) -> impl::transform<decltype(impl::compose(std::move(fn), std::move(fns)...))>
+    tests["single test of interest"] = [&]
     {
-        return { impl::compose(std::move(fn), std::move(fns)...) };
-    }
-#endif
 
+    };
+#else 
 
 
+#if __cplusplus >= 201402L // gcc 4.9.3 complains about auto&& as lambda param with -std=c++11
+    tests["Test for NB[4]"] = [&]
+    {
+        auto xs = make_inputs({1,2,3}) 
+                % fn::where_max_by([](auto&& xx)
+                  {
+                     return std::tie(xx);
+                  });
+        VERIFY(xs.size() == 1);
+    };
+#endif
 
-    /// @}
-    /// @defgroup folding Folds and Loops
-    /// @{
 
-    /////////////////////////////////////////////////////////////////////////////
-    /*! @brief Range-based version of c++20 (copy-free) `std::accumulate`
-     *
-     * @see foldl_d
-     * @see foldl_1
-    @code
-        using namespace fn::operators;
-        const std::string x = vec_t{ 1, 2, 3 }
-          % fn::foldl(std::string{"^"},         // init
-                   [](std::string out, int in)  // fold-op
-            {
-                return std::move(out) + "|" + std::to_string(in);
-            });
+    /////////////////////////////////////////////////////////////////////////
 
-        VERIFY(x == "^|1|2|3");
-    @endcode
+    tests["Test for NB[3]"] = [&]
+    {
+        auto res = make_inputs({1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20})
+        % fn::transform([](X x) { return std::to_string(x); })
+        % fn::foldl_d([](std::string out, std::string in)
+        {
+            return std::move(out) + "," + in;
+        });
+        VERIFY(res == ",1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20");
+    };
 
-    NB: The body of the fold-loop is `init = binary_op(std::move(init), *it);`
-    If `it` is a `move`-ing iterator, like that of an `seq`, 
-    you'd take `in` by value or rvalue-reference in your binary operator,
-    whereas if it's a regular iterator yielding lvalue-references, you'd 
-    take it by const or non-const reference.
-    */
-    template<typename Result, typename Op>
-    impl::foldl<Result, Op> foldl(Result init, Op binary_op)
+    tests["foldl"] = [&]
     {
-        // NB: idiomatically the init value goes after the binary op,
-        // but most of the time binary-op is a multiline lambda, and having
-        // the init arg visually far-removed from the call-site 
-        // make things less readable, i.e. foldl([](...){ many lines }, init).
-        // So placing the binary-op last.
-        // (Tried it both ways, and found this order preferable).
+        // ensure compilation with move-only inputs
+        auto res = make_inputs({1,2,3})
+      % fn::foldl(X{42}, [](X out, int in)
+        {
+            return X(out*10+in);
+        });
+        VERIFY(res == 42123);
+    };
 
-        return { std::move(init), std::move(binary_op) };
-    }
 
-    /// Fold-Left-with-Default: this version uses default-initialized value for init.
-    /*!
-     * @see foldl
-     * @see foldl_1
-    @code
-        const std::string x = vec_t{ 1, 2, 3 }
-        % fn::foldl_d(
-            [](std::string out, int in)
-            {
-                return std::move(out) + "|" + std::to_string(in);
-            });
 
-        VERIFY(x == "|1|2|3");
-    @endcode
-    */
-    template<typename Op>
-    impl::foldl_d<Op> foldl_d(Op binary_op)
-    {
-        return { std::move(binary_op) };
-    }
 
-    /////////////////////////////////////////////////////////////////////////////
-    /// Init-free version of foldl (first element is used as init); requires at least one element.
-    /*!
-     * @see foldl
-     * @see foldl_d
-     * 
-    @code
-        const auto min_int = 
-            std::vector<std::string>{{ "11", "-333", "22" }}
-        % fn::transform([](const string& s) { return std::stoi(s); })
-        % fn::foldl_1([](int out, int in)   { return std::min(out, in); });
+    /////////////////////////////////////////////////////////////////////////
 
-        VERIFY(min_int == -333);
-    @endcode
-     */
-    template<typename Op>
-    impl::foldl_1<Op> foldl_1(Op binary_op) 
+    tests["sliding_window"] = [&]
     {
-        return { std::move(binary_op) };
-    }
+        //using view_t = fn::view<typename vec_t::iterator>;
+        // TODO: does not compile if using auto instead of view_t
 
+#if __cplusplus >= 201402L
+    // using auto-parameter for `v` in lambda, can be
+    // either container's iterator, or deque<...>::iterator 
+    // depending on inputs type
 
-    /// Return a `seq` yielding a view of a fixed-sized sliding window over elements.
-    ///
-    /// If the input is a `seq`, last `win_size` elements are internally cached in a deque.
-    /*!
-    @code
         const auto result = 
             make_inputs({ 1,2,3,4 })
           % fn::sliding_window(2)
@@ -3839,3308 +10069,4022 @@ namespace impl
                 return (out * 1000) + (*it * 10) + *std::next(it);
             });
         VERIFY(result == 12023034);
-    @endcode
-    */
-    inline impl::sliding_window sliding_window(size_t win_size)
-    {
-        return { win_size };
-    }
+#endif
+    };
 
-    /// Invoke fn on each element.
-    ///
-    /// NB: this is similar to a left-fold with binary-op `(nullptr_t, x) -> nullptr_t`
-    /// where `x` is consumed by-side-effect, and the binary-op is simplified to unary `(x)->void`. 
-    template<typename F>
-    impl::for_each<F> for_each(F fn)
+    /////////////////////////////////////////////////////////////////////////
+
+    tests["where"] = [&]
     {
-        return { std::move(fn) };
-    }
+        auto ret = make_inputs({1,2,3}) 
+            % fn::where([](int x) { return x != 2; }) 
+            % fold;
+        VERIFY(ret == 13);
 
+        //123 % fn::where([](int x) { return x == 2; }); 
+    };
 
-    /// Invoke binary fn on each pair of adjacent elements.
-    ///
-    /// NB: the inputs must satisfy `ForwardRange` or stronger.
-    template<typename F2>
-    impl::for_each_adjacent<F2> for_each_adjacent(F2 fn2)
-    {
-        return { std::move(fn2) };
-    }
 
-    /// @}
-    /// @defgroup filtering Filtering
-    /// @{
- 
-    /// @brief Yield elements until pred evaluates to false.
-    template<typename P> 
-    impl::take_while<P> take_while(P pred)
-    {
-        return { std::move(pred) };
-    }
+    tests["where_in_sorted"] = [&]
+    {
+        auto ret = make_inputs({1,2,3,4})
+           % fn::where_in_sorted(std::vector<int>{{ 1, 3}})
+           % fold;
+        VERIFY(ret == 13);
+    };
 
-    /// @brief Yield first `n` elements.
-    inline impl::take_while<impl::call_count_lt> take_first(size_t n = 1)
+    tests["where_not_in_sorted"] = [&]
     {
-        return {{ n, 0UL }};
-    }
+        auto ret = make_inputs({1,2,3,4})
+           % fn::where_not_in_sorted(std::vector<int>{{1, 3}})
+           % fold;
+        VERIFY(ret == 24);
+    };
 
-    /// @brief Yield last `n` elements.
-    ///
-    /// Buffering space requirements for `seq`: `O(n)`.
-    inline impl::take_last take_last(size_t n = 1)
+    tests["where_max_by"] = [&]
     {
-        return { n };
-    }
+        auto ret = make_inputs({1,3,1,3}) 
+            % fn::where_max_by(fn::by::identity{})
+            % fold;
+        VERIFY(ret == 33);
+    };
 
-    /// @brief Drop elements until pred evaluates to false.
-    template<typename P> 
-    impl::drop_while<P> drop_while(P pred)
+    tests["where_min_by"] = [&]
     {
-        return { std::move(pred) };
-    }
+        // NB: also testing compilation where key_fn returns a tuple
+        // containing references (see NB[2])
+        auto ret = make_inputs({5,3,5,3}) 
+            % fn::where_min_by([](const int& x) { return std::tie(x); })
+            % fold;
+        VERIFY(ret == 33);
+    };
 
-    /// @brief Drop first `n` elements.
-    inline impl::drop_while<impl::call_count_lt> drop_first(size_t n = 1)
+    tests["take_while"] = [&]
     {
-        return {{ n, 0UL }};
-    }
+        auto ret = make_inputs({3,4,1,2}) 
+            % fn::take_while([](int x) { return x > 1; })
+            % fold;
+        VERIFY(ret == 34);
+    };
 
-    /// @brief Drop last `n` elements.
-    ///
-    /// Buffering space requirements for `seq`: `O(n)`.
-    inline impl::drop_last drop_last(size_t n = 1)
+    tests["drop_while"] = [&]
     {
-        return { n };
-    }
+        auto ret = make_inputs({3,4,1,2}) 
+            % fn::drop_while([](int x) { return x > 1; })
+            % fold;
+        VERIFY(ret == 12);
+    };
 
-    ///////////////////////////////////////////////////////////////////////////
-    /// @brief Filter elements.
-    ///
-    /// Returns a unary function-object.
-    /*!
-    @code
-        // 1) If arg is a container passed by lvalue-reference,
-        // return a copy of the container with elements 
-        // satisfying the predicate:
-        auto nonempty_strs = strs % fn::where([](auto&& s) { return !s.empty(); });
 
-        // 2.1) If arg is a sequence container passed by rvalue,
-        // remove the unsatisfying elements using erase-remove idiom and return the container.
-        //
-        // 2.2) If arg is a container having equal_range method (sets, associative containers, etc),
-        // remove the unsatisfying elements using iterate-erase idiom and return the container.
-        strs = std::move(strs) % fn::where([](auto&& s) { return !s.empty(); });
+    tests["take_last"] = [&]
+    {
+        auto ret = 
+              make_inputs({1,2,3}) 
+            % fn::take_last(2)
+            % fold;
+        VERIFY(ret == 23);
 
-        // 3) If arg is a seq<G>, return adapted seq<...> that shall 
-        // yield elements satisfying the predicate:
-        auto res = fn::seq([i = 0]
-        {
-            return i < 5 ? i++ : fn::end_seq();
+        ret = make_inputs({1,2,3}) 
+            % fn::take_last(3)
+            % fold;
+        VERIFY(ret == 123);
 
-        }) % fn::where(     [](int x) { return x > 2; }) // 3, 4
-           % fn::transform( [](int x) { return x + 1; }) // 4, 5
-           % fn::foldl_d(   [](int out, int in) { return out*10 + in; });
-        VERIFY(res == 45);
-    @endcode
-     */
-    template<typename P> 
-    impl::where<P> where(P pred)
-    {
-        return { std::move(pred) };
-    }
+        ret = make_inputs({1,2,3}) 
+            % fn::take_last(4)
+            % fold;
+        VERIFY(ret == 123);
 
-    /// @see `where_in_sorted`
-    template<typename SortedForwardRange, typename F> 
-    impl::where<impl::in_sorted_by<SortedForwardRange, F> > where_in_sorted_by(const SortedForwardRange& r, F key_fn)
-    {
-        return { { r, false, { std::move(key_fn) } } };
-    }
+        const auto inputs = std::vector<int>{{1,2,3}};
+        ret = inputs % fn::take_last(2) % fold;
+        VERIFY(ret == 23);
+    };
 
-    ///////////////////////////////////////////////////////////////////////////
-    /// @brief Intersect with a sorted range.
-    ///
-    /// `elems %= fn::where_in_sorted(whitelist);`
-    template<typename SortedForwardRange> 
-    impl::where<impl::in_sorted_by<SortedForwardRange, by::identity> > where_in_sorted(const SortedForwardRange& r)
+    tests["drop_last"] = [&]
     {
-        return { { r, false, { { } } } };
-    }
+        auto ret = 
+              make_inputs({1,2,3}) 
+            % fn::drop_last(2)
+            % fold;
 
-    /// @see `where_not_in_sorted`
-    template<typename SortedForwardRange, typename F> 
-    impl::where<impl::in_sorted_by<SortedForwardRange, F> > where_not_in_sorted_by(const SortedForwardRange& r, F key_fn)
-    {
-        return { { r, true, { std::move(key_fn) } } };
-    }
+        VERIFY(ret == 1);
 
-    ///////////////////////////////////////////////////////////////////////////
-    /// @brief Subtract a sorted range.
-    ///
-    /// `elems %= fn::where_not_in_sorted(blacklist);`
-    template<typename SortedForwardRange> 
-    impl::where<impl::in_sorted_by<SortedForwardRange, by::identity> > where_not_in_sorted(const SortedForwardRange& r)
-    {
-        return { { r, true, { { } } } };
-    }
+        ret = make_inputs({1,2,3}) 
+            % fn::drop_last(3)
+            % fold;
 
+        VERIFY(ret == 0);
 
+        ret = make_inputs({1,2,3}) 
+            % fn::drop_last(4)
+            % fold;
 
-    ///////////////////////////////////////////////////////////////////////////
-    /// @brief Filter elements to those having maximum value of fn.
-    ///
-    /*!
-    @code
-        // 1) If Arg is a container (taken by value), find the max-element
-        // and return a vector of max-elements (moved-from the original container).
-        strs = std::move(strs) % fn::where_max_by([](auto&& s) { return s.size(); });
+        VERIFY(ret == 0);
 
-        // 2) If Arg is a seq, iterates the seq and returns
-        // std::vector<seq<...>::value_type> containing maximal elements.
-        auto res = fn::seq([i = 0]
-        {
-            return i < 5 ? i++ : fn::end_seq();
-        }) % fn::where_max_by([](int x) { return x % 2; });
-        VERIFY((res == vec_t{{1, 3}}));
-    @endcode
+        const auto inputs = std::vector<int>{{1,2,3}};
+        ret = inputs % fn::drop_last(2) % fold;
+        VERIFY(ret == 1);
+    };
 
-    Buffering space requirements for `seq`: `O(k)`, where `k` = maximum number of max-elements in a prefix of seq over all prefixes of seq.
-    e.g.
-    <br>`[1,0,1,1,0,1,1,9]: k = 5`
-    <br>`[1,3,1,1,3,1,1,9]: k = 2`
-    */
-    template<typename F> 
-    impl::where_max_by<F> where_max_by(F key_fn)
+    tests["take_first"] = [&]
     {
-        return { std::move(key_fn), 1 };
-    }
+        auto ret = 
+              make_inputs({1,2,3}) 
+            % fn::take_first(2)
+            % fold;
+        VERIFY(ret == 12);
+    };
 
-    inline impl::where_max_by<by::identity> where_max()
+    tests["drop_first"] = [&]
     {
-        return { by::identity{}, 1 };
-    }
+        auto ret = 
+              make_inputs({1,2,3}) 
+            % fn::drop_first(2)
+            % fold;
+        VERIFY(ret == 3);
+    };
 
-    /// Filter elements to those having maximum value of fn.
-    /// @see where_max_by
-    template<typename F> 
-    impl::where_max_by<F> where_min_by(F key_fn)
-    {
-        return { std::move(key_fn), -1 };
-    }
 
-    inline impl::where_max_by<by::identity> where_min()
+    /////////////////////////////////////////////////////////////////////////
+
+    tests["append"] = [&]
     {
-        return { by::identity{}, -1 };
-    }
+        auto res = make_inputs({1,2,3})
+                 % fn::append( make_inputs({4,5}) )
+                 % fold;
 
-    /// @code
-    /// const bool any  = vals %  fn::exists_where(pred);
-    /// const bool none = vals % !fn::exists_where(pred);
-    /// const bool all =  vals % !fn::exists_where(not_pred);
-    /// @endcode
-    template<typename Pred>
-    impl::exists_where<Pred> exists_where(Pred p)
+        VERIFY(res == 12345);
+    };
+
+    tests["zip_with"] = [&]
     {
-        return { std::move(p), true };
-    }
+        auto res = make_inputs({1,2})
+                 % fn::zip_with( make_inputs({3,4,5}), [](int x, int y)
+                   {
+                        return std::array<int, 2>{{x, y}};
+                   })
+                 % fn::concat()
+                 % fold;
 
+        VERIFY(res == 1324);
+    };
 
-    /// @}
-    /// @defgroup grouping Grouping
-    /// @{
 
-    /// @brief Similar to `group_adjacent_by`, but presorts the elements.
-    ///
-    /// @see group_adjacent_by
-    /*! 
-    @code
-        using alns_t = std::vector<CRef<CSeq_align>>;
-        
-        std::move(alignments)
+    /////////////////////////////////////////////////////////////////////////
+
+    tests["enumerate"] = [&]
+    {
+        auto res = make_inputs({4,5,6})
+        % fn::transform(fn::get::enumerated{})
+        % fn::transform([](std::pair<size_t, int> p)
+        {
+            return std::array<int, 2>{{p.second, int(p.first)}};
+        })
+        % fn::concat()
+        % fold;
+
+        VERIFY(res == 405162);
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    
+    tests["values"] = [&]
+    {
+        auto inps = make_inputs({1,2,3});
 
-          % fn::group_all_by([&](CConstRef<CSeq_align> aln) 
-            {    
-                return GetLocusId( aln->GetSeq_id(0) );
-            })   
+        auto m = std::map<int, decltype(inps) >{};
+        m.emplace(1, std::move(inps));
+        m.emplace(2, make_inputs({4,5,6}));
 
-          % fn::for_each([&](alns_t alns)
-            {    
-                // Process alignments for a locus...
-            });  
+        auto res = std::move(m) 
+                 % fn::transform(fn::get::second{})
+                 % fn::concat() 
+                 % fold;
 
-       Note: template<typename Container> impl::group_all_by<F>::operator()(Container inputs)
-       takes Container by-value and moves elements into the output.
-    @endcode
+        VERIFY(res == 123456);
+    };
 
-    Buffering space requirements for `seq`: `O(N)`.
-    */
-    template<typename F> 
-    impl::group_all_by<F> group_all_by(F key_fn)
+    /////////////////////////////////////////////////////////////////////////
+
+    tests["group_adjacent"] = [&]
     {
-        return { std::move(key_fn) };
-    }
+        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
+        % fn::group_adjacent()
+        % fn::transform([](Xs v)
+        {
+            return int(v.size());
+        })
+        % fold;
+        VERIFY(res == 12321);
+    };
 
-    inline impl::group_all_by<by::identity> group_all()
+    tests["group_adjacent_if"] = [&]
     {
-        return { by::identity{} };
-    }
+        auto res = make_inputs({1,2,2,4,4,4,2,2,1})
+        % fn::group_adjacent_if([](const int& a, const int& b)
+        {
+            return abs(a - b) < 2;
+        })
+        % fn::transform([](Xs v)
+        {
+            return int(v.size());
+        })
+        % fold;
+        VERIFY(res == 333);
+    };
 
-    /////////////////////////////////////////////////////////////////////////
+    tests["group_all"] = [&]
+    {
+        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
+        % fn::group_all()
+        % fn::transform([](Xs v)
+        {
+            return int(v.size());
+        })
+        % fold;
+        VERIFY(res == 243);
+    };
 
-    /// @brief Group adjacent elements.
-    /// @see group_all_by
-    /// @see concat
-    ///
-    /// If arg is a container, works similar to `group_all_by`, except 
-    /// returns a `std::vector<Container>` where each container
-    /// contains adjacently-equal elements having same value of key.
-    ///
-    /// If arg is a `seq<...>`, composes a `seq<...>`
-    /// that shall yield `vector<value_type>`s having same value of key.
-    /// (NB: if the value_type is a char, the group-type is std::string).
-    ///
-    /// Buffering space requirements for `seq`: `O(max-groupsize)`.
-    template<typename F>
-    impl::group_adjacent_by<F> group_adjacent_by(F key_fn)
+    tests["in_groups_of"] = [&]
     {
-        return { std::move(key_fn), {} };
-    }
+        auto res = make_inputs({1,2,3,4,5})
+        % fn::in_groups_of(2)
+        % fn::transform([](Xs v)
+        {
+            return int64_t(v.size());
+        })
+        % fold;
+        VERIFY(res == 221);
+    };
 
-    /////////////////////////////////////////////////////////////////////////
-    /// @brief Group adjacent elements.
-    ///
-    /// This is similar to regular `group_adjacent_by`, except the result type
-    /// is a seq yielding subseqs of equivalent elements, rather than vectors.
-    /// @code
-    ///     fn::seq(...) 
-    ///   % fn::group_adjacent_by(key_fn, fn::to_seq()) 
-    ///   % fn::for_each([&](auto group_seq) // type of group_seq is a seq<...> instead of vector<...>
-    ///     {
-    ///         for(auto elem : group_seq) {
-    ///             // ...
-    ///         }
-    ///     });
-    /// @endcode
-    ///
-    /// This is useful for cases where a subseq can be arbitrarily large, and you want
-    /// to process grouped elements on-the-fly without accumulating them in a vector.
-    ///
-    /// This comes at the cost of more constrained functionality, since all groups and
-    /// all elements in each group can only be accessed once and in order.
-    template<typename F>
-    impl::group_adjacent_as_subseqs_by<F> group_adjacent_by(F key_fn, impl::to_seq)
+    tests["concat"] = [&]
     {
-        return { std::move(key_fn), {} };
-    }
+        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
+        % fn::group_all()
+        % fn::concat()
+        % fold;
+        VERIFY(res == 112222333);
+    };
 
-    /////////////////////////////////////////////////////////////////////////
+    tests["unique_adjacent"] = [&]
+    {
+        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
+        % fn::unique_adjacent()
+        % fold;
+        VERIFY(res == 12321);
+    };
 
-    inline impl::group_adjacent_by<by::identity> group_adjacent()
+    tests["unique_all"] = [&]
     {
-        return { by::identity{}, {} };
-    }
+        // NB: key-function requires copy-constructible in this use-case.
+        // see unique_all_by::gen::operator()()
+        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
+#if 0
+        % fn::unique_all()
+        // Normally this would work, but we've made our type X not default-constructible,
+        // so when using identity key-fn, the type X returned by it cannot be 
+        // used as key-type to store seen elements. Instead, will use modified key-fn below.
+#elif 1
+        % fn::unique_all_by([](const X& x) -> const int& { return x; })
+#elif 0
+        % fn::unique_all_by([](const X& x) { const int& r = x; return std::tie(r); })
+        // This is not expected to work because returned reference-wrapper is
+        // not default-constructible.
+#endif
+        % fold;
+        VERIFY(res == 123);
+    };
 
-    inline impl::group_adjacent_as_subseqs_by<by::identity> group_adjacent(impl::to_seq)
+    tests["sort"] = [&]
     {
-        return { by::identity{}, {} };
-    }
+        auto res = make_inputs({3,2,4,1,5})
+        % sort()
+        % reverse()
+        % fold;
+        VERIFY(res == 54321);
 
-    /////////////////////////////////////////////////////////////////////////
+        res = make_inputs({3,2,4,1,5})
+        % unstable_sort()
+        % fold;
+        VERIFY(res == 12345);
+    };
 
-    /// @brief Group adjacent elements if binary predicate holds.
-    template<typename BinaryPred>
-    impl::group_adjacent_by<fn::by::identity, BinaryPred> group_adjacent_if(BinaryPred pred2)
+    tests["lazy_sort"] = [&]
     {
-        return { {}, std::move(pred2) };
-    }
+        auto res = make_inputs({3,2,4,1,5})
+        % lazy_sort()
+        % reverse()
+        % fold;
+        VERIFY(res == 54321);
+    };
 
-    /// @brief Group adjacent elements if binary predicate holds.
-    template<typename BinaryPred>
-    impl::group_adjacent_as_subseqs_by<fn::by::identity, BinaryPred> group_adjacent_if(BinaryPred pred2, impl::to_seq)
+    tests["top_n"] = [&]
     {
-        return { {}, std::move(pred2) };
-    }
+        auto res = make_inputs({3,2,4,1,5,0})
+        % take_top_n(3)
+        % fold;
+        VERIFY(res == 345);
+    };
 
-    /////////////////////////////////////////////////////////////////////////
 
+#if __cplusplus >= 201402L
+    tests["group_adjacent_as_subseqs"] = [&]
+    {
+        int res = 0;
+        int group_num = 0;
 
-    /// @brief Group adjacent elements into chunks of specified size.
-    /*!
-    @code
-        std::move(elems) 
-      % fn::in_groups_of(5)
-      % fn::for_each(auto&& group)
+        make_inputs({1,2,2,3,3,3,4,5})
+      % fn::group_adjacent(fn::to_seq())
+      % fn::for_each([&](auto subseq)
         {
-            ASSERT(group.size() <= 5);
+            //subseq.size();  // sanity-check: this should not compile, because type is seq<...>
+
+            group_num++;
+            if(group_num == 4) {
+                return; // testing skipping a group without accessing it
+            }
+
+            size_t i = 0;
+            for(const auto x : subseq) {
+
+                // testing that things work as expected
+                // for partially-accessed groups leaving
+                // some elements unaccessed. Here we'll skip
+                // the last 3 in 333 subgroup.
+                if(i++ >= 2) {
+                    break;
+                }
+
+                res = res*10 + x;
+            }
+            res = res*10;
         });
-    @endcode
 
-    Buffering space requirements for `seq`: `O(n)`.
-    */
-    inline impl::group_adjacent_by<impl::chunker> in_groups_of(size_t n)
-    {
-        if(n < 1) {
-            RANGELESS_FN_THROW("Batch size must be at least 1.");
-        }
-        return { impl::chunker{ n, 0 }, {} };
-    }
+        VERIFY(res == 1022033050);
+    };
+#endif
 
 
-    /// @}
-    /// @defgroup ordering Ordering
-    /// @{
+    tests["key_fn returning a reference_wrapper"] = [&]
+    {
+        // testing compilation. see lt
+        auto get_ref = [](const X& x) { return std::cref(x); };
 
-    /// @brief Reverse the elements in the input container.
-    ///
-    /// Buffering space requirements for `seq`: `O(N)`.
-    inline impl::reverse reverse()
+        make_inputs({1,2,3}) %       fn::group_all_by(get_ref);
+        make_inputs({1,2,3}) %  fn::group_adjacent_by(get_ref);
+        make_inputs({1,2,3}) %            fn::sort_by(get_ref);
+        make_inputs({1,2,3}) % fn::unique_adjacent_by(get_ref);
+    //  make_inputs({1,2,3}) %      fn::unique_all_by(get_ref);
+    //  This is static-asserted against for seq because the implementation
+    //  requires default-constructible key-type (see discussion in unique_all_by::gen)
+    };
+
+    tests["to"] = [&]
     {
-        return {};
-    }
+        auto res = make_inputs({2,3,1,2}) % fn::to(std::set<int>{}) % fold;
+        VERIFY(res == 123);
+    };
 
-    /// @brief stable-sort and return the input.
-    /*! 
-    @code
-        auto res = 
-            std::list<std::string>{{ "333", "1", "22", "333", "22" }}
-          % fn::to_vector()
-          % fn::sort_by([](const std::string& s) 
-            {
-                return fn::by::decreasing(s.size());
-            })
-          % fn::unique_adjacent();
 
-        VERIFY(( res == std::vector<std::string>{{ "333", "22", "1" }} ));
-    @endcode
+    /////////////////////////////////////////////////////////////////////////
+#endif
 
-    Buffering space requirements for `seq`: `O(N)`.
-    */
-    template<typename F>
-    impl::sort_by<F, impl::stable_sort_tag> sort_by(F key_fn)
-    {
-        return { std::move(key_fn) };
-    }
+    return tests;
+}
 
-    /// @brief `sort_by with key_fn = by::identity`
-    inline impl::sort_by<by::identity, impl::stable_sort_tag> sort()
-    {
-        return { by::identity{} };
-    }
 
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+static void run_tests()
+{
+    using fn::operators::operator%;
 
-    template<typename F>
-    impl::sort_by<F, impl::unstable_sort_tag> unstable_sort_by(F key_fn)
-    {
-        return { std::move(key_fn) };
-    }
+#if 0 // single test
 
-    inline impl::sort_by<by::identity, impl::unstable_sort_tag> unstable_sort()
+    std::map<std::string, std::function<void()>> tests1{}, tests2{}, test_other{};
+    test_other["single"] = [&]
     {
-        return { by::identity{} };
-    }
+        auto res = Xs{}
+        % fn::to_seq()
+        % fn::group_all()
+        % fn::transform([](Xs v)
+        {
+            return (int)v.size();
+        });
+    };
 
+#else // all tests
 
-    /// @brief Unstable lazy sort.
-    ///
-    /// Initially move all inputs into a `std::vector` and heapify in `O(n)`,
-    /// and then lazily yield elements with `pop_heap` in `O(log(n))`. This is more efficient
-    /// if the downstream stage is expected to consume a small fraction of
-    /// sorted inputs.
-    ///
-    /// Buffering space requirements for `seq`: `O(N)`.
-    template<typename F>
-    impl::lazy_sort_by<F> lazy_sort_by(F key_fn)
-    {
-        return { std::move(key_fn) };
-    }
+    std::map<std::string, std::function<void()>> 
+        test_cont{}, test_seq{}, test_view{}, test_other{};
 
-    /// @brief `lazy_sort_by with key_fn = by::identity`
-    inline impl::lazy_sort_by<by::identity> lazy_sort()
+    // make battery of tests where input is a container (Xs)
+    test_cont = make_tests([](std::initializer_list<int> xs)
     {
-        return { by::identity{} };
-    }
+        Xs ret;
+        for(auto x : xs) {
+            ret.push_back(X(x));
+        }
+        return ret;
+    });
 
-    /// @brief Return top-n elements, sorted by key_fn.
-    ///
-    /// This is conceptually similar to `fn::sort_by(key_fn) % fn::take_last(n)`,
-    /// but is more efficient: the implementation mantains a priority-queue of
-    /// top-n max-elements encountered so-far.
-    ///
-    /// Buffering space requirements: `O(n)`; time complexity: `O(N*log(n))`
-    template<typename F>
-    impl::take_top_n_by<F> take_top_n_by(size_t n, F key_fn)
+    // make battery of tests where input is an input-range
+    test_seq = make_tests([](std::initializer_list<int> xs)
     {
-        return { std::move(key_fn), n };
-    }
+        Xs ret;
+        for(auto x : xs) {
+            ret.push_back(X(x));
+        }
+        return fn::to_seq()(std::move(ret));
+    });
 
-    /// @brief Return top-n elements, sorted by identity.
-    inline impl::take_top_n_by<by::identity> take_top_n(size_t n)
+    // make battery of tests where input is a view
+    test_view = make_tests([](std::initializer_list<int> xs)
     {
-        return { by::identity{}, n };
-    }
+        // will be returning views; will keep the underlying data
+        // in a static vector.
 
+        static std::vector<Xs> vecs{};
+        vecs.push_back(Xs{});
+        auto& ret = vecs.back();
 
+        for(auto x : xs) {
+            ret.push_back(X(x));
+        }
+        return fn::from(ret);
+    });
 
-    /// @}
-    /// @defgroup uniq Uniquefying
-    /// @{
 
-    /// @brief Keep first element from every adjacently-equal run of elements.
-    /// 
-    /// If arg is a container, apply erase-unique idiom and return
-    /// the container.
-    ///
-    /// If arg is a `seq<In>`, compose `seq<Out>` that
-    /// will yield first element from every adjacently-equal run of elements.
-    template<typename F>
-    impl::unique_adjacent_by<F> unique_adjacent_by(F key_fn)
-    {
-        return { std::move(key_fn) };
-    }
+    using vec_t = std::vector<int>;
 
-    inline impl::unique_adjacent_by<by::identity> unique_adjacent()
-    {
-        return { by::identity{} };
-    }
+    /////////////////////////////////////////////////////////////////////////
 
-    /// @brief Uniquefy elements globally, as-if `unique_adjacent_by` pre-sorted by same key.
-    ///
-    /// If arg is a container, move contents to vector, and then sort-by and unique-adjacent-by.
-    ///
-    /// If arg is a `seq<In>`, compose `seq<Out>` that will
-    /// keep values of key_fn in a set, and skip already-seen elements. 
-    ///
-    /// NB: the lifetime of value returned by key_fn must be independent of arg.
-    template<typename F>
-    impl::unique_all_by<F> unique_all_by(F key_fn)
-    {
-        return { std::move(key_fn) };
-    }
 
-    inline impl::unique_all_by<by::identity> unique_all()
-    {
-        return { by::identity{} };
-    }    
-    
+    /////////////////////////////////////////////////////////////////////////
 
-    /// @}
-    /// @defgroup concat Combining
-    /// @{
 
-    /// @brief Flatten the result of `group_all_by` or `group_adjacent_by`. 
-    ///
-    /// Given a `ContainerA<ContainerB<...>>`, move all elements and return `ContainerB<...>`.
-    ///
-    /// Given a seq-of-iterables `seq<In>`, compose `seq<Out>` that will lazily yield elements 
-    /// of each iterable in seq.
-    inline impl::concat concat()
+    test_other["Test for NB[5]"] = [&]
     {
-        return {};
-    }
-
-    /// @brief Yield elements of next after elements of arg.
-    /*!
-    @code
-        auto res = vec_t{{1,2}}
-                 % fn::append( vec_t{{3}} )
-                 % fn::to_vector();
+        const auto inps = vec_t{{1,2,3}};
+        auto res = fn::cfrom(inps) % fn::to_seq() % fn::to_vector();
+        VERIFY(res == inps);
+    };
 
-        VERIFY((res == vec_t{{1,2,3}}));
-    @endcode
-    */
-    template<typename Iterable>
-    impl::append<Iterable> append(Iterable next)
+    test_other["typerased"] = [&]
     {
-        return { std::move(next) };
-    }
+        int i = 0;
+        auto myseq = fn::make_typerased(
+            fn::seq([i, p = std::unique_ptr<int>()]() mutable // p is just to make sure it works for move-only lambdas
+            {
+                return i < 10 ? i++ : fn::end_seq();
+            })
+          % fn::where([](int x)
+            {
+                return x % 2 == 0;
+            }));
 
-    /// @brief Yield pairs of elements, (up to end of the shorter range)
-    /*!
-    @code
-        auto res = vec_t{{1,2}}
-                 % fn::zip_with( vec_t{{3,4,5}}, [](int x, int y)
-                   {
-                        return x*10 + y;
-                   })
-                 % fn::to_vector();
+        int res = 0;
+        for(const auto& x : myseq) {
+            res = res*10 + x;
+        }
+       
+        VERIFY(res == 2468);
+    };
 
-        VERIFY((res == vec_t{{13, 24}}));
-    @endcode
-    */
-    template<typename Iterable, typename BinaryFn>
-    impl::zip_with<Iterable, BinaryFn> zip_with(Iterable second, BinaryFn fn)
+    test_other["for_each"] = [&]
     {
-        // We could have provided zip2 instead, returning a pair of elements,
-        // but more often than not that pair will need to be transformed,
-        // so instead we provide generalized zip_with that also takes the
-        // binary transform-function, obviating the need in separate transform-stage.
-        // If necessary, the transform-function can simply yield std::make_pair.
-
-        return { std::move(second), std::move(fn) };
-    }
+        // NB: making sure that for_each compiles with mutable lambdas
+        auto vec = vec_t{{1,2,3}};
+        vec % fn::for_each([](int& x) mutable
+        {
+            x *= 10;
+        });
+        VERIFY(( vec == vec_t{{10,20,30}} ));
+    };
 
-    /// @brief Yield invocations of `fn` over pairs of adjacent inputs.
-    template<typename BinaryFn>
-    impl::zip_adjacent<BinaryFn> zip_adjacent(BinaryFn fn)
+    test_other["for_each_adjacent"] = [&]
     {
-        return { std::move(fn) };
-    }
+        auto vec = vec_t{{1,2,3,4}};
+        vec % fn::for_each_adjacent([](int& x1, int& x2) mutable // making sure non-const-reference binds
+        {
+            return x2 = x1*10 + x2;
+        });
 
-    // @brief Outer zip_with.
-    template<typename Iterable, typename BinaryFn>
-    impl::cartesian_product_with<Iterable, BinaryFn> cartesian_product_with(Iterable second, BinaryFn fn)
-    {
-        return { std::move(second), std::move(fn) };
-    }
+        VERIFY(( vec == vec_t{{1,12,123,1234}} ));
+    };
 
-    /// @}
-    /// @defgroup el_access Element Access
-    /// @{
 
-    /////////////////////////////////////////////////////////////////////////////
-    /*! @brief Access unique element matching the predicate.
-     *
-     * Throw unless found exactly one element matching the predicate.
-     * Returns const or non-const reference depending on the constness of the container.
-     * @see set_unique
-    @code
-        const CConstRef<CUser_object>& model_evidence_uo = 
-            fn::get_unique(seq_feat.GetExts(), [](CConstRef<CUser_object> uo)
-            {
-                return uo->GetType().GetStr() == "ModelEvidence";
-            });
-    @endcode
-    */
-    template<typename Container, typename P>
-    auto get_unique(Container& container, P&& pred) -> decltype(*container.begin())
+    test_other["zip_adjacent"] = [&]
     {
-        auto best_it = container.end();
-        size_t n = 0;
-
-        for(auto it   = container.begin(), 
-                 it_end = container.end();
+        auto res =
+            vec_t{{1,2,3,4}}
+          % fn::zip_adjacent([](int& x1, int& x2) // making sure non-const-reference binds
+            {
+                return x1*10 + x2;
+            })
+          % fn::to_vector();
 
-                 it != it_end; ++it)
-        {
-            if(pred(*it)) {
-                best_it = it;
-                ++n;
-            }
-        }
+        VERIFY(( res == std::vector<int>{{12,23,34}} ));
+    };
 
-        if(n != 1) {
-            RANGELESS_FN_THROW("Expected unique element satisfying search criteria, found " 
-                          + std::to_string(n) + ".");
-        }
 
-        return *best_it;
-    }
 
-    /////////////////////////////////////////////////////////////////////////////
-    /// @brief Similar to get_unique, but end-insert an element if missing.
-    ///
-    /*!
-    @code
-        CRef<CSeqdesc>& gb_desc =
-            fn::set_unique(seq_entry.SetDescr().Set(), [](CConstRef<CSeqdesc> d)
-            {    
-                return d->IsGenbank();
-            },   
-            [] // add if missing (must satisfy pred)
-            {    
-                auto g = Ref(new CSeqdesc);
-                g->SetGenbank();
-                return g;
-            });  
-    @endcode
-    */
-    template<typename Container, typename P, typename Construct>
-    auto set_unique(Container& container, P&& pred, Construct&& con) -> decltype(*container.begin())
+    test_other["fold"] = [&]
     {
-        auto best_it = container.end();
-        size_t n = 0;
-
-        for(auto it   = container.begin(), 
-                 it_end = container.end();
+        const std::string x = 
+        vec_t{{1,2,3}} % fn::foldl(std::string{"^"},
+                                [](std::string s, int x_)
+        {
+            return std::move(s) + "|" + std::to_string(x_);
+        }) ;
+        VERIFY(x == "^|1|2|3");
+    };
 
-                 it != it_end; ++it)
+    test_other["foldl_d"] = [&]
+    {
+        const std::string x =
+        vec_t{{1,2,3}} % fn::foldl_d( [](std::string s, int x_)
         {
-            if(pred(*it)) {
-                best_it = it;
-                ++n;
-            }
-        }
+            return std::move(s) + "|" + std::to_string(x_);
+        });
 
-        if(n == 0) {
-            best_it = container.insert(container.end(), con());
-            ++n;
-            if(!pred(*best_it)) {
-                RANGELESS_FN_THROW("New element does not satisfy predicate.");
-            }
-        }
+        VERIFY(x == "|1|2|3");
+    };
 
-        if(n != 1) {
-            RANGELESS_FN_THROW("Expected unique element satisfying search criteria, found " 
-                          + std::to_string(n) + ".");
-        }
+    test_other["foldl_1"] = [&]
+    {
+        const auto min_int = 
+            std::vector<std::string>{{ "11", "-333", "22" }}
+        % fn::transform([](const std::string& s) { return std::stoi(s); })
+        % fn::foldl_1([](int out, int in) { return std::min(out, in); });
 
-        return *best_it;
-    }
+        VERIFY(min_int == -333);
+    };
 
+    test_other["prefetch"] = [&]
+    {
+        std::vector<int> ints = { 5, 3, 1, 4, 2 };
 
-    /////////////////////////////////////////////////////////////////////////////
+        for(const size_t distance : { 0, 1, 3, 100 }) {
+            auto res = fn::refs(ints)
+              % fn::prefetch(distance)
+              % fn::transform([](int x){ return x * 10; })
+              % fn::to_vector();
+            VERIFY(( res == vec_t{{ 50, 30, 10, 40, 20 }} ));
+        }
 
-    /// e.g. `const CConstRef<CSeq_align> aln = first_or_default( get_alns_annot(...)->Get() );`
-    template<typename Container>
-    auto first_or_default(const Container& c) -> typename Container::value_type
-    {
-        return c.begin() == c.end() ? typename Container::value_type{} : *c.begin();
-    }
+        // move-only elements, custom addr_fn
+        auto res2 = vec_t{{ 1, 2, 3, 4, 5 }}
+          % fn::transform([](int x){ return std::unique_ptr<X>(new X{ x }); })
+          % fn::prefetch(2, [](const std::unique_ptr<X>& p){ return p.get(); })
+          % fn::transform([](std::unique_ptr<X> p){ return int(*p); })
+          % fn::to_vector();
+        VERIFY(( res2 == vec_t{{ 1, 2, 3, 4, 5 }} ));
 
-    template<typename Container, typename Pred>
-    auto first_or_default(const Container& c, Pred&& pred) -> typename Container::value_type
-    {
-        auto it = std::find_if(c.begin(), c.end(), std::forward<Pred>(pred));
-        return it == c.end() ? typename Container::value_type{} : *it;
-    }
+        VERIFY(( std::vector<const int*>{} % fn::prefetch(4) % fn::to_vector() ).empty());
+    };
 
-    template<typename Container>
-    auto last_or_default(const Container& c) -> typename Container::value_type
+    test_other["split"] = [&]
     {
-        return c.rbegin() == c.rend() ? typename Container::value_type{} : *c.rbegin();
-    }
+        auto to_strs = fn::transform([](fn::string_view s){ return std::string(s); });
 
-    template<typename Container, typename Pred>
-    auto last_or_default(const Container& c, Pred&& pred) -> typename Container::value_type
-    {
-        auto it = std::find_if(c.rbegin(), c.rend(), std::forward<Pred>(pred));
-        return it == c.rend() ? typename Container::value_type{} : *it;
-    }
+        const std::string csv = "a,bb,,ccc,";
+        VERIFY(( csv % fn::split(',') % to_strs % fn::to_vector()
+              == std::vector<std::string>({ "a", "bb", "", "ccc", "" }) ));
 
-    /// @}
-    /// @defgroup other Util
-    /// @{
+        const std::string empty = "";
+        VERIFY(( empty % fn::split(',') % to_strs % fn::to_vector()
+              == std::vector<std::string>({ "" }) ));
 
-    /// @brief Memoizing wrapper for non-recursive non-mutable unary lambdas (not synchronized).
-    /*!
-    @code
-        size_t exec_count = 0;
-        auto fn = make_memoized([&](int x){ exec_count++; return x*2; });
-        
-        VERIFY(fn(1) == 2);
-        VERIFY(fn(2) == 4);
-        VERIFY(fn(1) == 2);
-        VERIFY(exec_count == 2);
-    @endcode
-    */
-    template<typename F>
-    impl::memoizer<F> make_memoized(F fn)
-    {
-        return { std::move(fn), {} };
-    }
+        const std::string blanks = " a , b,  ,c";
+        VERIFY(( blanks % fn::split(',').trim_blanks().drop_empty() % to_strs % fn::to_vector()
+              == std::vector<std::string>({ "a", "b", "c" }) ));
 
-    /////////////////////////////////////////////////////////////////////////
-    /// @brief Basic scope guard - execute some code in guard`s destructor.
-    /*!
-    @code
-        {{
-            // ...
+        // an lvalue is not copied: the collected tokens point into it,
+        // including the ones short enough to fit in a copy's SSO buffer.
+        auto csv_toks = csv % fn::split(',') % fn::to_vector();
+        VERIFY(csv_toks.size() == 5 && csv_toks[3] == "ccc");
+        VERIFY(csv_toks[0].data() == csv.data() && csv_toks[3].data() == csv.data() + 6);
 
-            auto on_exit = fn::make_scope_guard([&]
-            {
-                std::cerr << "Executing clean-up or roll-back...\n";
-            });
+        const std::vector<char> chars = { 'x', ';', 'y' };
+        VERIFY(( chars % fn::split(';') % to_strs % fn::to_vector()
+              == std::vector<std::string>({ "x", "y" }) ));
 
-            on_exit.dismiss(); // Cancel if no longer applicable.
-        }}
-    @endcode
-    */
-    template<typename F>
-    impl::scope_guard<F> make_scope_guard(F fn)
-    {
-        return { std::move(fn), false };
-    }
+        // zero-copy: the tokens point into the input
+        const std::string str = "10M2I3D";
+        auto toks = fn::string_view(str)
+          % fn::split([](char c){ return !std::isdigit(c); })
+          % fn::to_vector();
+        VERIFY(toks.size() == 4 && toks[1] == "2" && toks[3].empty());
+        VERIFY(toks[0].data() == str.data() && toks[2].data() == str.data() + 5);
 
-    /////////////////////////////////////////////////////////////////////////
-    /// Similar to `std::tie`; except capture lvalues as lvalue-references, and rvalues as values.
-    /*!
-    @code
-        const int x = 0;
-        const char* foo = "foo";
-        auto tpl = fn::tie_lvals(x, 42, std::ref(x), foo, "abc");
-        static_assert(std::is_same<decltype(tpl), std::tuple<const int&, int, std::reference_wrapper<const int>, const char*&, const char (&)[4]>>::value, "");
-    @code
-    */
-    template<typename... Ts>
-    auto tie_lvals(Ts&&... xs) -> std::tuple<Ts...>
+        // a view of chars
+        auto toks2 = fn::cfrom(str) % fn::split('I') % to_strs % fn::to_vector();
+        VERIFY(( toks2 == std::vector<std::string>({ "10M2", "3D" }) ));
+    };
+
+    test_other["join"] = [&]
     {
-        return std::tuple<Ts...>(std::forward<Ts>(xs)...);
-    }
+        VERIFY(( std::vector<std::string>({ "a", "bb", "ccc" }) % fn::join(", ") == "a, bb, ccc" ));
+        VERIFY(( std::vector<std::string>({ "", "a", "" }) % fn::join('|') == "|a|" ));
+        VERIFY(( std::vector<std::string>{} % fn::join(", ") == "" ));
+        VERIFY(( std::vector<char>({ 'a', 'b', 'c' }) % fn::join() == "abc" ));
 
-    /// @}
+        // seq of string-views
+        const std::string abc = "abc";
+        size_t pos = 0;
+        auto res = fn::seq([&]{ return pos < 3 ? fn::string_view(abc.data() + pos++, 1) : fn::end_seq(); })
+          % fn::join(std::string{ "--" });
+        VERIFY(res == "a--b--c");
 
+        // formatting version
+        VERIFY(( vec_t{{ 1, 2, 3 }}
+          % fn::join(",", [](std::string& out, int x)
+            {
+                out += std::to_string(x * x);
+            }) == "1,4,9" ));
 
-namespace operators
-{
-    // Why operator % ?
-    // Because many other libraries overload >> or | for various purposes,
-    // so in case of compilation errors involving those 
-    // you get an honorable mention of every possible overload in TU.
-    //
-    // Also, in range-v3 it is used for composition of views
-    // rather than a function application, so we want to avoid possible confusion.
+        VERIFY(( vec_t{{ 1, 2, 3 }}
+          % fn::transform([](int x){ return X{ x }; })
+          % fn::join(' ', [](std::string& out, const X& x)
+            {
+                out += std::to_string(int(x));
+            }) == "1 2 3" ));
+    };
 
-    /// @brief `return std::forward<F>(fn)(std::forward<Arg>(arg))`
-    ///
-    /// This is similar to Haskell's operator `(&) :: a -> (a -> b) -> b |infix 1|` or F#'s operator `|>`
-    
-#if 0 && (defined(__GNUC__) || defined(__clang__))
-    __attribute__ ((warn_unused_result))
-    // A user may forget to iterate over the sequence, e.g.
-    //         std::move(inputs) % fn::transform(...); // creates and immediately destroys a lazy-seq.
-    // whereas the user code probably intended:
-    //         std::move(inputs) % fn::transform(...) % fn::for_each(...);
-    // 
-    // To deal with this we could make operator% nodiscard / warn_unused_result,
-    // but disabling for now because I can't figure out how to suppress the 
-    // warning from the final % for_each(...).
-#endif 
-    template<typename Arg, typename F>
-    auto operator % (Arg&& arg, F&& fn) -> decltype( std::forward<F>(fn)(std::forward<Arg>(arg)) )
-    {
-        // NB: forwarding fn too because it may have rvalue-specific overloads
-        return std::forward<F>(fn)(std::forward<Arg>(arg));
-    }
 
-    // Note: in operator %= and <<= below we're not returning the original reference
-    // because the operators are right-to-left associative, so it makes no sense to do it.
+    /////////////////////////////////////////////////////////////////////////
 
-    /// @brief `arg = fn::to(Arg{})(std::forward<F>(fn)(std::move(arg)));`
-    ///
-    /// `strs %= fn::where([](const std::string& s){ return !s.empty(); }); // drop empty strings`
-    template<typename Arg, typename F>
-    auto operator %= (Arg& arg, F&& fn) -> decltype(void(std::forward<F>(fn)(std::move(arg))))
+    /////////////////////////////////////////////////////////////////////////
+    test_other["fn::where with associative containers"] = [&]
     {
-        // NB: forwarding fn too because it may have rvalue-specific overloads.
-        // Note: result-type may be not the same as arg, so we 
-        // have to move the elements rather than simply assign.
-        arg = fn::to(Arg{})(std::forward<F>(fn)(std::move(arg)));
-    }
+        // verify what filtering works for containers where
+        // std::remove_if is not supported (e.g. assotiative)
+        
+        auto ints2 = std::set<int>{{111, 333}};
 
-    /// @brief End-insert elements of cont2 into cont1 by-move.
-    /*!
-    @code
-        out <<= GetItems();
+        using fn::operators::operator%=;
 
-        // equivalent of:
-        {{
-            auto items = GetItems();
-            for(auto&& item : items) {
-                out.insert(out.end(), std::move(item));
-            }
-        }}
-    @endcode
-    */
-    template<class Container1, class Container2>
-    auto operator<<=(Container1& cont1, 
-                    Container2&& cont2) -> decltype(void(cont1.insert(cont1.end(), std::move(*cont2.begin()))))
-    {
-        static_assert(std::is_rvalue_reference<Container2&&>::value, "");
-        cont1.insert(cont1.end(),
-                     std::make_move_iterator(cont2.begin()),
-                     std::make_move_iterator(cont2.end()));
-    }
+        ints2 %= fn::where([](int x) { return x > 222; });
+        VERIFY(ints2.size() == 1 && *ints2.begin() == 333);
 
-    // Could also take Container2 by value, but taking by rvalue-reference instead
-    // will preserve the internal storage of the container (instead of it being 
-    // freed here when going out of scope if we took it by value). In some cases
-    // this may be desirable. So instead having separate overloads for 
-    // Container2&& and const Container2& that will copy elements.
+        using map_t = std::map<int, int>;
+        auto m = map_t{{ {1,111}, {3,333} }};
 
-    template<class Container1, class Container2>
-    auto operator<<=(Container1& cont1, 
-               const Container2& cont2) -> decltype(void(cont1.insert(cont1.end(), *cont2.begin())))
-    {
-        cont1.insert(cont1.end(),
-                     cont2.begin(),
-                     cont2.end());
-    }
+        m %= fn::where([](const map_t::value_type& x) { return x.second > 222; });
+        VERIFY(m.size() == 1 && m.at(3) == 333);
 
-    // I would have expected that seq-based input would work with the above overload as well,
-    // but that is not so - after wrapping into std::make_move_iterator we're getting 
-    // compilation errors about missing operators +,+=,-,-= for the iterator.
-    // Hence the special overload for seq (it already yields rvalue-references)
-    template<class Container1, class Gen>
-    void operator<<=(Container1& cont1, impl::seq<Gen> seq)
+        //*m.begin() = *m.begin();
+    };
+
+    test_other["fn::where with mutable lambdas"] = [&]
     {
-        cont1.insert(cont1.end(), seq.begin(), seq.end());
-    }
+         // must work with mutable lambda
+         int i = 0;
+         auto ints2 = vec_t{{1,2,3}} % fn::where([i](int) mutable { return i++ >= 1; });
+         VERIFY(( ints2 == vec_t{{2, 3}} ));
+    };
 
-    template<class Container>
-    void operator<<=(Container& cont, typename Container::value_type el)
+    test_other["fn::where with const_reference inputs"] = [&]
     {
-         cont.insert(cont.end(), std::move(el));
-    }
+        // check const-reference overload with non-sequence containers
+        const auto ints1 = std::set<int>{1,2,3};
+        auto ints2 = ints1 % fn::where([](int x_) { return x_ > 1; });
+        VERIFY(( ints2.size() == 2 ));
+    };
 
-} // namespace operators
+    test_other["fn::where with non-const reference inputs"] = [&]
+    {
+        // check const-reference overload with non-sequence containers
+        auto ints1 = std::set<int>{1,2,3};
+        auto ints2 = ints1 % fn::where([](int x_) { return x_ > 1; });
 
-} // namespace fn
+        VERIFY(( ints1.size() == 3 ));
+        VERIFY(( ints2.size() == 2 ));
+    };
 
-} // namespace rangeless
-        
-#if RANGELESS_ENABLE_TSV
 
-#include <string>
-#include <iostream>
-#include <cctype> // for MSVC v19.16
-#include <cstdlib>
-#include <cstring>
+    test_other["refs"] = [&]
+    {
+        auto inps = vec_t({1,2,3});
 
-namespace rangeless
-{
-namespace tsv
-{
-    using row_t = std::vector<std::string>;
+        auto res = fn::refs(inps)
+           % fn::foldl_d([](int64_t out, int& in)
+             {
+                ++in;
+                // NB: taking in by non-const reference to verify
+                // that it binds to non-const reference-wrapper
+                return out*10 + in;
+             });
+        VERIFY(res == 234);
 
-    struct params
-    {
-        std::string header = "";    
-        // If specified, throw unless it is encountered verbatim in data before first data-row.
-        // Used for checking that the file content corresponds to the program's expectations.
-        // Skipped, even if skip_comments = false.
-        //
-        //  e.g. "#Col1 name\tCol2 name"  - Column names are in a comment before the data rows.
-        //   or  "Col1 name\tCol2 name"   - Column names are in the first data-row.
-        //   or  "# File descriptor 42"   - some arbitrary comment. 
+        // check with const inputs
+        const auto& const_inps = inps;
+        res = fn::refs(const_inps)
+           % fn::foldl_d([](int64_t out, const int& in)
+             {
+                return out*10 + in;
+             });
+        VERIFY(res == 234);
 
-        std::string filename  = "";    // Report filename in exception messages.
-                                        
-        bool skip_comments    = true;  // Skip lines starting with '#'.
-        bool truncate_blanks  = true;  // Truncate leading and trailing spaces.
-        bool skip_empty       = true;  // Skip lines that are empty (checked after truncate_blanks is applied).
     };
 
+
     /////////////////////////////////////////////////////////////////////////
 
-    class get_next_line
+
+    test_other["memoized"] = [&]
     {
-    public: 
-        get_next_line(std::istream& istr, params p = params{})
-            :   m_istr{ istr }
-            , m_params{ std::move(p) }
-        {}
+        size_t exec_count = 0;
+        auto strs = std::vector<std::string>{{ "333", "4444", "22", "1" }};
 
-        auto operator()() -> std::reference_wrapper<const std::string>
+        using fn::operators::operator%=;
+        strs %= fn::sort_by(fn::make_memoized([&](const std::string& s)
         {
-            if(!m_istr) {
-                throw std::runtime_error("Stream " + m_params.filename + " is not in good state before reading.");
-            }
+            exec_count++; 
+            return s.size();
+        }));
 
-            m_line.clear();
-            while(std::getline(m_istr, m_line))
-                if(x_prepare())
-            {
-                return { m_line };
-            }
+        // this should not compile (decayed arg-type is not default-constructible)
+        // fn::make_memoized([&](std::tuple<int&> x) { return 123; });
 
-            if(    m_istr.bad() 
-               || (m_istr.fail() && !m_istr.eof()) 
-               || !m_line.empty())
-            {
-                throw std::runtime_error("Stream " + m_params.filename + " terminated abnormally.");
-            } else {
-                rangeless::fn::end_seq(); // finished normally.
-            }
+        // this should not compile (return type is not default-constructible)
+        // fn::make_memoized([&](int x) { return std::ref(x); });
 
-            return { m_line };
-        }
+        VERIFY((strs == std::vector<std::string>{{ "1", "22", "333", "4444" }}));
+        VERIFY(exec_count == 4);
+    };
 
-    private:
-        std::istream& m_istr;
-         const params m_params;
-                 bool m_found_header = false;
-          std::string m_line         = "";
+    test_other["scope_guard"] = [&]
+    {
+        int i = 0;
+        {{
+            auto on_exit_add1 = fn::make_scope_guard([&]
+            {
+                i += 1;
+            });
 
-        // preprocess the line and return true iff returnable
-        bool x_prepare()
-        {
-            if(!m_line.empty() && m_line.back() == '\r') {
-                m_line.pop_back();
-            }
+            auto on_exit_add10 = fn::make_scope_guard([&]
+            {
+                i += 10;
+            });
 
-            const bool is_comment = !m_line.empty() && m_line[0] == '#';
+            on_exit_add1.dismiss();
+        }}
+        VERIFY(i == 10);
+    };
 
-            if(    !m_params.header.empty()
-                && !m_found_header
-                && m_line == m_params.header)
-            {
-                m_found_header = true;
-                m_line.clear();
-                return false;
-            }
+    test_other["operator<<=, operator%="] = [&]
+    {
+        using fn::operators::operator<<=;
+        using fn::operators::operator%=;
 
-            if(m_params.truncate_blanks) {
-                while(!m_line.empty() && m_line.back() == ' ') {
-                    m_line.pop_back();
-                }
+        auto cont = vec_t{{1,2}};
+        cont <<= std::set<int>{{3,4}}; // excerising rvalue-based overload
 
-                size_t i = 0;
-                while(i < m_line.size() && m_line[i] == ' ') {
-                    ++i;
-                }
-                m_line.erase(0, i);
-            }
+        const auto const_set = std::set<int>{{5,6}};
+        cont <<= const_set; // excercising conts-reference overload.
 
-            if( (m_params.skip_empty    &&  m_line.empty())
-             || (m_params.skip_comments && !m_line.empty() && m_line[0] == '#'))
-            {
-                m_line.clear();
-                return false;
-            }
+        int i = 0;
+        cont <<= fn::seq([&i]{ return i++ < 1 ? 7 : fn::end_seq(); }); // should also work for seq rhs
 
-            if(    !m_line.empty() && !is_comment // data-line
-                && !m_params.header.empty() && !m_found_header) // did not find expected header-line
-            {
-                throw std::runtime_error(
-                        "Did not find expected header: '" 
-                       + m_params.header + "'" 
-                       + (m_params.filename.empty() ? "" : ( " in file: " + m_params.filename)));
-            }
+        cont <<= 9;
 
-            return true;
-        }
+        cont %= fn::where([](int x) { return x % 2 != 0; });
+
+        VERIFY((cont == vec_t{{1,3,5,7,9}}));
     };
 
-    /////////////////////////////////////////////////////////////////////////
+#if 0
+    test_other["generate and output_iterator"] = []
+    {
+        int i = 0;
+        auto r = fn::seq([&i]
+        {
+            return i < 5 ? i++ : fn::end_seq();
+        });
 
-    class split_on_delim
+        int sum = 0;
+        std::copy(r.begin(), r.end(), fn::make_output_iterator([&](int x)
+        {
+            sum = sum * 10 + x;
+        }));
+
+        VERIFY(sum == 1234);
+    };
+#endif
+
+    test_other["get_unique/set_unique"] = [&]
     {
-    private:
-        const char m_delim;
-        const bool m_truncate_blanks;
-        tsv::row_t m_row;
+        vec_t ints{{1,2,3}};
 
-    public:
-        split_on_delim(char delim = '\t', bool truncate_blanks = true)
-          : m_delim{ delim }
-          , m_truncate_blanks{ truncate_blanks }
-          , m_row{}
-        {}
+        auto& x1 = get_unique(ints, [](int x_){ return x_ == 2; });
+        VERIFY(x1 == 2);
 
-        // If we're an rvalue, support usage like `const auto row = tsv::split_on_delim{ ',' }("a,bb,ccc");` 
-        // or, if we want to reuse existing row's storage: `row = tsv::spit_on_delim{ ',' }("a,bb,ccc", std::move(row));`
-        auto operator()(const std::string& line, row_t ret = {}) const && -> tsv::row_t
-        {
-            ret.resize(size_t(1 + std::count(line.begin(), line.end(), m_delim)));
+        // verify that works with const
+        const auto& const_ints = ints;
+        const auto& x2 = get_unique(const_ints, [](int x_){ return x_ == 2; });
+        VERIFY(&x1 == &x2);
 
-            size_t i = 0;
-            auto capture_next = [&](size_t b, size_t e)
-            {
-                if(e == std::string::npos) {
-                    e = line.size();
-                }
+        auto ints2 = ints;
+        auto& y = set_unique(ints2, [](int x_) { return x_ == 42; },
+                                    []{ return 42; });
 
-                while(m_truncate_blanks && b < e && line[b] == ' ') {
-                    ++b;
-                }
-                while(m_truncate_blanks && b < e && line[e-1] == ' ') {
-                    --e;
-                }
+        VERIFY( ints2.size() == 4 
+            &&  ints2.back() == 42 
+            && &ints2.back() == &y);
+    };
 
-                ret[i++].assign(line, b, e - b);
-            };
+    test_other["group_adjacent_by vector-storage-recycling"] = []
+    {
+        // Check that vec_t& passed by reference
+        // is reused on subsequent iterations instead 
+        // of reallocated de-novo.
+        std::set<int*> ptrs;
 
-            size_t start_pos = 0, end_pos = 0;
+        auto result = 
+            vec_t{2,4,1,3,5,6,7,9}
+          % fn::to_seq()
+          % fn::group_adjacent_by([](int x) { return x % 2; })
+          % fn::foldl_d([&](int64_t out, vec_t&& in)
+            {
+                in.reserve(64);
+                ptrs.insert(in.data());
+                return out*10 + int64_t(in.size());
+            });
 
-            do {
-                end_pos = line.find(m_delim, start_pos);
-                capture_next(start_pos, end_pos);
-                start_pos = end_pos + 1;
-            } while(end_pos != std::string::npos);
+        VERIFY((result == 2312));
+        VERIFY((ptrs.size() <= 2));
+    };
 
-            return ret; // copy elision guaranteed here in c++11?
-        }
+    test_other["group_adjacent_by in_arena"] = [&]
+    {
+        const std::string text = "The quick brown fox,  jumps over the laaaaaaaaaaaaaaazy dog!";
 
-        // The operator below is for repeated invocations when we're an lvalue.
-        //
-        // To prevent unnecesary heap allocatinos, instead of returning row_t,
-        // we return a const reference-wrapper, and reuse the allocated storage
-        // in m_row.
-        auto operator()(const std::string& line) & -> std::reference_wrapper<const tsv::row_t>
+        auto is_alpha = [](const char c)
         {
-            m_row = std::move(*this)(line, std::move(m_row));
-            return { m_row };
+            return bool(std::isalpha(c));
+        };
+
+        const auto expected = text % fn::group_adjacent_by(is_alpha);
+
+        // the views keep their chunks alive, including
+        // across chunks, and with groups longer than a chunk.
+        const auto views = text
+          % fn::group_adjacent_by(is_alpha, fn::in_arena(8))
+          % fn::to_vector();
+
+        VERIFY(views.size() == expected.size());
+        for(size_t i = 0; i < views.size(); i++) {
+            VERIFY(views[i] == expected[i]);
         }
-    };
 
-    /// @brief Read tab-separated-values from stream.
-    /*!
-    @code
-    std::string result = "";
-    std::istringstream istr{"foo\n#comment\n\n\n  bar  \tbaz\n"};
+        const auto counts = text
+          % fn::group_adjacent_by(is_alpha, fn::in_arena(4))
+          % fn::counts();
+        VERIFY(counts.size() == 12 && counts.at(fn::arena_string_view{ " ", nullptr }) == 7);
 
-    for(const std::vector<std::string>& row : tsv::from(istr)) {
-        for(const auto& f : row) {
-            result += f;
-            result += "|";
+        // streaming: the chunk is reused in place once the views are gone,
+        // cycling many times over the long text.
+        std::string long_text{};
+        for(int i = 0; i < 100; i++) {
+            long_text += text;
         }
-        result += ";";
-    });
+        const auto long_expected = long_text % fn::group_adjacent_by(is_alpha);
 
-    VERIFY(result == "foo|;bar|baz|;");
-    @endcode
-    */
-    inline auto from(std::istream& istr, char delim = '\t', params params = {}) 
-        -> fn::impl::seq<
-                fn::impl::transform< tsv::split_on_delim >::gen<
-                    fn::impl::catch_end< tsv::get_next_line > > >
-    {
-        const auto truncate_blanks = params.truncate_blanks; // params will be moved from.
-        return fn::transform( split_on_delim{ delim, truncate_blanks } )( 
-                     fn::seq(  get_next_line{ istr,  std::move(params) }) );
-    }
+        const char* min_addr = nullptr;
+        const char* max_addr = nullptr;
+        auto lengths = long_text
+          % fn::group_adjacent_by(is_alpha, fn::in_arena(64))
+          % fn::transform([&](fn::string_view s)
+            {
+                min_addr = min_addr ? std::min(min_addr, s.data()) : s.data();
+                max_addr = std::max(max_addr, s.data() + s.size());
+                return s.size();
+            })
+          % fn::to_vector();
+        VERIFY(lengths.size() == long_expected.size() && size_t(max_addr - min_addr) <= 64);
+        VERIFY(lengths % fn::foldl(size_t(0), std::plus<size_t>{}) == long_text.size());
+
+        // from blocks
+        for(const size_t block_size : { 1, 3, 64 }) {
+            std::istringstream istr{ text };
+            auto words = fn::from_istream_blocks(istr, block_size)
+              % fn::group_adjacent_by(is_alpha, fn::in_arena(16))
+              % fn::transform([](fn::string_view s){ return std::string(s); })
+              % fn::to_vector();
+            VERIFY(words == expected);
+        }
+
+        // group_adjacent_if
+        auto runs = std::string("aaabccdd")
+          % fn::group_adjacent_if([](char a, char b){ return a == b; }, fn::in_arena())
+          % fn::transform([](fn::string_view s){ return s.size(); })
+          % fn::to_vector();
+        VERIFY(( runs == std::vector<size_t>({ 3, 1, 2, 2 }) ));
 
-    /// @brief Utility to parse numbers.
-    ///
-    /// This is a dispatcher for `std::strto*` functions with additional functionality:
-    /// throws `std::domain_error` if can't parse, or out of bounds, or input has trailing non-whitespaces, or the destination type is unsigned and the input is a negative number.
-    /*!
-     * @code
-     * double   a = tsv::to_num("");         // throws - expected a number
-     * double   b = tsv::to_num(" 123xyz");  // throws - trailing garbage not allowed
-     * int8_t   c = tsv::to_num(" 12345 ");  // throws - out of range
-     * float    d = tsv::to_num("12e-456");  // throws - underflow
-     * uint16_t e = tsv::to_num("-1");       // throws - negative number while destination is unsigned
-     * @endcode
-     */
-    class to_num
-    {
-    public:
-        to_num(const to_num&) = delete; // prevent nonsense like auto x = tsv::num("123") from compiling
-        to_num& operator=(const to_num&) = delete;
+        VERIFY(( std::string{} % fn::group_adjacent_by(is_alpha, fn::in_arena()) % fn::to_vector() ).empty());
+    };
 
-        explicit to_num(const char* str) 
-          : m_beg{ str }
-          , m_end{ m_beg + std::strlen(str) } 
-        {}
+    test_other["decreasing"] = [&]
+    {
+        // sort by longest-first, then lexicographically
 
-        template<typename Str> // string, string_view, CTempString etc.
-        explicit to_num(const Str& str) 
-          : m_beg{ str.begin() == str.end() ? nullptr : &*str.begin() }
-          , m_end{ str.begin() == str.end() ? nullptr : &*str.begin() + str.size() }
-        {}
+        const auto inp      = std::vector<std::string>{ "2", "333", "1", "222", "3" };
+        const auto expected = std::vector<std::string>{ "222", "333", "1", "2", "3" };
 
-        /// Conversion to an enum or enum-class
-        template<typename Enum, typename std::enable_if<std::is_enum<Enum>::value>::type* = nullptr>
-        operator Enum() const && // rvalue-specific such that no possibility of m_beg/m_end becoming dangling
+        auto ret1 = inp % fn::sort_by([](const std::string& s)
         {
-            auto value = typename std::underlying_type<Enum>::type{};
-            value = std::move(*this);
-            return Enum(value);
-        }
+            return fn::tie_lvals(fn::by::decreasing(s.size()), s);
+        });
+        VERIFY(ret1 == expected);
 
-        /// Conversion to an arithmetic type
-        template<typename Number, typename std::enable_if<std::is_arithmetic<Number>::value>::type* = nullptr>
-        operator Number() const &&
+        auto ret2 = inp % fn::sort_by([](const std::string& s)
         {
-            auto ret = Number{};
-            char* endptr = nullptr;
-            
-            errno = 0;
-            x_parse(ret, &endptr);
-
-            throw_if(errno,                      ret, "under-or-overflow"); 
-            throw_if(!endptr || endptr == m_beg, ret, "could not interpret");
-            throw_if(endptr > m_end,             ret, "parsed past the end");
+            return std::make_tuple(s.size(), fn::by::decreasing(std::ref(s)));
+        }) % fn::reverse() % fn::to_vector();
 
-            for(; endptr < m_end; ++endptr) { // verify that there's no garbage past the end
-                throw_if(!std::isspace(*endptr), ret, "trailing non-whitespace characters");
-            }
-            return ret;
-        }
+        VERIFY(ret2 == expected);
 
-        /// Convert to `uint8_t` first; throw unless 0 or 1; return as bool.
-        operator bool() const &&
+        auto ret3 = inp % fn::sort_by(fn::by::decreasing([](const std::string& s)
         {
-            uint8_t ret = std::move(*this);
-            throw_if(ret != 0 && ret != 1, ret, "out of bounds");
-            return ret;
-        }
+            return std::make_tuple(s.size(), fn::by::decreasing_ref(s));
+        }));
 
-    private:
-        const char* m_beg;
-        const char* m_end;
+        VERIFY(ret3 == expected);
 
-        template<typename T>
-        void throw_if(bool cond, const T&, const char* message) const
+        auto ret4 = inp;
+        std::sort(ret4.begin(), ret4.end(), fn::by::make_comp([](const std::string& s)
         {
-            if(cond) {
-                throw std::domain_error(
-                    "Can't parse '" 
-                  + std::string(m_beg, size_t(m_end-m_beg))
-                  + "' as numeric type '" + typeid(T).name() 
-                  + "' - " + message + ".");
-            }
-        }
+            return std::make_tuple(fn::by::decreasing(s.size()), std::ref(s));
+        }));
+
+        VERIFY(ret4 == expected);
+    };
+
+    test_other["by"] = [&]
+    {
+        // make sure first{}, second{}, and dereferenced{} return arg as reference (or reference-wrapper)
+        // rather than by value.
+
+        std::vector<std::pair<std::unique_ptr<int>, int>> v{};
+        
+        fn::sort_by(fn::by::first{})(std::move(v));
+        fn::sort_by(fn::by::second{})(std::move(v));
+
+        const auto xy = std::make_pair(10, 20);
+        const auto& x = fn::by::first{}(xy);
+        VERIFY(&x == &xy.first);
+
+        std::vector<std::unique_ptr<int> > v2{};
+        fn::sort_by(fn::by::dereferenced{})(std::move(v2));
+    };
+
+    test_other["exists_where"] = [&]
+    { 
+         VERIFY(  ( vec_t{{ 1, 2, 3}} %  fn::exists_where([](int x){ return x == 2; }) ));
+         VERIFY( !( vec_t{{ 1, 2, 3}} %  fn::exists_where([](int x){ return x == 5; }) ));
+         VERIFY(  ( vec_t{{ 1, 2, 3}} % !fn::exists_where([](int x){ return x == 5; }) ));
+    };
 
-        void x_parse(long double& d, char** endptr) const
-        {
-            d = std::strtold(m_beg, endptr);
-        }
 
-        void x_parse(double& d, char** endptr) const
-        {
-            d = std::strtod(m_beg, endptr);
-        }
-        
-        void x_parse(float& d, char** endptr) const
+#if __cplusplus >= 201402L
+    test_other["compose"] = []
+    {
+        auto my_transform = [](auto fn)
         {
-            d = std::strtof(m_beg, endptr);
-        }
+            return fn::adapt([fn = std::move(fn)](auto gen)
+            {
+                return fn(gen());
+            });
+        };
 
-        // NB: originally had two functions below as one function and 
-        // chose dynamically how to parse based on std::is_signed<Integral>::value,
-        // but had to switch to static-dispatch to avoid the signed-vs-unsigned 
-        // comparison warnings
+        auto my_where = [](auto pred)
+        {
+            return fn::adapt([pred = std::move(pred)](auto gen)
+            {
+                auto x = gen();
+                while(!pred(x)) {
+                    x = gen();
+                }
+                return x;
+            });
+        };
 
-        template<typename Integral, typename std::enable_if<std::is_signed<Integral>::value>::type* = nullptr >
-        void x_parse(Integral& x, char** endptr) const
+        auto my_take_while = [](auto pred)
         {
-            static_assert(std::is_integral<Integral>::value, "");
-            auto num = std::strtoll(m_beg, endptr, 10);
-            x = static_cast<Integral>(num);
-            throw_if(x != num, x, "overflow");
-        }
+            return fn::adapt([pred = std::move(pred)](auto gen)
+            {
+                auto x = gen();
+                return pred(x) ? std::move(x) : fn::end_seq();
+            });
+        };
 
-        template<typename Integral, typename std::enable_if<std::is_unsigned<Integral>::value>::type* = nullptr >
-        void x_parse(Integral& x, char** endptr) const
+        auto my_intersperse = [](auto delim)
         {
-            static_assert(std::is_integral<Integral>::value, "");
-            auto ptr = m_beg;
-            while(ptr < m_end && std::isspace(*ptr)) {
-                ++ptr;
-            }
-            throw_if(ptr < m_end && *ptr == '-', x, "negative number in unsigned conversion");
+#if 1
+            return [delim = std::move(delim)](auto inputs)
+            {
+                return fn::seq([  delim, 
+                                 inputs = std::move(inputs), 
+                                     it = inputs.end(), 
+                                started = false, 
+                                   flag = false]() mutable
+                {
+                    if(!started) {
+                        started = true;
+                        it = inputs.begin();
+                    }
+                    return it == inputs.end() ? fn::end_seq()
+                         :     (flag = !flag) ? std::move(*it++)
+                         :                      delim;
+                });
+            };
+            
+#elif 0 // or
 
-            auto num = std::strtoull(ptr, endptr, 10);
-            x = static_cast<Integral>(num);
-            throw_if(x != num, x, "overflow");
-        }
-    }; // to_num
+            return [delim = std::move(delim)](auto inputs)
+            {
+                return std::move(inputs)
+              % fn::transform([delim](auto inp)
+                {
+                    return std::array<decltype(inp), 2>{{ delim, std::move(inp) }};
+                })
+              % fn::concat()
+              % fn::drop_first(); // drop leading delim
+            };
 
+#else // or
 
-} // namespace tsv
+            return fn::adapt([delim, flag = false](auto gen) mutable
+            {
+                return           !gen ? fn::end_seq() 
+                     : (flag = !flag) ? gen() 
+                     :                  delim;
+            });
+#endif
+        };
 
-} // namespace rangeless
+        auto my_inclusive_scan = []
+        {
+            return fn::adapt([sum = 0](auto gen) mutable
+            {
+                return sum += gen();
+            });
+        };
 
-#endif // ENABLE_TSV
+        auto res = 
+            fn::seq([i = 0]() mutable
+            {
+                return i++;
+            })                  // 0,1,2,3,...
 
+          % my_where([](int x)
+            {
+                return x >= 3; 
+            })                  // 3,4,5,...
 
+          % my_take_while([](int x)
+            {
+                return x <= 5;
+            })                  // 3,4,5
 
-#if RANGELESS_FN_ENABLE_RUN_TESTS
-#include <list>
-#include <string>
-#include <tuple>
-#include <set>
-#include <array>
-#include <iostream>
-#include <sstream>
-#include <cctype>
-#include <memory>
+          % my_intersperse(-1)  // 3,-1,4,-1,5
 
-#ifndef VERIFY
-#define VERIFY(expr) if(!(expr)) RANGELESS_FN_THROW("Assertion failed: ( "#expr" ).");
-#endif
+          % my_transform([](int x)
+            {
+                return x + 1;
+            })                  // 4,0,5,0,6
 
-namespace rangeless
-{
-namespace fn
-{
-namespace impl
-{
+          % my_inclusive_scan() // 4,4,9,9,15
 
-// move-only non-default-constructible type wrapping an int.
-// Will use it as our value_type in tests to verify that 
-// we're supporting this.
-struct X
-{
-    int value;
+          % fn::to_vector();
 
-    X(int i) : value{ i }
-    {}
+        VERIFY((res == vec_t{{4, 4, 9, 9, 15}}));
+    };
+#endif // tests for compose
 
-#if defined(__GNUC__) && (__GNUC___ >= 5)
-    X() = delete;
 
-    // We want to test that everything compiles even if the
-    // type is not default-constructibse, however, with GCC 4.9.3
-    // that results in
-    // /opt/ncbi/gcc/4.9.3/include/c++/4.9.3/bits/stl_algobase.h:573:4: error: static assertion failed: type is not assignable
-    // when calling std::erase or std::rotate on a vector<X>.
-    //
-    // So making leaving X default-constructible.
-#endif
-               X(X&&) = default;
-    X& operator=(X&&) = default;
+    test_other["cartesian_product_with"] = [&]
+    {
+        auto res = 
+            vec_t{{1,2}}
+          % fn::cartesian_product_with( vec_t{{3,4,5}}, [](int x, int y)
+            {
+                return x*10+y;
+            })
+          % fn::foldl_d([](int64_t out, int64_t in)
+            {
+                return out*1000+in;
+            });
 
-               X(const X&) = delete;
-    X& operator=(const X&) = delete;
+         VERIFY(res == 13014015023024025);
+    };
 
-    operator int&()
+    test_other["guard_against_multiple_iterations_of_input_range"] = [&]
     {
-        return value;
-    }
+        auto gen_ints = [](int i, int j)
+        {
+            return fn::seq([i, j]() mutable
+            {
+                return i < j ? i++ : fn::end_seq();
+            });
+        };
 
-    operator const int& () const
-    {
-        return value;
-    }
-};
-using Xs = std::vector<X>;
+        auto xs =
+            gen_ints(0, 6) 
+          % fn::transform([&](int x) { return gen_ints(x, x+2); })
+          % fn::concat()
+          % fn::where([](int x) { return x % 2 == 0; });
 
-// This is templated to unary-callable, because
-// we want to reuse the same battery of tests when
-// the input is a container and when the input-type
-// is a lazy seq.
-template<typename UnaryCallable>
-auto make_tests(UnaryCallable make_inputs) -> std::map<std::string, std::function<void()>>
-{
-    std::map<std::string, std::function<void()>> tests{};
-    using fn::operators::operator%;
+        // 011223344556
+        int64_t res = 0;
+        bool threw = true;
+        try {
+            // xs is a seq, so trying to iterate it 
+            // a second time shall throw.
+            for(size_t i = 0; i < 2; i++) {
+                for(auto x : xs) {
+                    res = res*10 + x;
+                }
+            }
+            threw = false;
+        } catch(...) {
+            threw = true;
+        }
+        VERIFY(threw);
+        VERIFY(res == 22446);
+    };
 
-    //make_inputs({1, 2, 3}); // returns Xs or seq yielding X's
 
-    auto fold = fn::foldl_d([](int64_t out, int64_t in)
+    test_other["from_istream_blocks"] = [&]
     {
-        return out*10 + in;
-    });
+        const std::string text = "The quick brown fox,  jumps over\nthe lazy DOG!";
+
+        auto to_lower = [](const char c)
+        {
+            return ('A' <= c && c <= 'Z') ? char(c - ('Z' - 'z')) : c;
+        };
+
+        auto is_alpha = [](const char c)
+        {
+            return bool(std::isalpha(c));
+        };
+
+        std::istringstream istr1{ text };
+        auto expected = fn::from(
+            std::istreambuf_iterator<char>(istr1.rdbuf()),
+            std::istreambuf_iterator<char>{})
+          % fn::transform(to_lower)
+          % fn::group_adjacent_by(is_alpha)
+          % fn::to_vector();
 
+        VERIFY(expected.size() == 18 && expected[16] == "dog" && expected[17] == "!");
 
-#if 0
-    tests["single test of interest"] = [&]
-    {
+        // groups spanning blocks, down to one char per block
+        for(const size_t block_size : { 1, 3, 4, 1000 }) {
+            std::istringstream istr{ text };
+            auto words = fn::from_istream_blocks(istr, block_size)
+              % fn::transform_chars(to_lower)
+              % fn::group_adjacent_by(is_alpha)
+              % fn::to_vector();
+            VERIFY(words == expected);
+        }
 
-    };
-#else 
+        // blocks, as is
+        std::istringstream istr2{ text };
+        auto blocks = fn::from_istream_blocks(istr2, 16) % fn::to_vector();
+        VERIFY(blocks.size() == 3 && blocks[0] == "The quick brown " && blocks[2] == "\nthe lazy DOG!");
 
+        // empty stream
+        std::istringstream istr3{ "" };
+        VERIFY(( fn::from_istream_blocks(istr3) % fn::group_adjacent_by(is_alpha) % fn::to_vector() ).empty());
 
-#if __cplusplus >= 201402L // gcc 4.9.3 complains about auto&& as lambda param with -std=c++11
-    tests["Test for NB[4]"] = [&]
-    {
-        auto xs = make_inputs({1,2,3}) 
-                % fn::where_max_by([](auto&& xx)
-                  {
-                     return std::tie(xx);
-                  });
-        VERIFY(xs.size() == 1);
-    };
-#endif
+        // char -> int (e.g. std::tolower) is narrowed back to char
+        std::istringstream istr5{ text };
+        auto lowered = fn::from_istream_blocks(istr5, 16)
+          % fn::transform_chars([](char c){ return std::tolower(c); })
+          % fn::group_adjacent_by(is_alpha)
+          % fn::to_vector();
+        VERIFY(lowered == expected);
 
+        // same for a seq of chars
+        std::istringstream istr6{ text };
+        auto lowered2 = fn::from(std::istreambuf_iterator<char>(istr6.rdbuf()), std::istreambuf_iterator<char>{})
+          % fn::transform_chars([](char c){ return std::tolower(c); })
+          % fn::group_adjacent_by(is_alpha)
+          % fn::to_vector();
+        VERIFY(lowered2 == expected);
 
-    /////////////////////////////////////////////////////////////////////////
+#if __cplusplus >= 201402L
+        // fn::transform passes the blocks as is, e.g. to a generic function
+        std::istringstream istr4{ text };
+        auto sizes = fn::from_istream_blocks(istr4, 16)
+          % fn::transform([](const auto& blk){ return blk.size(); })
+          % fn::to_vector();
+        VERIFY(( sizes == std::vector<size_t>({ 16, 16, 14 }) ));
 
-    tests["Test for NB[3]"] = [&]
-    {
-        auto res = make_inputs({1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20})
-        % fn::transform([](X x) { return std::to_string(x); })
-        % fn::foldl_d([](std::string out, std::string in)
-        {
-            return std::move(out) + "," + in;
-        });
-        VERIFY(res == ",1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20");
+        // the README's word-frequency pipeline, with generic lambdas as made by its L(expr)
+        std::istringstream istr7{ text + " the" };
+        auto my_isalnum = [&](auto&& _){ return std::isalnum(_) || _ == '_'; };
+        auto top = fn::from_istream_blocks(istr7, 8)
+          % fn::transform_chars([&](auto&& _){ return char(std::tolower(_)); })
+          % fn::group_adjacent_by(my_isalnum)
+          % fn::where([&](auto&& _){ return my_isalnum(_.front()); })
+          % fn::counts()
+          % fn::group_all_by([&](auto&& _){ return _.first.size(); })
+          % fn::transform(fn::take_top_n_by(1UL, [&](auto&& _){ return _.second; }))
+          % fn::concat()
+          % fn::to_vector();
+        VERIFY(top.size() == 3 && top[0].first == "the" && top[0].second == 3);
+#endif
     };
 
-    tests["foldl"] = [&]
+    test_other["most 5 top frequent words"] = [&]
     {
-        // ensure compilation with move-only inputs
-        auto res = make_inputs({1,2,3})
-      % fn::foldl(X{42}, [](X out, int in)
-        {
-            return X(out*10+in);
-        });
-        VERIFY(res == 42123);
-    };
+        // TODO : for now just testing compilation
 
+        std::istringstream istr{};
 
+        auto my_isalnum = [](const int ch)
+        {
+            return std::isalnum(ch) || ch == '_';
+        };
 
+        using counts_t = std::map<std::string, size_t>;
 
-    /////////////////////////////////////////////////////////////////////////
+        fn::from_istream_blocks(istr)
 
-    tests["sliding_window"] = [&]
-    {
-        //using view_t = fn::view<typename vec_t::iterator>;
-        // TODO: does not compile if using auto instead of view_t
+          % fn::transform_chars([](const char c) // tolower
+            {
+                return ('A' <= c && c <= 'Z') ? char(c - ('Z' - 'z')) : c;
+            })
 
-#if __cplusplus >= 201402L
-    // using auto-parameter for `v` in lambda, can be
-    // either container's iterator, or deque<...>::iterator 
-    // depending on inputs type
+          % fn::group_adjacent_by(my_isalnum)
 
-        const auto result = 
-            make_inputs({ 1,2,3,4 })
-          % fn::sliding_window(2)
-          % fn::foldl(0L, [](long out, auto v)
-            { 
-                VERIFY(std::distance(v.begin(), v.end()) == 2);
-                auto it = v.begin();
-                return (out * 1000) + (*it * 10) + *std::next(it);
-            });
-        VERIFY(result == 12023034);
+#if 0
+            // build word->count map
+          % fn::foldl_d([&](counts_t out, const std::string& in)
+            {
+                if(my_isalnum(in.front())) {
+                    ++out[ in ];
+                }
+                return std::move(out);
+            })
+#else
+          % fn::where([&](const std::string& s)
+            {
+                return my_isalnum(s.front());
+            })
+          % fn::counts() // map:word->count
 #endif
-    };
 
-    /////////////////////////////////////////////////////////////////////////
-
-    tests["where"] = [&]
-    {
-        auto ret = make_inputs({1,2,3}) 
-            % fn::where([](int x) { return x != 2; }) 
-            % fold;
-        VERIFY(ret == 13);
+          % fn::group_all_by([](const counts_t::value_type kv)
+            {
+                return kv.first.size(); // by word-size
+            })
 
-        //123 % fn::where([](int x) { return x == 2; }); 
-    };
+          % fn::transform(
+                  fn::take_top_n_by(5UL, fn::by::second{}))
 
+          % fn::concat()
 
-    tests["where_in_sorted"] = [&]
-    {
-        auto ret = make_inputs({1,2,3,4})
-           % fn::where_in_sorted(std::vector<int>{{ 1, 3}})
-           % fold;
-        VERIFY(ret == 13);
+          % fn::for_each([](const counts_t::value_type& kv)
+            {
+                std::cerr << kv.first << "\t" << kv.second << "\n";
+            })
+          ;
     };
 
-    tests["where_not_in_sorted"] = [&]
+    test_other["placement-new without std::launder"] = [&]
     {
-        auto ret = make_inputs({1,2,3,4})
-           % fn::where_not_in_sorted(std::vector<int>{{1, 3}})
-           % fold;
-        VERIFY(ret == 24);
-    };
+        struct S
+        {
+            const int n;
+            const int& r;
+        };
+        const int x1 = 1;
+        const int x2 = 2;
 
-    tests["where_max_by"] = [&]
-    {
-        auto ret = make_inputs({1,3,1,3}) 
-            % fn::where_max_by(fn::by::identity{})
-            % fold;
-        VERIFY(ret == 33);
-    };
+        impl::maybe<S> m{};
 
-    tests["where_min_by"] = [&]
-    {
-        // NB: also testing compilation where key_fn returns a tuple
-        // containing references (see NB[2])
-        auto ret = make_inputs({5,3,5,3}) 
-            % fn::where_min_by([](const int& x) { return std::tie(x); })
-            % fold;
-        VERIFY(ret == 33);
+        m.reset(S{42, x1});
+        VERIFY((*m).n == 42);
+        VERIFY((*m).r == 1);
+
+        m.reset(S{420, x2});
+        VERIFY((*m).n == 420);
+        VERIFY((*m).r == 2);
     };
 
-    tests["take_while"] = [&]
-    {
-        auto ret = make_inputs({3,4,1,2}) 
-            % fn::take_while([](int x) { return x > 1; })
-            % fold;
-        VERIFY(ret == 34);
+    test_other["maybe specializations"] = [&]
+    {
+        static_assert(sizeof(impl::maybe<int*>) == sizeof(int*), "");
+        static_assert(sizeof(impl::maybe<std::reference_wrapper<const std::string>>) == sizeof(std::string*), "");
+        static_assert(std::is_trivially_destructible<impl::maybe<int>>::value, "");
+        static_assert(!std::is_trivially_destructible<impl::maybe<std::string>>::value, "");
+
+        // nullptr is a value, distinct from empty
+        int x = 42;
+        impl::maybe<const int*> p{};
+        VERIFY(!p);
+        p.reset(nullptr);
+        VERIFY(p && *p == nullptr);
+        p.reset(&x);
+        auto p2 = std::move(p);
+        VERIFY(!p && p2 && **p2 == 42);
+
+        const std::vector<const int*> ptrs = { &x, nullptr, &x };
+        VERIFY(( ptrs % fn::to_seq() % fn::to_vector() == ptrs ));
+
+        // reference-wrappers
+        std::string s1 = "a", s2 = "b";
+        impl::maybe<std::reference_wrapper<std::string>> r{};
+        VERIFY(!r);
+        r.reset(std::ref(s1));
+        VERIFY(r && (*r).get() == "a");
+        impl::maybe<std::reference_wrapper<std::string>> r2{ std::ref(s2) };
+        r = std::move(r2);
+        VERIFY(!r2 && (*r).get() == "b");
+        (*r).get() = "bb";
+        VERIFY(s2 == "bb");
+        r.reset();
+        VERIFY(!r);
+
+        // trivially-destructible
+        impl::maybe<int> i{ 1 };
+        impl::maybe<int> i2{};
+        i2 = std::move(i);
+        VERIFY(!i && i2 && *i2 == 1);
     };
 
-    tests["drop_while"] = [&]
+    test_other["counts"] = [&]
     {
-        auto ret = make_inputs({3,4,1,2}) 
-            % fn::drop_while([](int x) { return x > 1; })
-            % fold;
-        VERIFY(ret == 12);
+        auto res = 
+            vec_t{{ 1, 1,2, 1,2,3 }} 
+          % fn::counts()
+          % fn::transform([](const std::map<int, size_t>::value_type& kv)
+            {
+                return kv.first * 10 + int(kv.second);
+            })
+          % fn::to_vector();
+        
+        VERIFY((res == vec_t{{13, 22, 31}}));
     };
 
 
-    tests["take_last"] = [&]
+    test_other["lazy_sort_by"] = [&]
     {
-        auto ret = 
-              make_inputs({1,2,3}) 
-            % fn::take_last(2)
-            % fold;
-        VERIFY(ret == 23);
+        // pseudo-random pairs with many duplicate keys; ::second is the ordinal
+        std::vector<std::pair<int, int>> inp{};
+        uint32_t state = 12345;
+        for(int i = 0; i < 1000; i++) {
+            state = state * 1103515245u + 12345u;
+            inp.emplace_back(int((state >> 16) % 20), i);
+        }
 
-        ret = make_inputs({1,2,3}) 
-            % fn::take_last(3)
-            % fold;
-        VERIFY(ret == 123);
+        auto expected = inp;
+        std::stable_sort(expected.begin(), expected.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b)
+        {
+            return a.first < b.first;
+        });
 
-        ret = make_inputs({1,2,3}) 
-            % fn::take_last(4)
-            % fold;
-        VERIFY(ret == 123);
+        // consuming all elements
+        auto res = inp % fn::lazy_stable_sort_by(fn::by::first{}) % fn::to_vector();
+        VERIFY(res == expected);
 
-        const auto inputs = std::vector<int>{{1,2,3}};
-        ret = inputs % fn::take_last(2) % fold;
-        VERIFY(ret == 23);
+        // consuming a prefix
+        res = inp % fn::lazy_stable_sort_by(fn::by::first{}) % fn::take_first(10) % fn::to_vector();
+        VERIFY((res == std::vector<std::pair<int, int>>(expected.begin(), expected.begin() + 10)));
+
+        // unstable: keys in order, and all elements accounted-for.
+        res = inp % fn::lazy_sort_by(fn::by::first{}) % fn::to_vector();
+        VERIFY(res.size() == inp.size());
+        VERIFY(std::is_sorted(res.begin(), res.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b)
+        {
+            return a.first < b.first;
+        }));
+        VERIFY(res % fn::sort() == inp % fn::sort());
+
+        // McIlroy's "killer adversary": the values are decided lazily, as the comparisons
+        // are made, such that the partitions are maximally unbalanced. 
+        // The depth-limit bounds the number of comparisons to O(n*log(n)).
+        {{
+            struct adversary_t
+            {
+                std::vector<size_t> vals; // vals.size() is "gas": not yet decided
+                size_t num_solid;
+                size_t candidate;
+                size_t num_comparisons;
+            };
+
+            struct adversarial_key
+            {
+                size_t i;
+                adversary_t* adv;
+
+                bool operator<(const adversarial_key& other) const
+                {
+                    auto& vals = adv->vals;
+                    const size_t gas = vals.size();
+                    const size_t j = other.i;
+
+                    ++adv->num_comparisons;
+                    if(vals[i] == gas && vals[j] == gas) {
+                        vals[i == adv->candidate ? i : j] = adv->num_solid++;
+                    }
+                    if(vals[i] == gas) {
+                        adv->candidate = i;
+                    } else if(vals[j] == gas) {
+                        adv->candidate = j;
+                    }
+                    return vals[i] < vals[j];
+                }
+            };
+
+            const size_t num = 4000;
+            adversary_t adv{ std::vector<size_t>(num, num), 0, 0, 0 };
+
+            std::vector<size_t> idxs{};
+            for(size_t i = 0; i < num; i++) {
+                idxs.push_back(i);
+            }
+
+            const auto sorted_idxs = std::move(idxs)
+              % fn::lazy_sort_by([&adv](size_t i){ return adversarial_key{ i, &adv }; })
+              % fn::to_vector();
+
+            VERIFY(sorted_idxs.size() == num);
+            VERIFY(std::is_sorted(sorted_idxs.begin(), sorted_idxs.end(), [&adv](size_t a, size_t b)
+            {
+                return adv.vals[a] < adv.vals[b];
+            }));
+            VERIFY(adv.num_comparisons < 100 * num); // ~35*num; without the depth-limit ~num*num/4
+        }}
+
+        // move-only elements
+        Xs xs{};
+        for(const int i : { 3, 1, 2, 1 }) {
+            xs.emplace_back(i);
+        }
+        auto res2 = std::move(xs)
+          % fn::lazy_stable_sort()
+          % fn::foldl_d([](int out, const X& x){ return out * 10 + x; });
+        VERIFY(res2 == 1123);
+
+        // pulling past the end
+        auto sorted = vec_t{{ 3, 1, 2 }} % fn::lazy_sort();
+        auto& gen = sorted.get_gen();
+        int n = 0;
+        while(gen()) {
+            ++n;
+        }
+        VERIFY(n == 3 && !gen() && !gen());
     };
 
-    tests["drop_last"] = [&]
+    test_other["sort_by with string keys"] = [&]
     {
-        auto ret = 
-              make_inputs({1,2,3}) 
-            % fn::drop_last(2)
-            % fold;
+        // Strings sharing long prefixes, such that many normalized-prefix ties
+        // need to be resolved by full comparison; ::second is the ordinal.
+        std::vector<std::pair<std::string, int>> inp{};
+        uint32_t state = 42;
+        for(int i = 0; i < 500; i++) {
+            state = state * 1103515245u + 12345u;
+            const auto r = (state >> 16) % 64;
+            inp.emplace_back( r % 3 == 0 ? "acc" + std::to_string(r)
+                            : r % 3 == 1 ? "NM_000000" + std::to_string(r % 5)
+                            :              std::string(r % 7, 'x'), i);
+        }
 
-        VERIFY(ret == 1);
+        auto expected = inp;
+        std::stable_sort(expected.begin(), expected.end(), [](const std::pair<std::string, int>& a, const std::pair<std::string, int>& b)
+        {
+            return a.first < b.first;
+        });
 
-        ret = make_inputs({1,2,3}) 
-            % fn::drop_last(3)
-            % fold;
+        VERIFY(inp % fn::sort_by(fn::by::first{}) == expected);
+        VERIFY(inp % fn::unstable_sort_by(fn::by::first{}) == expected); // ties are resolved on the ordinal
 
-        VERIFY(ret == 0);
+        // std::tie-key with the string first
+        VERIFY((inp % fn::sort_by([](const std::pair<std::string, int>& p)
+                      {
+                          return std::tie(p.first, p.second);
+                      })
+                    % fn::sort_by(fn::by::first{})) == expected);
 
-        ret = make_inputs({1,2,3}) 
-            % fn::drop_last(4)
-            % fold;
+        // decreasing order is handled by the generic backend
+        auto res = inp % fn::sort_by([](const std::pair<std::string, int>& p)
+        {
+            return fn::by::decreasing(p.first);
+        });
+        const auto get_key = [](const std::pair<std::string, int>& p){ return p.first; };
+        std::reverse(expected.begin(), expected.end());
+        VERIFY(res % fn::transform(get_key) % fn::to_vector()
+          == expected % fn::transform(get_key) % fn::to_vector());
+    };
+
+    test_other["sort_by with presorted runs"] = [&]
+    {
+        // NB: static rather than captured by-reference, because GCC-12 at -O1 and above
+        // (-fipa-modref) fails to observe the increments via nested reference-captures.
+        static size_t num_calls = 0;
+        const auto key_fn = [](const std::pair<int, int>& p)
+        {
+            num_calls++;
+            return p.first;
+        };
+
+        const auto verify_sorts = [&](const std::vector<std::pair<int, int>>& inp)
+        {
+            auto expected = inp;
+            std::stable_sort(expected.begin(), expected.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b)
+            {
+                return a.first < b.first;
+            });
+            VERIFY(inp % fn::sort_by(key_fn) == expected);
+        };
+
+        // ::second is the ordinal
+        std::vector<std::pair<int, int>> inp{};
+
+        // already sorted: n-1 comparisons
+        for(int i = 0; i < 1000; i++) {
+            inp.emplace_back(i / 3, i);
+        }
+        num_calls = 0;
+        verify_sorts(inp);
+        VERIFY(num_calls == 2 * 999);
 
-        VERIFY(ret == 0);
+        // reverse-sorted, with ties
+        std::reverse(inp.begin(), inp.end());
+        verify_sorts(inp);
 
-        const auto inputs = std::vector<int>{{1,2,3}};
-        ret = inputs % fn::drop_last(2) % fold;
-        VERIFY(ret == 1);
-    };
+        // concatenated sorted shards, ascending and descending
+        inp.clear();
+        for(int i = 0; i < 3000; i++) {
+            const int shard = i / 1000;
+            inp.emplace_back(shard == 1 ? 1000 - i % 1000 : (i * 7) % 1000, i);
+        }
+        std::sort(inp.begin(),        inp.begin() + 1000);
+        std::sort(inp.begin() + 2000, inp.end());
+        verify_sorts(inp);
 
-    tests["take_first"] = [&]
-    {
-        auto ret = 
-              make_inputs({1,2,3}) 
-            % fn::take_first(2)
-            % fold;
-        VERIFY(ret == 12);
+        // not presorted
+        uint32_t state = 7;
+        for(auto& p : inp) {
+            state = state * 1103515245u + 12345u;
+            p.first = int((state >> 16) % 100);
+        }
+        verify_sorts(inp);
     };
 
-    tests["drop_first"] = [&]
+    test_other["where_indices"] = [&]
     {
-        auto ret = 
-              make_inputs({1,2,3}) 
-            % fn::drop_first(2)
-            % fold;
-        VERIFY(ret == 3);
-    };
+        Xs xs{};
+        for(int i = 0; i < 10; i++) {
+            xs.emplace_back(i);
+        }
 
+        auto sel = xs
+          % fn::where_indices([](const X& x){ return x % 2 == 0; })
+          % fn::where_indices([](const X& x){ return x > 2; });
 
-    /////////////////////////////////////////////////////////////////////////
+        VERIFY((sel.indices == std::vector<size_t>{{ 4, 6, 8 }}));
 
-    tests["append"] = [&]
-    {
-        auto res = make_inputs({1,2,3})
-                 % fn::append( make_inputs({4,5}) )
-                 % fold;
+        // iterating yields references to the original elements
+        int sum = 0;
+        for(const X& x : sel) {
+            sum += x;
+        }
+        VERIFY(sum == 18);
 
-        VERIFY(res == 12345);
+        // selection's iterator is default-constructible, as a ForwardIterator
+        decltype(sel.begin()) it{};
+        it = sel.begin();
+        VERIFY(int(*it) == 4);
+
+        // gather moves-out the selected elements of a non-const container
+        auto res = std::move(sel)
+          % fn::gather()
+          % fn::transform([](X x){ return int(x); })
+          % fn::to_vector();
+        VERIFY((res == vec_t{{ 4, 6, 8 }}));
+        VERIFY(xs.size() == 10);
     };
 
-    tests["zip_with"] = [&]
+    test_other["soa_vector"] = [&]
     {
-        auto res = make_inputs({1,2})
-                 % fn::zip_with( make_inputs({3,4,5}), [](int x, int y)
-                   {
-                        return std::array<int, 2>{{x, y}};
-                   })
-                 % fn::concat()
-                 % fold;
+        using soa_t = fn::soa_vector<std::string, int, X>;
 
-        VERIFY(res == 1324);
-    };
+        soa_t soa{};
+        for(int i = 0; i < 6; i++) {
+            soa.push_back(soa_t::value_type{ "acc" + std::to_string(i % 3), 10 - i, X{ i } });
+        }
 
+        soa = std::move(soa)
+          % fn::where([](const soa_t::const_reference& row){ return std::get<1>(row) > 5; })
+          % fn::sort_by(fn::by::get<std::string>{});
 
-    /////////////////////////////////////////////////////////////////////////
+        VERIFY(( soa.column<1>() == vec_t{{ 10, 7, 9, 6, 8 }} ));
+        VERIFY(soa.size() == 5 && std::get<2>(soa[1]) == 3 && std::get<0>(soa[4]) == "acc2");
 
-    tests["enumerate"] = [&]
-    {
-        auto res = make_inputs({4,5,6})
-        % fn::transform(fn::get::enumerated{})
-        % fn::transform([](std::pair<size_t, int> p)
-        {
-            return std::array<int, 2>{{p.second, int(p.first)}};
-        })
-        % fn::concat()
-        % fold;
+        // generic container-overloads: take_while erases via soa_vector::erase
+        soa = std::move(soa) % fn::take_while([](const soa_t::const_reference& row){ return std::get<1>(row) != 6; });
+        VERIFY(soa.size() == 3);
 
-        VERIFY(res == 405162);
-    };
+        // swapping rows via the row-proxies
+        soa = std::move(soa) % fn::reverse();
+        VERIFY(( soa.column<1>() == vec_t{{ 9, 7, 10 }} ));
+        VERIFY(std::get<0>(soa[0]) == "acc1" && std::get<2>(soa[0]) == 1);
 
-    /////////////////////////////////////////////////////////////////////////
-    
-    tests["values"] = [&]
-    {
-        auto inps = make_inputs({1,2,3});
+        const auto rows = std::move(soa) % fn::to_vector();
+        VERIFY(rows.size() == 3 && std::get<2>(rows[0]) == 1 && std::get<0>(rows[0]) == "acc1");
 
-        auto m = std::map<int, decltype(inps) >{};
-        m.emplace(1, std::move(inps));
-        m.emplace(2, make_inputs({4,5,6}));
+        // generic stages on an rvalue: the rows are moved out of the columns
+        {{
+            fn::soa_vector<std::string, std::unique_ptr<int>> soa_p{};
+            for(int i = 0; i < 3; i++) {
+                soa_p.push_back(std::make_tuple(std::to_string(i), std::unique_ptr<int>{ new int(i * 10) }));
+            }
 
-        auto res = std::move(m) 
-                 % fn::transform(fn::get::second{})
-                 % fn::concat() 
-                 % fold;
+            auto ptrs = std::move(soa_p)
+              % fn::transform([](std::tuple<std::string, std::unique_ptr<int>> row)
+                {
+                    return std::move(std::get<1>(row));
+                })
+              % fn::to_vector();
 
-        VERIFY(res == 123456);
-    };
+            VERIFY(ptrs.size() == 3 && *ptrs[0] == 0 && *ptrs[2] == 20);
+        }}
 
-    /////////////////////////////////////////////////////////////////////////
+        // const: copy the satisfying rows; lazy stages see value_type
+        const fn::soa_vector<std::string, int> csoa{ std::make_tuple(std::string("a"), 1), 
+                                                     std::make_tuple(std::string("b"), 2) };
 
-    tests["group_adjacent"] = [&]
-    {
-        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
-        % fn::group_adjacent()
-        % fn::transform([](Xs v)
+        auto res = csoa % fn::where([](const fn::soa_vector<std::string, int>::const_reference& row)
         {
-            return int(v.size());
-        })
-        % fold;
-        VERIFY(res == 12321);
-    };
+            return std::get<0>(row) == "b";
+        });
+        VERIFY(res.size() == 1 && csoa.size() == 2);
 
-    tests["group_adjacent_if"] = [&]
-    {
-        auto res = make_inputs({1,2,2,4,4,4,2,2,1})
-        % fn::group_adjacent_if([](const int& a, const int& b)
-        {
-            return abs(a - b) < 2;
-        })
-        % fn::transform([](Xs v)
+        // copying a row out leaves the columns intact
+        auto soa2 = csoa;
+        const std::tuple<std::string, int> row0 = *soa2.begin();
+        VERIFY(std::get<0>(row0) == "a" && std::get<0>(soa2[0]) == "a");
+
+        std::sort(soa2.begin(), soa2.end(), [](const std::tuple<std::string, int>& a, 
+                                               const std::tuple<std::string, int>& b)
         {
-            return int(v.size());
-        })
-        % fold;
-        VERIFY(res == 333);
+            return std::get<1>(a) > std::get<1>(b);
+        });
+        VERIFY(( soa2.column<0>() == std::vector<std::string>({ "b", "a" }) ));
+
+        auto ints = fn::cfrom(csoa) 
+          % fn::transform([](const std::tuple<std::string, int>& row){ return std::get<1>(row); }) 
+          % fn::to_vector();
+        VERIFY(( ints == vec_t{{ 1, 2 }} ));
     };
 
-    tests["group_all"] = [&]
+    test_other["sample_n, sample_fraction"] = [&]
     {
-        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
-        % fn::group_all()
-        % fn::transform([](Xs v)
+        // a minimal UniformRandomBitGenerator, so we don't need <random>
+        struct lcg_t
         {
-            return int(v.size());
-        })
-        % fold;
-        VERIFY(res == 243);
+            uint64_t state;
+
+            using result_type = uint32_t;
+            static constexpr result_type min() { return 0; }
+            static constexpr result_type max() { return 0xFFFFFFFFu; }
+
+            result_type operator()()
+            {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                return result_type(state >> 32);
+            }
+        };
+        lcg_t rng{ 42 };
+
+        auto inputs = vec_t{};
+        for(int i = 0; i < 10000; i++) {
+            inputs.push_back(i);
+        }
+
+        {{
+            auto res = fn::cfrom(inputs) % fn::sample_n(100, rng) % fn::sort();
+            VERIFY(res.size() == 100);
+            VERIFY(std::adjacent_find(res.begin(), res.end()) == res.end()); // no repeats
+            VERIFY(res.front() < 1000 && res.back() > 9000); // spans the range
+
+            // same with a seq; fewer inputs than k
+            VERIFY(fn::seq([]{ return 1; }) % fn::take_first(5) % fn::sample_n(10, rng) == vec_t(5, 1));
+        }}
+
+        {{
+            auto res = fn::cfrom(inputs) % fn::sample_fraction(0.1, rng) % fn::to_vector();
+            VERIFY(res.size() > 800 && res.size() < 1200);
+            VERIFY(std::is_sorted(res.begin(), res.end()));
+            VERIFY(std::adjacent_find(res.begin(), res.end()) == res.end());
+
+            auto res2 = fn::cfrom(inputs) % fn::to_seq() % fn::sample_fraction(0.1, rng) % fn::to_vector();
+            VERIFY(res2.size() > 800 && res2.size() < 1200);
+
+            VERIFY((fn::cfrom(inputs) % fn::sample_fraction(1.0, rng) % fn::to_vector()) == inputs);
+            VERIFY((fn::cfrom(inputs) % fn::sample_fraction(0.0, rng) % fn::to_vector()).empty());
+        }}
     };
 
-    tests["in_groups_of"] = [&]
+    test_other["approx_distinct_by"] = [&]
     {
-        auto res = make_inputs({1,2,3,4,5})
-        % fn::in_groups_of(2)
-        % fn::transform([](Xs v)
+        // small cardinality: linear counting is nearly exact
+        int n = 0;
+        auto sketch = fn::seq([&n]{ return n++; })
+          % fn::take_first(3000)
+          % fn::approx_distinct_by([](int x){ return x % 100; }, 10);
+
+        VERIFY(std::fabs(sketch.estimate() - 100) < 2);
+
+        // large cardinality, composite keys, merging shards with overlapping keys
+        auto make_sketch = [](int b, int e)
         {
-            return int64_t(v.size());
-        })
-        % fold;
-        VERIFY(res == 221);
-    };
+            auto inps = std::vector<std::pair<std::string, int>>{};
+            for(int i = b; i < e; i++) {
+                inps.emplace_back(i % 2 ? "a" : "b", i);
+            }
+            return inps % fn::approx_distinct_by([](const std::pair<std::string, int>& p)
+            {
+                return std::tie(p.first, p.second);
+            }, 12);
+        };
 
-    tests["concat"] = [&]
-    {
-        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
-        % fn::group_all()
-        % fn::concat()
-        % fold;
-        VERIFY(res == 112222333);
-    };
+        auto sketch2 = make_sketch(0, 60000);
+        sketch2.merge(make_sketch(40000, 100000));
 
-    tests["unique_adjacent"] = [&]
-    {
-        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
-        % fn::unique_adjacent()
-        % fold;
-        VERIFY(res == 12321);
-    };
+        const double err = 3 * sketch2.relative_error(); // ~4.9%
+        VERIFY(std::fabs(sketch2.estimate() / 100000 - 1) < err);
 
-    tests["unique_all"] = [&]
-    {
-        // NB: key-function requires copy-constructible in this use-case.
-        // see unique_all_by::gen::operator()()
-        auto res = make_inputs({1,2,2,3,3,3,2,2,1})
-#if 0
-        % fn::unique_all()
-        // Normally this would work, but we've made our type X not default-constructible,
-        // so when using identity key-fn, the type X returned by it cannot be 
-        // used as key-type to store seen elements. Instead, will use modified key-fn below.
-#elif 1
-        % fn::unique_all_by([](const X& x) -> const int& { return x; })
-#elif 0
-        % fn::unique_all_by([](const X& x) { const int& r = x; return std::tie(r); })
-        // This is not expected to work because returned reference-wrapper is
-        // not default-constructible.
-#endif
-        % fold;
-        VERIFY(res == 123);
+        // different precisions can't be merged
+        bool threw = false;
+        try {
+            sketch2.merge(sketch);
+        } catch(const std::logic_error&) {
+            threw = true;
+        }
+        VERIFY(threw);
     };
 
-    tests["sort"] = [&]
+    test_other["approx_quantiles_by"] = [&]
     {
-        auto res = make_inputs({3,2,4,1,5})
-        % sort()
-        % reverse()
-        % fold;
-        VERIFY(res == 54321);
+        auto make_sketch = [](int b, int e)
+        {
+            return fn::seq([b]() mutable { return b++; })
+              % fn::take_first(size_t(e - b))
+              % fn::approx_quantiles_by([](int x){ return (x * 7919) % 100000; }); // shuffled 0..99999
+        };
 
-        res = make_inputs({3,2,4,1,5})
-        % unstable_sort()
-        % fold;
-        VERIFY(res == 12345);
-    };
+        auto sketch = make_sketch(0, 100000);
+        VERIFY(sketch.count() == 100000 && sketch.num_retained() < 1000);
 
-    tests["lazy_sort"] = [&]
-    {
-        auto res = make_inputs({3,2,4,1,5})
-        % lazy_sort()
-        % reverse()
-        % fold;
-        VERIFY(res == 54321);
-    };
+        VERIFY(std::abs(sketch.quantile(0.5)  - 50000) < 1700);
+        VERIFY(std::abs(sketch.quantile(0.99) - 99000) < 1700);
+        VERIFY(std::fabs(sketch.rank(25000) - 0.25) < 0.017);
 
-    tests["top_n"] = [&]
-    {
-        auto res = make_inputs({3,2,4,1,5,0})
-        % take_top_n(3)
-        % fold;
-        VERIFY(res == 345);
-    };
+        // merging sketches of shards
+        auto merged = make_sketch(0, 30000);
+        merged.merge(make_sketch(30000, 100000));
+        VERIFY(merged.count() == 100000);
+        VERIFY(std::abs(merged.quantile(0.5) - 50000) < 1700);
+        VERIFY(std::abs(merged.quantile(0.1) - 10000) < 1700);
 
+        // exact while under capacity
+        auto small = vec_t{{ 5, 1, 4, 2, 3 }} % fn::approx_quantiles_by(fn::by::identity{});
+        VERIFY(small.quantile(0) == 1 && small.quantile(0.5) == 3 && small.quantile(1) == 5);
+    };
 
-#if __cplusplus >= 201402L
-    tests["group_adjacent_as_subseqs"] = [&]
+    test_other["heavy_hitters_by"] = [&]
     {
-        int res = 0;
-        int group_num = 0;
-
-        make_inputs({1,2,2,3,3,3,4,5})
-      % fn::group_adjacent(fn::to_seq())
-      % fn::for_each([&](auto subseq)
+        // 30% are 1, 20% are 2, 10% are 3, the rest are distinct.
+        auto make_summary = [](int b, int e)
         {
-            //subseq.size();  // sanity-check: this should not compile, because type is seq<...>
+            return fn::seq([b]() mutable { return b++; })
+              % fn::take_first(size_t(e - b))
+              % fn::heavy_hitters_by([](int i)
+                {
+                    return i % 10 < 3 ? 1
+                         : i % 10 < 5 ? 2
+                         : i % 10 < 6 ? 3
+                         :              1000 + i;
+                }, 9);
+        };
 
-            group_num++;
-            if(group_num == 4) {
-                return; // testing skipping a group without accessing it
-            }
+        auto summary = make_summary(0, 10000);
+        VERIFY(summary.count() == 10000);
+        VERIFY(summary.error_bound() <= 10000 / 10);
 
-            size_t i = 0;
-            for(const auto x : subseq) {
+        const auto top = summary.top();
+        VERIFY(top.size() >= 3 && top[0].first == 1 && top[1].first == 2 && top[2].first == 3);
+        VERIFY(summary.count(1) <= 3000 && summary.count(1) + summary.error_bound() >= 3000);
+        VERIFY(summary.count(3) <= 1000 && summary.count(3) + summary.error_bound() >= 1000);
 
-                // testing that things work as expected
-                // for partially-accessed groups leaving
-                // some elements unaccessed. Here we'll skip
-                // the last 3 in 333 subgroup.
-                if(i++ >= 2) {
-                    break;
-                }
+        auto merged = make_summary(0, 4000);
+        merged.merge(make_summary(4000, 10000));
+        VERIFY(merged.count() == 10000);
+        VERIFY(merged.error_bound() <= 10000 / 10);
+        VERIFY(merged.count(2) <= 2000 && merged.count(2) + merged.error_bound() >= 2000);
+        VERIFY(merged.top().size() <= 9 && merged.top()[0].first == 1);
+    };
 
-                res = res*10 + x;
+    test_other["approx_counts_by"] = [&]
+    {
+        // key i occurs i times, for i in [1, 100)
+        auto inputs = vec_t{};
+        for(int i = 1; i < 100; i++) {
+            inputs.insert(inputs.end(), size_t(i), i);
+        }
+
+        for(const bool conservative : { false, true }) {
+            auto sketch = inputs % fn::approx_counts_by(fn::by::identity{}, 272, 5, conservative);
+            VERIFY(sketch.total() == inputs.size()); // 4950
+            VERIFY(sketch.error_bound() < 50);       // e / 272 * N
+
+            for(int i = 1; i < 100; i++) {
+                VERIFY(sketch.count(i) >= uint64_t(i));
+                VERIFY(sketch.count(i) <= uint64_t(i) + 50);
             }
-            res = res*10;
-        });
+        }
 
-        VERIFY(res == 1022033050);
+        // merge shards
+        auto sketch = fn::cfrom(inputs) % fn::take_first(2000) % fn::approx_counts_by(fn::by::identity{}, 1000, 4);
+        sketch.merge(fn::cfrom(inputs) % fn::drop_first(2000) % fn::approx_counts_by(fn::by::identity{}, 1000, 4));
+        VERIFY(sketch.total() == inputs.size());
+        VERIFY(sketch.count(63) >= 63 && sketch.count(63) <= 63 + 20);
+        VERIFY(sketch.count(1000) <= 20); // absent
     };
-#endif
-
 
-    tests["key_fn returning a reference_wrapper"] = [&]
+    test_other["unique_within_by"] = [&]
     {
-        // testing compilation. see lt
-        auto get_ref = [](const X& x) { return std::cref(x); };
+        // last-n window: the dup at index 4 refreshes the key
+        VERIFY(( vec_t{{ 1, 2, 1, 3, 1, 2, 2 }} % fn::unique_within_by(fn::by::identity{}, 2) % fn::to_vector()
+              == vec_t{{ 1, 2, 3, 2 }} ));
 
-        make_inputs({1,2,3}) %       fn::group_all_by(get_ref);
-        make_inputs({1,2,3}) %  fn::group_adjacent_by(get_ref);
-        make_inputs({1,2,3}) %            fn::sort_by(get_ref);
-        make_inputs({1,2,3}) % fn::unique_adjacent_by(get_ref);
-    //  make_inputs({1,2,3}) %      fn::unique_all_by(get_ref);
-    //  This is static-asserted against for seq because the implementation
-    //  requires default-constructible key-type (see discussion in unique_all_by::gen)
+        VERIFY(( vec_t{{ 1, 2, 3, 1, 2, 2, 3 }} % fn::unique_within_lru_by(fn::by::identity{}, 2) % fn::to_vector()
+              == vec_t{{ 1, 2, 3, 1, 2, 3 }} ));
+
+        // time-span window
+        using event_t = std::pair<int, std::string>; // (time, key)
+        auto events = std::vector<event_t>{{ {0, "a"}, {5, "a"}, {12, "a"}, {30, "a"}, {31, "b"}, {35, "b"} }};
+
+        auto times = std::move(events)
+          % fn::unique_within_by(fn::by::second{}, 10, fn::by::first{})
+          % fn::transform([](const event_t& e){ return e.first; })
+          % fn::to_vector();
+        VERIFY(( times == vec_t{{ 0, 30, 31 }} ));
+
+        // unbounded stream, with move-only elements
+        int i = 0;
+        auto res = fn::seq([i]() mutable { return X{ i++ % 100 }; })
+          % fn::unique_within_lru_by([](const X& x){ return x % 10; }, 5)
+          % fn::take_first(12)
+          % fn::transform([](X x){ return int(x); })
+          % fn::to_vector();
+        VERIFY(( res == vec_t{{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 }} ));
     };
 
-    tests["to"] = [&]
+    test_other["incremental_aggregate_by"] = [&]
     {
-        auto res = make_inputs({2,3,1,2}) % fn::to(std::set<int>{}) % fold;
-        VERIFY(res == 123);
-    };
+        using row_t = std::pair<std::string, int>;
+        using rows_t = std::vector<row_t>;
+        using res_t = std::vector<std::pair<const std::string, int>>; // map::value_type
 
+        const auto table = rows_t{{ {"a", 1}, {"a", 5}, {"b", 3} }};
+        const auto ins   = rows_t{{ {"a", 2}, {"c", 7} }};
+        const auto del   = rows_t{{ {"a", 5}, {"b", 3} }};
 
-    /////////////////////////////////////////////////////////////////////////
-#endif
+        auto sums = table % fn::incremental_aggregate_by(fn::by::first{}, fn::agg::sum(fn::by::second{}));
+        auto maxs = table % fn::incremental_aggregate_by(fn::by::first{}, fn::agg::max(fn::by::second{}));
+        auto mins = table % fn::incremental_aggregate_by(fn::by::first{}, fn::agg::min(fn::by::second{}));
 
-    return tests;
-}
+        VERIFY(( sums.results() % fn::to_vector() == res_t{{ {"a", 6}, {"b", 3} }} ));
+        VERIFY(( maxs.results() % fn::to_vector() == res_t{{ {"a", 5}, {"b", 3} }} ));
 
+        sums.insert(ins);
+        maxs.insert(ins);
+        mins.insert(ins);
+        VERIFY(( sums.results() % fn::to_vector() == res_t{{ {"a", 8}, {"b", 3}, {"c", 7} }} ));
+        VERIFY(( mins.results() % fn::to_vector() == res_t{{ {"a", 1}, {"b", 3}, {"c", 7} }} ));
 
-/////////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////////
-static void run_tests()
-{
-    using fn::operators::operator%;
+        sums.erase(del);
+        maxs.erase(del);
+        mins.erase(fn::cfrom(del) % fn::to_seq()); // any range will do
+        VERIFY(( sums.results() % fn::to_vector() == res_t{{ {"a", 3}, {"c", 7} }} ));
+        VERIFY(( maxs.results() % fn::to_vector() == res_t{{ {"a", 2}, {"c", 7} }} ));
+        VERIFY(( mins.results() % fn::to_vector() == res_t{{ {"a", 1}, {"c", 7} }} ));
 
-#if 0 // single test
+        auto counts = fn::seq([]{ return 1; })
+          % fn::take_first(3)
+          % fn::incremental_aggregate_by(fn::by::identity{}, fn::agg::count());
+        counts.erase(vec_t{{ 1 }});
+        VERIFY(counts.results().begin()->second == 2);
 
-    std::map<std::string, std::function<void()>> tests1{}, tests2{}, test_other{};
-    test_other["single"] = [&]
-    {
-        auto res = Xs{}
-        % fn::to_seq()
-        % fn::group_all()
-        % fn::transform([](Xs v)
-        {
-            return (int)v.size();
-        });
+        // erasing a never-inserted element
+        bool threw = false;
+        try {
+            counts.erase(vec_t{{ 5 }});
+        } catch(const std::logic_error&) {
+            threw = true;
+        }
+        VERIFY(threw && counts.results().begin()->second == 2);
     };
 
-#else // all tests
+    test_other["assume_sorted_by"] = [&]
+    {
+        const vec_t inp = {{ 1, 2, 2, 3, 5, 8, 8, 9 }};
 
-    std::map<std::string, std::function<void()>> 
-        test_cont{}, test_seq{}, test_view{}, test_other{};
+        auto res = inp
+          % fn::assume_sorted()
+          % fn::drop_while([](int x){ return x < 2; })
+          % fn::take_while([](int x){ return x < 9; })
+          % fn::drop_first(1)
+          % fn::take_first(4)
+          % fn::unique_all()
+          % fn::to_vector();
+        VERIFY((res == vec_t{{ 2, 3, 5, 8 }}));
+
+        // keeps the tag through order-preserving container-stages
+        const auto cnts = inp 
+          % fn::assume_sorted() 
+          % fn::where([](int x){ return x != 3; }) 
+          % fn::take_last(5)
+          % fn::counts();
+        VERIFY((cnts == std::map<int, size_t>{{ {2, 1}, {5, 1}, {8, 2}, {9, 1} }}));
+
+        // group_all_by, skipping the sort
+        size_t num_calls = 0;
+        const auto key_fn = [&num_calls](int x)
+        {
+            ++num_calls;
+            return x / 2;
+        };
 
-    // make battery of tests where input is a container (Xs)
-    test_cont = make_tests([](std::initializer_list<int> xs)
-    {
-        Xs ret;
-        for(auto x : xs) {
-            ret.push_back(X(x));
-        }
-        return ret;
-    });
+        auto tagged = inp % fn::assume_sorted_by(key_fn);
+        num_calls = 0; // not counting the calls by the assert checking the order
 
-    // make battery of tests where input is an input-range
-    test_seq = make_tests([](std::initializer_list<int> xs)
-    {
-        Xs ret;
-        for(auto x : xs) {
-            ret.push_back(X(x));
-        }
-        return fn::to_seq()(std::move(ret));
-    });
+        const auto groups = std::move(tagged) % fn::group_all_by(key_fn);
+        VERIFY((groups == std::vector<vec_t>{{ {1}, {2, 2, 3}, {5}, {8, 8, 9} }}));
+        VERIFY(num_calls == 2 * (inp.size() - 1));
 
-    // make battery of tests where input is a view
-    test_view = make_tests([](std::initializer_list<int> xs)
-    {
-        // will be returning views; will keep the underlying data
-        // in a static vector.
+        // key-range by binary search on the key: x/2 in [1, 4)
+        const auto in_range = inp 
+          % fn::assume_sorted_by(key_fn) 
+          % fn::drop_while_key_lt(1)
+          % fn::take_while_key_lt(4) 
+          % fn::to_vector();
+        VERIFY((in_range == vec_t{{ 2, 2, 3, 5 }}));
 
-        static std::vector<Xs> vecs{};
-        vecs.push_back(Xs{});
-        auto& ret = vecs.back();
+        // a predicate not monotonic in the key: still linear, so correct
+        const auto prefix = inp 
+          % fn::assume_sorted() 
+          % fn::take_while([](int x){ return x != 3; })
+          % fn::drop_while([](int x){ return x % 2 == 1; })
+          % fn::to_vector();
+        VERIFY((prefix == vec_t{{ 2, 2 }}));
 
-        for(auto x : xs) {
-            ret.push_back(X(x));
-        }
-        return fn::from(ret);
-    });
+        // views
+        const auto res2 = fn::cfrom(inp) 
+          % fn::assume_sorted() 
+          % fn::take_while([](int x){ return x < 5; }) 
+          % fn::where([](int x){ return x % 2 == 0; })
+          % fn::to_vector();
+        VERIFY((res2 == vec_t{{ 2, 2 }}));
 
+        // re-sorting drops the tag
+        VERIFY((inp % fn::assume_sorted() % fn::sort_by(fn::by::decreasing(fn::by::identity{})) == inp % fn::reverse()));
+    };
 
-    using vec_t = std::vector<int>;
+    test_other["where_in_sorted"] = [&]
+    {
+        vec_t whitelist{};
+        for(int i = 0; i < 1000; i += 3) {
+            whitelist.push_back(i);
+        }
 
-    /////////////////////////////////////////////////////////////////////////
+        const vec_t inp = {{ 0, 2, 3, 3, 7, 9, 10, 500, 501, 996, 999, 1000 }};
+        const vec_t expected = {{ 0, 3, 3, 9, 501, 996, 999 }};
 
+        VERIFY(inp % fn::where_in_sorted(whitelist) == expected);
+        VERIFY(inp % fn::assume_sorted() % fn::where_in_sorted(whitelist) % fn::to_vector() == expected);
 
-    /////////////////////////////////////////////////////////////////////////
+        // not sorted
+        VERIFY(inp % fn::reverse() % fn::where_in_sorted(whitelist) == expected % fn::reverse());
 
+        VERIFY((inp % fn::where_not_in_sorted(whitelist) == vec_t{{ 2, 7, 10, 500, 1000 }}));
 
-    test_other["Test for NB[5]"] = [&]
-    {
-        const auto inps = vec_t{{1,2,3}};
-        auto res = fn::cfrom(inps) % fn::to_seq() % fn::to_vector();
-        VERIFY(res == inps);
+        // the range may grow (reallocate) between making the stage and applying it
+        vec_t r = {{ 3 }};
+        const auto in_r = fn::where_in_sorted(r);
+        for(int i = 4; i < 100; i++) {
+            r.push_back(i);
+        }
+        VERIFY((vec_t{{ 3, 50, 99, 100 }} % in_r == vec_t{{ 3, 50, 99 }}));
+        VERIFY((vec_t{{ 1, 99 }} % in_r == vec_t{{ 99 }}));
     };
 
-    test_other["typerased"] = [&]
+    test_other["sort_by_bounded_disorder"] = [&]
     {
-        int i = 0;
-        auto myseq = fn::make_typerased(
-            fn::seq([i, p = std::unique_ptr<int>()]() mutable // p is just to make sure it works for move-only lambdas
+        // each element is at most 2 positions out of place
+        const vec_t inp = {{ 3, 1, 2, 4, 6, 7, 5, 8, 10, 9 }};
+
+        VERIFY(inp % fn::sort_by_bounded_disorder(fn::by::identity{}, 2) % fn::to_vector() == inp % fn::sort());
+
+        bool threw = false;
+        try {
+            inp % fn::sort_by_bounded_disorder(fn::by::identity{}, 1) % fn::to_vector();
+        } catch(const std::logic_error&) {
+            threw = true;
+        }
+        VERIFY(threw);
+
+        vec_t late{};
+        auto res = inp 
+          % fn::sort_by_bounded_disorder(fn::by::identity{}, 1, [&](int x)
             {
-                return i < 10 ? i++ : fn::end_seq();
+                late.push_back(x);
             })
-          % fn::where([](int x)
+          % fn::to_vector();
+
+        VERIFY((res  == vec_t{{ 1, 2, 3, 4, 6, 7, 8, 9, 10 }}));
+        VERIFY((late == vec_t{{ 5 }}));
+
+        // stability; moves-only
+        int i = 0;
+        auto res2 = fn::seq([i]() mutable 
+            { 
+                if(i == 20) {
+                    throw fn::end_seq::exception{};
+                }
+                const int ordinal = i++;
+                return std::make_pair(X{ 3 - ordinal % 4 + ordinal / 4 * 4 }, ordinal);
+            })
+          % fn::sort_by_bounded_disorder([](const std::pair<X, int>& p)
             {
-                return x % 2 == 0;
-            }));
+                return int(p.first) / 2;
+            }, 3)
+          % fn::transform([](const std::pair<X, int>& p)
+            {
+                return std::make_pair(int(p.first) / 2, p.second);
+            })
+          % fn::to_vector();
 
-        int res = 0;
-        for(const auto& x : myseq) {
-            res = res*10 + x;
+        VERIFY(res2.size() == 20);
+        VERIFY(std::is_sorted(res2.begin(), res2.end()));
+    };
+
+    test_other["sort_by_indirect"] = [&]
+    {
+        // move-only elements
+        Xs xs{};
+        for(const int i : { 3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 8, 9, 7, 9, 3, 2, 3, 8, 4 }) {
+            xs.emplace_back(i);
         }
-       
-        VERIFY(res == 2468);
+
+        auto res = std::move(xs)
+          % fn::sort_by_indirect(fn::by::identity{})
+          % fn::transform([](const X& x){ return int(x); })
+          % fn::to_vector();
+
+        VERIFY(std::is_sorted(res.begin(), res.end()));
+        VERIFY(res.size() == 20);
+
+        // stability
+        const auto inp = std::vector<std::pair<int, int>>{{ {2, 0}, {1, 1}, {2, 2}, {1, 3}, {0, 4} }};
+        VERIFY(inp % fn::sort_by_indirect(fn::by::first{}) == inp % fn::sort_by(fn::by::first{}));
+
+        // sorting references to elements of a list
+        std::list<int> lst = { 3, 1, 2 };
+        int prev = 0;
+        fn::refs(lst) 
+          % fn::sort_by_indirect(fn::by::identity{}) 
+          % fn::for_each([&](int& x)
+            {
+                VERIFY(prev < x);
+                prev = x;
+            });
+        VERIFY(prev == 3);
     };
 
-    test_other["for_each"] = [&]
+    test_other["tsv"] = [&]
     {
-        // NB: making sure that for_each compiles with mutable lambdas
-        auto vec = vec_t{{1,2,3}};
-        vec % fn::for_each([](int& x) mutable
+        std::string result = "";
+        std::istringstream istr{"Expected Header\n \t r1f1 \t \n#Comment: next line is empty, and next one is blanks\n\n  \n r2f1  \tr2f2\t  r2f3  "};
+
+        tsv::params params{};
+        params.header = "Expected Header";
+        params.filename = "filename";
+
+        tsv::from(istr, '\t', params)  // tsv::from(istr, '\t', { "Expected Header", "filename" }) // won't compile in c++11
+      % fn::for_each([&](const tsv::row_t& row)
         {
-            x *= 10;
+            for(const auto& f : row) {
+                result += f;
+                result += "|";
+            }
+            result += ";";
         });
-        VERIFY(( vec == vec_t{{10,20,30}} ));
+
+        VERIFY(result == "|r1f1||;r2f1|r2f2|r2f3|;");
+
+        // test split_on_delim when it's an rvalue, returning row_t
+        const auto row = tsv::split_on_delim{ ',' }("a,bb,ccc");
+        VERIFY((row == tsv::row_t{{"a", "bb", "ccc"}}));
     };
 
-    test_other["for_each_adjacent"] = [&]
+    test_other["jsonl"] = [&]
     {
-        auto vec = vec_t{{1,2,3,4}};
-        vec % fn::for_each_adjacent([](int& x1, int& x2) mutable // making sure non-const-reference binds
+        std::istringstream istr{
+            R"({"acc": "NM_000001", "len": 123, "exons": [{"start": 1, "end": 10}, {"start": 50, "end": 99}], "cds": null})" "\n"
+            "\n"
+            R"({ "acc" : "NM_00\"2\u00e9\ud83d\ude00" , "len":-4.5e1, "tags":["a,b", "}", 7, true, [] ], "nested": {"x": {"y": false}}, "len2": "17"})" "\n"
+        };
+
+        std::vector<std::string> accs;
+        std::vector<double> lens;
+
+        jsonl::from(istr) % fn::for_each([&](const jsonl::record& rec)
         {
-            return x2 = x1*10 + x2;
+            accs.push_back(rec["acc"].str());
+            lens.push_back(rec["len"].num<double>());
+
+            if(accs.size() == 1) {
+                VERIFY(rec.get("exons.1.start").num<int>() == 50);
+                VERIFY(rec.get("exons.0.end").raw() == "10");
+                VERIFY(!rec.get("exons.2.start").exists());
+                VERIFY(rec["exons"][size_t(1)]["end"].num<int>() == 99);
+                VERIFY(rec["cds"].is_null());
+                VERIFY(!rec["tags"].exists());
+            } else {
+                VERIFY(rec.get("tags.0").str() == "a,b");
+                VERIFY(rec.get("tags.1").str() == "}");
+                VERIFY(rec.get("tags.2").num<int>() == 7);
+                VERIFY(rec.get("tags.3").boolean());
+                VERIFY(rec.get("tags.4").get_type() == jsonl::value::type::array);
+                VERIFY(!rec.get("tags.4.0").exists());
+                VERIFY(!rec.get("tags.5").exists());
+                VERIFY(rec.get("nested.x").raw() == R"({"y": false})");
+                VERIFY(!rec.get("nested.x.y").boolean());
+                VERIFY(rec["len2"].num<int>() == 17);
+            }
         });
 
-        VERIFY(( vec == vec_t{{1,12,123,1234}} ));
-    };
+        VERIFY(( accs == std::vector<std::string>({ "NM_000001", "NM_00\"2\xC3\xA9\xF0\x9F\x98\x80" }) ));
+        VERIFY(( lens == std::vector<double>{{ 123.0, -45.0 }} ));
 
+        // long line, to exercise the SIMD path with strings spanning blocks
+        std::string line = "{";
+        for(int i = 0; i < 100; i++) {
+            line += "\"key" + std::to_string(i) + "\": \"val\\\\ue" + std::to_string(i) + "\", ";
+        }
+        line += "\"last\": [1, 2, {\"x\": 3}]}";
 
-    test_other["zip_adjacent"] = [&]
-    {
-        auto res =
-            vec_t{{1,2,3,4}}
-          % fn::zip_adjacent([](int& x1, int& x2) // making sure non-const-reference binds
-            {
-                return x1*10 + x2;
-            })
-          % fn::to_vector();
+        const jsonl::record rec{ line };
+        VERIFY(rec["key57"].str() == "val\\ue57");
+        VERIFY(rec.get("last.2.x").num<int>() == 3);
 
-        VERIFY(( res == std::vector<int>{{12,23,34}} ));
+        bool threw = false;
+        try {
+            jsonl::record bad{ R"({"a": "b)" };
+        } catch(const std::runtime_error&) {
+            threw = true;
+        }
+        VERIFY(threw);
     };
 
+    test_other["to_num"] = [&]
+    {
+        VERIFY(123  == int(tsv::to_num(" +123 ")));
 
+        double delta = 123.0 - double(tsv::to_num(" 123.0 "));
+        if(delta < 0) {
+            delta *= -1;
+        }
+        VERIFY(delta < 1e-10);
 
-    test_other["fold"] = [&]
-    {
-        const std::string x = 
-        vec_t{{1,2,3}} % fn::foldl(std::string{"^"},
-                                [](std::string s, int x_)
-        {
-            return std::move(s) + "|" + std::to_string(x_);
-        }) ;
-        VERIFY(x == "^|1|2|3");
+        VERIFY(bool(tsv::to_num(" 1 ")));
+
+        try{
+            (void)int8_t(tsv::to_num("-129")); // overflow
+            VERIFY(false);
+        } catch(const std::domain_error&) {
+            ;
+        }
+
+        try{
+            (void)int(tsv::to_num("123 4")); // trailing garbage
+            VERIFY(false);
+        } catch(const std::domain_error&) {
+            ;
+        }
+
+        try{
+            (void)uint16_t(tsv::to_num("-123")); // negative number for unsigned
+            VERIFY(false);
+        } catch(const std::domain_error&) {
+            ;
+        }
+
+        enum class my_int_t : int{};
+        my_int_t my_int = tsv::to_num("42");
+        VERIFY(my_int == my_int_t(42));
+
+        // exercise signed and unsigned integral cases
+        VERIFY(-42 == int(tsv::to_num("-42")) );
+
+        const unsigned int u42 = tsv::to_num("42");
+        VERIFY(u42 == 42 );
     };
 
-    test_other["foldl_d"] = [&]
+
+#endif // single-test vs all
+
+    /////////////////////////////////////////////////////////////////////////
+    size_t num_failed = 0;
+    size_t num_ok = 0;
+    for(auto&& tests : { test_cont, test_seq, test_view, test_other })
+        for(const auto& kv : tests)
     {
-        const std::string x =
-        vec_t{{1,2,3}} % fn::foldl_d( [](std::string s, int x_)
-        {
-            return std::move(s) + "|" + std::to_string(x_);
-        });
+        try{
+            kv.second();
+            num_ok++;
+        } catch(const std::exception& e) {
+            num_failed++;
+            std::cerr << "Failed test '" << kv.first << "' :" << e.what() << "\n";
+        }
+    }
+    if(num_failed == 0) {
+        std::cerr << "Ran " << num_ok << " tests - OK\n";
+    } else {
+        throw std::runtime_error(std::to_string(num_failed) + " tests failed.");
+    }
+}
 
-        VERIFY(x == "|1|2|3");
-    };
+} // namespace impl
+} // namespace fn
+} // namespacce rangeless
 
-    test_other["foldl_1"] = [&]
-    {
-        const auto min_int = 
-            std::vector<std::string>{{ "11", "-333", "22" }}
-        % fn::transform([](const std::string& s) { return std::stoi(s); })
-        % fn::foldl_1([](int out, int in) { return std::min(out, in); });
 
-        VERIFY(min_int == -333);
-    };
+#endif //RANGELESS_FN_ENABLE_RUN_TESTS
 
 
-    /////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+//
+//
+// synchronized_queue, to_async, transform_in_parallel below
+//
+//
+/////////////////////////////////////////////////////////////////////////////
 
-    /////////////////////////////////////////////////////////////////////////
-    test_other["fn::where with associative containers"] = [&]
-    {
-        // verify what filtering works for containers where
-        // std::remove_if is not supported (e.g. assotiative)
-        
-        auto ints2 = std::set<int>{{111, 333}};
 
-        using fn::operators::operator%=;
+#if RANGELESS_FN_ENABLE_PARALLEL
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <future>
+#include <chrono>
+#include <memory>
+#include <fstream> // for transform_cached
+#include <cstring>
+#include <cstdio>
+
+#if defined(__linux__) // for shm_queue
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
-        ints2 %= fn::where([](int x) { return x > 222; });
-        VERIFY(ints2.size() == 1 && *ints2.begin() == 333);
+/////////////////////////////////////////////////////////////////////////////
 
-        using map_t = std::map<int, int>;
-        auto m = map_t{{ {1,111}, {3,333} }};
+namespace rangeless
+{ 
+   
+namespace mt
+{ 
 
-        m %= fn::where([](const map_t::value_type& x) { return x.second > 222; });
-        VERIFY(m.size() == 1 && m.at(3) == 333);
+/////////////////////////////////////////////////////////////////////////////
+/// \brief A simple timer.
+struct timer
+{
+    /// returns the time elapsed since timer's instantiation, in seconds.
+    /// To reset: `my_timer = mt::timer{}`.
+    operator double() const
+    {
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock_t::now() - start_timepoint).count()) * 1e-9;
+    }
+private:
+    using clock_t = std::chrono::steady_clock;
+    clock_t::time_point start_timepoint = clock_t::now();
+};
 
-        //*m.begin() = *m.begin();
-    };
+namespace lockables
+{
 
-    test_other["fn::where with mutable lambdas"] = [&]
-    {
-         // must work with mutable lambda
-         int i = 0;
-         auto ints2 = vec_t{{1,2,3}} % fn::where([i](int) mutable { return i++ >= 1; });
-         VERIFY(( ints2 == vec_t{{2, 3}} ));
-    };
+class atomic_mutex // without alignas(cacheline_size) to avoid overaligned-new pre-c++17
+{                  // instead will add padding around the fields
+protected:
+    std::atomic<bool> m_locked = { false };
 
-    test_other["fn::where with const_reference inputs"] = [&]
+public:
+    bool try_lock() noexcept
     {
-        // check const-reference overload with non-sequence containers
-        const auto ints1 = std::set<int>{1,2,3};
-        auto ints2 = ints1 % fn::where([](int x_) { return x_ > 1; });
-        VERIFY(( ints2.size() == 2 ));
-    };
+        return !m_locked.load(std::memory_order_relaxed)
+            && !m_locked.exchange(true, std::memory_order_acquire);
+    }
 
-    test_other["fn::where with non-const reference inputs"] = [&]
+    void lock() noexcept
     {
-        // check const-reference overload with non-sequence containers
-        auto ints1 = std::set<int>{1,2,3};
-        auto ints2 = ints1 % fn::where([](int x_) { return x_ > 1; });
+        for(size_t i = 0; !try_lock(); i++) {
+            std::this_thread::sleep_for(
+                std::chrono::microseconds(5)); // the actual time is greater, depends on scheduler
+        }
+    }
 
-        VERIFY(( ints1.size() == 3 ));
-        VERIFY(( ints2.size() == 2 ));
-    };
+    void unlock() noexcept
+    {
+        m_locked.store(false, std::memory_order_release);
+    }
+};
 
+}
 
-    test_other["refs"] = [&]
-    {
-        auto inps = vec_t({1,2,3});
+class synchronized_queue_base
+{
+public:
+    enum class status { success, closed, timeout };
 
-        auto res = fn::refs(inps)
-           % fn::foldl_d([](int64_t out, int& in)
-             {
-                ++in;
-                // NB: taking in by non-const reference to verify
-                // that it binds to non-const reference-wrapper
-                return out*10 + in;
-             });
-        VERIFY(res == 234);
+    // deriving from end_seq::exception to enable
+    // adapting queue as input-seq: fn::seq(my_queue.pop) % fn::for_each(...)
+    // (push will throw queue_closed, which will terminate the seq).
 
-        // check with const inputs
-        const auto& const_inps = inps;
-        res = fn::refs(const_inps)
-           % fn::foldl_d([](int64_t out, const int& in)
-             {
-                return out*10 + in;
-             });
-        VERIFY(res == 234);
+    class queue_closed : public rangeless::fn::end_seq::exception
+    {};
 
-    };
+    // NB: Core guideline T.62: Place non-dependent class template members in a non-templated base class
+};
 
 
-    /////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+/*! \brief Optionally-bounded blocking concurrent MPMC queue.
+ *
+ *   - Supports not-copy-constructible/not-default-constructible value-types (just requires move-assigneable).
+ *   - Can be used with lockables other than `std::mutex`, e.g. `mt::atomic_lock`.
+ *   - Contention-resistant: when used with `mt::atomic_lock` the throughput is comparable to state-of-the-art lock-free implementations.
+ *   - Short and simple implementation using only c++11 standard library primitives.
+ *   - Provides RAII-based closing semantics to communicate end-of-inputs 
+ *     from the pushing end or failure/going-out-of-scope from the popping end.
+ *
+ * Related:
+ * <br> <a href="http://www.boost.org/doc/libs/1_66_0/libs/fiber/doc/html/fiber/synchronization/channels/buffered_channel.html">`boost::fibers::buffered_channel`</a>
+ * <br> <a href="http://www.boost.org/doc/libs/1_66_0/doc/html/thread/sds.html">`boost::sync_bounded_queue`</a>
+ * <br> <a href="http://www.boost.org/doc/libs/1_66_0/doc/html/boost/lockfree/queue.html">`boost::lockfree::queue`</a>
+ * <br> <a href="https://software.intel.com/en-us/node/506200">`tbb::concurrent_queue`</a>
+ * <br> <a href="https://github.com/cameron314/concurrentqueue">`moodycamel::BlockingConcurrentQueue`</a>
+ *
+@code
+    // A toy example to compute sum of lengths of strings in parallel.
+    //
+    // Spin-off a separate async-task that enqueues jobs 
+    // to process a single input, and enqueues the 
+    // futures into a synchronized queue, while accumulating 
+    // the ready results from the queue in this thread.
 
+    using queue_t = mt::synchronized_queue<std::future<size_t> >;
+    queue_t queue{ 10 };
 
-    test_other["memoized"] = [&]
+    auto fut = std::async(std::launch::async,[ &queue ]
     {
-        size_t exec_count = 0;
-        auto strs = std::vector<std::string>{{ "333", "4444", "22", "1" }};
+        auto close_on_exit = queue.close();
 
-        using fn::operators::operator%=;
-        strs %= fn::sort_by(fn::make_memoized([&](const std::string& s)
-        {
-            exec_count++; 
-            return s.size();
-        }));
+        for(std::string line; std::getline(std::cin, line); ) {
+            queue <<= 
+                std::async(
+                    std::launch::async, 
+                    [](const std::string& s) { 
+                        return s.size(); 
+                    },
+                    std::move(line));
+        }
+    });
 
-        // this should not compile (decayed arg-type is not default-constructible)
-        // fn::make_memoized([&](std::tuple<int&> x) { return 123; });
+    size_t total = 0;
+    queue >>= [&](queue_t::value_type x) { total += x.get(); };
+    fut.get(); // rethrow exception, if any.
+@endcode
+*/
+template <typename T, class BasicLockable = std::mutex>
+class synchronized_queue : public synchronized_queue_base
+{
+public:
+    using value_type = T;
 
-        // this should not compile (return type is not default-constructible)
-        // fn::make_memoized([&](int x) { return std::ref(x); });
+    ///@{ 
 
-        VERIFY((strs == std::vector<std::string>{{ "1", "22", "333", "4444" }}));
-        VERIFY(exec_count == 4);
-    };
+    synchronized_queue(size_t cap = 1024)
+      : m_capacity{ cap }
+    {}
 
-    test_other["scope_guard"] = [&]
-    {
-        int i = 0;
-        {{
-            auto on_exit_add1 = fn::make_scope_guard([&]
-            {
-                i += 1;
-            });
+    ~synchronized_queue() = default;
+    // What if there are elements in the queue? 
+    // If there are active poppers, we ought to 
+    // let them finish, but if there aren't any,
+    // this will block indefinitely, so we'll 
+    // leave it to the user code to manage the
+    // lifetime across multiple threads.
+    //
+    // Should we call x_close() ?
+    // No point - we're already destructing.
+    // (it also grabs the m_queue_mutex, which 
+    // theoretically may throw).
 
-            auto on_exit_add10 = fn::make_scope_guard([&]
-            {
-                i += 10;
-            });
 
-            on_exit_add1.dismiss();
-        }}
-        VERIFY(i == 10);
-    };
+    // After careful consideration, decided not to provide 
+    // move-semantics; copy and move constructors are implicitly
+    // deleted.
+    //
+    // A synchronized_queue can be thought of buffered mutex
+    // (i.e. a synchronization primitive rather than just a 
+    // data structure), and mutexes are not movable.
+    
+    ///@}
+    ///@{
+
+    // push and pop are implemented as callable function-objects fields
+    // rather than plain methods to enable usage like:
+    //
+    // Adapt queue as input-range:
+    // fn::seq(synchronized_queue.pop) % fn::for_each(...)
+    //
+    // Adapt queue as sink-function:
+    // std::move(inputs) % fn::for_each(my_queue.push);
+    //
+    // Adapt queue as output-iterator:
+    // std::copy(inputs.begin(), inputs.end(), my_queue.push);
 
-    test_other["operator<<=, operator%="] = [&]
+    /////////////////////////////////////////////////////////////////////////
+    /// Implements insert_iterator and unary-invokable.
+    struct push_t
     {
-        using fn::operators::operator<<=;
-        using fn::operators::operator%=;
-
-        auto cont = vec_t{{1,2}};
-        cont <<= std::set<int>{{3,4}}; // excerising rvalue-based overload
+        using iterator_category = std::output_iterator_tag;
+        using   difference_type = void;
+        using        value_type = synchronized_queue::value_type;
+        using           pointer = void;
+        using         reference = void;
 
-        const auto const_set = std::set<int>{{5,6}};
-        cont <<= const_set; // excercising conts-reference overload.
+        synchronized_queue& m_queue;
 
-        int i = 0;
-        cont <<= fn::seq([&i]{ return i++ < 1 ? 7 : fn::end_seq(); }); // should also work for seq rhs
+        push_t& operator=(value_type val)
+        {
+            this->operator()(std::move(val));
+            return *this;
+        }
 
-        cont <<= 9;
+        push_t& operator*()     { return *this; }
+        push_t& operator++()    { return *this; }
+        push_t  operator++(int) { return *this; }
 
-        cont %= fn::where([](int x) { return x % 2 != 0; });
+        /// Blocking push. May throw `queue_closed`
+        void operator()(value_type val) noexcept(false)
+        {
+            // NB: if this throws, val is gone. If the user needs 
+            // to preserve it in case of failure (strong exception
+            // guarantee), it should be using try_push which takes 
+            // value by rvalue-reference and moves it only in case of success.
+            //
+            // We could do the same here, but that would mean
+            // that the user must always pass as rvalue, and 
+            // to pass by copy it would have to do so explicitly, e.g.
+            //
+            // void operator()(value_type&& val);
+            // queue.push(std::move(my_value));
+            // queue.push(my_const_ref); // won't compile.
+            // queue.push(queueue_t::value_type( my_const_ref )); // explicit copy
+            //
+            // I think this would actually be a good thing, as it 
+            // makes the copying visible, but all other synchronied-queue
+            // APIs allow pushing by const-or-forwarding-references, 
+            // so we have allow the same for the sake of consistency.
 
-        VERIFY((cont == vec_t{{1,3,5,7,9}}));
-    };
+            const status st = 
+                m_queue.try_push(std::move(val), no_timeout_sentinel_t{});
 
-#if 0
-    test_other["generate and output_iterator"] = []
-    {
-        int i = 0;
-        auto r = fn::seq([&i]
-        {
-            return i < 5 ? i++ : fn::end_seq();
-        });
+            assert(st != status::timeout);
 
-        int sum = 0;
-        std::copy(r.begin(), r.end(), fn::make_output_iterator([&](int x)
-        {
-            sum = sum * 10 + x;
-        }));
+            if(st == status::closed) {
+                throw queue_closed{};
+            }
 
-        VERIFY(sum == 1234);
+            assert(st == status::success);
+        }
     };
-#endif
+    friend struct push_t;
 
-    test_other["get_unique/set_unique"] = [&]
-    {
-        vec_t ints{{1,2,3}};
 
-        auto& x1 = get_unique(ints, [](int x_){ return x_ == 2; });
-        VERIFY(x1 == 2);
+    /////////////////////////////////////////////////////////////////////////
+    /// Blocking push. May throw `queue_closed`.
+    push_t push = { *this };
 
-        // verify that works with const
-        const auto& const_ints = ints;
-        const auto& x2 = get_unique(const_ints, [](int x_){ return x_ == 2; });
-        VERIFY(&x1 == &x2);
 
-        auto ints2 = ints;
-        auto& y = set_unique(ints2, [](int x_) { return x_ == 42; },
-                                    []{ return 42; });
+    /////////////////////////////////////////////////////////////////////////
+    struct pop_t
+    {
+        synchronized_queue& m_queue;
 
-        VERIFY( ints2.size() == 4 
-            &&  ints2.back() == 42 
-            && &ints2.back() == &y);
+        value_type operator()()
+        {
+            return m_queue.x_blocking_pop();
+        }
     };
 
-    test_other["group_adjacent_by vector-storage-recycling"] = []
-    {
-        // Check that vec_t& passed by reference
-        // is reused on subsequent iterations instead 
-        // of reallocated de-novo.
-        std::set<int*> ptrs;
+    friend struct pop_t;
 
-        auto result = 
-            vec_t{2,4,1,3,5,6,7,9}
-          % fn::to_seq()
-          % fn::group_adjacent_by([](int x) { return x % 2; })
-          % fn::foldl_d([&](int64_t out, vec_t&& in)
-            {
-                in.reserve(64);
-                ptrs.insert(in.data());
-                return out*10 + int64_t(in.size());
-            });
+    /////////////////////////////////////////////////////////////////////////
+    /// Blocking pop. May throw `queue_closed`.
+    pop_t pop = { *this };
 
-        VERIFY((result == 2312));
-        VERIFY((ptrs.size() <= 2));
-    };
 
-    test_other["decreasing"] = [&]
-    {
-        // sort by longest-first, then lexicographically
+    /////////////////////////////////////////////////////////////////////////
 
-        const auto inp      = std::vector<std::string>{ "2", "333", "1", "222", "3" };
-        const auto expected = std::vector<std::string>{ "222", "333", "1", "2", "3" };
+    ///@}
+    ///@{
 
-        auto ret1 = inp % fn::sort_by([](const std::string& s)
-        {
-            return fn::tie_lvals(fn::by::decreasing(s.size()), s);
-        });
-        VERIFY(ret1 == expected);
+    /// \brief pop() the values into the provided sink-function until closed and empty.
+    ///
+    /// e.g. `queue >>= [&out_it](T x){ *out_it++ = std::move(x); };`
+    /// <br>Queue is automatically closed if exiting via exception, unblocking the pushers.
+    template<typename F>
+    auto operator>>=(F&& sink) -> decltype((void)sink(this->pop()))
+    {
+        auto guard = this->close();
 
-        auto ret2 = inp % fn::sort_by([](const std::string& s)
-        {
-            return std::make_tuple(s.size(), fn::by::decreasing(std::ref(s)));
-        }) % fn::reverse() % fn::to_vector();
+        while(true) {
+            bool threw_in_pop = true;
 
-        VERIFY(ret2 == expected);
+            try {
+                value_type val = this->pop();
+                threw_in_pop = false;
+                sink(std::move(val));
 
-        auto ret3 = inp % fn::sort_by(fn::by::decreasing([](const std::string& s)
-        {
-            return std::make_tuple(s.size(), fn::by::decreasing_ref(s));
-        }));
+            } catch(queue_closed&) {
 
-        VERIFY(ret3 == expected);
+                if(threw_in_pop) {
+                    break; // threw in pop()
+                } else {
+                    throw; // threw in sink() - not our business - rethrow;
+                    //
+                    // This could be an unhandled exception from
+                    // sink that is from some different queue that we
+                    // shouldn't be intercepting.
+                    //
+                    // If sink intends to close the queue
+                    // (e.g. break-out), it can do it explicitly
+                    // via the close-guard;
+                }
+            }
+        }
+        
+        assert(closed() && m_queue.empty());
+    }
 
-        auto ret4 = inp;
-        std::sort(ret4.begin(), ret4.end(), fn::by::make_comp([](const std::string& s)
-        {
-            return std::make_tuple(fn::by::decreasing(s.size()), std::ref(s));
-        }));
+    ///@}
+    ///@{ 
 
-        VERIFY(ret4 == expected);
-    };
 
-    test_other["by"] = [&]
+    /////////////////////////////////////////////////////////////////////////
+    /// In case of success, the value will be moved-from.
+    template <typename Duration = std::chrono::milliseconds>
+    status try_push(value_type&& value, Duration timeout = {})
     {
-        // make sure first{}, second{}, and dereferenced{} return arg as reference (or reference-wrapper)
-        // rather than by value.
-
-        std::vector<std::pair<std::unique_ptr<int>, int>> v{};
-        
-        fn::sort_by(fn::by::first{})(std::move(v));
-        fn::sort_by(fn::by::second{})(std::move(v));
+        // NB: we could have taken value as value_type&, but
+        // the user-code may forget or not expect that the value 
+        // will be moved-from and may try to use it.
+        //
+        // With rvalue-reference the caller-code has to, e.g.
+        //     auto state = queue.try_push(std::move(x));
+        //
+        // making the move explicitly visible.
 
-        const auto xy = std::make_pair(10, 20);
-        const auto& x = fn::by::first{}(xy);
-        VERIFY(&x == &xy.first);
+        const guard_t contention_guard{ m_push_mutex };
 
-        std::vector<std::unique_ptr<int> > v2{};
-        fn::sort_by(fn::by::dereferenced{})(std::move(v2));
-    };
+        lock_t queue_lock{ m_queue_mutex };
 
-    test_other["exists_where"] = [&]
-    { 
-         VERIFY(  ( vec_t{{ 1, 2, 3}} %  fn::exists_where([](int x){ return x == 2; }) ));
-         VERIFY( !( vec_t{{ 1, 2, 3}} %  fn::exists_where([](int x){ return x == 5; }) ));
-         VERIFY(  ( vec_t{{ 1, 2, 3}} % !fn::exists_where([](int x){ return x == 5; }) ));
-    };
+        ++m_num_waiting_to_push;        
+        const bool ok = x_wait_until([this]
+            {
+                return m_queue.size() < m_capacity || !m_capacity;
+            }, 
+            m_can_push, queue_lock, timeout);
+        --m_num_waiting_to_push;        
 
+        if(!ok) {
+            return status::timeout;
+        }
 
-#if __cplusplus >= 201402L
-    test_other["compose"] = []
-    {
-        auto my_transform = [](auto fn)
-        {
-            return fn::adapt([fn = std::move(fn)](auto gen)
-            {
-                return fn(gen());
-            });
-        };
+        if(!m_capacity) {
+             return status::closed;
+        }
 
-        auto my_where = [](auto pred)
-        {
-            return fn::adapt([pred = std::move(pred)](auto gen)
-            {
-                auto x = gen();
-                while(!pred(x)) {
-                    x = gen();
-                }
-                return x;
-            });
-        };
+        assert(m_queue.size() < m_capacity); 
 
-        auto my_take_while = [](auto pred)
-        {
-            return fn::adapt([pred = std::move(pred)](auto gen)
-            {
-                auto x = gen();
-                return pred(x) ? std::move(x) : fn::end_seq();
-            });
-        };
+        // if push throws, is the value moved-from?
+        // No. std::move is just an rvalue_cast - no-op
+        // if the move-assignment never happens.
+        m_queue.push(std::move(value));
 
-        auto my_intersperse = [](auto delim)
-        {
-#if 1
-            return [delim = std::move(delim)](auto inputs)
-            {
-                return fn::seq([  delim, 
-                                 inputs = std::move(inputs), 
-                                     it = inputs.end(), 
-                                started = false, 
-                                   flag = false]() mutable
-                {
-                    if(!started) {
-                        started = true;
-                        it = inputs.begin();
-                    }
-                    return it == inputs.end() ? fn::end_seq()
-                         :     (flag = !flag) ? std::move(*it++)
-                         :                      delim;
-                });
-            };
-            
-#elif 0 // or
+        const bool do_notify = m_num_waiting_to_pop > 0;
+        queue_lock.unlock();
 
-            return [delim = std::move(delim)](auto inputs)
-            {
-                return std::move(inputs)
-              % fn::transform([delim](auto inp)
-                {
-                    return std::array<decltype(inp), 2>{{ delim, std::move(inp) }};
-                })
-              % fn::concat()
-              % fn::drop_first(); // drop leading delim
-            };
+        if(do_notify) {
+            m_can_pop.notify_one();
+        }
 
-#else // or
+        return status::success;
+    }
 
-            return fn::adapt([delim, flag = false](auto gen) mutable
-            {
-                return           !gen ? fn::end_seq() 
-                     : (flag = !flag) ? gen() 
-                     :                  delim;
-            });
-#endif
-        };
 
-        auto my_inclusive_scan = []
-        {
-            return fn::adapt([sum = 0](auto gen) mutable
-            {
-                return sum += gen();
-            });
-        };
+    /////////////////////////////////////////////////////////////////////////
+    /// In case of success, the value will be move-assigned.
+    template <typename Duration = std::chrono::milliseconds>
+    status try_pop(value_type& value, Duration timeout = {})
+    {
+        const guard_t contention_guard{ m_pop_mutex };
 
-        auto res = 
-            fn::seq([i = 0]() mutable
-            {
-                return i++;
-            })                  // 0,1,2,3,...
+        lock_t queue_lock{ m_queue_mutex };
 
-          % my_where([](int x)
+        ++m_num_waiting_to_pop;
+        bool ok = x_wait_until([this]
             {
-                return x >= 3; 
-            })                  // 3,4,5,...
+                return !m_queue.empty() || !m_capacity;
+            },
+            m_can_pop, queue_lock, timeout);
+        --m_num_waiting_to_pop;
 
-          % my_take_while([](int x)
-            {
-                return x <= 5;
-            })                  // 3,4,5
+        if(!ok) {
+            return status::timeout;
+        }
 
-          % my_intersperse(-1)  // 3,-1,4,-1,5
+        if(!m_queue.empty()) {
+            ;
+        } else if(!m_capacity) {
+            return status::closed;
+        } else {
+            assert(false);
+        }
 
-          % my_transform([](int x)
-            {
-                return x + 1;
-            })                  // 4,0,5,0,6
+        value = std::move(m_queue.front());
+        m_queue.pop();
 
-          % my_inclusive_scan() // 4,4,9,9,15
+        const bool do_notify = m_num_waiting_to_push > 0;
+        queue_lock.unlock();
 
-          % fn::to_vector();
+        if(do_notify) {
+            m_can_push.notify_one();
+        }
 
-        VERIFY((res == vec_t{{4, 4, 9, 9, 15}}));
-    };
-#endif // tests for compose
+        return status::success;
+    }
 
+    ///@}
+    ///@{ 
 
-    test_other["cartesian_product_with"] = [&]
+    /////////////////////////////////////////////////////////////////////////
+    size_t approx_size() const noexcept
     {
-        auto res = 
-            vec_t{{1,2}}
-          % fn::cartesian_product_with( vec_t{{3,4,5}}, [](int x, int y)
-            {
-                return x*10+y;
-            })
-          % fn::foldl_d([](int64_t out, int64_t in)
-            {
-                return out*1000+in;
-            });
+        return m_queue.size();
+    }
 
-         VERIFY(res == 13014015023024025);
-    };
+    size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
 
-    test_other["guard_against_multiple_iterations_of_input_range"] = [&]
+    bool closed() const noexcept
     {
-        auto gen_ints = [](int i, int j)
-        {
-            return fn::seq([i, j]() mutable
-            {
-                return i < j ? i++ : fn::end_seq();
-            });
-        };
+        return !m_capacity;
+    }
 
-        auto xs =
-            gen_ints(0, 6) 
-          % fn::transform([&](int x) { return gen_ints(x, x+2); })
-          % fn::concat()
-          % fn::where([](int x) { return x % 2 == 0; });
+    /////////////////////////////////////////////////////////////////////////
+    struct close_guard
+    {
+    private:
+        synchronized_queue* ptr;
 
-        // 011223344556
-        int64_t res = 0;
-        bool threw = true;
-        try {
-            // xs is a seq, so trying to iterate it 
-            // a second time shall throw.
-            for(size_t i = 0; i < 2; i++) {
-                for(auto x : xs) {
-                    res = res*10 + x;
-                }
+    public:
+        close_guard(synchronized_queue& queue) : ptr{ &queue }
+        {}
+
+        close_guard(const close_guard&) = default; // -Weffc++ warning
+        close_guard& operator=(const close_guard&) = default;
+
+        void reset()
+        {
+            ptr = nullptr;
+        }
+
+        ~close_guard()
+        {
+            if(ptr) {
+                ptr->x_close();
             }
-            threw = false;
-        } catch(...) {
-            threw = true;
         }
-        VERIFY(threw);
-        VERIFY(res == 22446);
     };
 
-
-    test_other["most 5 top frequent words"] = [&]
+    /// \brief Return an RAII object that will close the queue in its destructor.
+    /// 
+    /// @code
+    /// auto guard = queue.close(); // close the queue when leaving scope
+    /// queue.close(); // close the queue now (guard's is destroyed immediately)
+    /// @endcode
+    ///
+    /// <br> NB: closing is non-blocking.
+    /// <br>Blocked calls to try_push()/try_pop() shall return with status::closed.
+    /// <br>Blocked calls to push()/pop() shall throw `queue_closed`.
+    /// <br>Subsequent calls to push()/try_push() shall do as above.
+    /// <br>Subsequent calls to pop()/try_pop() will succeed
+    ///   until the queue becomes empty, and throw/return-closed thereafter.
+    close_guard close() noexcept
     {
-        // TODO : for now just testing compilation
+       return close_guard{ *this };
+    }
 
-        std::istringstream istr{};
+    ///@}
 
-        auto my_isalnum = [](const int ch)
-        {
-            return std::isalnum(ch) || ch == '_';
-        };
+private:
+    using guard_t = std::lock_guard<BasicLockable>;
+    using  lock_t = std::unique_lock<BasicLockable>;
+    using queue_t = std::queue<value_type>;
+
+    using condvar_t = typename std::conditional<
+        std::is_same<BasicLockable, std::mutex>::value,
+            std::condition_variable,
+            std::condition_variable_any        >::type;
+
+    struct no_timeout_sentinel_t
+    {};
+
+    template<typename F>
+    bool x_wait_until(F condition, condvar_t& cv, lock_t& lock, no_timeout_sentinel_t)
+    {    
+        cv.wait(lock, std::move(condition));
+        return true;
+    }    
+
+    template<typename Duration, typename F>
+    bool x_wait_until(F condition, condvar_t& cv, lock_t& lock, Duration duration)
+    {    
+        return cv.wait_for(lock, duration, std::move(condition));
+    } 
 
-        using counts_t = std::map<std::string, size_t>;
+    value_type x_blocking_pop()
+    {
+        const guard_t contention_guard{ m_pop_mutex };
 
-        fn::from(
-            std::istreambuf_iterator<char>(istr.rdbuf()),
-            std::istreambuf_iterator<char>{})
+        lock_t queue_lock{ m_queue_mutex };
 
-          % fn::transform([](const char c) // tolower
+        ++m_num_waiting_to_pop;
+        m_can_pop.wait(
+            queue_lock,
+            [this]
             {
-                return ('A' <= c && c <= 'Z') ? char(c - ('Z' - 'z')) : c;
-            })
-
-          % fn::group_adjacent_by(my_isalnum)
+                return !m_queue.empty() || !m_capacity;
+            });
+        --m_num_waiting_to_pop;
 
-#if 0
-            // build word->count map
-          % fn::foldl_d([&](counts_t out, const std::string& in)
-            {
-                if(my_isalnum(in.front())) {
-                    ++out[ in ];
-                }
-                return std::move(out);
-            })
-#else
-          % fn::where([&](const std::string& s)
-            {
-                return my_isalnum(s.front());
-            })
-          % fn::counts() // map:word->count
-#endif
+        if(m_queue.empty()) {
+            throw queue_closed{};
+        }
 
-          % fn::group_all_by([](const counts_t::value_type kv)
-            {
-                return kv.first.size(); // by word-size
-            })
+        value_type ret = std::move(m_queue.front());
+        m_queue.pop();
 
-          % fn::transform(
-                  fn::take_top_n_by(5UL, fn::by::second{}))
+        const bool do_notify = m_num_waiting_to_push > 0;
+        queue_lock.unlock();
 
-          % fn::concat()
+        if(do_notify) {
+            m_can_push.notify_one();
+        }
 
-          % fn::for_each([](const counts_t::value_type& kv)
-            {
-                std::cerr << kv.first << "\t" << kv.second << "\n";
-            })
-          ;
-    };
+        return ret;
+    }
 
-    test_other["placement-new without std::launder"] = [&]
+    /////////////////////////////////////////////////////////////////////////
+    /// \brief Closes the queue for more pushing.
+    ///
+    void x_close()
     {
-        struct S
         {
-            const int n;
-            const int& r;
-        };
-        const int x1 = 1;
-        const int x2 = 2;
+            guard_t g{ m_queue_mutex }; 
+            m_capacity = 0;
+        }
+        m_can_pop.notify_all();
+        m_can_push.notify_all();
+    }
 
-        impl::maybe<S> m{};
+    // NB: open() is not provided, such that if closed() returns true,
+    // we know for sure that it's staying that way. 
 
-        m.reset(S{42, x1});
-        VERIFY((*m).n == 42);
-        VERIFY((*m).r == 1);
+    /////////////////////////////////////////////////////////////////////////
 
-        m.reset(S{420, x2});
-        VERIFY((*m).n == 420);
-        VERIFY((*m).r == 2);
-    };
+       const char m_padding0[64]        = {};
 
-    test_other["counts"] = [&]
-    {
-        auto res = 
-            vec_t{{ 1, 1,2, 1,2,3 }} 
-          % fn::counts()
-          % fn::transform([](const std::map<int, size_t>::value_type& kv)
-            {
-                return kv.first * 10 + int(kv.second);
-            })
-          % fn::to_vector();
-        
-        VERIFY((res == vec_t{{13, 22, 31}}));
-    };
+         uint32_t m_num_waiting_to_push = 0;
+         uint32_t m_num_waiting_to_pop  = 0;
+           size_t m_capacity            = size_t(-1); // 0 means closed
+          queue_t m_queue               = queue_t{};
+    BasicLockable m_queue_mutex         = {};
+    BasicLockable m_push_mutex          = {}; // for managing contention in SPMC/MPSC cases
+    BasicLockable m_pop_mutex           = {};
+        condvar_t m_can_push            = {};
+        condvar_t m_can_pop             = {};
 
+       const char m_padding1[64]        = {};
+}; // synchronized_queue
 
-    test_other["tsv"] = [&]
-    {
-        std::string result = "";
-        std::istringstream istr{"Expected Header\n \t r1f1 \t \n#Comment: next line is empty, and next one is blanks\n\n  \n r2f1  \tr2f2\t  r2f3  "};
+#if defined(__linux__)
 
-        tsv::params params{};
-        params.header = "Expected Header";
-        params.filename = "filename";
+/////////////////////////////////////////////////////////////////////////////
+/*! \brief Bounded blocking MPMC queue in shared memory, for pipelines spanning processes.
+ *
+ *   - The elements are stored as length-prefixed byte-records in a ring-buffer
+ *     of `capacity` bytes. The value-type is either a trivial standard-layout
+ *     type (e.g. arithmetic types or POD structs), or `std::string` (arbitrary bytes).
+ *   - The anonymous-mapping constructor is for sharing the queue with the
+ *     processes forked after construction; the named constructor is for
+ *     unrelated processes, via a POSIX shared-memory object (see `shm_open`).
+ *   - Blocked pushers/poppers wait on a futex, rather than spinning;
+ *     the buffer is protected by a spinlock (`lockables::atomic_mutex`).
+ *   - Same `push`/`pop`/`close`/`>>=` interface and closing semantics as `synchronized_queue`.
+ *
+ * NB: if a process dies while holding the lock, the other parties will deadlock;
+ * if a process dies with the queue open, the poppers will wait indefinitely
+ * (use a separate channel to detect that, e.g. `waitpid`).
+ *
+@code
+    mt::shm_queue<std::string> queue{ 1 << 20 };
 
-        tsv::from(istr, '\t', params)  // tsv::from(istr, '\t', { "Expected Header", "filename" }) // won't compile in c++11
-      % fn::for_each([&](const tsv::row_t& row)
+    if(fork() == 0) {
         {
-            for(const auto& f : row) {
-                result += f;
-                result += "|";
+            auto close_on_exit = queue.close();
+            for(std::string line; std::getline(std::cin, line); ) {
+                queue.push(line);
             }
-            result += ";";
-        });
+        }
+        _exit(0);
+    }
 
-        VERIFY(result == "|r1f1||;r2f1|r2f2|r2f3|;");
+    queue >>= [](std::string line){ ... };
+@endcode
+*/
+template<typename T>
+class shm_queue : public synchronized_queue_base
+{
+    static_assert(   std::is_same<T, std::string>::value
+                  || (std::is_trivial<T>::value && std::is_standard_layout<T>::value),
+                  "shm_queue value_type must be std::string or a trivial standard-layout type.");
 
-        // test split_on_delim when it's an rvalue, returning row_t
-        const auto row = tsv::split_on_delim{ ',' }("a,bb,ccc");
-        VERIFY((row == tsv::row_t{{"a", "bb", "ccc"}}));
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Expecting futex-compatible atomic.");
+
+    // Shared state, at the beginning of the mapping, followed by the ring.
+    struct header_t
+    {
+        std::atomic<uint32_t>   initialized         = { 0 }; // == magic when ready (for named queue)
+        std::atomic<uint32_t>   closed              = { 0 };
+        std::atomic<uint32_t>   can_push            = { 0 }; // futex-words: bumped on state changes
+        std::atomic<uint32_t>   can_pop             = { 0 };
+        std::atomic<uint32_t>   num_waiting_to_push = { 0 };
+        std::atomic<uint32_t>   num_waiting_to_pop  = { 0 };
+        lockables::atomic_mutex mutex               = {};
+        uint64_t                capacity            = 0;     // bytes in the ring
+        uint64_t                head                = 0;     // total bytes popped
+        uint64_t                tail                = 0;     // total bytes pushed
     };
 
-    test_other["to_num"] = [&]
+    static const uint32_t s_magic = 0x5155454Eu;
+
+    using len_t = uint32_t; // record's length-prefix
+
+public:
+    using value_type = T;
+
+    ///@{
+
+    /// Anonymous shared mapping: shared with the processes forked after construction.
+    explicit shm_queue(size_t capacity = 1 << 20)
+        : m_name{}
+        , m_owner{ true }
+        , m_map_size{ sizeof(header_t) + capacity }
+        , m_hdr{ nullptr }
     {
-        VERIFY(123  == int(tsv::to_num(" +123 ")));
+        void* p = x_map(-1, MAP_SHARED | MAP_ANONYMOUS);
+        x_init(p, capacity);
+    }
 
-        double delta = 123.0 - double(tsv::to_num(" 123.0 "));
-        if(delta < 0) {
-            delta *= -1;
+    /// Named POSIX shared-memory object (e.g. "/my_queue"): created with the
+    /// specified capacity if it does not exist, or opened otherwise (the capacity is then
+    /// that of the existing queue). The creator unlinks the name in its destructor,
+    /// so the other parties shall open it while the creator is alive.
+    shm_queue(const std::string& name, size_t capacity)
+        : m_name{ name }
+        , m_owner{ false }
+        , m_map_size{ sizeof(header_t) + capacity }
+        , m_hdr{ nullptr }
+    {
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        m_owner = fd >= 0;
+
+        if(!m_owner && errno == EEXIST) {
+            fd = ::shm_open(name.c_str(), O_RDWR, 0600);
         }
-        VERIFY(delta < 1e-10);
 
-        VERIFY(bool(tsv::to_num(" 1 ")));
+        if(fd < 0) {
+            RANGELESS_FN_THROW("Could not open shared memory object.");
+        }
 
-        try{
-            (void)int8_t(tsv::to_num("-129")); // overflow
-            VERIFY(false);
-        } catch(const std::domain_error&) {
-            ;
+        void* p = nullptr;
+        if(m_owner) {
+            const bool ok = ::ftruncate(fd, off_t(m_map_size)) == 0;
+            p = ok ? x_map(fd, MAP_SHARED) : nullptr;
+        } else {
+            p = x_map_existing(fd);
         }
+        ::close(fd);
 
-        try{
-            (void)int(tsv::to_num("123 4")); // trailing garbage
-            VERIFY(false);
-        } catch(const std::domain_error&) {
-            ;
+        if(!p) {
+            if(m_owner) {
+                ::shm_unlink(m_name.c_str());
+            }
+            RANGELESS_FN_THROW("Could not map shared memory object.");
         }
 
-        try{
-            (void)uint16_t(tsv::to_num("-123")); // negative number for unsigned
-            VERIFY(false);
-        } catch(const std::domain_error&) {
-            ;
+        if(m_owner) {
+            x_init(p, capacity);
+        } else {
+            m_hdr = static_cast<header_t*>(p);
+            while(m_hdr->initialized.load(std::memory_order_acquire) != s_magic) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
         }
+    }
 
-        enum class my_int_t : int{};
-        my_int_t my_int = tsv::to_num("42");
-        VERIFY(my_int == my_int_t(42));
+    ~shm_queue()
+    {
+        ::munmap(m_hdr, m_map_size);
+        if(m_owner && !m_name.empty()) {
+            ::shm_unlink(m_name.c_str());
+        }
+    }
 
-        // exercise signed and unsigned integral cases
-        VERIFY(-42 == int(tsv::to_num("-42")) );
+    shm_queue(const shm_queue&) = delete;
+    shm_queue& operator=(const shm_queue&) = delete;
 
-        const unsigned int u42 = tsv::to_num("42");
-        VERIFY(u42 == 42 );
-    };
+    ///@}
+    ///@{
 
+    /////////////////////////////////////////////////////////////////////////
+    struct push_t
+    {
+        shm_queue& m_queue;
 
-#endif // single-test vs all
+        /// Blocking push. May throw `queue_closed`.
+        void operator()(const value_type& val)
+        {
+            m_queue.x_push(val);
+        }
+    };
+
+    /// Blocking push. May throw `queue_closed`.
+    push_t push = { *this };
 
     /////////////////////////////////////////////////////////////////////////
-    size_t num_failed = 0;
-    size_t num_ok = 0;
-    for(auto&& tests : { test_cont, test_seq, test_view, test_other })
-        for(const auto& kv : tests)
+    struct pop_t
     {
-        try{
-            kv.second();
-            num_ok++;
-        } catch(const std::exception& e) {
-            num_failed++;
-            std::cerr << "Failed test '" << kv.first << "' :" << e.what() << "\n";
+        shm_queue& m_queue;
+
+        value_type operator()()
+        {
+            return m_queue.x_pop();
         }
-    }
-    if(num_failed == 0) {
-        std::cerr << "Ran " << num_ok << " tests - OK\n";
-    } else {
-        throw std::runtime_error(std::to_string(num_failed) + " tests failed.");
-    }
-}
+    };
 
-} // namespace impl
-} // namespace fn
-} // namespacce rangeless
+    /// Blocking pop. May throw `queue_closed`.
+    pop_t pop = { *this };
+
+    /// \brief pop() the values into the provided sink-function until closed and empty.
+    /// (see `synchronized_queue::operator>>=`)
+    template<typename F>
+    auto operator>>=(F&& sink) -> decltype((void)sink(this->pop()))
+    {
+        auto guard = this->close();
+
+        while(true) {
+            bool threw_in_pop = true;
 
+            try {
+                value_type val = this->pop();
+                threw_in_pop = false;
+                sink(std::move(val));
+
+            } catch(queue_closed&) {
+                if(threw_in_pop) {
+                    break;
+                } else {
+                    throw;
+                }
+            }
+        }
+    }
+
+    ///@}
+    ///@{
 
-#endif //RANGELESS_FN_ENABLE_RUN_TESTS
+    /// Capacity of the ring, in bytes.
+    size_t capacity() const noexcept
+    {
+        return size_t(m_hdr->capacity);
+    }
 
+    bool closed() const noexcept
+    {
+        return m_hdr->closed.load() != 0;
+    }
 
-/////////////////////////////////////////////////////////////////////////////
-//
-//
-// synchronized_queue, to_async, transform_in_parallel below
-//
-//
-/////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////
+    struct close_guard
+    {
+    private:
+        shm_queue* ptr;
 
+    public:
+        close_guard(shm_queue& queue) : ptr{ &queue }
+        {}
 
-#if RANGELESS_FN_ENABLE_PARALLEL
-#include <queue>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <atomic>
-#include <future>
-#include <chrono>
-#include <memory>
+        close_guard(const close_guard&) = default;
+        close_guard& operator=(const close_guard&) = default;
 
-/////////////////////////////////////////////////////////////////////////////
+        void reset()
+        {
+            ptr = nullptr;
+        }
 
-namespace rangeless
-{ 
-   
-namespace mt
-{ 
+        ~close_guard()
+        {
+            if(ptr) {
+                ptr->x_close();
+            }
+        }
+    };
 
-/////////////////////////////////////////////////////////////////////////////
-/// \brief A simple timer.
-struct timer
-{
-    /// returns the time elapsed since timer's instantiation, in seconds.
-    /// To reset: `my_timer = mt::timer{}`.
-    operator double() const
+    /// \brief Return an RAII object that will close the queue in its destructor
+    /// (for all processes; see `synchronized_queue::close()`).
+    close_guard close() noexcept
     {
-        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(
-            clock_t::now() - start_timepoint).count()) * 1e-9;
+        return close_guard{ *this };
     }
-private:
-    using clock_t = std::chrono::steady_clock;
-    clock_t::time_point start_timepoint = clock_t::now();
-};
 
-namespace lockables
-{
+    ///@}
 
-class atomic_mutex // without alignas(cacheline_size) to avoid overaligned-new pre-c++17
-{                  // instead will add padding around the fields
-protected:
-    std::atomic<bool> m_locked = { false };
+private:
+    using guard_t = std::lock_guard<lockables::atomic_mutex>;
 
-public:
-    bool try_lock() noexcept
+    void* x_map(int fd, int flags)
     {
-        return !m_locked.load(std::memory_order_relaxed)
-            && !m_locked.exchange(true, std::memory_order_acquire);
+        void* p = ::mmap(nullptr, m_map_size, PROT_READ | PROT_WRITE, flags, fd, 0);
+        return p == MAP_FAILED ? nullptr : p;
     }
 
-    void lock() noexcept
+    // wait for the creator to set the size, and map the whole object
+    void* x_map_existing(int fd)
     {
-        for(size_t i = 0; !try_lock(); i++) {
-            std::this_thread::sleep_for(
-                std::chrono::microseconds(5)); // the actual time is greater, depends on scheduler
+        struct stat st;
+        for(size_t i = 0; ; i++) {
+            if(::fstat(fd, &st) != 0) {
+                return nullptr;
+            }
+            if(size_t(st.st_size) >= sizeof(header_t)) {
+                break;
+            }
+            if(i == 10000) {
+                return nullptr; // ~1s
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
         }
+        m_map_size = size_t(st.st_size);
+        return x_map(fd, MAP_SHARED);
     }
 
-    void unlock() noexcept
+    void x_init(void* p, size_t capacity)
     {
-        m_locked.store(false, std::memory_order_release);
+        if(!p) {
+            RANGELESS_FN_THROW("Could not map shared memory.");
+        }
+        m_hdr = new (p) header_t{};
+        m_hdr->capacity = capacity;
+        m_hdr->initialized.store(s_magic, std::memory_order_release);
     }
-};
-
-}
-
-class synchronized_queue_base
-{
-public:
-    enum class status { success, closed, timeout };
 
-    // deriving from end_seq::exception to enable
-    // adapting queue as input-seq: fn::seq(my_queue.pop) % fn::for_each(...)
-    // (push will throw queue_closed, which will terminate the seq).
+    char* x_ring()
+    {
+        return reinterpret_cast<char*>(m_hdr + 1);
+    }
 
-    class queue_closed : public rangeless::fn::end_seq::exception
-    {};
+    // copy to/from ring at position pos (mod capacity), wrapping around
+    void x_write(uint64_t pos, const char* src, size_t n)
+    {
+        const size_t cap = size_t(m_hdr->capacity);
+        const size_t offset = size_t(pos % cap);
+        const size_t n1 = std::min(n, cap - offset);
+        std::memcpy(x_ring() + offset, src, n1);
+        std::memcpy(x_ring(), src + n1, n - n1);
+    }
 
-    // NB: Core guideline T.62: Place non-dependent class template members in a non-templated base class
-};
+    void x_read(uint64_t pos, char* dest, size_t n)
+    {
+        const size_t cap = size_t(m_hdr->capacity);
+        const size_t offset = size_t(pos % cap);
+        const size_t n1 = std::min(n, cap - offset);
+        std::memcpy(dest, x_ring() + offset, n1);
+        std::memcpy(dest + n1, x_ring(), n - n1);
+    }
 
+    static const char* x_data(const std::string& s)  { return s.data(); }
+    static size_t      x_size(const std::string& s)  { return s.size(); }
 
-/////////////////////////////////////////////////////////////////////////////
-/*! \brief Optionally-bounded blocking concurrent MPMC queue.
- *
- *   - Supports not-copy-constructible/not-default-constructible value-types (just requires move-assigneable).
- *   - Can be used with lockables other than `std::mutex`, e.g. `mt::atomic_lock`.
- *   - Contention-resistant: when used with `mt::atomic_lock` the throughput is comparable to state-of-the-art lock-free implementations.
- *   - Short and simple implementation using only c++11 standard library primitives.
- *   - Provides RAII-based closing semantics to communicate end-of-inputs 
- *     from the pushing end or failure/going-out-of-scope from the popping end.
- *
- * Related:
- * <br> <a href="http://www.boost.org/doc/libs/1_66_0/libs/fiber/doc/html/fiber/synchronization/channels/buffered_channel.html">`boost::fibers::buffered_channel`</a>
- * <br> <a href="http://www.boost.org/doc/libs/1_66_0/doc/html/thread/sds.html">`boost::sync_bounded_queue`</a>
- * <br> <a href="http://www.boost.org/doc/libs/1_66_0/doc/html/boost/lockfree/queue.html">`boost::lockfree::queue`</a>
- * <br> <a href="https://software.intel.com/en-us/node/506200">`tbb::concurrent_queue`</a>
- * <br> <a href="https://github.com/cameron314/concurrentqueue">`moodycamel::BlockingConcurrentQueue`</a>
- *
-@code
-    // A toy example to compute sum of lengths of strings in parallel.
-    //
-    // Spin-off a separate async-task that enqueues jobs 
-    // to process a single input, and enqueues the 
-    // futures into a synchronized queue, while accumulating 
-    // the ready results from the queue in this thread.
+    template<typename U>
+    static const char* x_data(const U& x) { return reinterpret_cast<const char*>(&x); }
 
-    using queue_t = mt::synchronized_queue<std::future<size_t> >;
-    queue_t queue{ 10 };
+    template<typename U>
+    static size_t      x_size(const U&)   { return sizeof(U); }
 
-    auto fut = std::async(std::launch::async,[ &queue ]
+    static void x_resize(std::string& s, size_t n)
     {
-        auto close_on_exit = queue.close();
+        s.resize(n);
+    }
 
-        for(std::string line; std::getline(std::cin, line); ) {
-            queue <<= 
-                std::async(
-                    std::launch::async, 
-                    [](const std::string& s) { 
-                        return s.size(); 
-                    },
-                    std::move(line));
+    template<typename U>
+    static void x_resize(U&, size_t n)
+    {
+        if(n != sizeof(U)) {
+            RANGELESS_FN_THROW("Unexpected size of shm_queue record.");
         }
-    });
-
-    size_t total = 0;
-    queue >>= [&](queue_t::value_type x) { total += x.get(); };
-    fut.get(); // rethrow exception, if any.
-@endcode
-*/
-template <typename T, class BasicLockable = std::mutex>
-class synchronized_queue : public synchronized_queue_base
-{
-public:
-    using value_type = T;
-
-    ///@{ 
-
-    synchronized_queue(size_t cap = 1024)
-      : m_capacity{ cap }
-    {}
-
-    ~synchronized_queue() = default;
-    // What if there are elements in the queue? 
-    // If there are active poppers, we ought to 
-    // let them finish, but if there aren't any,
-    // this will block indefinitely, so we'll 
-    // leave it to the user code to manage the
-    // lifetime across multiple threads.
-    //
-    // Should we call x_close() ?
-    // No point - we're already destructing.
-    // (it also grabs the m_queue_mutex, which 
-    // theoretically may throw).
+    }
 
+    static char* x_mutable_data(std::string& s) { return &s[0]; }
 
-    // After careful consideration, decided not to provide 
-    // move-semantics; copy and move constructors are implicitly
-    // deleted.
-    //
-    // A synchronized_queue can be thought of buffered mutex
-    // (i.e. a synchronization primitive rather than just a 
-    // data structure), and mutexes are not movable.
-    
-    ///@}
-    ///@{
+    template<typename U>
+    static char* x_mutable_data(U& x) { return reinterpret_cast<char*>(&x); }
 
-    // push and pop are implemented as callable function-objects fields
-    // rather than plain methods to enable usage like:
-    //
-    // Adapt queue as input-range:
-    // fn::seq(synchronized_queue.pop) % fn::for_each(...)
-    //
-    // Adapt queue as sink-function:
-    // std::move(inputs) % fn::for_each(my_queue.push);
-    //
-    // Adapt queue as output-iterator:
-    // std::copy(inputs.begin(), inputs.end(), my_queue.push);
+    static void x_futex_wait(std::atomic<uint32_t>& word, uint32_t expected)
+    {
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+    }
 
-    /////////////////////////////////////////////////////////////////////////
-    /// Implements insert_iterator and unary-invokable.
-    struct push_t
+    // bump the futex-word and wake up the waiters, if any.
+    static void x_notify(std::atomic<uint32_t>& word, const std::atomic<uint32_t>& num_waiting)
     {
-        using iterator_category = std::output_iterator_tag;
-        using   difference_type = void;
-        using        value_type = synchronized_queue::value_type;
-        using           pointer = void;
-        using         reference = void;
+        word.fetch_add(1);
+        if(num_waiting.load() > 0) {
+            ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        }
+    }
 
-        synchronized_queue& m_queue;
+    void x_push(const value_type& val)
+    {
+        const len_t len = len_t(x_size(val));
+        const uint64_t rec_size = sizeof(len_t) + uint64_t(len);
 
-        push_t& operator=(value_type val)
-        {
-            this->operator()(std::move(val));
-            return *this;
+        if(rec_size > m_hdr->capacity || uint64_t(len) != uint64_t(x_size(val))) {
+            RANGELESS_FN_THROW("Record does not fit into shm_queue.");
         }
 
-        push_t& operator*()     { return *this; }
-        push_t& operator++()    { return *this; }
-        push_t  operator++(int) { return *this; }
-
-        /// Blocking push. May throw `queue_closed`
-        void operator()(value_type val) noexcept(false)
-        {
-            // NB: if this throws, val is gone. If the user needs 
-            // to preserve it in case of failure (strong exception
-            // guarantee), it should be using try_push which takes 
-            // value by rvalue-reference and moves it only in case of success.
-            //
-            // We could do the same here, but that would mean
-            // that the user must always pass as rvalue, and 
-            // to pass by copy it would have to do so explicitly, e.g.
-            //
-            // void operator()(value_type&& val);
-            // queue.push(std::move(my_value));
-            // queue.push(my_const_ref); // won't compile.
-            // queue.push(queueue_t::value_type( my_const_ref )); // explicit copy
-            //
-            // I think this would actually be a good thing, as it 
-            // makes the copying visible, but all other synchronied-queue
-            // APIs allow pushing by const-or-forwarding-references, 
-            // so we have allow the same for the sake of consistency.
+        while(true) {
+            uint32_t seq = 0;
+            {{
+                const guard_t g{ m_hdr->mutex };
 
-            const status st = 
-                m_queue.try_push(std::move(val), no_timeout_sentinel_t{});
+                if(m_hdr->closed.load()) {
+                    throw queue_closed{};
+                }
 
-            assert(st != status::timeout);
+                if(m_hdr->capacity - (m_hdr->tail - m_hdr->head) >= rec_size) {
+                    x_write(m_hdr->tail, reinterpret_cast<const char*>(&len), sizeof(len));
+                    x_write(m_hdr->tail + sizeof(len), x_data(val), len);
+                    m_hdr->tail += rec_size;
+                    break;
+                }
 
-            if(st == status::closed) {
-                throw queue_closed{};
-            }
+                seq = m_hdr->can_push.load();
+                ++m_hdr->num_waiting_to_push;
+            }}
 
-            assert(st == status::success);
+            x_futex_wait(m_hdr->can_push, seq);
+            --m_hdr->num_waiting_to_push;
         }
-    };
-    friend struct push_t;
 
+        x_notify(m_hdr->can_pop, m_hdr->num_waiting_to_pop);
+    }
 
-    /////////////////////////////////////////////////////////////////////////
-    /// Blocking push. May throw `queue_closed`.
-    push_t push = { *this };
+    value_type x_pop()
+    {
+        value_type ret{};
 
+        while(true) {
+            uint32_t seq = 0;
+            {{
+                const guard_t g{ m_hdr->mutex };
+
+                if(m_hdr->tail != m_hdr->head) {
+                    len_t len = 0;
+                    x_read(m_hdr->head, reinterpret_cast<char*>(&len), sizeof(len));
+                    x_resize(ret, len);
+                    x_read(m_hdr->head + sizeof(len), x_mutable_data(ret), len);
+                    m_hdr->head += sizeof(len) + uint64_t(len);
+                    break;
+                }
 
-    /////////////////////////////////////////////////////////////////////////
-    struct pop_t
-    {
-        synchronized_queue& m_queue;
+                if(m_hdr->closed.load()) {
+                    throw queue_closed{};
+                }
 
-        value_type operator()()
-        {
-            return m_queue.x_blocking_pop();
+                seq = m_hdr->can_pop.load();
+                ++m_hdr->num_waiting_to_pop;
+            }}
+
+            x_futex_wait(m_hdr->can_pop, seq);
+            --m_hdr->num_waiting_to_pop;
         }
-    };
 
-    friend struct pop_t;
+        x_notify(m_hdr->can_push, m_hdr->num_waiting_to_push);
+        return ret;
+    }
 
-    /////////////////////////////////////////////////////////////////////////
-    /// Blocking pop. May throw `queue_closed`.
-    pop_t pop = { *this };
+    void x_close()
+    {
+        {{
+            const guard_t g{ m_hdr->mutex };
+            m_hdr->closed.store(1);
+        }}
+        x_notify(m_hdr->can_pop, m_hdr->num_waiting_to_pop);
+        x_notify(m_hdr->can_push, m_hdr->num_waiting_to_push);
+    }
 
+    std::string m_name;
+    bool        m_owner;
+    size_t      m_map_size;
+    header_t*   m_hdr;
+}; // shm_queue
 
-    /////////////////////////////////////////////////////////////////////////
+#endif // defined(__linux__)
 
-    ///@}
-    ///@{
+} // namespace mt
 
-    /// \brief pop() the values into the provided sink-function until closed and empty.
-    ///
-    /// e.g. `queue >>= [&out_it](T x){ *out_it++ = std::move(x); };`
-    /// <br>Queue is automatically closed if exiting via exception, unblocking the pushers.
-    template<typename F>
-    auto operator>>=(F&& sink) -> decltype((void)sink(this->pop()))
+/////////////////////////////////////////////////////////////////////////////
+
+namespace fn
+{
+
+namespace impl
+{
+    struct async_wr
     {
-        auto guard = this->close();
+        size_t queue_size;
 
-        while(true) {
-            bool threw_in_pop = true;
+        template<typename InGen>
+        struct gen
+        {
+            using value_type = typename InGen::value_type;
 
-            try {
-                value_type val = this->pop();
-                threw_in_pop = false;
-                sink(std::move(val));
+            using queue_t = mt::synchronized_queue<maybe<value_type>, mt::lockables::atomic_mutex>;
 
-            } catch(queue_closed&) {
+                        InGen in_gen;      // nullary generator yielding maybe<...>
+                 const size_t queue_size;
+     std::unique_ptr<queue_t> queue;    // as unique-ptr, because non-moveable
+            std::future<void> fut;
 
-                if(threw_in_pop) {
-                    break; // threw in pop()
-                } else {
-                    throw; // threw in sink() - not our business - rethrow;
-                    //
-                    // This could be an unhandled exception from
-                    // sink that is from some different queue that we
-                    // shouldn't be intercepting.
-                    //
-                    // If sink intends to close the queue
-                    // (e.g. break-out), it can do it explicitly
-                    // via the close-guard;
+            auto operator()() -> maybe<value_type>
+            {
+                if(!queue) {
+                    queue.reset(new queue_t{ queue_size });
+                    fut = std::async(std::launch::async, [this]
+                    {
+                        auto guard = queue->close(); // close on scope-exit
+                        for(auto x = in_gen(); x; x = in_gen()) {
+                            queue->push(std::move(x));
+                        }
+                        queue->push({}); // last empty-maybe element
+                    });
                 }
-            }
-        }
-        
-        assert(closed() && m_queue.empty());
-    }
 
-    ///@}
-    ///@{ 
+                try {
+                    auto x = queue->pop();
+                    if(!x) {
+                        fut.get(); // last element - allow future to rethrow
+                        assert(queue->closed());
+                    }
+                    return x;
+                } catch(mt::synchronized_queue_base::queue_closed) {
+                    // pop() threw queue_closed before we saw the last empty-maybe
+                    // - allow the future to rethrow.
+                    fut.get();
+                    throw;
+                }
+            }
+        };
 
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(queue_size, {}, {})
+    };
 
     /////////////////////////////////////////////////////////////////////////
-    /// In case of success, the value will be moved-from.
-    template <typename Duration = std::chrono::milliseconds>
-    status try_push(value_type&& value, Duration timeout = {})
-    {
-        // NB: we could have taken value as value_type&, but
-        // the user-code may forget or not expect that the value 
-        // will be moved-from and may try to use it.
-        //
-        // With rvalue-reference the caller-code has to, e.g.
-        //     auto state = queue.try_push(std::move(x));
-        //
-        // making the move explicitly visible.
 
-        const guard_t contention_guard{ m_push_mutex };
 
-        lock_t queue_lock{ m_queue_mutex };
+    // Default implementation of Async for par_transform below.
+    struct std_async
+    {
+        template<typename NullaryCallable>
+        auto operator()(NullaryCallable gen) const -> std::future<decltype(gen())>
+        {
+            return std::async(std::launch::async, std::move(gen));
+        }
+    };
 
-        ++m_num_waiting_to_push;        
-        const bool ok = x_wait_until([this]
-            {
-                return m_queue.size() < m_capacity || !m_capacity;
-            }, 
-            m_can_push, queue_lock, timeout);
-        --m_num_waiting_to_push;        
+    /////////////////////////////////////////////////////////////////////
+    template<typename F, typename Async>
+    struct par_transform
+    {
+         Async async;
+             F map_fn;    
+        size_t queue_cap; // 0 means in-this-thread.
 
-        if(!ok) {
-            return status::timeout;
+        par_transform&& queue_capacity(size_t cap) &&
+        {
+            queue_cap = cap;
+            return std::move(*this);
         }
 
-        if(!m_capacity) {
-             return status::closed;
-        }
+#if __cplusplus >= 201402L 
 
-        assert(m_queue.size() < m_capacity); 
+        /// If a job granularity is too small, combine work in batches per-async-task.
+        auto in_batches_of(size_t batch_size) && // rvalue-specific because will move-from
+        {
+            assert(batch_size >= 2);
 
-        // if push throws, is the value moved-from?
-        // No. std::move is just an rvalue_cast - no-op
-        // if the move-assignment never happens.
-        m_queue.push(std::move(value));
+            return [ map_fn = std::move(this->map_fn), 
+                      async = std::move(this->async),
+                  queue_cap = std::move(this->queue_cap),
+                 batch_size
+                            ] (auto inputs)
+            {
+                // TODO: can capture map_fn and async below by-move and make this lambda mutable?
 
-        const bool do_notify = m_num_waiting_to_pop > 0;
-        queue_lock.unlock();
+                auto batch_transform = [ map_fn ](auto inputs_batch) // [ inputs ] -> [ outputs ]
+                {
+                    // NB:: since fn::transform is lazy, we need to force eager-evaluation
+                    // within the batch-transform function by converting to vector.
+                    return fn::to_vector()(
+                            fn::transform(map_fn)(
+                                std::move(inputs_batch)));
+                };
 
-        if(do_notify) {
-            m_can_pop.notify_one();
+                // par_batch_transform = fn::transform_in_parallel(...), but it has not been declared yet.
+                auto par_batch_transform = 
+                    impl::par_transform<decltype(batch_transform), Async>{ async, // by-move here?
+                                                                           std::move(batch_transform), 
+                                                                           queue_cap };
+
+                return fn::concat()(                      // flatten batches of outputs.
+                        std::move(par_batch_transform)(   // par-transform batches of inputs.
+                            fn::in_groups_of(batch_size)( // batch the inputs.
+                                std::move(inputs))));
+            };
         }
 
-        return status::success;
-    }
+#endif // __cplusplus >= 201402L
 
+        template<typename InGen>
+        struct gen
+        {
+                    InGen gen;
+              const Async async;
+                  const F map_fn;
+             const size_t queue_cap;
 
-    /////////////////////////////////////////////////////////////////////////
-    /// In case of success, the value will be move-assigned.
-    template <typename Duration = std::chrono::milliseconds>
-    status try_pop(value_type& value, Duration timeout = {})
-    {
-        const guard_t contention_guard{ m_pop_mutex };
+            using value_type = decltype(map_fn(std::move(*gen())));
+            
+#if 0
+            using queue_t = std::deque<std::future<value_type>>;
+#else
+            // Instead of assuming that async returns a std::future,
+            // support the usage of any future-like type,
+            // allowing integration of 3rd-party async-like libraries.
+            struct value_type_callable
+            {
+                // we only need this in decltype context, but won't link without the body definition.
+                value_type operator()() const
+                {
+                    return value_type{};
+                }
+            };
+            using future_like_t = decltype(async(value_type_callable{}));
+            using queue_t  = std::deque<future_like_t>;
+#endif
+          
+            queue_t queue;
 
-        lock_t queue_lock{ m_queue_mutex };
+            /////////////////////////////////////////////////////////////////
 
-        ++m_num_waiting_to_pop;
-        bool ok = x_wait_until([this]
+            auto operator()() -> maybe<value_type>
             {
-                return !m_queue.empty() || !m_capacity;
-            },
-            m_can_pop, queue_lock, timeout);
-        --m_num_waiting_to_pop;
-
-        if(!ok) {
-            return status::timeout;
-        }
+                // behave like a plain impl::transform in in-this-thread mode
+                if(queue_cap == 0) {
+                    assert(queue.empty());
+                    auto x = gen();
+                    if(!x) {
+                        return { };
+                    } else {
+                        return map_fn(std::move(*x));
+                    }
+                }
 
-        if(!m_queue.empty()) {
-            ;
-        } else if(!m_capacity) {
-            return status::closed;
-        } else {
-            assert(false);
-        }
+                struct job_t // wrapper for invoking fn on inp, passed by move
+                {
+                    using input_t = typename InGen::value_type;
 
-        value = std::move(m_queue.front());
-        m_queue.pop();
+                    const F& fn;
+                     input_t inp; 
 
-        const bool do_notify = m_num_waiting_to_push > 0;
-        queue_lock.unlock();
+                    auto operator()() -> decltype(fn(std::move(inp)))
+                    {    
+                        return fn(std::move(inp));
+                    }    
+                };
 
-        if(do_notify) {
-            m_can_push.notify_one();
-        }
+                // if have more inputs, top-off the queue with async-tasks.
+                while(queue.size() < queue_cap) {
+                    auto x = gen();
+                    
+                    if(!x) {
+                        break;
+                    }
 
-        return status::success;
-    }
+                    queue.emplace_back( async( job_t{ map_fn, std::move(*x) }));
+                }
 
-    ///@}
-    ///@{ 
+                if(queue.empty()) {
+                    return { };
+                }
 
-    /////////////////////////////////////////////////////////////////////////
-    size_t approx_size() const noexcept
-    {
-        return m_queue.size();
-    }
+                auto ret = queue.front().get(); // this returns by-value
+                queue.pop_front();
+                return { std::move(ret) };
+            }
+        };
 
-    size_t capacity() const noexcept
-    {
-        return m_capacity;
-    }
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(  async, map_fn, queue_cap, {} )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( async, map_fn, queue_cap, {} )
+    };
 
-    bool closed() const noexcept
+    /////////////////////////////////////////////////////////////////////
+    // Append-only key-value file with an in-memory index (key -> location of value).
+    // Record: [uint64 key-size][uint64 value-size][key-bytes][value-bytes].
+    //
+    // If the process died mid-append, the torn record at the tail is dropped
+    // when the file is next opened. Thread-safe; the file is not meant to be
+    // shared between simultaneously-running processes.
+    class kv_file
     {
-        return !m_capacity;
-    }
+        using location_t = std::pair<uint64_t, uint64_t>; // value offset and size
 
-    /////////////////////////////////////////////////////////////////////////
-    struct close_guard
-    {
-    private:
-        synchronized_queue* ptr;
+        const std::string m_path;
+        std::fstream m_file;
+        std::unordered_map<std::string, location_t> m_index;
+        std::mutex m_mutex;
 
     public:
-        close_guard(synchronized_queue& queue) : ptr{ &queue }
-        {}
-
-        close_guard(const close_guard&) = default; // -Weffc++ warning
-        close_guard& operator=(const close_guard&) = default;
+        kv_file(std::string path)
+            : m_path{ std::move(path) }
+            , m_file{}
+            , m_index{}
+            , m_mutex{}
+        {
+            x_load_index();
+            m_file.open(m_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::app);
+            if(!m_file) {
+                RANGELESS_FN_THROW("Could not open the cache-file.");
+            }
+        }
 
-        void reset()
+        bool get(const std::string& key, std::string& value)
         {
-            ptr = nullptr;
+            std::lock_guard<std::mutex> lock{ m_mutex };
+
+            const auto it = m_index.find(key);
+            if(it == m_index.end()) {
+                return false;
+            }
+
+            value.resize(size_t(it->second.second));
+            m_file.seekg(std::streamoff(it->second.first));
+            m_file.read(&value[0], std::streamsize(value.size()));
+            if(!m_file) {
+                RANGELESS_FN_THROW("Could not read from the cache-file.");
+            }
+            return true;
         }
 
-        ~close_guard()
+        void put(const std::string& key, const std::string& value)
         {
-            if(ptr) {
-                ptr->x_close();
+            std::lock_guard<std::mutex> lock{ m_mutex };
+
+            if(m_index.count(key)) {
+                return; // computed concurrently
             }
-        }
-    };
 
-    /// \brief Return an RAII object that will close the queue in its destructor.
-    /// 
-    /// @code
-    /// auto guard = queue.close(); // close the queue when leaving scope
-    /// queue.close(); // close the queue now (guard's is destroyed immediately)
-    /// @endcode
-    ///
-    /// <br> NB: closing is non-blocking.
-    /// <br>Blocked calls to try_push()/try_pop() shall return with status::closed.
-    /// <br>Blocked calls to push()/pop() shall throw `queue_closed`.
-    /// <br>Subsequent calls to push()/try_push() shall do as above.
-    /// <br>Subsequent calls to pop()/try_pop() will succeed
-    ///   until the queue becomes empty, and throw/return-closed thereafter.
-    close_guard close() noexcept
-    {
-       return close_guard{ *this };
-    }
+            m_file.seekp(0, std::ios::end);
+            const auto pos = uint64_t(m_file.tellp());
 
-    ///@}
+            const uint64_t header[2] = { key.size(), value.size() };
+            m_file.write(reinterpret_cast<const char*>(header), sizeof(header));
+            m_file.write(key.data(), std::streamsize(key.size()));
+            m_file.write(value.data(), std::streamsize(value.size()));
+            m_file.flush();
+            if(!m_file) {
+                RANGELESS_FN_THROW("Could not write to the cache-file.");
+            }
 
-private:
-    using guard_t = std::lock_guard<BasicLockable>;
-    using  lock_t = std::unique_lock<BasicLockable>;
-    using queue_t = std::queue<value_type>;
+            m_index.emplace(key, location_t{ pos + sizeof(header) + key.size(), value.size() });
+        }
 
-    using condvar_t = typename std::conditional<
-        std::is_same<BasicLockable, std::mutex>::value,
-            std::condition_variable,
-            std::condition_variable_any        >::type;
+    private:
+        void x_load_index()
+        {
+            std::ifstream istr(m_path, std::ios::binary);
+            if(!istr) {
+                return; // new file
+            }
 
-    struct no_timeout_sentinel_t
-    {};
+            istr.seekg(0, std::ios::end);
+            const auto file_size = uint64_t(istr.tellg());
+            istr.seekg(0);
 
-    template<typename F>
-    bool x_wait_until(F condition, condvar_t& cv, lock_t& lock, no_timeout_sentinel_t)
-    {    
-        cv.wait(lock, std::move(condition));
-        return true;
-    }    
+            uint64_t pos = 0;
+            uint64_t header[2] = { 0, 0 };
+            std::string key{};
 
-    template<typename Duration, typename F>
-    bool x_wait_until(F condition, condvar_t& cv, lock_t& lock, Duration duration)
-    {    
-        return cv.wait_for(lock, duration, std::move(condition));
-    } 
+            // NB: checking the sizes against the remainder one at a time,
+            // as garbage sizes in a torn header may overflow when added.
+            while(pos + sizeof(header) <= file_size
+                  && istr.read(reinterpret_cast<char*>(header), sizeof(header))
+                  && header[0] <= file_size - pos - sizeof(header)
+                  && header[1] <= file_size - pos - sizeof(header) - header[0])
+            {
+                key.resize(size_t(header[0]));
+                istr.read(&key[0], std::streamsize(key.size()));
+                istr.seekg(std::streamoff(header[1]), std::ios::cur);
 
-    value_type x_blocking_pop()
-    {
-        const guard_t contention_guard{ m_pop_mutex };
+                pos += sizeof(header) + header[0];
+                m_index[key] = location_t{ pos, header[1] };
+                pos += header[1];
+            }
 
-        lock_t queue_lock{ m_queue_mutex };
+            if(pos == file_size) {
+                return;
+            }
 
-        ++m_num_waiting_to_pop;
-        m_can_pop.wait(
-            queue_lock,
-            [this]
+            // torn record at the tail: rewrite the valid prefix to a
+            // temporary file and replace the original with it.
+            // (std::rename does not replace an existing file on Windows)
+            const std::string tmp_path = m_path + ".tmp";
             {
-                return !m_queue.empty() || !m_capacity;
-            });
-        --m_num_waiting_to_pop;
+                std::ofstream ostr(tmp_path, std::ios::binary | std::ios::trunc);
+                std::vector<char> buf(size_t(1) << 16);
+
+                istr.clear();
+                istr.seekg(0);
+                for(uint64_t remaining = pos; remaining && istr && ostr; ) {
+                    const auto n = std::min(remaining, uint64_t(buf.size()));
+                    istr.read(buf.data(), std::streamsize(n));
+                    ostr.write(buf.data(), istr.gcount());
+                    remaining -= uint64_t(istr.gcount());
+                }
+                ostr.flush();
 
-        if(m_queue.empty()) {
-            throw queue_closed{};
-        }
+                if(!istr || !ostr) {
+                    ostr.close();
+                    std::remove(tmp_path.c_str());
+                    RANGELESS_FN_THROW("Could not repair the cache-file.");
+                }
+            }
+            istr.close();
 
-        value_type ret = std::move(m_queue.front());
-        m_queue.pop();
+            if(std::remove(m_path.c_str()) != 0 || std::rename(tmp_path.c_str(), m_path.c_str()) != 0) {
+                RANGELESS_FN_THROW("Could not repair the cache-file.");
+            }
+        }
+    };
 
-        const bool do_notify = m_num_waiting_to_push > 0;
-        queue_lock.unlock();
+    /////////////////////////////////////////////////////////////////////
+    // Default codec for transform_cached: trivial standard-layout types
+    // (e.g. arithmetic types, or POD structs) as their bytes, and std::string as is.
+    struct bytes_codec
+    {
+        void encode(const std::string& x, std::string& out) const
+        {
+            out += x;
+        }
 
-        if(do_notify) {
-            m_can_push.notify_one();
+        void decode(const std::string& bytes, std::string& x) const
+        {
+            x = bytes;
         }
 
-        return ret;
-    }
+        template<typename T>
+        auto encode(const T& x, std::string& out) const
+            -> typename std::enable_if<std::is_trivial<T>::value && std::is_standard_layout<T>::value>::type
+        {
+            out.append(reinterpret_cast<const char*>(&x), sizeof(T));
+        }
 
-    /////////////////////////////////////////////////////////////////////////
-    /// \brief Closes the queue for more pushing.
-    ///
-    void x_close()
-    {
+        template<typename T>
+        auto decode(const std::string& bytes, T& x) const
+            -> typename std::enable_if<std::is_trivial<T>::value && std::is_standard_layout<T>::value>::type
         {
-            guard_t g{ m_queue_mutex }; 
-            m_capacity = 0;
+            if(bytes.size() != sizeof(T)) {
+                RANGELESS_FN_THROW("Unexpected size of cached value.");
+            }
+            std::memcpy(&x, bytes.data(), sizeof(T));
         }
-        m_can_pop.notify_all();
-        m_can_push.notify_all();
-    }
+    };
 
-    // NB: open() is not provided, such that if closed() returns true,
-    // we know for sure that it's staying that way. 
+    /////////////////////////////////////////////////////////////////////
+    // Memoized unary function: look up the result by encoded key_fn(arg)
+    // in the kv_file, and on a miss compute and append it.
+    // The computation happens outside of the lock, so this can be
+    // used with transform_in_parallel.
+    template<typename F, typename KeyFn, typename Codec>
+    struct cached_fn
+    {
+                               F map_fn;
+                           KeyFn key_fn;
+                           Codec codec;
+        std::shared_ptr<kv_file> cache;
 
-    /////////////////////////////////////////////////////////////////////////
+        template<typename Arg>
+        auto operator()(Arg&& arg) const -> typename std::decay<decltype(map_fn(std::forward<Arg>(arg)))>::type
+        {
+            using result_t = typename std::decay<decltype(map_fn(std::forward<Arg>(arg)))>::type;
 
-       const char m_padding0[64]        = {};
+            std::string key{};
+            codec.encode(key_fn(arg), key);
 
-         uint32_t m_num_waiting_to_push = 0;
-         uint32_t m_num_waiting_to_pop  = 0;
-           size_t m_capacity            = size_t(-1); // 0 means closed
-          queue_t m_queue               = queue_t{};
-    BasicLockable m_queue_mutex         = {};
-    BasicLockable m_push_mutex          = {}; // for managing contention in SPMC/MPSC cases
-    BasicLockable m_pop_mutex           = {};
-        condvar_t m_can_push            = {};
-        condvar_t m_can_pop             = {};
+            std::string bytes{};
+            if(cache->get(key, bytes)) {
+                result_t ret{};
+                codec.decode(bytes, ret);
+                return ret;
+            }
 
-       const char m_padding1[64]        = {};
-}; // synchronized_queue
+            result_t ret = map_fn(std::forward<Arg>(arg));
+            codec.encode(ret, bytes);
+            cache->put(key, bytes);
+            return ret;
+        }
+    };
 
-} // namespace mt
+#if defined(__linux__)
 
-/////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////
+    // Forked worker-processes, each connected to the parent with a unix-domain socket.
+    // Messages are frames: [uint64 payload-size][uint64 status][payload-bytes].
+    //
+    // The parent's ends are non-blocking: while sending to a worker, the parent
+    // buffers the worker's output, so that neither side can block the other
+    // when both the inputs and the outputs exceed the socket's buffer.
+    class subprocess_pool
+    {
+        struct worker_t
+        {
+                  pid_t pid;
+                    int fd;
+            std::string inbox; // received bytes not yet consumed
+        };
 
-namespace fn
-{
+        std::vector<worker_t> m_workers;
 
-namespace impl
-{
-    struct async_wr
-    {
-        size_t queue_size;
+    public:
+        subprocess_pool() : m_workers{}
+        {}
 
-        template<typename InGen>
-        struct gen
+        subprocess_pool(const subprocess_pool&) = delete;
+        subprocess_pool& operator=(const subprocess_pool&) = delete;
+
+        // the workers exit upon EOF
+        ~subprocess_pool()
         {
-            using value_type = typename InGen::value_type;
+            for(const auto& w : m_workers) {
+                ::close(w.fd);
+            }
+            for(const auto& w : m_workers) {
+                if(w.pid > 0) { // not reaped by x_died
+                    ::waitpid(w.pid, nullptr, 0);
+                }
+            }
+        }
 
-            using queue_t = mt::synchronized_queue<maybe<value_type>, mt::lockables::atomic_mutex>;
+        size_t size() const
+        {
+            return m_workers.size();
+        }
 
-                        InGen in_gen;      // nullary generator yielding maybe<...>
-                 const size_t queue_size;
-     std::unique_ptr<queue_t> queue;    // as unique-ptr, because non-moveable
-            std::future<void> fut;
+        // worker_loop(fd) runs in the child-process
+        template<typename WorkerLoop>
+        void start(size_t num_workers, const WorkerLoop& worker_loop)
+        {
+            for(size_t i = 0; i < num_workers; i++) {
+                int fds[2] = { -1, -1 };
+                if(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+                    RANGELESS_FN_THROW("Could not create socketpair.");
+                }
 
-            auto operator()() -> maybe<value_type>
-            {
-                if(!queue) {
-                    queue.reset(new queue_t{ queue_size });
-                    fut = std::async(std::launch::async, [this]
-                    {
-                        auto guard = queue->close(); // close on scope-exit
-                        for(auto x = in_gen(); x; x = in_gen()) {
-                            queue->push(std::move(x));
-                        }
-                        queue->push({}); // last empty-maybe element
-                    });
+                const pid_t pid = ::fork();
+
+                if(pid < 0) {
+                    ::close(fds[0]);
+                    ::close(fds[1]);
+                    RANGELESS_FN_THROW("Could not fork.");
                 }
 
-                try {
-                    auto x = queue->pop();
-                    if(!x) {
-                        fut.get(); // last element - allow future to rethrow
-                        assert(queue->closed());
+                if(pid == 0) {
+                    ::close(fds[0]);
+                    for(const auto& w : m_workers) {
+                        ::close(w.fd);
                     }
-                    return x;
-                } catch(mt::synchronized_queue_base::queue_closed) {
-                    // pop() threw queue_closed before we saw the last empty-maybe
-                    // - allow the future to rethrow.
-                    fut.get();
-                    throw;
+
+                    int rc = 0;
+                    try {
+                        worker_loop(fds[1]);
+                    } catch(...) {
+                        rc = 1;
+                    }
+                    ::_exit(rc); // don't run the parent's atexit-handlers and destructors
                 }
+
+                ::close(fds[1]);
+                ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+                m_workers.push_back(worker_t{ pid, fds[0], {} });
             }
-        };
+        }
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ(queue_size, {}, {})
-    };
+        void send(size_t i, const std::string& payload, uint64_t status = 0)
+        {
+            const uint64_t header[2] = { payload.size(), status };
+            x_send(m_workers[i], reinterpret_cast<const char*>(header), sizeof(header));
+            x_send(m_workers[i], payload.data(), payload.size());
+        }
 
-    /////////////////////////////////////////////////////////////////////////
+        // receive the next frame from i'th worker; returns status.
+        uint64_t recv(size_t i, std::string& payload)
+        {
+            auto& w = m_workers[i];
+            uint64_t header[2] = { 0, 0 };
 
+            while(true) {
+                if(w.inbox.size() >= sizeof(header)) {
+                    std::memcpy(header, w.inbox.data(), sizeof(header));
 
-    // Default implementation of Async for par_transform below.
-    struct std_async
-    {
-        template<typename NullaryCallable>
-        auto operator()(NullaryCallable gen) const -> std::future<decltype(gen())>
+                    if(w.inbox.size() - sizeof(header) >= header[0]) {
+                        payload.assign(w.inbox, sizeof(header), size_t(header[0]));
+                        w.inbox.erase(0, sizeof(header) + size_t(header[0]));
+                        return header[1];
+                    }
+                }
+
+                x_poll(w, POLLIN);
+                x_recv_some(w);
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////
+        // Blocking I/O in the worker; return false on EOF or error.
+
+        static bool read_frame(int fd, std::string& payload)
         {
-            return std::async(std::launch::async, std::move(gen));
+            uint64_t header[2] = { 0, 0 };
+            if(!x_io_all(fd, reinterpret_cast<char*>(header), sizeof(header), true)) {
+                return false;
+            }
+            payload.resize(size_t(header[0]));
+            return x_io_all(fd, &payload[0], payload.size(), true);
         }
-    };
 
-    /////////////////////////////////////////////////////////////////////
-    template<typename F, typename Async>
-    struct par_transform
-    {
-         Async async;
-             F map_fn;    
-        size_t queue_cap; // 0 means in-this-thread.
+        static bool write_frame(int fd, const std::string& payload, uint64_t status)
+        {
+            uint64_t header[2] = { payload.size(), status };
+            return x_io_all(fd, reinterpret_cast<char*>(header), sizeof(header), false)
+                && x_io_all(fd, const_cast<char*>(payload.data()), payload.size(), false);
+        }
 
-        par_transform&& queue_capacity(size_t cap) &&
+    private:
+        static bool x_io_all(int fd, char* buf, size_t n, bool is_read)
+        {
+            while(n > 0) {
+                const ssize_t k = is_read ? ::read(fd, buf, n)
+                                          : ::send(fd, buf, n, MSG_NOSIGNAL);
+                if(k < 0 && errno == EINTR) {
+                    continue;
+                } else if(k <= 0) {
+                    return false;
+                }
+                buf += k;
+                n -= size_t(k);
+            }
+            return true;
+        }
+
+        static short x_poll(const worker_t& w, short events)
         {
-            queue_cap = cap;
-            return std::move(*this);
+            pollfd pfd{ w.fd, events, 0 };
+            while(::poll(&pfd, 1, -1) < 0) {
+                if(errno != EINTR) {
+                    RANGELESS_FN_THROW("poll failed.");
+                }
+            }
+            return pfd.revents;
         }
 
-#if __cplusplus >= 201402L 
+        static void x_recv_some(worker_t& w)
+        {
+            char buf[65536];
+            const ssize_t k = ::read(w.fd, buf, sizeof(buf));
 
-        /// If a job granularity is too small, combine work in batches per-async-task.
-        auto in_batches_of(size_t batch_size) && // rvalue-specific because will move-from
+            if(k > 0) {
+                w.inbox.append(buf, size_t(k));
+            } else if(k == 0 || (errno != EAGAIN && errno != EINTR)) {
+                x_died(w);
+            }
+        }
+
+        // The worker closed its end: reap it, and report how it exited.
+        [[noreturn]] static void x_died(worker_t& w)
         {
-            assert(batch_size >= 2);
+            std::string msg = "Worker process " + std::to_string(w.pid) + " died";
 
-            return [ map_fn = std::move(this->map_fn), 
-                      async = std::move(this->async),
-                  queue_cap = std::move(this->queue_cap),
-                 batch_size
-                            ] (auto inputs)
-            {
-                // TODO: can capture map_fn and async below by-move and make this lambda mutable?
+            int status = 0;
+            if(w.pid > 0 && ::waitpid(w.pid, &status, 0) == w.pid) {
+                msg += WIFEXITED(status)   ? " with exit status " + std::to_string(WEXITSTATUS(status))
+                     : WIFSIGNALED(status) ? " on signal " + std::to_string(WTERMSIG(status))
+                     :                       std::string{};
+                w.pid = -1;
+            }
 
-                auto batch_transform = [ map_fn ](auto inputs_batch) // [ inputs ] -> [ outputs ]
-                {
-                    // NB:: since fn::transform is lazy, we need to force eager-evaluation
-                    // within the batch-transform function by converting to vector.
-                    return fn::to_vector()(
-                            fn::transform(map_fn)(
-                                std::move(inputs_batch)));
-                };
+            throw std::runtime_error(msg + ".");
+        }
 
-                // par_batch_transform = fn::transform_in_parallel(...), but it has not been declared yet.
-                auto par_batch_transform = 
-                    impl::par_transform<decltype(batch_transform), Async>{ async, // by-move here?
-                                                                           std::move(batch_transform), 
-                                                                           queue_cap };
+        static void x_send(worker_t& w, const char* data, size_t n)
+        {
+            while(n > 0) {
+                const short revents = x_poll(w, POLLIN | POLLOUT);
 
-                return fn::concat()(                      // flatten batches of outputs.
-                        std::move(par_batch_transform)(   // par-transform batches of inputs.
-                            fn::in_groups_of(batch_size)( // batch the inputs.
-                                std::move(inputs))));
-            };
+                if(revents & (POLLIN | POLLHUP | POLLERR)) {
+                    x_recv_some(w);
+                }
+
+                if(revents & POLLOUT) {
+                    const ssize_t k = ::send(w.fd, data, n, MSG_NOSIGNAL);
+                    if(k >= 0) {
+                        data += k;
+                        n -= size_t(k);
+                    } else if(errno != EAGAIN && errno != EINTR) {
+                        x_died(w);
+                    }
+                }
+            }
         }
+    };
 
-#endif // __cplusplus >= 201402L
+    template<typename F, typename Codec>
+    struct subprocess_transform
+    {
+              F map_fn;
+          Codec codec;
+         size_t num_workers;
+         size_t queue_cap;
+
+        subprocess_transform&& queue_capacity(size_t cap) &&
+        {
+            assert(cap > 0);
+            queue_cap = cap;
+            return std::move(*this);
+        }
 
         template<typename InGen>
         struct gen
         {
-                    InGen gen;
-              const Async async;
-                  const F map_fn;
-             const size_t queue_cap;
+                       InGen gen;
+                     const F map_fn;
+                 const Codec codec;
+                const size_t num_workers;
+                const size_t queue_cap;
 
-            using value_type = decltype(map_fn(std::move(*gen())));
-            
-#if 0
-            using queue_t = std::deque<std::future<value_type>>;
-#else
-            // Instead of assuming that async returns a std::future,
-            // support the usage of any future-like type,
-            // allowing integration of 3rd-party async-like libraries.
-            struct value_type_callable
+            using input_t    = typename std::decay<typename InGen::value_type>::type;
+            using value_type = typename std::decay<decltype(map_fn(std::move(*gen())))>::type;
+
+            // Since each worker processes its inputs in FIFO-order, to preserve the
+            // order of outputs we just need to remember the worker of each in-flight job.
+            std::shared_ptr<subprocess_pool> pool;
+                      std::deque<size_t> in_flight;
+                                  size_t next_worker;
+                                    bool inputs_done;
+
+            struct worker_loop
             {
-                // we only need this in decltype context, but won't link without the body definition.
-                value_type operator()() const
+                const F& map_fn;
+                const Codec& codec;
+
+                void operator()(int fd) const
                 {
-                    return value_type{};
+                    std::string bytes{};
+                    std::string out{};
+
+                    while(subprocess_pool::read_frame(fd, bytes)) {
+                        uint64_t status = 0;
+                        out.clear();
+                        try {
+                            input_t x{};
+                            codec.decode(bytes, x);
+                            codec.encode(map_fn(std::move(x)), out);
+                        } catch(const std::exception& e) {
+                            status = 1;
+                            out = e.what();
+                        }
+
+                        if(!subprocess_pool::write_frame(fd, out, status)) {
+                            return;
+                        }
+                    }
                 }
             };
-            using future_like_t = decltype(async(value_type_callable{}));
-            using queue_t  = std::deque<future_like_t>;
-#endif
-          
-            queue_t queue;
-
-            /////////////////////////////////////////////////////////////////
 
             auto operator()() -> maybe<value_type>
             {
-                // behave like a plain impl::transform in in-this-thread mode
-                if(queue_cap == 0) {
-                    assert(queue.empty());
-                    auto x = gen();
-                    if(!x) {
-                        return { };
-                    } else {
-                        return map_fn(std::move(*x));
-                    }
+                if(!pool) {
+                    pool = std::make_shared<subprocess_pool>();
+                    pool->start(num_workers, worker_loop{ map_fn, codec });
                 }
 
-                struct job_t // wrapper for invoking fn on inp, passed by move
-                {
-                    using input_t = typename InGen::value_type;
-
-                    const F& fn;
-                     input_t inp; 
-
-                    auto operator()() -> decltype(fn(std::move(inp)))
-                    {    
-                        return fn(std::move(inp));
-                    }    
-                };
+                std::string bytes{};
 
-                // if have more inputs, top-off the queue with async-tasks.
-                while(queue.size() < queue_cap) {
+                while(!inputs_done && in_flight.size() < queue_cap) {
                     auto x = gen();
-                    
                     if(!x) {
+                        inputs_done = true;
                         break;
                     }
 
-                    queue.emplace_back( async( job_t{ map_fn, std::move(*x) }));
+                    bytes.clear();
+                    codec.encode(*x, bytes);
+                    pool->send(next_worker, bytes);
+                    in_flight.push_back(next_worker);
+                    next_worker = (next_worker + 1) % num_workers;
                 }
 
-                if(queue.empty()) {
+                if(in_flight.empty()) {
                     return { };
                 }
 
-                auto ret = queue.front().get(); // this returns by-value
-                queue.pop_front();
+                const uint64_t status = pool->recv(in_flight.front(), bytes);
+                in_flight.pop_front();
+
+                if(status != 0) {
+                    throw std::runtime_error("Exception in worker process: " + bytes);
+                }
+
+                value_type ret{};
+                codec.decode(bytes, ret);
                 return { std::move(ret) };
             }
         };
 
-        RANGELESS_FN_OVERLOAD_FOR_SEQ(  async, map_fn, queue_cap, {} )
-        RANGELESS_FN_OVERLOAD_FOR_CONT( async, map_fn, queue_cap, {} )
+        RANGELESS_FN_OVERLOAD_FOR_SEQ(  map_fn, codec, num_workers, queue_cap, {}, {}, 0, false )
+        RANGELESS_FN_OVERLOAD_FOR_CONT( map_fn, codec, num_workers, queue_cap, {}, {}, 0, false )
     };
 
+#endif // defined(__linux__)
+
 } // namespace impl
 
 
@@ -7293,6 +14237,76 @@ namespace impl
         return { std::move(async), std::move(map_fn), std::thread::hardware_concurrency() };
     }
 
+    /// @brief Memoize a unary function in an append-only file at `cache_path`.
+    ///
+    /// The results are looked-up by `key_fn(arg)`, and only the misses are computed
+    /// and appended to the file, so re-running a pipeline after a small change
+    /// of the inputs only recomputes the results for the changed inputs.
+    /// The index (key -> file-offset) is kept in memory; the values are read on demand.
+    ///
+    /// The keys and the results are serialized with `codec`, having methods
+    /// `encode(const T&, std::string& out)` that appends the bytes of `T` to `out`, and
+    /// `decode(const std::string& bytes, T&)`. The default `impl::bytes_codec` supports
+    /// `std::string` and trivial standard-layout types. The result type of `map_fn` must be
+    /// default-constructible.
+    ///
+    /// The memoized function is thread-safe if `map_fn` is (it's not
+    /// invoked under the lock), and can be used with `fn::transform_in_parallel`.
+    ///
+    /// NB: the cache does not know about changes to `map_fn` itself - use a different file.
+    /*!
+    @code
+        auto realigned = std::move(alns)
+          % fn::transform_in_parallel(fn::cached(realign, "realign.cache", get_aln_id, my_aln_codec{}))
+          % fn::to_vector();
+    @endcode
+    */
+    template<typename F, typename KeyFn = by::identity, typename Codec = impl::bytes_codec>
+    impl::cached_fn<F, KeyFn, Codec> cached(F map_fn, std::string cache_path, KeyFn key_fn = {}, Codec codec = {})
+    {
+        return { std::move(map_fn),
+                 std::move(key_fn),
+                 std::move(codec),
+                 std::make_shared<impl::kv_file>(std::move(cache_path)) };
+    }
+
+    /// @brief `fn::transform(fn::cached(map_fn, cache_path, key_fn, codec))`
+    template<typename F, typename KeyFn = by::identity, typename Codec = impl::bytes_codec>
+    impl::transform<impl::cached_fn<F, KeyFn, Codec>> transform_cached(F map_fn, std::string cache_path, KeyFn key_fn = {}, Codec codec = {})
+    {
+        return { cached(std::move(map_fn), std::move(cache_path), std::move(key_fn), std::move(codec)) };
+    }
+
+#if defined(__linux__)
+    /// @brief Like `transform_in_parallel`, but `map_fn` is executed in `num_workers` forked worker-processes.
+    ///
+    /// The inputs are serialized with `codec` (see `fn::cached`) and streamed to the workers over
+    /// unix-domain sockets, and the results are streamed back. This provides crash-isolation
+    /// for native code: if a worker dies, an exception is thrown. An exception thrown by `map_fn`
+    /// in a worker is rethrown in the parent as `std::runtime_error` with the same message.
+    ///
+    /// The outputs are in the order of inputs. The number of in-flight jobs is bounded by
+    /// `queue_capacity`, which defaults to `num_workers`; jobs are dispatched round-robin.
+    ///
+    /// The workers are forked upon the first pull from the resulting seq, and exit when
+    /// the seq is destroyed. NB: as with any `fork`, the workers get a copy of the parent's
+    /// memory but only the forking thread, so `map_fn` must not depend on other threads
+    /// (e.g. hold locks taken by other threads of the parent). Linux-only.
+    /*!
+    @code
+        auto results = std::move(inputs)
+          % fn::transform_in_subprocesses(run_native_aligner, 8).queue_capacity(32)
+          % fn::to_vector();
+    @endcode
+    */
+    template<typename F, typename Codec = impl::bytes_codec>
+    impl::subprocess_transform<F, Codec> transform_in_subprocesses(F map_fn, size_t num_workers, Codec codec = {})
+    {
+        assert(num_workers > 0);
+        return { std::move(map_fn), std::move(codec), num_workers, num_workers };
+    }
+#endif
+
     ///@}
     // defgroup parallel
 
@@ -7335,6 +14349,69 @@ static void run_tests()
         VERIFY(y == 20);
     }}
 
+#if defined(__linux__)
+    // test shm_queue
+    {{
+        // between processes
+        mt::shm_queue<std::string> queue{ 64 }; // small, to make the pusher block
+        VERIFY(queue.capacity() == 64);
+
+        const pid_t pid = ::fork();
+        VERIFY(pid >= 0);
+
+        if(pid == 0) {
+            // NB: the child must not unwind into the rest of the tests
+            int rc = 0;
+            try {
+                auto close_on_exit = queue.close();
+                for(int i = 0; i < 1000; i++) {
+                    queue.push(std::to_string(i));
+                }
+            } catch(...) {
+                rc = 1;
+            }
+            ::_exit(rc);
+        }
+
+        int n = 0;
+        bool in_order = true;
+        queue >>= [&](std::string s)
+        {
+            in_order = in_order && s == std::to_string(n++);
+        };
+        VERIFY(n == 1000 && in_order);
+
+        int status = -1;
+        VERIFY(::waitpid(pid, &status, 0) == pid);
+        VERIFY(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+        // named, trivial value-type, multiple pushers
+        const std::string name = "/fn_test_shm_queue_" + std::to_string(::getpid());
+        mt::shm_queue<long> q1{ name, 100 };
+        mt::shm_queue<long> q2{ name, 0 }; // opens the existing one
+        VERIFY(q2.capacity() == 100);
+
+        auto fut1 = std::async(std::launch::async, [&]{ for(long i = 1; i <= 500; i++) q1.push(i); });
+        auto fut2 = std::async(std::launch::async, [&]{ for(long i = 1; i <= 500; i++) q1.push(-i); });
+        auto fut3 = std::async(std::launch::async, [&]{ fut1.get(); fut2.get(); q1.close(); });
+
+        long sum = 0;
+        size_t count = 0;
+        q2 >>= [&](long x) { sum += x; ++count; };
+        fut3.get();
+        VERIFY(count == 1000 && sum == 0);
+        VERIFY(q1.closed());
+
+        bool threw = false;
+        try {
+            q1.push(1);
+        } catch(const mt::shm_queue<long>::queue_closed&) {
+            threw = true;
+        }
+        VERIFY(threw);
+    }}
+#endif
+
     {{
         synchronized_queue<std::string> q{1};
         std::string s1 = "1";
@@ -7556,6 +14633,125 @@ static void run_tests()
 #endif
     }}
 
+#if defined(__linux__)
+    // test transform_in_subprocesses
+    {{
+        int next = 0;
+        auto res = fn::seq([&next]{ return next++; })
+          % fn::take_first(100)
+          % fn::transform_in_subprocesses([](int x)
+            {
+                return std::to_string(x) + ":" + std::to_string(::getpid());
+            }, 4).queue_capacity(10)
+          % fn::to_vector();
+
+        VERIFY(res.size() == 100);
+        std::set<std::string> pids;
+        bool in_order = true;
+        for(size_t i = 0; i < res.size(); i++) {
+            const auto pos = res[i].find(':');
+            in_order = in_order && res[i].substr(0, pos) == std::to_string(i);
+            pids.insert(res[i].substr(pos + 1));
+        }
+        VERIFY(in_order);
+        VERIFY(pids.size() == 4 && !pids.count(std::to_string(::getpid())));
+
+        // large records both ways: must not deadlock
+        auto res2 = std::vector<std::string>(8, std::string(1 << 20, 'a'))
+          % fn::transform_in_subprocesses([](std::string s){ return s + s; }, 2).queue_capacity(8)
+          % fn::foldl(size_t(0), [](size_t n, const std::string& s){ return n + s.size(); });
+        VERIFY(res2 == 8 * (2 << 20));
+
+        // exception in map_fn
+        bool threw = false;
+        try {
+            std::vector<int>({ 1, 2, 3 })
+              % fn::transform_in_subprocesses([](int x)
+                {
+                    if(x == 2) {
+                        throw std::logic_error("bad input");
+                    }
+                    return x;
+                }, 2)
+              % fn::to_vector();
+        } catch(const std::runtime_error& e) {
+            threw = std::string(e.what()).find("bad input") != std::string::npos;
+        }
+        VERIFY(threw);
+
+        // worker died
+        threw = false;
+        try {
+            std::vector<int>({ 1, 2, 3 })
+              % fn::transform_in_subprocesses([](int x)
+                {
+                    if(x == 2) {
+                        ::_exit(1);
+                    }
+                    return x;
+                }, 2)
+              % fn::to_vector();
+        } catch(const std::runtime_error& e) {
+            threw = std::string(e.what()).find("died with exit status 1") != std::string::npos;
+        }
+        VERIFY(threw);
+    }}
+#endif
+
+    // test transform_cached
+    {{
+        const std::string path = "fn_test_transform_cached.tmp";
+        std::remove(path.c_str());
+
+        std::atomic<int> num_calls{ 0 };
+        auto square = [&num_calls](int x)
+        {
+            ++num_calls;
+            return std::to_string(x * x);
+        };
+
+        auto res = std::vector<int>({ 1, 2, 3, 1 })
+          % fn::transform_cached(square, path)
+          % fn::to_vector();
+        VERIFY(num_calls == 3);
+        VERIFY(res == std::vector<std::string>({ "1", "4", "9", "1" }));
+
+        // simulate a torn write
+        {{
+            std::ofstream ostr(path, std::ios::binary | std::ios::app);
+            ostr.write("garbage", 7);
+        }}
+
+        // re-run with more inputs: only the new ones are computed
+        auto res2 = std::vector<int>({ 1, 2, 3, 4, 5 })
+          % fn::transform_in_parallel(fn::cached(square, path)).queue_capacity(2)
+          % fn::to_vector();
+        VERIFY(num_calls == 5);
+        VERIFY(res2 == std::vector<std::string>({ "1", "4", "9", "16", "25" }));
+        VERIFY(!std::ifstream(path + ".tmp")); // the repair left no temporary behind
+
+        // a torn header with garbage sizes, which overflow when added
+        {{
+            const uint64_t header[2] = { uint64_t(-8), 16 };
+            std::ofstream ostr(path, std::ios::binary | std::ios::app);
+            ostr.write(reinterpret_cast<const char*>(header), sizeof(header));
+            ostr.write("garbage", 7);
+        }}
+
+        auto res2b = std::vector<int>({ 5, 6 }) % fn::transform_cached(square, path) % fn::to_vector();
+        VERIFY(num_calls == 6);
+        VERIFY(res2b == std::vector<std::string>({ "25", "36" }));
+
+        // keyed by a different key, with results of trivial type
+        auto res3 = std::vector<int>({ 10, 11, 20 })
+          % fn::transform_cached([](int x){ return double(x) / 2; }, path + "2", [](int x){ return x / 10; })
+          % fn::to_vector();
+        VERIFY(res3 == std::vector<double>({ 5.0, 5.0, 10.0 }));
+
+        std::remove(path.c_str());
+        std::remove((path + "2").c_str());
+    }}
+
 
 } // run_tests()
 
@@ -34,9 +34,10 @@ static void MakeCalendar(const uint16_t year,
     // format a line for a week, e.g. "       1  2  3  4  5"
   % fn::transform( [&](dates_t wk_dates) -> std::pair<date_t::month_type, std::string>
     {
-        auto dates_str = wk_dates % fn::foldl_d( [](std::string ret, const date_t& d)
+        auto dates_str = wk_dates % fn::join( "", [](std::string& out, const date_t& d)
         {
-            return std::move(ret) + (d.day() < 10 ? "  " : " ") + std::to_string(d.day());
+            out += d.day() < 10 ? "  " : " ";
+            out += std::to_string(d.day());
         });
         const auto prefix_len = size_t(3 * ((wk_dates.front().day_of_week() + 7 - 1) % 7));
         return { wk_dates.front().month(), std::string(prefix_len, ' ') + std::move(dates_str) };
@@ -0,0 +1,99 @@
+#include <fn.hpp>
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+// Benchmark for fn::prefetch: visiting objects via a shuffled array 
+// of pointers, such that every access is a cache-miss.
+//
+// "sum-keys" does next to no work per object: the out-of-order core already 
+// overlaps the misses of many iterations, so prefetching does not help.
+// "hash" does some real work per object (hashing the first 32 bytes of the payload),
+// which limits how far ahead the core gets on its own, and prefetching pays off.
+//
+// Build with optimizations, e.g. cmake -DCMAKE_BUILD_TYPE=Release
+// Usage: prefetch_bench [num-objects]
+
+namespace fn = rangeless::fn;
+using fn::operators::operator%;
+
+struct object_t
+{
+    uint64_t key;
+    char     payload[120]; // two cache-lines per object
+};
+
+template<typename F>
+static void run(const char* name, size_t n, F fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t result = fn();
+    const auto stop = std::chrono::steady_clock::now();
+
+    const double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+    std::cout << name << "\t" << ns / double(n) << " ns/elem\t(checksum " << result << ")\n";
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 4000000;
+
+    std::vector<object_t> objects(n);
+    std::vector<const object_t*> ptrs(n);
+    for(size_t i = 0; i < n; i++) {
+        objects[i].key = i;
+        for(size_t j = 0; j < sizeof(objects[i].payload); j++) {
+            objects[i].payload[j] = char(i + j);
+        }
+        ptrs[i] = &objects[i];
+    }
+
+    std::mt19937 rng{ 42 };
+    std::shuffle(ptrs.begin(), ptrs.end(), rng);
+
+    auto add_key = [](uint64_t out, const object_t* p)
+    {
+        return out + p->key;
+    };
+
+    auto add_hash = [](uint64_t out, const object_t* p)
+    {
+        uint64_t h = 14695981039346656037ULL ^ p->key; // FNV-1a
+        for(size_t i = 0; i < 32; i++) {
+            h = (h ^ uint8_t(p->payload[i])) * 1099511628211ULL;
+        }
+        return out + h;
+    };
+
+    for(size_t rep = 0; rep < 3; rep++) {
+        run("sum-keys no prefetch", n, [&]
+        {
+            return fn::cfrom(ptrs) % fn::to_seq() % fn::foldl(uint64_t(0), add_key);
+        });
+
+        for(const size_t distance : { 4, 8, 16, 32 }) {
+            const std::string name = "sum-keys prefetch(" + std::to_string(distance) + ")";
+            run(name.c_str(), n, [&]
+            {
+                return fn::cfrom(ptrs) % fn::prefetch(distance) % fn::foldl(uint64_t(0), add_key);
+            });
+        }
+
+        run("hash     no prefetch", n, [&]
+        {
+            return fn::cfrom(ptrs) % fn::to_seq() % fn::foldl(uint64_t(0), add_hash);
+        });
+
+        for(const size_t distance : { 4, 8, 16, 32 }) {
+            const std::string name = "hash     prefetch(" + std::to_string(distance) + ")";
+            run(name.c_str(), n, [&]
+            {
+                return fn::cfrom(ptrs) % fn::prefetch(distance) % fn::foldl(uint64_t(0), add_hash);
+            });
+        }
+        std::cout << "\n";
+    }
+
+    return 0;
+}